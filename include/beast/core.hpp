@@ -13,7 +13,9 @@
 #include <beast/core/detail/config.hpp>
 
 #include <beast/core/bind_handler.hpp>
+#include <beast/core/buffer_pool.hpp>
 #include <beast/core/buffered_read_stream.hpp>
+#include <beast/core/buffered_write_stream.hpp>
 #include <beast/core/buffers_adapter.hpp>
 #include <beast/core/buffers_cat.hpp>
 #include <beast/core/buffers_prefix.hpp>
@@ -31,6 +33,7 @@
 #include <beast/core/multi_buffer.hpp>
 #include <beast/core/ostream.hpp>
 #include <beast/core/read_size.hpp>
+#include <beast/core/ring_buffer.hpp>
 #include <beast/core/span.hpp>
 #include <beast/core/static_buffer.hpp>
 #include <beast/core/static_string.hpp>
@@ -0,0 +1,220 @@
+//
+// Copyright (c) 2016-2017 Vinnie Falco (vinnie dot falco at gmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/boostorg/beast
+//
+
+#ifndef BEAST_CORE_BUFFER_POOL_HPP
+#define BEAST_CORE_BUFFER_POOL_HPP
+
+#include <beast/core/detail/config.hpp>
+#include <boost/throw_exception.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <new>
+#include <type_traits>
+
+// Turn this off to never back pool slabs with huge pages
+#if ! defined(BEAST_USE_HUGE_PAGES)
+# if defined(__linux__)
+#  define BEAST_USE_HUGE_PAGES 1
+# else
+#  define BEAST_USE_HUGE_PAGES 0
+# endif
+#endif
+
+namespace beast {
+
+/** A process-wide pool of memory blocks for buffers.
+
+    Requests are rounded up to a power of two between
+    @ref min_size and @ref max_size. Each thread keeps a small
+    cache of free blocks for every size, so most allocations
+    and deallocations take no lock. When a cache grows too
+    large, a batch of blocks is moved to a shared depot, from
+    which other threads refill their caches. A thread which
+    exits returns its cached blocks to the depot. Blocks may be
+    deallocated on any thread.
+
+    New blocks are carved from slabs of @ref slab_size octets.
+    Slab memory is kept by the pool for the life of the process,
+    so the footprint is the peak amount of memory in use rather
+    than the current amount. Requests larger than @ref max_size
+    are passed to `operator new`.
+
+    Use @ref pool_allocator to obtain buffer memory from
+    the pool.
+
+    @note If `BEAST_NO_THREAD_LOCAL` is defined, all threads
+    share one cache protected by a mutex.
+*/
+class buffer_pool
+{
+public:
+    /// The smallest block size
+    static std::size_t constexpr min_size = 64;
+
+    /// The largest block size
+    static std::size_t constexpr max_size = 1024 * 1024;
+
+    /// The number of block sizes
+    static std::size_t constexpr classes = 15;
+
+    /// The size of each slab obtained from the system
+    static std::size_t constexpr slab_size = 2 * 1024 * 1024;
+
+    /// Counters describing the use of the pool
+    struct statistics
+    {
+        /// The number of calls to @ref allocate
+        std::uint64_t allocations = 0;
+
+        /// The number of calls to @ref deallocate
+        std::uint64_t deallocations = 0;
+
+        /// The number of allocations served from a thread cache
+        std::uint64_t cache_hits = 0;
+
+        /// The number of batches moved between a thread cache and the depot
+        std::uint64_t depot_transfers = 0;
+
+        /// The number of allocations larger than @ref max_size
+        std::uint64_t large_allocations = 0;
+
+        /// The number of octets allocated and not yet deallocated
+        std::uint64_t bytes_in_use = 0;
+
+        /// The number of octets of slab memory obtained from the system
+        std::uint64_t bytes_reserved = 0;
+
+        /// The part of `bytes_reserved` backed by explicit huge pages
+        std::uint64_t bytes_huge_pages = 0;
+    };
+
+    /** Allocate memory.
+
+        @param n The number of octets to allocate.
+
+        @return A pointer to at least `n` octets, aligned for
+        any fundamental type.
+
+        @throws std::bad_alloc if memory could not be obtained.
+    */
+    static
+    void*
+    allocate(std::size_t n);
+
+    /** Deallocate memory.
+
+        @param p A pointer returned by @ref allocate.
+
+        @param n The size which was passed to @ref allocate.
+    */
+    static
+    void
+    deallocate(void* p, std::size_t n);
+
+    /// Returns the current counters
+    static
+    statistics
+    stats();
+
+    /** Set whether new slabs are backed by huge pages.
+
+        When enabled, slabs are mapped from the explicit huge
+        page pool, or if none are available, mapped on a huge
+        page boundary and marked for transparent huge pages.
+        This reduces TLB misses when many large buffers are in
+        use. Slabs which were already obtained are not affected.
+
+        This has no effect unless `BEAST_USE_HUGE_PAGES` is set,
+        which is the default on Linux.
+    */
+    static
+    void
+    huge_pages(bool value);
+};
+
+/** An allocator which obtains memory from the @ref buffer_pool.
+
+    This allocator is stateless, and may be used in place of
+    `std::allocator` with any container in the library. Buffers
+    created and destroyed for each connection then reuse memory
+    from the pool instead of going to the heap.
+
+    @par Example
+    @code
+    using pooled_flat_buffer =
+        basic_flat_buffer<pool_allocator<char>>;
+
+    using pooled_multi_buffer =
+        basic_multi_buffer<pool_allocator<char>>;
+
+    using pooled_fields =
+        http::basic_fields<pool_allocator<char>>;
+    @endcode
+*/
+template<class T>
+class pool_allocator
+{
+public:
+    using value_type = T;
+
+    using is_always_equal = std::true_type;
+
+    /// Constructor
+    pool_allocator() = default;
+
+    /// Constructor
+    pool_allocator(pool_allocator const&) = default;
+
+    /// Constructor
+    template<class U>
+    pool_allocator(pool_allocator<U> const&) noexcept
+    {
+    }
+
+    /// Allocate space for `n` objects
+    T*
+    allocate(std::size_t n)
+    {
+        if(n > (std::numeric_limits<
+                std::size_t>::max)() / sizeof(T))
+            BOOST_THROW_EXCEPTION(std::bad_alloc{});
+        return static_cast<T*>(
+            buffer_pool::allocate(n * sizeof(T)));
+    }
+
+    /// Deallocate space for `n` objects
+    void
+    deallocate(T* p, std::size_t n)
+    {
+        buffer_pool::deallocate(p, n * sizeof(T));
+    }
+
+    template<class U>
+    friend
+    bool
+    operator==(pool_allocator const&, pool_allocator<U> const&)
+    {
+        return true;
+    }
+
+    template<class U>
+    friend
+    bool
+    operator!=(pool_allocator const&, pool_allocator<U> const&)
+    {
+        return false;
+    }
+};
+
+} // beast
+
+#include <beast/core/impl/buffer_pool.ipp>
+
+#endif
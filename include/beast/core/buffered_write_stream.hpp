@@ -0,0 +1,438 @@
+//
+// Copyright (c) 2016-2017 Vinnie Falco (vinnie dot falco at gmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/boostorg/beast
+//
+
+#ifndef BEAST_BUFFERED_WRITE_STREAM_HPP
+#define BEAST_BUFFERED_WRITE_STREAM_HPP
+
+#include <beast/core/detail/config.hpp>
+#include <beast/core/error.hpp>
+#include <beast/core/type_traits.hpp>
+#include <beast/core/detail/pausation.hpp>
+#include <asio/async_result.hpp>
+#include <asio/buffer.hpp>
+#include <asio/io_context.hpp>
+#include <cstdint>
+#include <utility>
+
+namespace beast {
+
+/** A @b Stream with attached @b DynamicBuffer to buffer writes.
+
+    This wraps a @b Stream implementation so that calls to write are
+    passed through the buffer, while calls to read are passed through
+    directly. Small writes are copied into the buffer and reported
+    as complete without performing I/O on the next layer. The
+    buffered data is sent together with the data of the write which
+    does not fit, as a single gather write, or when the caller
+    requests a flush. This is similar to the effect of `MSG_MORE`
+    or `TCP_CORK` on a socket, and reduces the number of calls to
+    the next layer for protocols which produce many small writes,
+    such as @ref http::write or @ref websocket::stream.
+
+    Optionally, asynchronous writes may schedule an automatic flush.
+    The flush waits until a pass through the queue of the stream's
+    executor completes without another write to the stream, so that
+    all of the writes made by handlers which are ready to run are
+    coalesced, and then sends the buffered data in the background.
+    Any error from the background flush is reported by the next
+    call to write or flush.
+
+    Example:
+    @code
+    // Send an HTTP message with one call to the socket,
+    // even though the serializer produces several buffers.
+    //
+    buffered_write_stream<tcp::socket, flat_buffer> stream{ioc};
+    ...
+    http::write(stream, res);
+    stream.flush();
+    @endcode
+
+    @par Thread Safety
+    @e Distinct @e objects: Safe.@n
+    @e Shared @e objects: Unsafe. The application must also ensure that all
+    asynchronous operations are performed within the same implicit or explicit
+    strand.
+
+    @note The buffered data is not sent when the stream is destroyed.
+    When the automatic flush is enabled, the stream must not be destroyed
+    while buffered data is pending; call @ref async_flush first.
+
+    @tparam Stream The type of stream to wrap.
+
+    @tparam DynamicBuffer The type of stream buffer to use.
+*/
+template<class Stream, class DynamicBuffer>
+class buffered_write_stream
+{
+    static_assert(
+        asio::is_dynamic_buffer<DynamicBuffer>::value,
+        "DynamicBuffer requirements not met");
+
+    template<class Buffers, class Handler>
+    class write_some_op;
+
+    template<class Handler>
+    class flush_op;
+
+    class auto_flush_op;
+
+    DynamicBuffer buffer_;
+    std::size_t capacity_ = 4096;
+    error_code ec_;                 // from the automatic flush
+    std::uint64_t writes_ = 0;      // number of buffered writes
+    bool auto_flush_ = false;
+    bool flushing_ = false;         // automatic flush scheduled
+    bool writing_ = false;          // automatic flush in progress
+    detail::pausation paused_;      // waiting for the automatic flush
+    Stream next_layer_;
+
+public:
+    /// The type of the internal buffer
+    using buffer_type = DynamicBuffer;
+
+    /// The type of the next layer.
+    using next_layer_type =
+        typename std::remove_reference<Stream>::type;
+
+    /// The type of the lowest layer.
+    using lowest_layer_type = get_lowest_layer<next_layer_type>;
+
+    /// The type of the executor associated with the object.
+    using executor_type = typename next_layer_type::executor_type;
+
+    /** Move constructor.
+
+        @note The behavior of move assignment on or from streams
+        with active or pending operations is undefined.
+    */
+    buffered_write_stream(buffered_write_stream&&) = default;
+
+    /** Move assignment.
+
+        @note The behavior of move assignment on or from streams
+        with active or pending operations is undefined.
+    */
+    buffered_write_stream& operator=(buffered_write_stream&&) = default;
+
+    /** Construct the wrapping stream.
+
+        @param args Parameters forwarded to the `Stream` constructor.
+    */
+    template<class... Args>
+    explicit
+    buffered_write_stream(Args&&... args);
+
+    /// Get a reference to the next layer.
+    next_layer_type&
+    next_layer()
+    {
+        return next_layer_;
+    }
+
+    /// Get a const reference to the next layer.
+    next_layer_type const&
+    next_layer() const
+    {
+        return next_layer_;
+    }
+
+    /// Get a reference to the lowest layer.
+    lowest_layer_type&
+    lowest_layer()
+    {
+        return next_layer_.lowest_layer();
+    }
+
+    /// Get a const reference to the lowest layer.
+    lowest_layer_type const&
+    lowest_layer() const
+    {
+        return next_layer_.lowest_layer();
+    }
+
+    /** Get the executor associated with the object.
+
+        This function may be used to obtain the executor object that the stream
+        uses to dispatch handlers for asynchronous operations.
+
+        @return A copy of the executor that stream will use to dispatch handlers.
+    */
+    executor_type
+    get_executor() noexcept
+    {
+        return next_layer_.get_executor();
+    }
+
+    /** Access the internal buffer.
+
+        The internal buffer is returned. It is possible for the
+        caller to break invariants with this function. For example,
+        by causing the internal buffer size to increase beyond
+        the caller defined maximum.
+    */
+    DynamicBuffer&
+    buffer()
+    {
+        return buffer_;
+    }
+
+    /// Access the internal buffer
+    DynamicBuffer const&
+    buffer() const
+    {
+        return buffer_;
+    }
+
+    /** Set the maximum buffer size.
+
+        This changes the maximum size of the internal buffer used
+        to hold written data. A write which would cause the buffer
+        to exceed this size is sent to the next layer together with
+        the buffered data. No bytes are sent by this call. If the
+        buffer size is set to zero, no more data will be buffered.
+        The default is 4096.
+
+        Thread safety:
+            The caller is responsible for making sure the call is
+            made from the same implicit or explicit strand.
+
+        @param size The number of bytes in the write buffer.
+    */
+    void
+    capacity(std::size_t size)
+    {
+        capacity_ = size;
+    }
+
+    /** Set whether asynchronous writes are flushed automatically.
+
+        When enabled, an asynchronous write which is buffered
+        schedules a flush of the buffer on the stream's executor.
+        The flush is performed once a pass through the executor's
+        queue adds nothing to the buffer. The default is disabled.
+
+        @param value `true` to enable the automatic flush.
+    */
+    void
+    auto_flush(bool value)
+    {
+        auto_flush_ = value;
+    }
+
+    /// Returns `true` if asynchronous writes are flushed automatically
+    bool
+    auto_flush() const
+    {
+        return auto_flush_;
+    }
+
+    /** Write all of the buffered data to the next layer.
+
+        The call will block until all of the buffered data
+        has been written, or until an error occurs.
+
+        @throws system_error Thrown on failure.
+    */
+    void
+    flush();
+
+    /** Write all of the buffered data to the next layer.
+
+        The call will block until all of the buffered data
+        has been written, or until an error occurs.
+
+        @param ec Set to the error, if any occurred. On error,
+        the data not yet written remains in the buffer.
+    */
+    void
+    flush(error_code& ec);
+
+    /** Start an asynchronous flush.
+
+        This function is used to asynchronously write all of the
+        buffered data to the next layer. The function call always
+        returns immediately.
+
+        @param handler Invoked when the operation completes.
+        The handler may be moved or copied as needed.
+        The equivalent function signature of the handler must be:
+        @code void handler(
+            error_code const& error // result of operation
+        ); @endcode
+        Regardless of whether the asynchronous operation completes
+        immediately or not, the handler will not be invoked from within
+        this function. Invocation of the handler will be performed in a
+        manner equivalent to using `asio::io_context::post`.
+    */
+    template<class FlushHandler>
+    ASIO_INITFN_RESULT_TYPE(
+        FlushHandler, void(error_code))
+    async_flush(FlushHandler&& handler);
+
+    /** Read some data from the stream.
+
+        This function is used to read data from the stream.
+        The function call will block until one or more bytes of
+        data has been read successfully, or until an error occurs.
+
+        @param buffers One or more buffers into which the data will be read.
+
+        @return The number of bytes read.
+
+        @throws system_error Thrown on failure.
+    */
+    template<class MutableBufferSequence>
+    std::size_t
+    read_some(MutableBufferSequence const& buffers)
+    {
+        static_assert(is_sync_read_stream<next_layer_type>::value,
+            "SyncReadStream requirements not met");
+        return next_layer_.read_some(buffers);
+    }
+
+    /** Read some data from the stream.
+
+        This function is used to read data from the stream.
+        The function call will block until one or more bytes of
+        data has been read successfully, or until an error occurs.
+
+        @param buffers One or more buffers into which the data will be read.
+
+        @param ec Set to the error, if any occurred.
+
+        @return The number of bytes read, or 0 on error.
+    */
+    template<class MutableBufferSequence>
+    std::size_t
+    read_some(MutableBufferSequence const& buffers,
+        error_code& ec)
+    {
+        static_assert(is_sync_read_stream<next_layer_type>::value,
+            "SyncReadStream requirements not met");
+        return next_layer_.read_some(buffers, ec);
+    }
+
+    /** Start an asynchronous read.
+
+        This function is used to asynchronously read data from
+        the stream. The function call always returns immediately.
+
+        @param buffers One or more buffers into which the data
+        will be read. Although the buffers object may be copied
+        as necessary, ownership of the underlying memory blocks
+        is retained by the caller, which must guarantee that they
+        remain valid until the handler is called.
+
+        @param handler Invoked when the operation completes.
+        The handler may be moved or copied as needed.
+        The equivalent function signature of the handler must be:
+        @code void handler(
+            error_code const& error,      // result of operation
+            std::size_t bytes_transferred // number of bytes transferred
+        ); @endcode
+        Regardless of whether the asynchronous operation completes
+        immediately or not, the handler will not be invoked from within
+        this function. Invocation of the handler will be performed in a
+        manner equivalent to using `asio::io_context::post`.
+    */
+    template<class MutableBufferSequence, class ReadHandler>
+    ASIO_INITFN_RESULT_TYPE(
+        ReadHandler, void(error_code, std::size_t))
+    async_read_some(MutableBufferSequence const& buffers,
+        ReadHandler&& handler);
+
+    /** Write some data to the stream.
+
+        This function is used to write data to the stream. If the
+        data fits in the buffer it is copied there and the call
+        returns immediately. Otherwise, the buffered data and the
+        new data are written to the next layer, and the call
+        blocks until one or more bytes of the new data have been
+        written or buffered, or until an error occurs.
+
+        @param buffers One or more data buffers to be written to the stream.
+
+        @return The number of bytes written.
+
+        @throws system_error Thrown on failure.
+    */
+    template<class ConstBufferSequence>
+    std::size_t
+    write_some(ConstBufferSequence const& buffers);
+
+    /** Write some data to the stream.
+
+        This function is used to write data to the stream. If the
+        data fits in the buffer it is copied there and the call
+        returns immediately. Otherwise, the buffered data and the
+        new data are written to the next layer, and the call
+        blocks until one or more bytes of the new data have been
+        written or buffered, or until an error occurs.
+
+        @param buffers One or more data buffers to be written to the stream.
+
+        @param ec Set to the error, if any occurred.
+
+        @return The number of bytes written, or 0 on error.
+    */
+    template<class ConstBufferSequence>
+    std::size_t
+    write_some(ConstBufferSequence const& buffers,
+        error_code& ec);
+
+    /** Start an asynchronous write.
+
+        This function is used to asynchronously write data to
+        the stream. The function call always returns immediately.
+        If the data fits in the buffer it is copied there and the
+        operation completes without performing I/O.
+
+        @param buffers One or more data buffers to be written to
+        the stream. Although the buffers object may be copied as
+        necessary, ownership of the underlying memory blocks is
+        retained by the caller, which must guarantee that they
+        remain valid until the handler is called.
+
+        @param handler Invoked when the operation completes.
+        The handler may be moved or copied as needed.
+        The equivalent function signature of the handler must be:
+        @code void handler(
+            error_code const& error,      // result of operation
+            std::size_t bytes_transferred // number of bytes transferred
+        ); @endcode
+        Regardless of whether the asynchronous operation completes
+        immediately or not, the handler will not be invoked from within
+        this function. Invocation of the handler will be performed in a
+        manner equivalent to using `asio::io_context::post`.
+    */
+    template<class ConstBufferSequence, class WriteHandler>
+    ASIO_INITFN_RESULT_TYPE(
+        WriteHandler, void(error_code, std::size_t))
+    async_write_some(ConstBufferSequence const& buffers,
+        WriteHandler&& handler);
+
+private:
+    template<class ConstBufferSequence>
+    bool
+    fits(ConstBufferSequence const& buffers) const;
+
+    template<class ConstBufferSequence>
+    std::size_t
+    append(ConstBufferSequence const& buffers);
+
+    void
+    schedule_flush();
+};
+
+} // beast
+
+#include <beast/core/impl/buffered_write_stream.ipp>
+
+#endif
@@ -11,6 +11,7 @@
 #define BEAST_BUFFERS_CAT_HPP
 
 #include <beast/core/detail/config.hpp>
+#include <beast/core/detail/buffer_array.hpp>
 #include <beast/core/detail/type_traits.hpp>
 #include <tuple>
 
@@ -25,6 +26,8 @@ class buffers_cat_view
 {
     std::tuple<Buffers...> bn_;
 
+    friend class detail::buffers_flattener;
+
 public:
     /** The type of buffer returned when dereferencing an iterator.
 
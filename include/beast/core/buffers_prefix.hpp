@@ -11,6 +11,7 @@
 #define BEAST_BUFFERS_PREFIX_HPP
 
 #include <beast/core/detail/config.hpp>
+#include <beast/core/detail/buffer_array.hpp>
 #include <beast/core/type_traits.hpp>
 #include <asio/buffer.hpp>
 #include <boost/optional/optional.hpp>
@@ -41,6 +42,8 @@ class buffers_prefix_view
     std::size_t remain_;
     iter_type end_;
 
+    friend class detail::buffers_flattener;
+
     template<class Deduced>
     buffers_prefix_view(
             Deduced&& other, std::size_t dist)
@@ -11,6 +11,7 @@
 #define BEAST_BUFFERS_SUFFIX_HPP
 
 #include <beast/core/detail/config.hpp>
+#include <beast/core/detail/buffer_array.hpp>
 #include <beast/core/detail/type_traits.hpp>
 #include <asio/buffer.hpp>
 #include <boost/optional.hpp>
@@ -62,6 +63,8 @@ class buffers_suffix
     iter_type begin_;
     std::size_t skip_ = 0;
 
+    friend class detail::buffers_flattener;
+
     template<class Deduced>
     buffers_suffix(Deduced&& other, std::size_t dist)
         : bs_(std::forward<Deduced>(other).bs_)
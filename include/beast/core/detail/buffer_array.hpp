@@ -0,0 +1,335 @@
+//
+// Copyright (c) 2016-2017 Vinnie Falco (vinnie dot falco at gmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/boostorg/beast
+//
+
+#ifndef BEAST_DETAIL_BUFFER_ARRAY_HPP
+#define BEAST_DETAIL_BUFFER_ARRAY_HPP
+
+#include <asio/buffer.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+#include <memory>
+#include <new>
+#include <tuple>
+#include <type_traits>
+
+namespace beast {
+
+template<class... Buffers>
+class buffers_cat_view;
+
+template<class BufferSequence>
+class buffers_prefix_view;
+
+template<class BufferSequence>
+class buffers_suffix;
+
+namespace detail {
+
+template<class BufferSequence>
+class buffers_ref;
+
+/*  Copies the non-empty buffers of a sequence to an array.
+
+    The views defined by Beast are taken apart directly rather
+    than through their iterators: the components of a
+    concatenation are visited one after the other, a prefix
+    only lowers the number of octets to copy, and a suffix
+    starts the underlying sequence at its first buffer. The
+    sequence is traversed once, and stops when the array is
+    full or the octets of an enclosing prefix are exhausted.
+*/
+class buffers_flattener
+{
+    asio::const_buffer* it_;
+    asio::const_buffer* end_;
+    std::size_t limit_ =
+        (std::numeric_limits<std::size_t>::max)();
+
+    template<bool B>
+    using bool_constant = std::integral_constant<bool, B>;
+
+public:
+    buffers_flattener(
+        asio::const_buffer* first,
+        asio::const_buffer* last)
+        : it_(first)
+        , end_(last)
+    {
+    }
+
+    // One past the last buffer copied
+    asio::const_buffer*
+    position() const
+    {
+        return it_;
+    }
+
+    // Returns `false` if the rest of the sequence is not needed
+    template<class BufferSequence>
+    bool
+    operator()(BufferSequence const& buffers)
+    {
+        return visit(buffers);
+    }
+
+private:
+    bool
+    append(asio::const_buffer b)
+    {
+        if(b.size() == 0)
+            return true;
+        if(it_ == end_)
+            return false;
+        if(b.size() > limit_)
+            b = {b.data(), limit_};
+        ::new(it_++) asio::const_buffer(b);
+        limit_ -= b.size();
+        return limit_ != 0;
+    }
+
+    template<class Iterator>
+    bool
+    range(Iterator it, Iterator last, std::size_t skip)
+    {
+        if(it == last)
+            return true;
+        if(! append(asio::const_buffer(*it) + skip))
+            return false;
+        while(++it != last)
+            if(! append(*it))
+                return false;
+        return true;
+    }
+
+    template<class BufferSequence>
+    bool
+    visit(BufferSequence const& buffers, std::true_type)
+    {
+        return append(asio::const_buffer(buffers));
+    }
+
+    template<class BufferSequence>
+    bool
+    visit(BufferSequence const& buffers, std::false_type)
+    {
+        return range(
+            asio::buffer_sequence_begin(buffers),
+            asio::buffer_sequence_end(buffers), 0);
+    }
+
+    template<class BufferSequence>
+    bool
+    visit(BufferSequence const& buffers)
+    {
+        return visit(buffers, std::is_convertible<
+            BufferSequence const&, asio::const_buffer>{});
+    }
+
+    template<class... Bn>
+    bool
+    visit(buffers_cat_view<Bn...> const& buffers)
+    {
+        return each<0>(buffers.bn_,
+            bool_constant<sizeof...(Bn) == 0>{});
+    }
+
+    template<class Buffers>
+    bool
+    visit(buffers_prefix_view<Buffers> const& buffers)
+    {
+        auto const limit = limit_;
+        auto const n = (std::min)(limit, buffers.size_);
+        if(n == 0)
+            return true;
+        limit_ = n;
+        (*this)(buffers.bs_);
+        limit_ = limit - (n - limit_);
+        return it_ != end_ && limit_ != 0;
+    }
+
+    template<class Buffers>
+    bool
+    visit(buffers_suffix<Buffers> const& buffers)
+    {
+        return range(buffers.begin_,
+            asio::buffer_sequence_end(buffers.bs_),
+                buffers.skip_);
+    }
+
+    template<class... Bn>
+    bool
+    visit(buffers_suffix<buffers_cat_view<Bn...>> const& buffers)
+    {
+        // Resume the concatenation at the component
+        // which the suffix's first iterator is in.
+        return from<0>(buffers.bs_.bn_, buffers.begin_,
+            buffers.skip_, bool_constant<sizeof...(Bn) == 0>{});
+    }
+
+    template<class Buffers>
+    bool
+    visit(buffers_ref<Buffers> const& buffers)
+    {
+        return (*this)(*buffers.buffers_);
+    }
+
+    template<std::size_t I, class Tuple>
+    bool
+    each(Tuple const&, std::true_type)
+    {
+        return true;
+    }
+
+    template<std::size_t I, class Tuple>
+    bool
+    each(Tuple const& bn, std::false_type)
+    {
+        if(! (*this)(std::get<I>(bn)))
+            return false;
+        return each<I+1>(bn, bool_constant<
+            I+1 == std::tuple_size<Tuple>::value>{});
+    }
+
+    template<std::size_t I, class Tuple, class Iterator>
+    bool
+    from(Tuple const&, Iterator const&,
+        std::size_t, std::true_type)
+    {
+        // past the end
+        return true;
+    }
+
+    template<std::size_t I, class Tuple, class Iterator>
+    bool
+    from(Tuple const& bn, Iterator const& it,
+        std::size_t skip, std::false_type)
+    {
+        using last = bool_constant<
+            I+1 == std::tuple_size<Tuple>::value>;
+        if(it.it_.index() != I+1)
+            return from<I+1>(bn, it, skip, last{});
+        if(! range(it.it_.template get<I+1>(),
+                asio::buffer_sequence_end(std::get<I>(bn)), skip))
+            return false;
+        return each<I+1>(bn, last{});
+    }
+};
+
+/*  A fixed capacity sequence of constant buffers.
+
+    Constructing the array from a buffer sequence copies the
+    first `N` non-empty buffers in a single pass, which makes
+    later iteration as cheap as iterating a plain array. This
+    is intended for calls to `write_some`, which may transfer
+    fewer octets than the sequence holds, on sequences such
+    as those produced by @ref http::serializer whose iterators
+    dispatch on every step.
+*/
+template<std::size_t N>
+class buffer_array
+{
+    typename std::aligned_storage<
+        N * sizeof(asio::const_buffer),
+        alignof(asio::const_buffer)>::type buf_;
+    std::size_t n_ = 0;
+
+    asio::const_buffer*
+    data()
+    {
+        return reinterpret_cast<
+            asio::const_buffer*>(&buf_);
+    }
+
+    asio::const_buffer const*
+    data() const
+    {
+        return reinterpret_cast<
+            asio::const_buffer const*>(&buf_);
+    }
+
+    void
+    copy(buffer_array const& other)
+    {
+        std::uninitialized_copy(
+            other.begin(), other.end(), data());
+        n_ = other.n_;
+    }
+
+    void
+    clear()
+    {
+        for(std::size_t i = 0; i < n_; ++i)
+            data()[i].~const_buffer();
+        n_ = 0;
+    }
+
+public:
+    using value_type = asio::const_buffer;
+
+    using const_iterator = asio::const_buffer const*;
+
+    ~buffer_array()
+    {
+        clear();
+    }
+
+    buffer_array() = default;
+
+    buffer_array(buffer_array const& other)
+    {
+        copy(other);
+    }
+
+    buffer_array&
+    operator=(buffer_array const& other)
+    {
+        if(this != &other)
+        {
+            clear();
+            copy(other);
+        }
+        return *this;
+    }
+
+    template<class ConstBufferSequence>
+    explicit
+    buffer_array(ConstBufferSequence const& buffers)
+    {
+        assign(buffers);
+    }
+
+    template<class ConstBufferSequence>
+    void
+    assign(ConstBufferSequence const& buffers)
+    {
+        clear();
+        buffers_flattener f{data(), data() + N};
+        f(buffers);
+        n_ = static_cast<std::size_t>(
+            f.position() - data());
+    }
+
+    const_iterator
+    begin() const
+    {
+        return data();
+    }
+
+    const_iterator
+    end() const
+    {
+        return data() + n_;
+    }
+};
+
+} // detail
+} // beast
+
+#endif
@@ -11,6 +11,7 @@
 #define BEAST_DETAIL_BUFFERS_REF_HPP
 
 #include <beast/core/type_traits.hpp>
+#include <beast/core/detail/buffer_array.hpp>
 #include <iterator>
 
 namespace beast {
@@ -22,6 +23,8 @@ class buffers_ref
 {
     BufferSequence const* buffers_;
 
+    friend class buffers_flattener;
+
 public:
     using const_iterator = typename
         buffer_sequence_iterator<BufferSequence>::type;
@@ -12,13 +12,34 @@
 
 #include <beast/core/detail/type_traits.hpp>
 #include <boost/assert.hpp>
+#include <boost/type_traits/has_trivial_copy.hpp>
+#include <boost/type_traits/has_trivial_destructor.hpp>
 #include <cstddef>
+#include <cstring>
 #include <tuple>
 #include <type_traits>
 
 namespace beast {
 namespace detail {
 
+template<class... TN>
+struct is_variant_trivial;
+
+template<>
+struct is_variant_trivial<>
+    : std::true_type
+{
+};
+
+template<class T, class... TN>
+struct is_variant_trivial<T, TN...>
+    : std::integral_constant<bool,
+        boost::has_trivial_copy<T>::value &&
+        boost::has_trivial_destructor<T>::value &&
+        is_variant_trivial<TN...>::value>
+{
+};
+
 // This simple variant gets the job done without
 // causing too much trouble with template depth:
 //
@@ -26,6 +47,9 @@ namespace detail {
 // * emplace() and get() support 1-based indexes only
 // * Basic exception guarantee
 // * Max 255 types
+// * Copies and destroys without visiting the
+//   alternatives when all of them are trivial,
+//   as most buffer sequence iterators are.
 //
 template<class... TN>
 class variant
@@ -33,6 +57,8 @@ class variant
     detail::aligned_union_t<1, TN...> buf_;
     unsigned char i_ = 0;
 
+    using is_trivial = is_variant_trivial<TN...>;
+
     template<std::size_t I>
     using type = typename std::tuple_element<
         I, std::tuple<TN...>>::type;
@@ -45,7 +71,7 @@ public:
 
     ~variant()
     {
-        destroy(C<0>{});
+        destroy(is_trivial{});
     }
 
     bool
@@ -66,13 +92,13 @@ public:
     // moved-from object becomes empty
     variant(variant&& other)
     {
-        i_ = other.move(&buf_, C<0>{});
+        i_ = other.move(&buf_, is_trivial{});
         other.i_ = 0;
     }
 
     variant(variant const& other)
     {
-        i_ = other.copy(&buf_, C<0>{});
+        i_ = other.copy(&buf_, is_trivial{});
     }
 
     // moved-from object becomes empty
@@ -80,8 +106,8 @@ public:
     {
         if(this != &other)
         {
-            destroy(C<0>{});
-            i_ = other.move(&buf_, C<0>{});
+            destroy(is_trivial{});
+            i_ = other.move(&buf_, is_trivial{});
             other.i_ = 0;
         }
         return *this;
@@ -91,8 +117,8 @@ public:
     {
         if(this != &other)
         {
-            destroy(C<0>{});
-            i_ = other.copy(&buf_, C<0>{});
+            destroy(is_trivial{});
+            i_ = other.copy(&buf_, is_trivial{});
         }
         return *this;
     }
@@ -101,7 +127,7 @@ public:
     void
     emplace(Args&&... args)
     {
-        destroy(C<0>{});
+        destroy(is_trivial{});
         new(&buf_) type<I-1>(
             std::forward<Args>(args)...);
         i_ = I;
@@ -128,10 +154,48 @@ public:
     void
     reset()
     {
-        destroy(C<0>{});
+        destroy(is_trivial{});
     }
 
 private:
+    void
+    destroy(std::true_type)
+    {
+        i_ = 0;
+    }
+
+    void
+    destroy(std::false_type)
+    {
+        destroy(C<0>{});
+    }
+
+    unsigned char
+    move(void* dest, std::true_type)
+    {
+        std::memcpy(dest, &buf_, sizeof(buf_));
+        return i_;
+    }
+
+    unsigned char
+    move(void* dest, std::false_type)
+    {
+        return move(dest, C<0>{});
+    }
+
+    unsigned char
+    copy(void* dest, std::true_type) const
+    {
+        std::memcpy(dest, &buf_, sizeof(buf_));
+        return i_;
+    }
+
+    unsigned char
+    copy(void* dest, std::false_type) const
+    {
+        return copy(dest, C<0>{});
+    }
+
     void
     destroy(C<0>)
     {
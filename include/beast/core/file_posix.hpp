@@ -141,6 +141,19 @@ public:
     void
     seek(std::uint64_t offset, error_code& ec);
 
+    /** Advise the system that a range of the file will be read soon
+
+        This allows the system to start reading the range in the
+        background, using `posix_fadvise` where available. The
+        advice is only a hint, and errors are ignored.
+
+        @param offset The offset in bytes from the beginning of the file
+
+        @param n The number of bytes
+    */
+    void
+    prefetch(std::uint64_t offset, std::uint64_t n) const;
+
     /** Read from the open file
 
         @param buffer The buffer for storing the result of the read
@@ -19,6 +19,54 @@
 
 namespace beast {
 
+/** Settings which control how a @ref basic_flat_buffer manages memory.
+
+    The default settings grow the buffer to what is needed,
+    move the readable bytes to the front whenever that makes
+    room, and keep the storage until the buffer is destroyed.
+
+    @par Example
+    Settings suited to reading pipelined requests:
+    @code
+    flat_buffer_policy policy;
+    policy.growth_factor = 2;
+    policy.compact_ratio = 0.5f;
+    policy.shrink_after = 64;
+    buffer.policy(policy);
+    @endcode
+*/
+struct flat_buffer_policy
+{
+    /** The growth of the capacity when reallocating.
+
+        When the buffer is reallocated, the new capacity is at
+        least the old capacity multiplied by this factor, so a
+        buffer which keeps growing is reallocated a logarithmic
+        number of times. Values of one or less disable this.
+    */
+    float growth_factor = 0;
+
+    /** The unused space which justifies moving the readable bytes.
+
+        Readable bytes are moved to the front of the buffer only
+        when the space before them is at least this fraction of
+        the capacity. Otherwise, a @ref basic_flat_buffer::prepare
+        which does not fit after the readable bytes reallocates,
+        and @ref read_size asks only for the space after the
+        readable bytes. Zero moves the bytes whenever needed.
+    */
+    float compact_ratio = 0;
+
+    /** The number of times the buffer empties before shrinking.
+
+        After @ref basic_flat_buffer::consume has emptied the buffer
+        this many times, the storage is released if no call to
+        prepare in that period needed more than a quarter of the
+        capacity. Zero keeps the storage.
+    */
+    std::size_t shrink_after = 0;
+};
+
 /** A linear dynamic buffer.
 
     Objects of this type meet the requirements of @b DynamicBuffer
@@ -77,6 +125,9 @@ class basic_flat_buffer
     char* last_;
     char* end_;
     std::size_t max_;
+    flat_buffer_policy policy_;
+    std::size_t idle_ = 0;  // times emptied since the last check
+    std::size_t peak_ = 0;  // largest size needed since the last check
 
 public:
     /// The type of allocator used.
@@ -241,6 +292,24 @@ public:
         return dist(begin_, end_);
     }
 
+    /// Returns the settings which control memory management.
+    flat_buffer_policy const&
+    policy() const
+    {
+        return policy_;
+    }
+
+    /** Set the settings which control memory management.
+
+        The settings apply to later calls, the current
+        storage is not changed.
+    */
+    void
+    policy(flat_buffer_policy const& value)
+    {
+        policy_ = value;
+    }
+
     /// Get a list of buffers that represent the input sequence.
     const_buffers_type
     data() const
@@ -300,7 +369,18 @@ public:
         basic_flat_buffer<Alloc>& lhs,
         basic_flat_buffer<Alloc>& rhs);
 
+#if ! BEAST_DOXYGEN
+    template<class Alloc>
+    friend
+    std::size_t
+    read_size_helper(
+        basic_flat_buffer<Alloc>& buffer, std::size_t max_size);
+#endif
+
 private:
+    bool
+    should_compact() const;
+
     void
     reset();
 
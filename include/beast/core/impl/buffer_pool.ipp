@@ -0,0 +1,565 @@
+//
+// Copyright (c) 2016-2017 Vinnie Falco (vinnie dot falco at gmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/boostorg/beast
+//
+
+#ifndef BEAST_CORE_IMPL_BUFFER_POOL_IPP
+#define BEAST_CORE_IMPL_BUFFER_POOL_IPP
+
+#include <boost/assert.hpp>
+#include <atomic>
+#include <mutex>
+
+#if BEAST_USE_HUGE_PAGES
+#include <sys/mman.h>
+#endif
+
+namespace beast {
+namespace detail {
+
+// A free block. Blocks moved to the depot travel in
+// batches, and the first block of a batch holds the
+// number of blocks in it.
+struct pool_block
+{
+    pool_block* next;       // next block in the batch
+    pool_block* next_batch; // next batch in the depot
+    std::size_t count;      // number of blocks in the batch
+};
+
+static_assert(sizeof(pool_block) <= buffer_pool::min_size,
+    "min_size requirements not met");
+
+// Returns the size class for a request of n octets
+inline
+std::size_t
+pool_class(std::size_t n)
+{
+    BOOST_ASSERT(n <= buffer_pool::max_size);
+    std::size_t k = 0;
+    for(auto m = (n - 1) / buffer_pool::min_size; n > 0 && m > 0; m >>= 1)
+        ++k;
+    return k;
+}
+
+inline
+std::size_t
+pool_block_size(std::size_t k)
+{
+    return buffer_pool::min_size << k;
+}
+
+// Returns the number of blocks moved to or from the depot
+// at once. A thread cache holds at most twice this many.
+inline
+std::size_t
+pool_batch(std::size_t k)
+{
+    auto const n = (256 * 1024) / pool_block_size(k);
+    return n < 1 ? 1 : (n > 32 ? 32 : n);
+}
+
+struct pool_counters
+{
+    std::atomic<std::uint64_t> allocations{0};
+    std::atomic<std::uint64_t> deallocations{0};
+    std::atomic<std::uint64_t> cache_hits{0};
+    std::atomic<std::uint64_t> bytes_allocated{0};
+    std::atomic<std::uint64_t> bytes_deallocated{0};
+
+    // Used only by the thread owning the counter, this
+    // avoids the cost of an atomic read-modify-write.
+    static
+    void
+    bump(std::atomic<std::uint64_t>& c, std::uint64_t n)
+    {
+        c.store(c.load(std::memory_order_relaxed) + n,
+            std::memory_order_relaxed);
+    }
+
+    void
+    add_to(buffer_pool::statistics& s) const
+    {
+        s.allocations +=
+            allocations.load(std::memory_order_relaxed);
+        s.deallocations +=
+            deallocations.load(std::memory_order_relaxed);
+        s.cache_hits +=
+            cache_hits.load(std::memory_order_relaxed);
+        s.bytes_in_use +=
+            bytes_allocated.load(std::memory_order_relaxed) -
+            bytes_deallocated.load(std::memory_order_relaxed);
+    }
+
+    void
+    add_to(pool_counters& c) const
+    {
+        c.allocations.fetch_add(allocations.load(
+            std::memory_order_relaxed), std::memory_order_relaxed);
+        c.deallocations.fetch_add(deallocations.load(
+            std::memory_order_relaxed), std::memory_order_relaxed);
+        c.cache_hits.fetch_add(cache_hits.load(
+            std::memory_order_relaxed), std::memory_order_relaxed);
+        c.bytes_allocated.fetch_add(bytes_allocated.load(
+            std::memory_order_relaxed), std::memory_order_relaxed);
+        c.bytes_deallocated.fetch_add(bytes_deallocated.load(
+            std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+};
+
+class pool_cache;
+
+/*  The state shared by all threads.
+
+    Each size class has its own list of batches and its own
+    mutex. The depot is never destroyed, so that blocks may be
+    returned to it by objects destroyed at any point during
+    program exit.
+*/
+class pool_depot
+{
+    struct bin
+    {
+        std::mutex m;
+        pool_block* head = nullptr;
+    };
+
+    bin bins_[buffer_pool::classes];
+    std::mutex slab_mutex_;
+    char* slab_ = nullptr;
+    std::size_t slab_left_ = 0;
+
+public:
+    std::atomic<bool> huge_pages{false};
+    std::atomic<std::uint64_t> transfers{0};
+    std::atomic<std::uint64_t> large{0};
+    std::atomic<std::uint64_t> reserved{0};
+    std::atomic<std::uint64_t> huge{0};
+
+    // Counters for threads which exited, and for
+    // operations which did not use a thread cache
+    pool_counters shared;
+
+    std::mutex registry_mutex;
+    pool_cache* caches = nullptr;
+
+    static
+    pool_depot&
+    get()
+    {
+        static pool_depot& d = *new pool_depot;
+        return d;
+    }
+
+    // Add a batch of blocks
+    void
+    push(std::size_t k, pool_block* batch)
+    {
+        BOOST_ASSERT(batch && batch->count > 0);
+        auto& b = bins_[k];
+        std::lock_guard<std::mutex> lock(b.m);
+        batch->next_batch = b.head;
+        b.head = batch;
+    }
+
+    // Remove a batch of blocks, or return `nullptr`
+    pool_block*
+    pop(std::size_t k)
+    {
+        auto& b = bins_[k];
+        std::lock_guard<std::mutex> lock(b.m);
+        auto const batch = b.head;
+        if(batch)
+            b.head = batch->next_batch;
+        return batch;
+    }
+
+    // Return a block which was never used
+    void*
+    fresh(std::size_t k)
+    {
+        auto const size = pool_block_size(k);
+        std::lock_guard<std::mutex> lock(slab_mutex_);
+        if(slab_left_ < size)
+        {
+            // Put the rest of the slab in the depot as
+            // blocks of smaller sizes, largest first, so
+            // that each block stays aligned.
+            while(slab_left_ >= buffer_pool::min_size)
+            {
+                auto j = pool_class(slab_left_);
+                if(pool_block_size(j) > slab_left_)
+                    --j;
+                auto const b = reinterpret_cast<pool_block*>(slab_);
+                b->next = nullptr;
+                b->count = 1;
+                push(j, b);
+                slab_ += pool_block_size(j);
+                slab_left_ -= pool_block_size(j);
+            }
+            slab_ = new_slab();
+            slab_left_ = buffer_pool::slab_size;
+        }
+        auto const p = slab_;
+        slab_ += size;
+        slab_left_ -= size;
+        return p;
+    }
+
+private:
+    char*
+    new_slab()
+    {
+        auto const size = buffer_pool::slab_size;
+    #if BEAST_USE_HUGE_PAGES
+        if(huge_pages.load(std::memory_order_relaxed))
+        {
+        #ifdef MAP_HUGETLB
+            auto p = ::mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+            if(p != MAP_FAILED)
+            {
+                reserved.fetch_add(size, std::memory_order_relaxed);
+                huge.fetch_add(size, std::memory_order_relaxed);
+                return static_cast<char*>(p);
+            }
+        #endif
+            // Map twice the size and trim both ends, so the
+            // slab is aligned and can be a transparent huge page.
+            auto const q = ::mmap(nullptr, 2 * size,
+                PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if(q == MAP_FAILED)
+                BOOST_THROW_EXCEPTION(std::bad_alloc{});
+            auto const first = static_cast<char*>(q);
+            auto const aligned = first + ((size - (
+                reinterpret_cast<std::uintptr_t>(first) % size)) % size);
+            if(aligned != first)
+                ::munmap(first, aligned - first);
+            if(aligned + size != first + 2 * size)
+                ::munmap(aligned + size,
+                    (first + 2 * size) - (aligned + size));
+        #ifdef MADV_HUGEPAGE
+            ::madvise(aligned, size, MADV_HUGEPAGE);
+        #endif
+            reserved.fetch_add(size, std::memory_order_relaxed);
+            return aligned;
+        }
+    #endif
+        auto const p = static_cast<char*>(::operator new(size));
+        reserved.fetch_add(size, std::memory_order_relaxed);
+        return p;
+    }
+};
+
+/*  A list of free blocks for each size class.
+
+    A cache is used by one thread at a time. It is registered
+    with the depot so that its counters can be read, and
+    returns its blocks to the depot when destroyed.
+*/
+class pool_cache
+{
+    struct list
+    {
+        pool_block* head = nullptr;
+        std::size_t count = 0;
+    };
+
+    list lists_[buffer_pool::classes];
+
+public:
+    pool_counters counters;
+    pool_cache* prev = nullptr;
+    pool_cache* next = nullptr;
+
+    pool_cache()
+    {
+        auto& d = pool_depot::get();
+        std::lock_guard<std::mutex> lock(d.registry_mutex);
+        next = d.caches;
+        if(next)
+            next->prev = this;
+        d.caches = this;
+    }
+
+    ~pool_cache()
+    {
+        auto& d = pool_depot::get();
+        for(std::size_t k = 0; k < buffer_pool::classes; ++k)
+        {
+            auto& l = lists_[k];
+            if(l.head)
+            {
+                l.head->count = l.count;
+                d.push(k, l.head);
+                d.transfers.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+        std::lock_guard<std::mutex> lock(d.registry_mutex);
+        counters.add_to(d.shared);
+        if(prev)
+            prev->next = next;
+        else
+            d.caches = next;
+        if(next)
+            next->prev = prev;
+    }
+
+    void*
+    allocate(std::size_t k)
+    {
+        pool_counters::bump(counters.allocations, 1);
+        pool_counters::bump(counters.bytes_allocated,
+            pool_block_size(k));
+        auto& l = lists_[k];
+        if(l.head)
+        {
+            pool_counters::bump(counters.cache_hits, 1);
+            auto const b = l.head;
+            l.head = b->next;
+            --l.count;
+            return b;
+        }
+        auto& d = pool_depot::get();
+        if(auto const b = d.pop(k))
+        {
+            d.transfers.fetch_add(1, std::memory_order_relaxed);
+            l.head = b->next;
+            l.count = b->count - 1;
+            return b;
+        }
+        return d.fresh(k);
+    }
+
+    void
+    deallocate(void* p, std::size_t k)
+    {
+        pool_counters::bump(counters.deallocations, 1);
+        pool_counters::bump(counters.bytes_deallocated,
+            pool_block_size(k));
+        auto& l = lists_[k];
+        auto const b = static_cast<pool_block*>(p);
+        b->next = l.head;
+        l.head = b;
+        ++l.count;
+        auto const batch = pool_batch(k);
+        if(l.count < 2 * batch)
+            return;
+        // Keep the blocks used most recently, which are
+        // more likely to be in the CPU cache.
+        auto last = l.head;
+        for(std::size_t i = 1; i < batch; ++i)
+            last = last->next;
+        auto const rest = last->next;
+        last->next = nullptr;
+        rest->count = l.count - batch;
+        l.count = batch;
+        auto& d = pool_depot::get();
+        d.push(k, rest);
+        d.transfers.fetch_add(1, std::memory_order_relaxed);
+    }
+};
+
+#ifndef BEAST_NO_THREAD_LOCAL
+
+// Trivially destructible, so that it may still be used
+// while other thread_local objects are destroyed.
+struct pool_tls
+{
+    pool_cache* cache;
+    bool done;
+};
+
+inline
+pool_tls&
+pool_state()
+{
+    static thread_local pool_tls s{nullptr, false};
+    return s;
+}
+
+struct pool_cache_holder
+{
+    pool_cache cache;
+
+    pool_cache_holder()
+    {
+        pool_state().cache = &cache;
+    }
+
+    ~pool_cache_holder()
+    {
+        pool_state() = {nullptr, true};
+    }
+};
+
+// Returns the cache for this thread, or `nullptr`
+// if the thread's cache was already destroyed.
+inline
+pool_cache*
+pool_local()
+{
+    auto& s = pool_state();
+    if(s.cache)
+        return s.cache;
+    if(s.done)
+        return nullptr;
+    static thread_local pool_cache_holder h;
+    return s.cache;
+}
+
+#else
+
+inline
+std::mutex&
+pool_mutex()
+{
+    static std::mutex m;
+    return m;
+}
+
+inline
+pool_cache&
+pool_shared()
+{
+    static pool_cache& c = *new pool_cache;
+    return c;
+}
+
+#endif
+
+// Allocate without a thread cache
+inline
+void*
+pool_allocate_direct(std::size_t k)
+{
+    auto& d = pool_depot::get();
+    d.shared.allocations.fetch_add(1, std::memory_order_relaxed);
+    d.shared.bytes_allocated.fetch_add(
+        pool_block_size(k), std::memory_order_relaxed);
+    if(auto const b = d.pop(k))
+    {
+        if(b->next)
+        {
+            b->next->count = b->count - 1;
+            d.push(k, b->next);
+        }
+        return b;
+    }
+    return d.fresh(k);
+}
+
+// Deallocate without a thread cache
+inline
+void
+pool_deallocate_direct(void* p, std::size_t k)
+{
+    auto& d = pool_depot::get();
+    d.shared.deallocations.fetch_add(1, std::memory_order_relaxed);
+    d.shared.bytes_deallocated.fetch_add(
+        pool_block_size(k), std::memory_order_relaxed);
+    auto const b = static_cast<pool_block*>(p);
+    b->next = nullptr;
+    b->count = 1;
+    d.push(k, b);
+}
+
+} // detail
+
+inline
+void*
+buffer_pool::
+allocate(std::size_t n)
+{
+    if(n > max_size)
+    {
+        auto& d = detail::pool_depot::get();
+        auto const p = ::operator new(n);
+        d.large.fetch_add(1, std::memory_order_relaxed);
+        d.shared.allocations.fetch_add(
+            1, std::memory_order_relaxed);
+        d.shared.bytes_allocated.fetch_add(
+            n, std::memory_order_relaxed);
+        return p;
+    }
+    auto const k = detail::pool_class(n);
+#ifndef BEAST_NO_THREAD_LOCAL
+    if(auto const c = detail::pool_local())
+        return c->allocate(k);
+    return detail::pool_allocate_direct(k);
+#else
+    std::lock_guard<std::mutex> lock(detail::pool_mutex());
+    return detail::pool_shared().allocate(k);
+#endif
+}
+
+inline
+void
+buffer_pool::
+deallocate(void* p, std::size_t n)
+{
+    if(! p)
+        return;
+    if(n > max_size)
+    {
+        auto& d = detail::pool_depot::get();
+        ::operator delete(p);
+        d.shared.deallocations.fetch_add(
+            1, std::memory_order_relaxed);
+        d.shared.bytes_deallocated.fetch_add(
+            n, std::memory_order_relaxed);
+        return;
+    }
+    auto const k = detail::pool_class(n);
+#ifndef BEAST_NO_THREAD_LOCAL
+    if(auto const c = detail::pool_local())
+        return c->deallocate(p, k);
+    detail::pool_deallocate_direct(p, k);
+#else
+    std::lock_guard<std::mutex> lock(detail::pool_mutex());
+    detail::pool_shared().deallocate(p, k);
+#endif
+}
+
+inline
+auto
+buffer_pool::
+stats() ->
+    statistics
+{
+    auto& d = detail::pool_depot::get();
+    statistics s;
+    {
+        std::lock_guard<std::mutex> lock(d.registry_mutex);
+        d.shared.add_to(s);
+        for(auto c = d.caches; c; c = c->next)
+            c->counters.add_to(s);
+    }
+    s.depot_transfers =
+        d.transfers.load(std::memory_order_relaxed);
+    s.large_allocations =
+        d.large.load(std::memory_order_relaxed);
+    s.bytes_reserved =
+        d.reserved.load(std::memory_order_relaxed);
+    s.bytes_huge_pages =
+        d.huge.load(std::memory_order_relaxed);
+    return s;
+}
+
+inline
+void
+buffer_pool::
+huge_pages(bool value)
+{
+    detail::pool_depot::get().huge_pages.store(
+        value, std::memory_order_relaxed);
+}
+
+} // beast
+
+#endif
@@ -0,0 +1,602 @@
+//
+// Copyright (c) 2016-2017 Vinnie Falco (vinnie dot falco at gmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/boostorg/beast
+//
+
+#ifndef BEAST_IMPL_BUFFERED_WRITE_STREAM_IPP
+#define BEAST_IMPL_BUFFERED_WRITE_STREAM_IPP
+
+#include <beast/core/bind_handler.hpp>
+#include <beast/core/buffers_cat.hpp>
+#include <beast/core/error.hpp>
+#include <beast/core/type_traits.hpp>
+#include <beast/core/detail/config.hpp>
+#include <asio/associated_allocator.hpp>
+#include <asio/associated_executor.hpp>
+#include <asio/executor_work_guard.hpp>
+#include <asio/handler_continuation_hook.hpp>
+#include <asio/handler_invoke_hook.hpp>
+#include <asio/post.hpp>
+#include <boost/throw_exception.hpp>
+
+namespace beast {
+
+template<class Stream, class DynamicBuffer>
+template<class ConstBufferSequence, class Handler>
+class buffered_write_stream<
+    Stream, DynamicBuffer>::write_some_op
+{
+    buffered_write_stream& s_;
+    asio::executor_work_guard<decltype(
+        std::declval<Stream&>().get_executor())> wg_;
+    ConstBufferSequence b_;
+    Handler h_;
+    int step_ = 0;
+
+public:
+    write_some_op(write_some_op&&) = default;
+    write_some_op(write_some_op const&) = delete;
+
+    template<class DeducedHandler>
+    write_some_op(DeducedHandler&& h,
+        buffered_write_stream& s,
+            ConstBufferSequence const& b)
+        : s_(s)
+        , wg_(s_.get_executor())
+        , b_(b)
+        , h_(std::forward<DeducedHandler>(h))
+    {
+    }
+
+    using allocator_type =
+        asio::associated_allocator_t<Handler>;
+
+    allocator_type
+    get_allocator() const noexcept
+    {
+        return (asio::get_associated_allocator)(h_);
+    }
+
+    using executor_type =
+        asio::associated_executor_t<Handler, decltype(
+            std::declval<buffered_write_stream&>().get_executor())>;
+
+    executor_type
+    get_executor() const noexcept
+    {
+        return (asio::get_associated_executor)(
+            h_, s_.get_executor());
+    }
+
+    void
+    operator()(
+        error_code ec = {},
+        std::size_t bytes_transferred = 0);
+
+    friend
+    bool asio_handler_is_continuation(write_some_op* op)
+    {
+        using asio::asio_handler_is_continuation;
+        return op->step_ > 1 ||
+            asio_handler_is_continuation(
+                std::addressof(op->h_));
+    }
+
+    template<class Function>
+    friend
+    void asio_handler_invoke(Function&& f, write_some_op* op)
+    {
+        using asio::asio_handler_invoke;
+        asio_handler_invoke(f, std::addressof(op->h_));
+    }
+};
+
+template<class Stream, class DynamicBuffer>
+template<class ConstBufferSequence, class Handler>
+void
+buffered_write_stream<Stream, DynamicBuffer>::
+write_some_op<ConstBufferSequence, Handler>::operator()(
+    error_code ec, std::size_t bytes_transferred)
+{
+    switch(step_)
+    {
+    case 0:
+        if(s_.writing_)
+        {
+            // wait for the automatic flush
+            step_ = 1;
+            return s_.paused_.emplace(std::move(*this));
+        }
+        break;
+
+    case 1:
+        // resume
+        step_ = 2;
+        return asio::post(
+            s_.get_executor(), std::move(*this));
+
+    case 2:
+        break;
+
+    case 3:
+    {
+        // gather write
+        s_.writing_ = false;
+        if(ec)
+            goto upcall;
+        auto const size = s_.buffer_.size();
+        if(bytes_transferred > size)
+        {
+            s_.buffer_.consume(size);
+            bytes_transferred -= size;
+            goto upcall;
+        }
+        s_.buffer_.consume(bytes_transferred);
+        bytes_transferred = 0;
+        break;
+    }
+
+    case 4:
+        goto upcall;
+    }
+    if(s_.ec_)
+    {
+        ec = s_.ec_;
+        s_.ec_ = {};
+    }
+    else if(s_.fits(b_))
+    {
+        bytes_transferred = s_.append(b_);
+    }
+    else
+    {
+        step_ = 3;
+        s_.writing_ = true;
+        return s_.next_layer_.async_write_some(
+            buffers_cat(s_.buffer_.data(), b_),
+                std::move(*this));
+    }
+    if(step_ == 0)
+    {
+        // The completion is queued ahead of the
+        // automatic flush, so that further writes
+        // from the handler are coalesced.
+        auto& s = s_;
+        step_ = 4;
+        asio::post(s.get_executor(),
+            bind_handler(std::move(*this),
+                ec, bytes_transferred));
+        return s.schedule_flush();
+    }
+    s_.schedule_flush();
+upcall:
+    h_(ec, bytes_transferred);
+}
+
+//------------------------------------------------------------------------------
+
+template<class Stream, class DynamicBuffer>
+template<class Handler>
+class buffered_write_stream<
+    Stream, DynamicBuffer>::flush_op
+{
+    buffered_write_stream& s_;
+    asio::executor_work_guard<decltype(
+        std::declval<Stream&>().get_executor())> wg_;
+    Handler h_;
+    int step_ = 0;
+
+public:
+    flush_op(flush_op&&) = default;
+    flush_op(flush_op const&) = delete;
+
+    template<class DeducedHandler>
+    flush_op(DeducedHandler&& h,
+        buffered_write_stream& s)
+        : s_(s)
+        , wg_(s_.get_executor())
+        , h_(std::forward<DeducedHandler>(h))
+    {
+    }
+
+    using allocator_type =
+        asio::associated_allocator_t<Handler>;
+
+    allocator_type
+    get_allocator() const noexcept
+    {
+        return (asio::get_associated_allocator)(h_);
+    }
+
+    using executor_type =
+        asio::associated_executor_t<Handler, decltype(
+            std::declval<buffered_write_stream&>().get_executor())>;
+
+    executor_type
+    get_executor() const noexcept
+    {
+        return (asio::get_associated_executor)(
+            h_, s_.get_executor());
+    }
+
+    void
+    operator()(
+        error_code ec = {},
+        std::size_t bytes_transferred = 0);
+
+    friend
+    bool asio_handler_is_continuation(flush_op* op)
+    {
+        using asio::asio_handler_is_continuation;
+        return op->step_ > 1 ||
+            asio_handler_is_continuation(
+                std::addressof(op->h_));
+    }
+
+    template<class Function>
+    friend
+    void asio_handler_invoke(Function&& f, flush_op* op)
+    {
+        using asio::asio_handler_invoke;
+        asio_handler_invoke(f, std::addressof(op->h_));
+    }
+};
+
+template<class Stream, class DynamicBuffer>
+template<class Handler>
+void
+buffered_write_stream<Stream, DynamicBuffer>::
+flush_op<Handler>::operator()(
+    error_code ec, std::size_t bytes_transferred)
+{
+    switch(step_)
+    {
+    case 0:
+        if(s_.writing_)
+        {
+            // wait for the automatic flush
+            step_ = 1;
+            return s_.paused_.emplace(std::move(*this));
+        }
+        if(s_.ec_ || s_.buffer_.size() == 0)
+        {
+            ec = s_.ec_;
+            s_.ec_ = {};
+            step_ = 4;
+            return asio::post(
+                s_.get_executor(),
+                bind_handler(std::move(*this), ec));
+        }
+        break;
+
+    case 1:
+        // resume
+        step_ = 2;
+        return asio::post(
+            s_.get_executor(), std::move(*this));
+
+    case 2:
+        if(s_.ec_)
+        {
+            ec = s_.ec_;
+            s_.ec_ = {};
+            goto upcall;
+        }
+        break;
+
+    case 3:
+        s_.writing_ = false;
+        if(ec)
+            goto upcall;
+        s_.buffer_.consume(bytes_transferred);
+        break;
+
+    case 4:
+        goto upcall;
+    }
+    if(s_.buffer_.size() > 0)
+    {
+        step_ = 3;
+        s_.writing_ = true;
+        return s_.next_layer_.async_write_some(
+            s_.buffer_.data(), std::move(*this));
+    }
+upcall:
+    h_(ec);
+}
+
+//------------------------------------------------------------------------------
+
+// Writes the buffer in the background, once
+// the stream has gone a full pass through the
+// executor's queue without a buffered write.
+//
+template<class Stream, class DynamicBuffer>
+class buffered_write_stream<
+    Stream, DynamicBuffer>::auto_flush_op
+{
+    buffered_write_stream& s_;
+    std::uint64_t writes_;
+
+public:
+    explicit
+    auto_flush_op(buffered_write_stream& s)
+        : s_(s)
+        , writes_(s.writes_)
+    {
+    }
+
+    using executor_type = typename
+        buffered_write_stream::executor_type;
+
+    executor_type
+    get_executor() const noexcept
+    {
+        return s_.get_executor();
+    }
+
+    void
+    operator()();
+
+    void
+    operator()(error_code ec,
+        std::size_t bytes_transferred);
+};
+
+template<class Stream, class DynamicBuffer>
+void
+buffered_write_stream<Stream, DynamicBuffer>::
+auto_flush_op::operator()()
+{
+    if(s_.writes_ != writes_)
+    {
+        // more writes are coming
+        writes_ = s_.writes_;
+        return asio::post(
+            s_.get_executor(), std::move(*this));
+    }
+    if(s_.writing_ || s_.buffer_.size() == 0)
+    {
+        // flushed by another operation
+        s_.flushing_ = false;
+        return;
+    }
+    s_.writing_ = true;
+    s_.next_layer_.async_write_some(
+        s_.buffer_.data(), std::move(*this));
+}
+
+template<class Stream, class DynamicBuffer>
+void
+buffered_write_stream<Stream, DynamicBuffer>::
+auto_flush_op::operator()(
+    error_code ec, std::size_t bytes_transferred)
+{
+    if(! ec)
+    {
+        s_.buffer_.consume(bytes_transferred);
+        if(s_.buffer_.size() > 0)
+            return s_.next_layer_.async_write_some(
+                s_.buffer_.data(), std::move(*this));
+    }
+    else
+    {
+        s_.ec_ = ec;
+    }
+    s_.writing_ = false;
+    s_.flushing_ = false;
+    s_.paused_.maybe_invoke();
+}
+
+//------------------------------------------------------------------------------
+
+template<class Stream, class DynamicBuffer>
+template<class... Args>
+buffered_write_stream<Stream, DynamicBuffer>::
+buffered_write_stream(Args&&... args)
+    : next_layer_(std::forward<Args>(args)...)
+{
+}
+
+template<class Stream, class DynamicBuffer>
+void
+buffered_write_stream<Stream, DynamicBuffer>::
+flush()
+{
+    error_code ec;
+    flush(ec);
+    if(ec)
+        BOOST_THROW_EXCEPTION(system_error{ec});
+}
+
+template<class Stream, class DynamicBuffer>
+void
+buffered_write_stream<Stream, DynamicBuffer>::
+flush(error_code& ec)
+{
+    static_assert(is_sync_write_stream<next_layer_type>::value,
+        "SyncWriteStream requirements not met");
+    if(ec_)
+    {
+        ec = ec_;
+        ec_ = {};
+        return;
+    }
+    while(buffer_.size() > 0)
+    {
+        auto const n =
+            next_layer_.write_some(buffer_.data(), ec);
+        if(ec)
+            return;
+        buffer_.consume(n);
+    }
+    ec.assign(0, ec.category());
+}
+
+template<class Stream, class DynamicBuffer>
+template<class FlushHandler>
+ASIO_INITFN_RESULT_TYPE(
+    FlushHandler, void(error_code))
+buffered_write_stream<Stream, DynamicBuffer>::
+async_flush(FlushHandler&& handler)
+{
+    static_assert(is_async_write_stream<next_layer_type>::value,
+        "AsyncWriteStream requirements not met");
+    BEAST_HANDLER_INIT(
+        FlushHandler, void(error_code));
+    flush_op<ASIO_HANDLER_TYPE(
+        FlushHandler, void(error_code))>{
+            std::move(init.completion_handler), *this}();
+    return init.result.get();
+}
+
+template<class Stream, class DynamicBuffer>
+template<class MutableBufferSequence, class ReadHandler>
+ASIO_INITFN_RESULT_TYPE(
+    ReadHandler, void(error_code, std::size_t))
+buffered_write_stream<Stream, DynamicBuffer>::
+async_read_some(
+    MutableBufferSequence const& buffers,
+    ReadHandler&& handler)
+{
+    static_assert(is_async_read_stream<next_layer_type>::value,
+        "AsyncReadStream requirements not met");
+    static_assert(asio::is_mutable_buffer_sequence<
+        MutableBufferSequence>::value,
+            "MutableBufferSequence requirements not met");
+    static_assert(is_completion_handler<ReadHandler,
+        void(error_code, std::size_t)>::value,
+            "ReadHandler requirements not met");
+    return next_layer_.async_read_some(buffers,
+        std::forward<ReadHandler>(handler));
+}
+
+template<class Stream, class DynamicBuffer>
+template<class ConstBufferSequence>
+std::size_t
+buffered_write_stream<Stream, DynamicBuffer>::
+write_some(
+    ConstBufferSequence const& buffers)
+{
+    static_assert(is_sync_write_stream<next_layer_type>::value,
+        "SyncWriteStream requirements not met");
+    static_assert(asio::is_const_buffer_sequence<
+        ConstBufferSequence>::value,
+            "ConstBufferSequence requirements not met");
+    error_code ec;
+    auto n = write_some(buffers, ec);
+    if(ec)
+        BOOST_THROW_EXCEPTION(system_error{ec});
+    return n;
+}
+
+template<class Stream, class DynamicBuffer>
+template<class ConstBufferSequence>
+std::size_t
+buffered_write_stream<Stream, DynamicBuffer>::
+write_some(ConstBufferSequence const& buffers,
+    error_code& ec)
+{
+    static_assert(is_sync_write_stream<next_layer_type>::value,
+        "SyncWriteStream requirements not met");
+    static_assert(asio::is_const_buffer_sequence<
+        ConstBufferSequence>::value,
+            "ConstBufferSequence requirements not met");
+    if(ec_)
+    {
+        ec = ec_;
+        ec_ = {};
+        return 0;
+    }
+    for(;;)
+    {
+        if(fits(buffers))
+        {
+            ec.assign(0, ec.category());
+            return append(buffers);
+        }
+        // Send the buffered data and the new
+        // data together, with one call.
+        auto const n = next_layer_.write_some(
+            buffers_cat(buffer_.data(), buffers), ec);
+        if(ec)
+            return 0;
+        auto const size = buffer_.size();
+        if(n > size)
+        {
+            buffer_.consume(size);
+            return n - size;
+        }
+        buffer_.consume(n);
+    }
+}
+
+template<class Stream, class DynamicBuffer>
+template<class ConstBufferSequence, class WriteHandler>
+ASIO_INITFN_RESULT_TYPE(
+    WriteHandler, void(error_code, std::size_t))
+buffered_write_stream<Stream, DynamicBuffer>::
+async_write_some(
+    ConstBufferSequence const& buffers,
+    WriteHandler&& handler)
+{
+    static_assert(is_async_write_stream<next_layer_type>::value,
+        "AsyncWriteStream requirements not met");
+    static_assert(asio::is_const_buffer_sequence<
+        ConstBufferSequence>::value,
+            "ConstBufferSequence requirements not met");
+    if( buffer_.size() == 0 && capacity_ == 0 &&
+        ! writing_ && ! ec_)
+        return next_layer_.async_write_some(buffers,
+            std::forward<WriteHandler>(handler));
+    BEAST_HANDLER_INIT(
+        WriteHandler, void(error_code, std::size_t));
+    write_some_op<ConstBufferSequence, ASIO_HANDLER_TYPE(
+        WriteHandler, void(error_code, std::size_t))>{
+            std::move(init.completion_handler), *this, buffers}();
+    return init.result.get();
+}
+
+template<class Stream, class DynamicBuffer>
+template<class ConstBufferSequence>
+bool
+buffered_write_stream<Stream, DynamicBuffer>::
+fits(ConstBufferSequence const& buffers) const
+{
+    auto const size = buffer_.size();
+    return size <= capacity_ &&
+        asio::buffer_size(buffers) <= capacity_ - size;
+}
+
+template<class Stream, class DynamicBuffer>
+template<class ConstBufferSequence>
+std::size_t
+buffered_write_stream<Stream, DynamicBuffer>::
+append(ConstBufferSequence const& buffers)
+{
+    auto const n = asio::buffer_copy(
+        buffer_.prepare(asio::buffer_size(buffers)),
+            buffers);
+    buffer_.commit(n);
+    ++writes_;
+    return n;
+}
+
+template<class Stream, class DynamicBuffer>
+void
+buffered_write_stream<Stream, DynamicBuffer>::
+schedule_flush()
+{
+    if(! auto_flush_ || flushing_ || buffer_.size() == 0)
+        return;
+    flushing_ = true;
+    asio::post(get_executor(), auto_flush_op{*this});
+}
+
+} // beast
+
+#endif
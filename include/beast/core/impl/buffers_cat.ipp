@@ -45,6 +45,7 @@ class buffers_cat_view<Bn...>::const_iterator
             past_end> it_;
 
     friend class buffers_cat_view<Bn...>;
+    friend class detail::buffers_flattener;
 
     template<std::size_t I>
     using C = std::integral_constant<std::size_t, I>;
@@ -24,6 +24,7 @@
 # endif
 #endif
 
+#include <boost/core/ignore_unused.hpp>
 #include <limits>
 #include <fcntl.h>
 #include <sys/types.h>
@@ -275,6 +276,20 @@ seek(std::uint64_t offset, error_code& ec)
     ec.assign(0, ec.category());
 }
 
+inline
+void
+file_posix::
+prefetch(std::uint64_t offset, std::uint64_t n) const
+{
+#if BEAST_USE_POSIX_FADVISE
+    if(fd_ != -1)
+        ::posix_fadvise(fd_, static_cast<off_t>(offset),
+            static_cast<off_t>(n), POSIX_FADV_WILLNEED);
+#else
+    boost::ignore_unused(offset, n);
+#endif
+}
+
 inline
 std::size_t
 file_posix::
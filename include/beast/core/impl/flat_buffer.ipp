@@ -91,6 +91,7 @@ basic_flat_buffer(basic_flat_buffer&& other)
     , last_(out_)
     , end_(other.end_)
     , max_(other.max_)
+    , policy_(other.policy_)
 {
     other.begin_ = nullptr;
     other.in_ = nullptr;
@@ -104,6 +105,7 @@ basic_flat_buffer<Allocator>::
 basic_flat_buffer(basic_flat_buffer&& other,
         Allocator const& alloc)
     : detail::empty_base_optimization<base_alloc_type>(alloc)
+    , policy_(other.policy_)
 {
     if(this->member() != other.member())
     {
@@ -144,6 +146,7 @@ basic_flat_buffer(basic_flat_buffer const& other)
     , last_(nullptr)
     , end_(nullptr)
     , max_(other.max_)
+    , policy_(other.policy_)
 {
     copy_from(other);
 }
@@ -159,6 +162,7 @@ basic_flat_buffer(basic_flat_buffer const& other,
     , last_(nullptr)
     , end_(nullptr)
     , max_(other.max_)
+    , policy_(other.policy_)
 {
     copy_from(other);
 }
@@ -174,6 +178,7 @@ basic_flat_buffer(
     , last_(nullptr)
     , end_(nullptr)
     , max_(other.max_)
+    , policy_(other.policy_)
 {
     copy_from(other);
 }
@@ -190,6 +195,7 @@ basic_flat_buffer(basic_flat_buffer<OtherAlloc> const& other,
     , last_(nullptr)
     , end_(nullptr)
     , max_(other.max_)
+    , policy_(other.policy_)
 {
     copy_from(other);
 }
@@ -227,6 +233,7 @@ operator=(basic_flat_buffer<OtherAlloc> const& other) ->
 {
     reset();
     max_ = other.max_;
+    policy_ = other.policy_;
     copy_from(other);
     return *this;
 }
@@ -239,14 +246,34 @@ basic_flat_buffer<Allocator>::
 prepare(std::size_t n) ->
     mutable_buffers_type
 {
+    auto const len = size();
     if(n <= dist(out_, end_))
     {
         // existing capacity is sufficient
+        if(peak_ < len + n)
+            peak_ = len + n;
         last_ = out_ + n;
         return{out_, n};
     }
-    auto const len = size();
-    if(n <= capacity() - len)
+    // enforce maximum capacity
+    if(n > max_ - len)
+        BOOST_THROW_EXCEPTION(std::length_error{
+            "basic_flat_buffer overflow"});
+    if(peak_ < len + n)
+        peak_ = len + n;
+    auto new_size = (std::max<std::size_t>)(2 * len, len + n);
+    if(policy_.growth_factor > 1)
+    {
+        auto const grown = capacity() *
+            static_cast<double>(policy_.growth_factor);
+        if(grown >= static_cast<double>(max_))
+            new_size = max_;
+        else if(new_size < static_cast<std::size_t>(grown))
+            new_size = static_cast<std::size_t>(grown);
+    }
+    new_size = (std::min<std::size_t>)(max_, new_size);
+    if(n <= capacity() - len &&
+        (should_compact() || new_size <= capacity()))
     {
         // after a memmove,
         // existing capacity is sufficient
@@ -257,14 +284,7 @@ prepare(std::size_t n) ->
         last_ = out_ + n;
         return {out_, n};
     }
-    // enforce maximum capacity
-    if(n > max_ - len)
-        BOOST_THROW_EXCEPTION(std::length_error{
-            "basic_flat_buffer overflow"});
     // allocate a new buffer
-    auto const new_size = (std::min<std::size_t>)(
-        max_,
-        (std::max<std::size_t>)(2 * len, len + n));
     auto const p = alloc_traits::allocate(
         this->member(), new_size);
     if(begin_)
@@ -292,6 +312,23 @@ consume(std::size_t n)
     {
         in_ = begin_;
         out_ = begin_;
+        if(policy_.shrink_after > 0 &&
+            ++idle_ >= policy_.shrink_after)
+        {
+            // release storage which has gone unused
+            if(begin_ && peak_ <= capacity() / 4)
+            {
+                alloc_traits::deallocate(
+                    this->member(), begin_, capacity());
+                begin_ = nullptr;
+                in_ = nullptr;
+                out_ = nullptr;
+                last_ = nullptr;
+                end_ = nullptr;
+            }
+            idle_ = 0;
+            peak_ = 0;
+        }
         return;
     }
     in_ += n;
@@ -329,6 +366,16 @@ shrink_to_fit()
 
 //------------------------------------------------------------------------------
 
+template<class Allocator>
+inline
+bool
+basic_flat_buffer<Allocator>::
+should_compact() const
+{
+    return static_cast<float>(dist(begin_, in_)) >=
+        policy_.compact_ratio * static_cast<float>(capacity());
+}
+
 template<class Allocator>
 inline
 void
@@ -367,6 +414,7 @@ move_assign(basic_flat_buffer& other, std::true_type)
     last_ = out_;
     end_ = other.end_;
     max_ = other.max_;
+    policy_ = other.policy_;
     other.begin_ = nullptr;
     other.in_ = nullptr;
     other.out_ = nullptr;
@@ -383,6 +431,7 @@ move_assign(basic_flat_buffer& other, std::false_type)
     reset();
     if(this->member() != other.member())
     {
+        policy_ = other.policy_;
         copy_from(other);
         other.reset();
     }
@@ -400,6 +449,7 @@ copy_assign(basic_flat_buffer const& other, std::true_type)
 {
     reset();
     max_ = other.max_;
+    policy_ = other.policy_;
     this->member() = other.member();
     copy_from(other);
 }
@@ -412,6 +462,7 @@ copy_assign(basic_flat_buffer const& other, std::false_type)
 {
     reset();
     max_ = other.max_;
+    policy_ = other.policy_;
     copy_from(other);
 }
 
@@ -434,6 +485,9 @@ swap(basic_flat_buffer& other, std::true_type)
     using std::swap;
     swap(this->member(), other.member());
     swap(max_, other.max_);
+    swap(policy_, other.policy_);
+    swap(idle_, other.idle_);
+    swap(peak_, other.peak_);
     swap(begin_, other.begin_);
     swap(in_, other.in_);
     swap(out_, other.out_);
@@ -451,6 +505,9 @@ swap(basic_flat_buffer& other, std::false_type)
     BOOST_ASSERT(this->member() == other.member());
     using std::swap;
     swap(max_, other.max_);
+    swap(policy_, other.policy_);
+    swap(idle_, other.idle_);
+    swap(peak_, other.peak_);
     swap(begin_, other.begin_);
     swap(in_, other.in_);
     swap(out_, other.out_);
@@ -468,6 +525,26 @@ swap(
     lhs.swap(rhs);
 }
 
+template<class Allocator>
+std::size_t
+read_size_helper(
+    basic_flat_buffer<Allocator>& buffer, std::size_t max_size)
+{
+    BOOST_ASSERT(max_size >= 1);
+    auto const size = buffer.size();
+    auto const limit = buffer.max_size() - size;
+    BOOST_ASSERT(size <= buffer.max_size());
+    // While the readable bytes are not due to be moved,
+    // ask only for the space after them.
+    auto n = buffer.capacity() - size;
+    auto const tail = buffer.dist(buffer.out_, buffer.end_);
+    if(tail >= buffer.min_size && ! buffer.should_compact())
+        n = tail;
+    return (std::min<std::size_t>)(
+        (std::max<std::size_t>)(buffer.min_size, n),
+        (std::min<std::size_t>)(max_size, limit));
+}
+
 } // beast
 
 #endif
@@ -470,6 +470,8 @@ basic_multi_buffer(basic_multi_buffer&& other)
         other.out_ == other.list_.end();
     list_ = std::move(other.list_);
     out_ = at_end ? list_.end() : other.out_;
+    free_ = std::move(other.free_);
+    policy_ = other.policy_;
     other.in_size_ = 0;
     other.out_ = other.list_.end();
     other.in_pos_ = 0;
@@ -484,6 +486,7 @@ basic_multi_buffer(basic_multi_buffer&& other,
     : detail::empty_base_optimization<
         base_alloc_type>(alloc)
     , max_(other.max_)
+    , policy_(other.policy_)
 {
     if(this->member() != other.member())
     {
@@ -501,6 +504,7 @@ basic_multi_buffer(basic_multi_buffer&& other,
         in_pos_ = other.in_pos_;
         out_pos_ = other.out_pos_;
         out_end_ = other.out_end_;
+        free_ = std::move(other.free_);
         other.in_size_ = 0;
         other.out_ = other.list_.end();
         other.in_pos_ = 0;
@@ -518,6 +522,7 @@ basic_multi_buffer(basic_multi_buffer const& other)
             other.member()))
     , max_(other.max_)
     , out_(list_.end())
+    , policy_(other.policy_)
 {
     copy_from(other);
 }
@@ -530,6 +535,7 @@ basic_multi_buffer(basic_multi_buffer const& other,
         base_alloc_type>(alloc)
     , max_(other.max_)
     , out_(list_.end())
+    , policy_(other.policy_)
 {
     copy_from(other);
 }
@@ -554,6 +560,7 @@ basic_multi_buffer(
         base_alloc_type>(alloc)
     , max_(other.max_)
     , out_(list_.end())
+    , policy_(other.policy_)
 {
     copy_from(other);
 }
@@ -568,6 +575,7 @@ operator=(basic_multi_buffer&& other) ->
         return *this;
     reset();
     max_ = other.max_;
+    policy_ = other.policy_;
     move_assign(other, std::integral_constant<bool,
         alloc_traits::propagate_on_container_move_assignment::value>{});
     return *this;
@@ -596,10 +604,40 @@ operator=(
 {
     reset();
     max_ = other.max_;
+    policy_ = other.policy_;
     copy_from(other);
     return *this;
 }
 
+template<class Allocator>
+void
+basic_multi_buffer<Allocator>::
+policy(multi_buffer_policy const& value)
+{
+    policy_ = value;
+    auto const size = fixed_size();
+    for(auto it = free_.begin(); it != free_.end();)
+    {
+        // Elements of another size would never be used again
+        if(size != 0 && it->size() != size)
+        {
+            auto& e = *it;
+            it = free_.erase(it);
+            destroy_element(e);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+    while(free_.size() > policy_.free_elements)
+    {
+        auto& e = free_.back();
+        free_.pop_back();
+        destroy_element(e);
+    }
+}
+
 template<class Allocator>
 std::size_t
 basic_multi_buffer<Allocator>::
@@ -684,40 +722,49 @@ prepare(size_type n) ->
     #endif
     }
     BOOST_ASSERT(total <= max_);
-    if(! reuse.empty() || n > 0)
+    while(! reuse.empty())
     {
-        for(auto it = reuse.begin(); it != reuse.end();)
-        {
-            auto& e = *it++;
-            reuse.erase(list_.iterator_to(e));
-            auto const len = sizeof(e) + e.size();
-            alloc_traits::destroy(this->member(), &e);
-            alloc_traits::deallocate(this->member(),
-                reinterpret_cast<char*>(&e), len);
-        }
-        if(n > 0)
+        auto& e = reuse.front();
+        reuse.pop_front();
+        free_element(e);
+    }
+    if(n > 0 && policy_.element_size != 0)
+    {
+        // Every element has the same size
+        auto const size = fixed_size();
+        do
         {
-            static auto const growth_factor = 2.0f;
-            auto const size =
-                (std::min<std::size_t>)(
-                    max_ - total,
-                    (std::max<std::size_t>)({
-                        static_cast<std::size_t>(
-                            in_size_ * growth_factor - in_size_),
-                        512,
-                        n}));
-            auto& e = *reinterpret_cast<element*>(static_cast<
-                void*>(alloc_traits::allocate(this->member(),
-                    sizeof(element) + size)));
-            alloc_traits::construct(this->member(), &e, size);
+            auto& e = alloc_element(size, size);
             list_.push_back(e);
             if(out_ == list_.end())
                 out_ = list_.iterator_to(e);
-            out_end_ = n;
-        #if BEAST_MULTI_BUFFER_DEBUG_CHECK
-            debug_check();
-        #endif
+            out_end_ = (std::min)(n, e.size());
+            n -= out_end_;
         }
+        while(n > 0);
+    #if BEAST_MULTI_BUFFER_DEBUG_CHECK
+        debug_check();
+    #endif
+    }
+    else if(n > 0)
+    {
+        static auto const growth_factor = 2.0f;
+        auto const size =
+            (std::min<std::size_t>)(
+                max_ - total,
+                (std::max<std::size_t>)({
+                    static_cast<std::size_t>(
+                        in_size_ * growth_factor - in_size_),
+                    512,
+                    n}));
+        auto& e = alloc_element(n, size);
+        list_.push_back(e);
+        if(out_ == list_.end())
+            out_ = list_.iterator_to(e);
+        out_end_ = n;
+    #if BEAST_MULTI_BUFFER_DEBUG_CHECK
+        debug_check();
+    #endif
     }
     return mutable_buffers_type(*this);
 }
@@ -796,10 +843,7 @@ consume(size_type n)
             in_pos_ = 0;
             auto& e = list_.front();
             list_.erase(list_.iterator_to(e));
-            auto const len = sizeof(e) + e.size();
-            alloc_traits::destroy(this->member(), &e);
-            alloc_traits::deallocate(this->member(),
-                reinterpret_cast<char*>(&e), len);
+            free_element(e);
         #if BEAST_MULTI_BUFFER_DEBUG_CHECK
             debug_check();
         #endif
@@ -837,6 +881,69 @@ consume(size_type n)
     }
 }
 
+template<class Allocator>
+auto
+basic_multi_buffer<Allocator>::
+fixed_size() const ->
+    size_type
+{
+    if(policy_.element_size == 0)
+        return 0;
+    return policy_.element_size > sizeof(element) ?
+        policy_.element_size - sizeof(element) : 1;
+}
+
+template<class Allocator>
+auto
+basic_multi_buffer<Allocator>::
+alloc_element(size_type n, size_type size) ->
+    element&
+{
+    // Use the first kept element which holds `n` octets, or
+    // exactly `size` octets when the size is fixed, otherwise
+    // allocate one which holds `size` octets.
+    auto const fixed = fixed_size() != 0;
+    for(auto it = free_.begin(); it != free_.end(); ++it)
+    {
+        if(fixed ? it->size() == size : it->size() >= n)
+        {
+            auto& e = *it;
+            free_.erase(it);
+            return e;
+        }
+    }
+    auto& e = *reinterpret_cast<element*>(static_cast<
+        void*>(alloc_traits::allocate(this->member(),
+            sizeof(element) + size)));
+    alloc_traits::construct(this->member(), &e, size);
+    return e;
+}
+
+template<class Allocator>
+void
+basic_multi_buffer<Allocator>::
+free_element(element& e)
+{
+    auto const size = fixed_size();
+    if( free_.size() < policy_.free_elements &&
+        (size == 0 || e.size() == size))
+        free_.push_front(e);
+    else
+        destroy_element(e);
+}
+
+template<class Allocator>
+inline
+void
+basic_multi_buffer<Allocator>::
+destroy_element(element& e)
+{
+    auto const len = sizeof(e) + e.size();
+    alloc_traits::destroy(this->member(), &e);
+    alloc_traits::deallocate(this->member(),
+        reinterpret_cast<char*>(&e), len);
+}
+
 template<class Allocator>
 inline
 void
@@ -844,13 +951,9 @@ basic_multi_buffer<Allocator>::
 delete_list()
 {
     for(auto iter = list_.begin(); iter != list_.end();)
-    {
-        auto& e = *iter++;
-        auto const len = sizeof(e) + e.size();
-        alloc_traits::destroy(this->member(), &e);
-        alloc_traits::deallocate(this->member(),
-            reinterpret_cast<char*>(&e), len);
-    }
+        destroy_element(*iter++);
+    for(auto iter = free_.begin(); iter != free_.end();)
+        destroy_element(*iter++);
 }
 
 template<class Allocator>
@@ -861,6 +964,7 @@ reset()
 {
     delete_list();
     list_.clear();
+    free_.clear();
     out_ = list_.end();
     in_size_ = 0;
     in_pos_ = 0;
@@ -910,6 +1014,7 @@ move_assign(basic_multi_buffer& other, std::true_type)
         other.out_ == other.list_.end();
     list_ = std::move(other.list_);
     out_ = at_end ? list_.end() : other.out_;
+    free_ = std::move(other.free_);
 
     in_size_ = other.in_size_;
     in_pos_ = other.in_pos_;
@@ -932,6 +1037,7 @@ copy_assign(
 {
     reset();
     max_ = other.max_;
+    policy_ = other.policy_;
     copy_from(other);
 }
 
@@ -944,6 +1050,7 @@ copy_assign(
 {
     reset();
     max_ = other.max_;
+    policy_ = other.policy_;
     this->member() = other.member();
     copy_from(other);
 }
@@ -980,6 +1087,8 @@ swap(basic_multi_buffer& other, std::true_type)
     swap(in_pos_, other.in_pos_);
     swap(out_pos_, other.out_pos_);
     swap(out_end_, other.out_end_);
+    swap(free_, other.free_);
+    swap(policy_, other.policy_);
 }
 
 template<class Allocator>
@@ -1004,6 +1113,8 @@ swap(basic_multi_buffer& other, std::false_type)
     swap(in_pos_, other.in_pos_);
     swap(out_pos_, other.out_pos_);
     swap(out_end_, other.out_end_);
+    swap(free_, other.free_);
+    swap(policy_, other.policy_);
 }
 
 template<class Allocator>
@@ -0,0 +1,270 @@
+//
+// Copyright (c) 2016-2017 Vinnie Falco (vinnie dot falco at gmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/boostorg/beast
+//
+
+#ifndef BEAST_CORE_IMPL_RING_BUFFER_IPP
+#define BEAST_CORE_IMPL_RING_BUFFER_IPP
+
+#include <boost/assert.hpp>
+#include <boost/throw_exception.hpp>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace beast {
+
+namespace detail {
+
+inline
+std::size_t
+ring_buffer_page_size()
+{
+    static std::size_t const n =
+        static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+    return n;
+}
+
+/*  Map `size` octets of a new shared memory file twice,
+    at consecutive addresses. Returns the address of the
+    first view, or `nullptr` on failure.
+*/
+inline
+char*
+ring_buffer_map(std::size_t size, error_code& ec)
+{
+#ifdef MFD_CLOEXEC
+    unsigned const flags = MFD_CLOEXEC;
+#else
+    unsigned const flags = 1;
+#endif
+    auto const fd = static_cast<int>(::syscall(
+        SYS_memfd_create, "beast.ring_buffer", flags));
+    if(fd == -1)
+    {
+        ec.assign(errno, generic_category());
+        return nullptr;
+    }
+    char* p = nullptr;
+    int ev = 0;
+    if(::ftruncate(fd, static_cast<off_t>(size)) == 0)
+    {
+        // Reserve the address space first, so that
+        // nothing else can be mapped between the views.
+        auto const q = ::mmap(nullptr, 2 * size,
+            PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if(q != MAP_FAILED)
+        {
+            p = static_cast<char*>(q);
+            if( ::mmap(p, size, PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED ||
+                ::mmap(p + size, size, PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED)
+            {
+                ev = errno;
+                ::munmap(p, 2 * size);
+                p = nullptr;
+            }
+        }
+        else
+        {
+            ev = errno;
+        }
+    }
+    else
+    {
+        ev = errno;
+    }
+    // The mappings keep the file alive
+    ::close(fd);
+    if(! p)
+        ec.assign(ev, generic_category());
+    else
+        ec.assign(0, ec.category());
+    return p;
+}
+
+} // detail
+
+inline
+ring_buffer::
+~ring_buffer()
+{
+    release();
+}
+
+inline
+ring_buffer::
+ring_buffer(std::size_t limit)
+    : max_(limit)
+{
+}
+
+inline
+ring_buffer::
+ring_buffer(ring_buffer&& other)
+    : base_(other.base_)
+    , capacity_(other.capacity_)
+    , in_(other.in_)
+    , size_(other.size_)
+    , max_(other.max_)
+{
+    other.base_ = nullptr;
+    other.capacity_ = 0;
+    other.in_ = 0;
+    other.size_ = 0;
+    other.out_ = 0;
+}
+
+inline
+ring_buffer::
+ring_buffer(ring_buffer const& other)
+    : max_(other.max_)
+{
+    if(other.size_ > 0)
+    {
+        std::memcpy(prepare(other.size_).data(),
+            other.base_ + other.in_, other.size_);
+        commit(other.size_);
+    }
+}
+
+inline
+auto
+ring_buffer::
+operator=(ring_buffer&& other) ->
+    ring_buffer&
+{
+    if(this != &other)
+    {
+        release();
+        base_ = other.base_;
+        capacity_ = other.capacity_;
+        in_ = other.in_;
+        size_ = other.size_;
+        out_ = 0;
+        max_ = other.max_;
+        other.base_ = nullptr;
+        other.capacity_ = 0;
+        other.in_ = 0;
+        other.size_ = 0;
+        other.out_ = 0;
+    }
+    return *this;
+}
+
+inline
+auto
+ring_buffer::
+operator=(ring_buffer const& other) ->
+    ring_buffer&
+{
+    if(this != &other)
+    {
+        consume(size_);
+        out_ = 0;
+        max_ = other.max_;
+        if(other.size_ > 0)
+        {
+            std::memcpy(prepare(other.size_).data(),
+                other.base_ + other.in_, other.size_);
+            commit(other.size_);
+        }
+    }
+    return *this;
+}
+
+inline
+auto
+ring_buffer::
+prepare(std::size_t n) ->
+    mutable_buffers_type
+{
+    if(n > max_ - size_)
+        BOOST_THROW_EXCEPTION(std::length_error{
+            "ring_buffer overflow"});
+    if(n > capacity_ - size_)
+        grow(size_ + n);
+    // The output sequence may run past the end of
+    // the first view, into the second.
+    auto pos = in_ + size_;
+    if(pos >= capacity_)
+        pos -= capacity_;
+    out_ = n;
+    return {base_ + pos, n};
+}
+
+inline
+void
+ring_buffer::
+consume(std::size_t n)
+{
+    if(n >= size_)
+    {
+        // Start over at the front, where
+        // the memory is likely to be cached.
+        in_ = 0;
+        size_ = 0;
+        return;
+    }
+    in_ += n;
+    if(in_ >= capacity_)
+        in_ -= capacity_;
+    size_ -= n;
+}
+
+inline
+void
+ring_buffer::
+reserve(std::size_t n)
+{
+    if(n > max_)
+        BOOST_THROW_EXCEPTION(std::length_error{
+            "ring_buffer overflow"});
+    if(n > capacity_)
+        grow(n);
+}
+
+inline
+void
+ring_buffer::
+grow(std::size_t n)
+{
+    BOOST_ASSERT(n > capacity_);
+    // Grow geometrically, in whole pages
+    auto const page = detail::ring_buffer_page_size();
+    auto size = (std::max)(n, 2 * capacity_);
+    size = (size + page - 1) / page * page;
+    error_code ec;
+    auto const p = detail::ring_buffer_map(size, ec);
+    if(ec)
+        BOOST_THROW_EXCEPTION(system_error{ec});
+    if(size_ > 0)
+        std::memcpy(p, base_ + in_, size_);
+    release();
+    base_ = p;
+    capacity_ = size;
+    in_ = 0;
+}
+
+inline
+void
+ring_buffer::
+release()
+{
+    if(base_)
+        ::munmap(base_, 2 * capacity_);
+    base_ = nullptr;
+    capacity_ = 0;
+}
+
+} // beast
+
+#endif
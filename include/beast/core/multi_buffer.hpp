@@ -22,6 +22,51 @@
 
 namespace beast {
 
+/** Settings which control how a @ref basic_multi_buffer manages memory.
+
+    The default settings size each new element from the amount
+    of data in the buffer, and free elements as soon as they
+    are consumed.
+
+    Keeping consumed elements avoids an allocation and a
+    deallocation for each element streamed through a long lived
+    buffer, for example when relaying a chunked body or a
+    websocket session. With a fixed element size, every
+    allocation made by the buffer has the same size, so an
+    allocator which recycles blocks of equal size, such as
+    @ref pool_allocator, can also share them among buffers.
+
+    @par Example
+    Settings for a buffer used for the lifetime of a connection:
+    @code
+    multi_buffer_policy policy;
+    policy.element_size = 16384;
+    policy.free_elements = 4;
+    buffer.policy(policy);
+    @endcode
+*/
+struct multi_buffer_policy
+{
+    /** The size of each allocation, or zero.
+
+        When this is not zero, every element is allocated with
+        this size, which includes a small header, and a call to
+        @ref basic_multi_buffer::prepare which needs more space
+        than one element provides appends several. Zero sizes
+        each new element from the size of the input sequence.
+    */
+    std::size_t element_size = 0;
+
+    /** The number of unused elements to keep.
+
+        Elements emptied by @ref basic_multi_buffer::consume
+        or left over by @ref basic_multi_buffer::prepare are
+        kept, up to this number, and used again before
+        allocating. Zero frees them immediately.
+    */
+    std::size_t free_elements = 0;
+};
+
 /** A @b DynamicBuffer that uses multiple buffers internally.
 
     The implementation uses a sequence of one or more character arrays
@@ -76,6 +121,8 @@ class basic_multi_buffer
     size_type in_pos_ = 0;  // input offset in list_.front()
     size_type out_pos_ = 0; // output offset in *out_
     size_type out_end_ = 0; // output end offset in list_.back()
+    list_type free_;        // unused elements kept for reuse
+    multi_buffer_policy policy_;
 
 public:
     /// The type of allocator used.
@@ -237,6 +284,21 @@ public:
     std::size_t
     capacity() const;
 
+    /// Returns the settings which control memory management.
+    multi_buffer_policy const&
+    policy() const
+    {
+        return policy_;
+    }
+
+    /** Set the settings which control memory management.
+
+        The settings apply to later calls. Kept elements
+        beyond the new limit are freed.
+    */
+    void
+    policy(multi_buffer_policy const& value);
+
     /** Get a list of buffers that represents the input sequence.
 
         @note These buffers remain valid across subsequent calls to `prepare`.
@@ -275,6 +337,18 @@ private:
     template<class OtherAlloc>
     friend class basic_multi_buffer;
 
+    size_type
+    fixed_size() const;
+
+    element&
+    alloc_element(size_type n, size_type size);
+
+    void
+    free_element(element& e);
+
+    void
+    destroy_element(element& e);
+
     void
     delete_list();
 
@@ -0,0 +1,220 @@
+//
+// Copyright (c) 2016-2017 Vinnie Falco (vinnie dot falco at gmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/boostorg/beast
+//
+
+#ifndef BEAST_CORE_RING_BUFFER_HPP
+#define BEAST_CORE_RING_BUFFER_HPP
+
+#include <beast/core/detail/config.hpp>
+
+// Turn this off to omit ring_buffer even where
+// the mirrored mappings it needs are available
+#if ! defined(BEAST_USE_RING_BUFFER)
+# if defined(__linux__)
+#  define BEAST_USE_RING_BUFFER 1
+# else
+#  define BEAST_USE_RING_BUFFER 0
+# endif
+#endif
+
+#if BEAST_USE_RING_BUFFER
+
+#include <beast/core/error.hpp>
+#include <asio/buffer.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+
+namespace beast {
+
+/** A circular dynamic buffer with contiguous sequences.
+
+    Objects of this type meet the requirements of @b DynamicBuffer.
+    The storage is a shared memory file mapped twice, back to
+    back, so that octets which wrap around the end of the storage
+    also appear directly after it. The input and output sequences
+    are therefore always a single buffer, as with @ref flat_buffer,
+    while consuming octets only advances a position, as with
+    @ref static_buffer. Readable octets are never moved, except
+    when the buffer grows.
+
+    The buffer grows as needed up to an optional maximum size.
+    The capacity is a multiple of the page size, and twice the
+    capacity in address space is used.
+
+    This type may be used as the buffer for @ref http::read,
+    @ref buffered_read_stream and @ref websocket::stream, where
+    the parser and frame decoder then always see a single buffer.
+
+    @note This class is only available on Linux.
+*/
+class ring_buffer
+{
+    char* base_ = nullptr;
+    std::size_t capacity_ = 0;
+    std::size_t in_ = 0;    // offset of the input sequence
+    std::size_t size_ = 0;  // size of the input sequence
+    std::size_t out_ = 0;   // size of the output sequence
+    std::size_t max_ =
+        (std::numeric_limits<std::size_t>::max)();
+
+public:
+    /// The type used to represent the input sequence as a list of buffers.
+    using const_buffers_type = asio::const_buffer;
+
+    /// The type used to represent the output sequence as a list of buffers.
+    using mutable_buffers_type = asio::mutable_buffer;
+
+    /// Destructor
+    ~ring_buffer();
+
+    /** Constructor
+
+        Upon construction, capacity will be zero.
+    */
+    ring_buffer() = default;
+
+    /** Constructor
+
+        Upon construction, capacity will be zero.
+
+        @param limit The setting for @ref max_size.
+    */
+    explicit
+    ring_buffer(std::size_t limit);
+
+    /** Constructor
+
+        After the move, `*this` will have an empty output sequence.
+
+        @param other The object to move from. After the move,
+        the object's state will be as if constructed using
+        its current limit.
+    */
+    ring_buffer(ring_buffer&& other);
+
+    /** Constructor
+
+        @param other The object to copy from.
+    */
+    ring_buffer(ring_buffer const& other);
+
+    /** Assignment
+
+        After the move, `*this` will have an empty output sequence.
+
+        @param other The object to move from. After the move,
+        the object's state will be as if constructed using
+        its current limit.
+    */
+    ring_buffer&
+    operator=(ring_buffer&& other);
+
+    /** Assignment
+
+        After the copy, `*this` will have an empty output sequence.
+
+        @param other The object to copy from.
+    */
+    ring_buffer&
+    operator=(ring_buffer const& other);
+
+    /// Returns the size of the input sequence.
+    std::size_t
+    size() const
+    {
+        return size_;
+    }
+
+    /// Return the maximum sum of the input and output sequence sizes.
+    std::size_t
+    max_size() const
+    {
+        return max_;
+    }
+
+    /// Return the maximum sum of input and output sizes that can be held without an allocation.
+    std::size_t
+    capacity() const
+    {
+        return capacity_;
+    }
+
+    /// Get a list of buffers that represent the input sequence.
+    const_buffers_type
+    data() const
+    {
+        return {base_ + in_, size_};
+    }
+
+    /** Get a list of buffers that represent the output sequence, with the given size.
+
+        @throws std::length_error if `size() + n` exceeds `max_size()`.
+
+        @throws system_error if the storage could not be mapped.
+
+        @note All previous buffers sequences obtained from
+        calls to @ref data or @ref prepare are invalidated.
+    */
+    mutable_buffers_type
+    prepare(std::size_t n);
+
+    /** Move bytes from the output sequence to the input sequence.
+
+        @param n The number of bytes to move. If this is larger than
+        the number of bytes in the output sequences, then the entire
+        output sequences is moved.
+
+        @note All previous buffers sequences obtained from
+        calls to @ref data or @ref prepare are invalidated.
+    */
+    void
+    commit(std::size_t n)
+    {
+        size_ += (std::min)(n, out_);
+        out_ = 0;
+    }
+
+    /** Remove bytes from the input sequence.
+
+        If `n` is greater than the number of bytes in the input
+        sequence, all bytes in the input sequence are removed.
+
+        @note All previous buffers sequences obtained from
+        calls to @ref data or @ref prepare are invalidated.
+    */
+    void
+    consume(std::size_t n);
+
+    /** Make room for at least `n` octets without further allocation.
+
+        @throws std::length_error if `n` exceeds `max_size()`.
+
+        @throws system_error if the storage could not be mapped.
+
+        @note All previous buffers sequences obtained from
+        calls to @ref data or @ref prepare are invalidated.
+    */
+    void
+    reserve(std::size_t n);
+
+private:
+    void
+    grow(std::size_t n);
+
+    void
+    release();
+};
+
+} // beast
+
+#include <beast/core/impl/ring_buffer.ipp>
+
+#endif
+
+#endif
@@ -10,9 +10,12 @@
 #ifndef BEAST_CORE_DETAIL_FLAT_STREAM_HPP
 #define BEAST_CORE_DETAIL_FLAT_STREAM_HPP
 
+#include <beast/core/buffer_pool.hpp>
 #include <asio/buffer.hpp>
 #include <cstdlib>
 #include <iterator>
+#include <memory>
+#include <utility>
 
 namespace beast {
 namespace detail {
@@ -24,6 +27,53 @@ public:
     // 16KB is the upper limit on reasonably sized HTTP messages.
     static std::size_t constexpr coalesce_limit = 16 * 1024;
 
+    // returns a block to the buffer pool
+    struct pool_deleter
+    {
+        std::size_t size = 0;
+
+        pool_deleter() = default;
+
+        explicit
+        pool_deleter(std::size_t n)
+            : size(n)
+        {
+        }
+
+        void
+        operator()(char* p) const
+        {
+            buffer_pool::deallocate(p, size);
+        }
+    };
+
+    using pool_ptr = std::unique_ptr<char[], pool_deleter>;
+
+    static
+    pool_ptr
+    allocate(std::size_t size)
+    {
+        return pool_ptr{static_cast<char*>(
+            buffer_pool::allocate(size)), pool_deleter{size}};
+    }
+
+    // returns the size of the first non-empty buffer
+    template<class BufferSequence>
+    static
+    std::size_t
+    first_size(BufferSequence const& buffers)
+    {
+        auto const last = asio::buffer_sequence_end(buffers);
+        for(auto it = asio::buffer_sequence_begin(buffers);
+            it != last; ++it)
+        {
+            auto const n = asio::buffer_size(*it);
+            if(n > 0)
+                return n;
+        }
+        return 0;
+    }
+
     // calculates the coalesce settings for a buffer sequence
     template<class BufferSequence>
     static
@@ -54,6 +104,37 @@ public:
         }
         return result;
     }
+
+    // calculates the fill settings for a buffer sequence,
+    // when writes are limited to `limit` octets each
+    template<class BufferSequence>
+    static
+    std::pair<std::size_t, bool>
+    fill(BufferSequence const& buffers, std::size_t limit)
+    {
+        std::pair<std::size_t, bool> result{0, false};
+        auto first = asio::buffer_sequence_begin(buffers);
+        auto last = asio::buffer_sequence_end(buffers);
+        if(first != last)
+        {
+            result.first = asio::buffer_size(*first);
+            if(result.first >= limit)
+            {
+                result.first = limit;
+            }
+            else
+            {
+                auto const n = result.first;
+                auto it = first;
+                while(++it != last && result.first < limit)
+                    result.first += asio::buffer_size(*it);
+                if(result.first > limit)
+                    result.first = limit;
+                result.second = result.first > n;
+            }
+        }
+        return result;
+    }
 };
 
 } // detail
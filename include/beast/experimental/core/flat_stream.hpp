@@ -15,12 +15,91 @@
 #include <beast/core/type_traits.hpp>
 #include <beast/experimental/core/detail/flat_stream.hpp>
 #include <asio/async_result.hpp>
+#include <chrono>
 #include <cstdlib>
 #include <utility>
 
 namespace beast {
 
-/** Stream wrapper to improve ssl::stream write performance.
+/** Settings which control the reads and writes made by @ref flat_stream.
+
+    When the next layer is an SSL stream, each write produces
+    a TLS record, and the peer can not use any octet of a record
+    until all of it has arrived. A 16KB record sent on a new or
+    idle connection, whose congestion window is small, can take
+    several round trips to arrive and delays the first octets of
+    a response. With dynamic record sizing, writes at the start
+    of a burst are limited to a size whose record fits in one TCP
+    segment. Once enough octets have been written, the limit is
+    raised to the largest record, which has the least overhead.
+
+    An SSL stream decrypts into the first buffer of a read only,
+    so a caller reading into small buffers needs one call to the
+    SSL library for each of them. Reads into a buffer smaller than
+    a threshold are instead made into an internal buffer which
+    holds a whole record, and later reads are served from it.
+
+    @par Example
+    Writes which are only limited by the caller:
+    @code
+    flat_stream_policy policy;
+    policy.initial_record_size = 0;
+    stream.policy(policy);
+    @endcode
+*/
+struct flat_stream_policy
+{
+    /** The largest write at the start of a burst.
+
+        The default, together with the overhead of a TLS record
+        and the TCP/IP headers, fits in one Ethernet frame. Zero
+        turns off dynamic record sizing.
+    */
+    std::size_t initial_record_size = 1400;
+
+    /** The largest write once the burst has ramped up.
+
+        The default is the largest payload of a TLS record.
+    */
+    std::size_t max_record_size = 16 * 1024;
+
+    /** The number of octets in a burst before writes ramp up.
+
+        After this many octets have been written since the stream
+        was last idle, writes are limited by @ref max_record_size
+        instead of @ref initial_record_size.
+    */
+    std::size_t ramp_threshold = 128 * 1024;
+
+    /** The time without writes after which the stream is idle.
+
+        A write which starts this long after the previous write
+        completed begins a new burst.
+    */
+    std::chrono::milliseconds idle_timeout{1000};
+
+    /** The size of the internal buffer used for reads.
+
+        The default holds the payload of the largest TLS record.
+        Zero turns off reads through the internal buffer.
+    */
+    std::size_t read_buffer_size = 16 * 1024;
+
+    /** The size below which reads use the internal buffer.
+
+        A read whose first non-empty buffer is smaller than this
+        reads up to @ref read_buffer_size octets from the next
+        layer, and copies them to the caller's buffers and to
+        subsequent reads. The stream adapts the threshold: when
+        such a read receives no more octets than would have fit
+        in the caller's first buffer, the threshold is lowered to
+        that buffer's size, and when a direct read fills the
+        caller's first buffer it is restored to this value.
+    */
+    std::size_t read_threshold = 4096;
+};
+
+/** Stream wrapper to improve ssl::stream read and write performance.
 
     This wrapper flattens writes for buffer sequences having length
     greater than 1 and total size below a predefined amount, using
@@ -29,6 +108,18 @@ namespace beast {
     which does not use OpenSSL's scatter/gather interface for its
     low-level read some and write some operations.
 
+    The wrapper also limits the size of each write to the next layer
+    according to a @ref flat_stream_policy, so that an SSL stream
+    sends small records at the start of a burst of writes and full
+    size records afterwards. Flattened writes are filled up to the
+    limit, which avoids records much smaller than it.
+
+    Reads into small buffers are made through an internal buffer
+    sized to hold a whole TLS record, so that a message read in
+    small pieces needs fewer calls to the SSL library. The internal
+    buffer is taken from the @ref buffer_pool when a read needs it,
+    and returned once all of its octets have been copied out.
+
     @par Example
 
     To use the @ref flat_stream template with SSL streams, declare
@@ -87,9 +178,19 @@ class flat_stream
     // 16KB is the upper limit on reasonably sized HTTP messages.
     static std::size_t constexpr max_size = 16 * 1024;
 
+    template<class, class> class read_op;
     template<class, class> class write_op;
 
+    using clock_type = std::chrono::steady_clock;
+
     NextLayer stream_;
+    flat_stream_policy policy_;
+    std::size_t sent_ = 0;      // octets written in the burst
+    clock_type::time_point last_; // when the last write completed
+    pool_ptr rbuf_;             // internal read buffer
+    std::size_t rpos_ = 0;      // unread octets are [rpos_, rend_)
+    std::size_t rend_ = 0;
+    std::size_t threshold_;     // current read threshold
 
 public:
     /// The type of the next layer.
@@ -193,6 +294,26 @@ public:
         return stream_.lowest_layer();
     }
 
+    /// Returns the settings which control reads and writes.
+    flat_stream_policy const&
+    policy() const
+    {
+        return policy_;
+    }
+
+    /** Set the settings which control reads and writes.
+
+        The settings apply to later reads and writes. The current
+        burst is not restarted, and octets already in the internal
+        read buffer are still returned by later reads.
+    */
+    void
+    policy(flat_stream_policy const& value)
+    {
+        policy_ = value;
+        threshold_ = policy_.read_threshold;
+    }
+
     //--------------------------------------------------------------------------
 
     /** Read some data from the stream.
@@ -343,6 +464,40 @@ public:
     async_write_some(
         ConstBufferSequence const& buffers,
         WriteHandler&& handler);
+
+private:
+    std::size_t
+    record_limit();
+
+    void
+    on_write(std::size_t bytes_transferred);
+
+    template<class ConstBufferSequence>
+    std::pair<std::size_t, bool>
+    flatten(ConstBufferSequence const& buffers);
+
+    template<class MutableBufferSequence>
+    bool
+    bulk_read(MutableBufferSequence const& buffers) const;
+
+    asio::mutable_buffer
+    prepare_read();
+
+    template<class MutableBufferSequence>
+    std::size_t
+    commit_read(
+        MutableBufferSequence const& buffers,
+        std::size_t bytes_transferred);
+
+    template<class MutableBufferSequence>
+    std::size_t
+    copy_read(MutableBufferSequence const& buffers);
+
+    template<class MutableBufferSequence>
+    void
+    on_read(
+        MutableBufferSequence const& buffers,
+        std::size_t bytes_transferred);
 };
 
 } // beast
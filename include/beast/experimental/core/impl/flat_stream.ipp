@@ -10,6 +10,7 @@
 #ifndef BEAST_CORE_IMPL_FLAT_STREAM_IPP
 #define BEAST_CORE_IMPL_FLAT_STREAM_IPP
 
+#include <beast/core/bind_handler.hpp>
 #include <beast/core/buffers_prefix.hpp>
 #include <beast/websocket/teardown.hpp>
 #include <asio/associated_allocator.hpp>
@@ -18,9 +19,113 @@
 #include <asio/coroutine.hpp>
 #include <asio/handler_continuation_hook.hpp>
 #include <asio/handler_invoke_hook.hpp>
+#include <asio/post.hpp>
+#include <algorithm>
 
 namespace beast {
 
+template<class NextLayer>
+template<class MutableBufferSequence, class Handler>
+class flat_stream<NextLayer>::read_op
+    : public asio::coroutine
+{
+    flat_stream<NextLayer>& s_;
+    MutableBufferSequence b_;
+    Handler h_;
+
+public:
+    template<class DeducedHandler>
+    read_op(
+        flat_stream<NextLayer>& s,
+        MutableBufferSequence const& b,
+        DeducedHandler&& h)
+        : s_(s)
+        , b_(b)
+        , h_(std::forward<DeducedHandler>(h))
+    {
+    }
+
+    using allocator_type =
+        asio::associated_allocator_t<Handler>;
+
+    allocator_type
+    get_allocator() const noexcept
+    {
+        return (asio::get_associated_allocator)(h_);
+    }
+
+    using executor_type = asio::associated_executor_t<
+        Handler, decltype(std::declval<NextLayer&>().get_executor())>;
+
+    executor_type
+    get_executor() const noexcept
+    {
+        return (asio::get_associated_executor)(
+            h_, s_.get_executor());
+    }
+
+    void
+    operator()(
+        std::error_code ec,
+        std::size_t bytes_transferred);
+
+    friend
+    bool asio_handler_is_continuation(read_op* op)
+    {
+        using asio::asio_handler_is_continuation;
+        return asio_handler_is_continuation(
+                std::addressof(op->h_));
+    }
+
+    template<class Function>
+    friend
+    void asio_handler_invoke(Function&& f, read_op* op)
+    {
+        using asio::asio_handler_invoke;
+        asio_handler_invoke(f, std::addressof(op->h_));
+    }
+};
+
+template<class NextLayer>
+template<class MutableBufferSequence, class Handler>
+void
+flat_stream<NextLayer>::
+read_op<MutableBufferSequence, Handler>::
+operator()(
+    error_code ec,
+    std::size_t bytes_transferred)
+{
+    ASIO_CORO_REENTER(*this)
+    {
+        if(s_.rpos_ != s_.rend_)
+        {
+            // serve the read from the internal buffer
+            ASIO_CORO_YIELD
+            asio::post(
+                s_.get_executor(),
+                bind_handler(std::move(*this), ec, 0));
+            bytes_transferred = s_.copy_read(b_);
+        }
+        else if(! s_.bulk_read(b_))
+        {
+            ASIO_CORO_YIELD
+            s_.stream_.async_read_some(b_, std::move(*this));
+            s_.on_read(b_, bytes_transferred);
+        }
+        else
+        {
+            ASIO_CORO_YIELD
+            s_.stream_.async_read_some(
+                s_.prepare_read(), std::move(*this));
+            bytes_transferred =
+                s_.commit_read(b_, bytes_transferred);
+        }
+        h_(ec, bytes_transferred);
+    }
+}
+
+//------------------------------------------------------------------------------
+
 template<class NextLayer>
 template<class ConstBufferSequence, class Handler>
 class flat_stream<NextLayer>::write_op
@@ -121,7 +226,7 @@ operator()(
     {
         ASIO_CORO_YIELD
         {
-            auto const result = coalesce(b_,  coalesce_limit);
+            auto const result = s_.flatten(b_);
             if(result.second)
             {
                 p_.get_deleter().size = result.first;
@@ -144,6 +249,7 @@ operator()(
             }
         }
         p_.reset();
+        s_.on_write(bytes_transferred);
         h_(ec, bytes_transferred);
     }
 }
@@ -155,6 +261,7 @@ template<class... Args>
 flat_stream<NextLayer>::
 flat_stream(Args&&... args)
     : stream_(std::forward<Args>(args)...)
+    , threshold_(policy_.read_threshold)
 {
 }
 
@@ -182,7 +289,24 @@ std::size_t
 flat_stream<NextLayer>::
 read_some(MutableBufferSequence const& buffers, error_code& ec)
 {
-    return stream_.read_some(buffers, ec);
+    static_assert(beast::is_sync_read_stream<next_layer_type>::value,
+        "SyncReadStream requirements not met");
+    static_assert(asio::is_mutable_buffer_sequence<
+        MutableBufferSequence>::value,
+            "MutableBufferSequence requirements not met");
+    if(rpos_ != rend_)
+    {
+        ec.assign(0, ec.category());
+        return copy_read(buffers);
+    }
+    if(! bulk_read(buffers))
+    {
+        auto const n = stream_.read_some(buffers, ec);
+        on_read(buffers, n);
+        return n;
+    }
+    auto const n = stream_.read_some(prepare_read(), ec);
+    return commit_read(buffers, n);
 }
 
 template<class NextLayer>
@@ -201,8 +325,12 @@ async_read_some(
     static_assert(asio::is_mutable_buffer_sequence<
             MutableBufferSequence >::value,
         "MutableBufferSequence  requirements not met");
-    return stream_.async_read_some(
-        buffers, std::forward<ReadHandler>(handler));
+    BEAST_HANDLER_INIT(
+        ReadHandler, void(error_code, std::size_t));
+    read_op<MutableBufferSequence, ASIO_HANDLER_TYPE(
+        ReadHandler, void(error_code, std::size_t))>{
+            *this, buffers, std::move(init.completion_handler)}({}, 0);
+    return init.result.get();
 }
 
 template<class NextLayer>
@@ -216,16 +344,11 @@ write_some(ConstBufferSequence const& buffers)
     static_assert(asio::is_const_buffer_sequence<
         ConstBufferSequence>::value,
             "ConstBufferSequence requirements not met");
-    auto const result = coalesce(buffers, coalesce_limit);
-    if(result.second)
-    {
-        std::unique_ptr<char[]> p{new char[result.first]};
-        auto const b = asio::buffer(p.get(), result.first);
-        asio::buffer_copy(b, buffers);
-        return stream_.write_some(b);
-    }
-    return stream_.write_some(
-        beast::buffers_prefix(result.first, buffers));
+    error_code ec;
+    auto n = write_some(buffers, ec);
+    if(ec)
+        BOOST_THROW_EXCEPTION(std::system_error{ec});
+    return n;
 }
 
 template<class NextLayer>
@@ -239,16 +362,22 @@ write_some(ConstBufferSequence const& buffers, error_code& ec)
     static_assert(asio::is_const_buffer_sequence<
         ConstBufferSequence>::value,
             "ConstBufferSequence requirements not met");
-    auto const result = coalesce(buffers, coalesce_limit);
+    std::size_t n;
+    auto const result = flatten(buffers);
     if(result.second)
     {
-        std::unique_ptr<char[]> p{new char[result.first]};
+        auto const p = allocate(result.first);
         auto const b = asio::buffer(p.get(), result.first);
         asio::buffer_copy(b, buffers);
-        return stream_.write_some(b, ec);
+        n = stream_.write_some(b, ec);
+    }
+    else
+    {
+        n = stream_.write_some(
+            beast::buffers_prefix(result.first, buffers), ec);
     }
-    return stream_.write_some(
-        beast::buffers_prefix(result.first, buffers), ec);
+    on_write(n);
+    return n;
 }
 
 template<class NextLayer>
@@ -275,6 +404,122 @@ async_write_some(
     return init.result.get();
 }
 
+template<class NextLayer>
+std::size_t
+flat_stream<NextLayer>::
+record_limit()
+{
+    if(policy_.initial_record_size == 0)
+        return 0;
+    if(clock_type::now() - last_ >= policy_.idle_timeout)
+        sent_ = 0;
+    if(sent_ < policy_.ramp_threshold)
+        return policy_.initial_record_size;
+    return policy_.max_record_size;
+}
+
+template<class NextLayer>
+void
+flat_stream<NextLayer>::
+on_write(std::size_t bytes_transferred)
+{
+    if(policy_.initial_record_size == 0)
+        return;
+    if(bytes_transferred > policy_.ramp_threshold - (
+            std::min)(sent_, policy_.ramp_threshold))
+        sent_ = policy_.ramp_threshold;
+    else
+        sent_ += bytes_transferred;
+    last_ = clock_type::now();
+}
+
+template<class NextLayer>
+template<class ConstBufferSequence>
+std::pair<std::size_t, bool>
+flat_stream<NextLayer>::
+flatten(ConstBufferSequence const& buffers)
+{
+    auto const limit = record_limit();
+    if(limit == 0)
+        return coalesce(buffers, coalesce_limit);
+    return fill(buffers, limit);
+}
+
+template<class NextLayer>
+template<class MutableBufferSequence>
+bool
+flat_stream<NextLayer>::
+bulk_read(MutableBufferSequence const& buffers) const
+{
+    auto const n = first_size(buffers);
+    return n > 0 &&
+        n < threshold_ &&
+        n < policy_.read_buffer_size;
+}
+
+template<class NextLayer>
+asio::mutable_buffer
+flat_stream<NextLayer>::
+prepare_read()
+{
+    rbuf_ = allocate(policy_.read_buffer_size);
+    return asio::buffer(rbuf_.get(), policy_.read_buffer_size);
+}
+
+template<class NextLayer>
+template<class MutableBufferSequence>
+std::size_t
+flat_stream<NextLayer>::
+commit_read(
+    MutableBufferSequence const& buffers,
+    std::size_t bytes_transferred)
+{
+    rpos_ = 0;
+    rend_ = bytes_transferred;
+    auto const n = first_size(buffers);
+    if(bytes_transferred > 0 && bytes_transferred <= n)
+    {
+        // a direct read would have received as much
+        threshold_ = n;
+    }
+    return copy_read(buffers);
+}
+
+template<class NextLayer>
+template<class MutableBufferSequence>
+std::size_t
+flat_stream<NextLayer>::
+copy_read(MutableBufferSequence const& buffers)
+{
+    auto const n = asio::buffer_copy(buffers,
+        asio::buffer(rbuf_.get() + rpos_, rend_ - rpos_));
+    rpos_ += n;
+    if(rpos_ == rend_)
+    {
+        // return the memory to the pool while idle
+        rbuf_.reset();
+        rpos_ = 0;
+        rend_ = 0;
+    }
+    return n;
+}
+
+template<class NextLayer>
+template<class MutableBufferSequence>
+void
+flat_stream<NextLayer>::
+on_read(
+    MutableBufferSequence const& buffers,
+    std::size_t bytes_transferred)
+{
+    if(bytes_transferred > 0 &&
+        bytes_transferred == first_size(buffers))
+    {
+        // more octets may be ready than the caller asked for
+        threshold_ = policy_.read_threshold;
+    }
+}
+
 template<class NextLayer>
 void
 teardown(
@@ -56,6 +56,11 @@ namespace beast {
         limitation of `asio::ssl::stream` when writing buffer sequences
         having length greater than one.
 
+    @li Sizes TLS records dynamically, see @ref flat_stream_policy.
+
+    @li Reads into small buffers through an internal buffer which
+        holds a whole TLS record, see @ref flat_stream_policy.
+
     @par Concepts:
         @li AsyncReadStream
         @li AsyncWriteStream
@@ -229,6 +234,30 @@ public:
         return p_->lowest_layer();
     }
 
+    /** Returns the settings which control TLS records and reads.
+
+        @see flat_stream_policy
+    */
+    flat_stream_policy const&
+    policy() const
+    {
+        return p_->policy();
+    }
+
+    /** Set the settings which control TLS records and reads.
+
+        By default, records start at a size which fits in one TCP
+        segment, and grow to the largest size after a number of
+        octets have been written without the stream becoming idle.
+
+        @see flat_stream_policy
+    */
+    void
+    policy(flat_stream_policy const& value)
+    {
+        p_->policy(value);
+    }
+
       /** Set the peer verification mode.
 
         This function may be used to configure the peer verification mode used by
@@ -0,0 +1,525 @@
+//
+// Copyright (c) 2016-2017 Vinnie Falco (vinnie dot falco at gmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/boostorg/beast
+//
+
+#ifndef BEAST_TEST_IMPL_PIPE_STREAM_IPP
+#define BEAST_TEST_IMPL_PIPE_STREAM_IPP
+
+#include <beast/core/bind_handler.hpp>
+#include <beast/core/type_traits.hpp>
+#include <asio/associated_allocator.hpp>
+#include <asio/associated_executor.hpp>
+#include <asio/error.hpp>
+#include <asio/handler_continuation_hook.hpp>
+#include <asio/handler_invoke_hook.hpp>
+#include <asio/post.hpp>
+#include <boost/assert.hpp>
+#include <boost/throw_exception.hpp>
+#include <algorithm>
+#include <array>
+#include <thread>
+
+namespace beast {
+namespace test {
+
+template<class Handler, class Buffers>
+class pipe_stream::read_op
+{
+    pipe_stream& s_;
+    Buffers b_;
+    Handler h_;
+    std::size_t spins_ = 0;
+
+public:
+    read_op(read_op&&) = default;
+    read_op(read_op const&) = delete;
+
+    template<class DeducedHandler>
+    read_op(DeducedHandler&& h,
+        pipe_stream& s, Buffers const& b)
+        : s_(s)
+        , b_(b)
+        , h_(std::forward<DeducedHandler>(h))
+    {
+    }
+
+    using allocator_type =
+        asio::associated_allocator_t<Handler>;
+
+    allocator_type
+    get_allocator() const noexcept
+    {
+        return (asio::get_associated_allocator)(h_);
+    }
+
+    using executor_type = asio::associated_executor_t<
+        Handler, pipe_stream::executor_type>;
+
+    executor_type
+    get_executor() const noexcept
+    {
+        return (asio::get_associated_executor)(
+            h_, s_.get_executor());
+    }
+
+    void
+    operator()()
+    {
+        error_code ec;
+        std::size_t bytes_transferred;
+        if(! s_.try_read(b_, bytes_transferred, ec))
+        {
+            pipe_stream::wait(spins_);
+            return asio::post(
+                s_.get_executor(), std::move(*this));
+        }
+        h_(ec, bytes_transferred);
+    }
+
+    friend
+    bool asio_handler_is_continuation(read_op* op)
+    {
+        using asio::asio_handler_is_continuation;
+        return asio_handler_is_continuation(
+            std::addressof(op->h_));
+    }
+
+    template<class Function>
+    friend
+    void asio_handler_invoke(Function&& f, read_op* op)
+    {
+        using asio::asio_handler_invoke;
+        asio_handler_invoke(f, std::addressof(op->h_));
+    }
+};
+
+template<class Handler, class Buffers>
+class pipe_stream::write_op
+{
+    pipe_stream& s_;
+    Buffers b_;
+    Handler h_;
+    std::size_t spins_ = 0;
+
+public:
+    write_op(write_op&&) = default;
+    write_op(write_op const&) = delete;
+
+    template<class DeducedHandler>
+    write_op(DeducedHandler&& h,
+        pipe_stream& s, Buffers const& b)
+        : s_(s)
+        , b_(b)
+        , h_(std::forward<DeducedHandler>(h))
+    {
+    }
+
+    using allocator_type =
+        asio::associated_allocator_t<Handler>;
+
+    allocator_type
+    get_allocator() const noexcept
+    {
+        return (asio::get_associated_allocator)(h_);
+    }
+
+    using executor_type = asio::associated_executor_t<
+        Handler, pipe_stream::executor_type>;
+
+    executor_type
+    get_executor() const noexcept
+    {
+        return (asio::get_associated_executor)(
+            h_, s_.get_executor());
+    }
+
+    void
+    operator()()
+    {
+        error_code ec;
+        std::size_t bytes_transferred;
+        if(! s_.try_write(b_, bytes_transferred, ec))
+        {
+            pipe_stream::wait(spins_);
+            return asio::post(
+                s_.get_executor(), std::move(*this));
+        }
+        h_(ec, bytes_transferred);
+    }
+
+    friend
+    bool asio_handler_is_continuation(write_op* op)
+    {
+        using asio::asio_handler_is_continuation;
+        return asio_handler_is_continuation(
+            std::addressof(op->h_));
+    }
+
+    template<class Function>
+    friend
+    void asio_handler_invoke(Function&& f, write_op* op)
+    {
+        using asio::asio_handler_invoke;
+        asio_handler_invoke(f, std::addressof(op->h_));
+    }
+};
+
+//------------------------------------------------------------------------------
+
+inline
+pipe_stream::
+pipe::
+pipe(std::size_t capacity)
+    : head(0)
+    , tail(0)
+    , code(status::ok)
+    , orphaned(false)
+{
+    std::size_t n = 1;
+    while(n < capacity)
+        n <<= 1;
+    buf.reset(new char[n]);
+    mask = n - 1;
+}
+
+inline
+pipe_stream::
+~pipe_stream()
+{
+    disconnect();
+}
+
+inline
+pipe_stream::
+pipe_stream(pipe_stream&& other) = default;
+
+inline
+pipe_stream&
+pipe_stream::
+operator=(pipe_stream&& other)
+{
+    if(this != &other)
+    {
+        disconnect();
+        ioc_ = other.ioc_;
+        in_ = std::move(other.in_);
+        out_ = std::move(other.out_);
+        capacity_ = other.capacity_;
+        head_ = other.head_;
+        tail_ = other.tail_;
+        nread_ = other.nread_;
+        nwrite_ = other.nwrite_;
+        read_max_ = other.read_max_;
+        write_max_ = other.write_max_;
+    }
+    return *this;
+}
+
+inline
+pipe_stream::
+pipe_stream(
+    asio::io_context& ioc,
+    std::size_t capacity)
+    : ioc_(&ioc)
+    , capacity_(capacity)
+{
+}
+
+inline
+void
+pipe_stream::
+connect(pipe_stream& remote)
+{
+    BOOST_ASSERT(! out_);
+    BOOST_ASSERT(! remote.out_);
+    in_ = std::make_shared<pipe>(capacity_);
+    remote.in_ = std::make_shared<pipe>(remote.capacity_);
+    out_ = remote.in_;
+    remote.out_ = in_;
+    head_ = 0;
+    tail_ = 0;
+    remote.head_ = 0;
+    remote.tail_ = 0;
+}
+
+inline
+void
+pipe_stream::
+close()
+{
+    if(! out_)
+        return;
+    auto code = status::ok;
+    out_->code.compare_exchange_strong(code, status::eof);
+}
+
+template<class MutableBufferSequence>
+std::size_t
+pipe_stream::
+read_some(MutableBufferSequence const& buffers)
+{
+    static_assert(asio::is_mutable_buffer_sequence<
+            MutableBufferSequence>::value,
+        "MutableBufferSequence requirements not met");
+    error_code ec;
+    auto const n = read_some(buffers, ec);
+    if(ec)
+        BOOST_THROW_EXCEPTION(system_error{ec});
+    return n;
+}
+
+template<class MutableBufferSequence>
+std::size_t
+pipe_stream::
+read_some(MutableBufferSequence const& buffers,
+    error_code& ec)
+{
+    static_assert(asio::is_mutable_buffer_sequence<
+            MutableBufferSequence>::value,
+        "MutableBufferSequence requirements not met");
+    std::size_t bytes_transferred;
+    std::size_t spins = 0;
+    while(! try_read(buffers, bytes_transferred, ec))
+        wait(spins);
+    return bytes_transferred;
+}
+
+template<class MutableBufferSequence, class ReadHandler>
+ASIO_INITFN_RESULT_TYPE(
+    ReadHandler, void(error_code, std::size_t))
+pipe_stream::
+async_read_some(
+    MutableBufferSequence const& buffers,
+    ReadHandler&& handler)
+{
+    static_assert(asio::is_mutable_buffer_sequence<
+            MutableBufferSequence>::value,
+        "MutableBufferSequence requirements not met");
+    BEAST_HANDLER_INIT(
+        ReadHandler, void(error_code, std::size_t));
+    asio::post(
+        get_executor(),
+        read_op<ASIO_HANDLER_TYPE(
+            ReadHandler, void(error_code, std::size_t)),
+                MutableBufferSequence>{
+            std::move(init.completion_handler), *this, buffers});
+    return init.result.get();
+}
+
+template<class ConstBufferSequence>
+std::size_t
+pipe_stream::
+write_some(ConstBufferSequence const& buffers)
+{
+    static_assert(asio::is_const_buffer_sequence<
+            ConstBufferSequence>::value,
+        "ConstBufferSequence requirements not met");
+    error_code ec;
+    auto const bytes_transferred =
+        write_some(buffers, ec);
+    if(ec)
+        BOOST_THROW_EXCEPTION(system_error{ec});
+    return bytes_transferred;
+}
+
+template<class ConstBufferSequence>
+std::size_t
+pipe_stream::
+write_some(
+    ConstBufferSequence const& buffers, error_code& ec)
+{
+    static_assert(asio::is_const_buffer_sequence<
+            ConstBufferSequence>::value,
+        "ConstBufferSequence requirements not met");
+    std::size_t bytes_transferred;
+    std::size_t spins = 0;
+    while(! try_write(buffers, bytes_transferred, ec))
+        wait(spins);
+    return bytes_transferred;
+}
+
+template<class ConstBufferSequence, class WriteHandler>
+ASIO_INITFN_RESULT_TYPE(
+    WriteHandler, void(error_code, std::size_t))
+pipe_stream::
+async_write_some(ConstBufferSequence const& buffers,
+    WriteHandler&& handler)
+{
+    static_assert(asio::is_const_buffer_sequence<
+            ConstBufferSequence>::value,
+        "ConstBufferSequence requirements not met");
+    BEAST_HANDLER_INIT(
+        WriteHandler, void(error_code, std::size_t));
+    asio::post(
+        get_executor(),
+        write_op<ASIO_HANDLER_TYPE(
+            WriteHandler, void(error_code, std::size_t)),
+                ConstBufferSequence>{
+            std::move(init.completion_handler), *this, buffers});
+    return init.result.get();
+}
+
+template<class MutableBufferSequence>
+bool
+pipe_stream::
+try_read(
+    MutableBufferSequence const& buffers,
+    std::size_t& bytes_transferred,
+    error_code& ec)
+{
+    bytes_transferred = 0;
+    if(! in_)
+    {
+        ec = asio::error::not_connected;
+        return true;
+    }
+    if(asio::buffer_size(buffers) == 0)
+    {
+        ec.assign(0, ec.category());
+        return true;
+    }
+    auto& p = *in_;
+    auto const tail = p.tail.load(std::memory_order_relaxed);
+    if(head_ == tail)
+    {
+        head_ = p.head.load(std::memory_order_acquire);
+        if(head_ == tail)
+        {
+            auto const code = p.code.load(std::memory_order_acquire);
+            if(code == status::ok)
+                return false;
+
+            // data written before the close is visible now
+            head_ = p.head.load(std::memory_order_acquire);
+            if(head_ == tail)
+            {
+                ++nread_;
+                if(code == status::eof)
+                    ec = asio::error::eof;
+                else
+                    ec = asio::error::connection_reset;
+                return true;
+            }
+        }
+    }
+    auto const n = (std::min)(head_ - tail, read_max_);
+    auto const pos = tail & p.mask;
+    auto const first = (std::min)(n, p.mask + 1 - pos);
+    std::array<asio::const_buffer, 2> const b{{
+        asio::const_buffer(p.buf.get() + pos, first),
+        asio::const_buffer(p.buf.get(), n - first)}};
+    bytes_transferred = asio::buffer_copy(buffers, b);
+    p.tail.store(tail + bytes_transferred,
+        std::memory_order_release);
+    ++nread_;
+    ec.assign(0, ec.category());
+    return true;
+}
+
+template<class ConstBufferSequence>
+bool
+pipe_stream::
+try_write(
+    ConstBufferSequence const& buffers,
+    std::size_t& bytes_transferred,
+    error_code& ec)
+{
+    bytes_transferred = 0;
+    if(! out_ || out_->orphaned.load(std::memory_order_acquire))
+    {
+        ec = asio::error::connection_reset;
+        return true;
+    }
+    auto const size = asio::buffer_size(buffers);
+    if(size == 0)
+    {
+        ec.assign(0, ec.category());
+        return true;
+    }
+    auto& p = *out_;
+    auto const capacity = p.mask + 1;
+    auto const head = p.head.load(std::memory_order_relaxed);
+    if(head - tail_ == capacity)
+    {
+        tail_ = p.tail.load(std::memory_order_acquire);
+        if(head - tail_ == capacity)
+            return false;
+    }
+    auto const n = (std::min)(size, (std::min)(
+        write_max_, capacity - (head - tail_)));
+    auto const pos = head & p.mask;
+    auto const first = (std::min)(n, capacity - pos);
+    std::array<asio::mutable_buffer, 2> const b{{
+        asio::mutable_buffer(p.buf.get() + pos, first),
+        asio::mutable_buffer(p.buf.get(), n - first)}};
+    bytes_transferred = asio::buffer_copy(b, buffers);
+    p.head.store(head + bytes_transferred,
+        std::memory_order_release);
+    ++nwrite_;
+    ec.assign(0, ec.category());
+    return true;
+}
+
+inline
+void
+pipe_stream::
+wait(std::size_t& spins)
+{
+    // Spin for a while before giving up the time slice,
+    // the peer is usually about to make progress.
+    if(++spins > 1000)
+        std::this_thread::yield();
+}
+
+inline
+void
+pipe_stream::
+disconnect()
+{
+    if(out_)
+    {
+        auto code = status::ok;
+        out_->code.compare_exchange_strong(code, status::reset);
+        out_.reset();
+    }
+    if(in_)
+    {
+        in_->orphaned.store(true, std::memory_order_release);
+        in_.reset();
+    }
+}
+
+inline
+void
+teardown(
+websocket::role_type,
+pipe_stream& s,
+std::error_code& ec)
+{
+    s.close();
+    ec.assign(0, ec.category());
+}
+
+template<class TeardownHandler>
+inline
+void
+async_teardown(
+websocket::role_type,
+pipe_stream& s,
+TeardownHandler&& handler)
+{
+    s.close();
+    asio::post(
+        s.get_executor(),
+        bind_handler(std::move(handler), error_code{}));
+}
+
+} // test
+} // beast
+
+#endif
@@ -0,0 +1,639 @@
+//
+// Copyright (c) 2016-2017 Vinnie Falco (vinnie dot falco at gmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/boostorg/beast
+//
+
+#ifndef BEAST_TEST_IMPL_SIMULATED_STREAM_IPP
+#define BEAST_TEST_IMPL_SIMULATED_STREAM_IPP
+
+#include <beast/core/bind_handler.hpp>
+#include <beast/core/buffers_prefix.hpp>
+#include <beast/core/type_traits.hpp>
+#include <asio/error.hpp>
+#include <asio/post.hpp>
+#include <boost/assert.hpp>
+#include <boost/throw_exception.hpp>
+#include <algorithm>
+
+namespace beast {
+namespace test {
+
+// One direction of a connection
+struct simulated_network::link
+{
+    struct event
+    {
+        duration time;
+        std::size_t size;
+    };
+
+    network_conditions cond;
+    flat_buffer b;                  // octets written and not yet read
+    std::deque<event> flight;       // segments which have not arrived
+    std::deque<event> credits;      // window updates in flight
+    duration busy{0};               // when the sender is free
+    duration last{0};               // arrival of the last segment
+    duration last_credit{0};        // arrival of the last window update
+    duration fin_time{0};           // arrival of the end of the data
+    std::size_t readable = 0;       // octets in b which have arrived
+    std::size_t unacked = 0;        // octets counted against the window
+    bool closed = false;            // the writer closed the link
+    bool fin = false;               // the end of the data arrived
+    bool orphaned = false;          // the reader is gone
+
+    // pending operations of the reader and the writer
+    std::unique_ptr<simulated_stream::op_base> rop;
+    std::unique_ptr<simulated_stream::op_base> wop;
+};
+
+inline
+simulated_network::
+simulated_network(
+    asio::io_context& ioc,
+    std::uint32_t seed)
+    : ioc_(ioc)
+    , rng_(seed)
+{
+}
+
+inline
+std::size_t
+simulated_network::
+run()
+{
+    std::size_t n = 0;
+    for(;;)
+    {
+        ioc_.restart();
+        n += ioc_.poll();
+        if(! step())
+            break;
+    }
+    return n;
+}
+
+inline
+bool
+simulated_network::
+step()
+{
+    bool found = false;
+    duration t{0};
+    auto const consider =
+        [&](duration when)
+        {
+            if(! found || when < t)
+            {
+                t = when;
+                found = true;
+            }
+        };
+    for(auto it = links_.begin(); it != links_.end();)
+    {
+        auto const l = it->lock();
+        if(! l)
+        {
+            it = links_.erase(it);
+            continue;
+        }
+        if(! l->flight.empty())
+            consider(l->flight.front().time);
+        if(! l->credits.empty())
+            consider(l->credits.front().time);
+        if(l->closed && ! l->fin)
+            consider(l->fin_time);
+        ++it;
+    }
+    if(! found)
+        return false;
+    if(now_ < t)
+        now_ = t;
+
+    // Completing an operation only posts its handler,
+    // so the set of links does not change in the loop.
+    for(std::size_t i = 0; i < links_.size(); ++i)
+    {
+        auto const l = links_[i].lock();
+        if(! l)
+            continue;
+        while(! l->flight.empty() &&
+            l->flight.front().time <= now_)
+        {
+            l->readable += l->flight.front().size;
+            l->flight.pop_front();
+        }
+        while(! l->credits.empty() &&
+            l->credits.front().time <= now_)
+        {
+            l->unacked -= l->credits.front().size;
+            l->credits.pop_front();
+        }
+        if(l->closed && ! l->fin &&
+            l->flight.empty() && l->fin_time <= now_)
+            l->fin = true;
+        notify(*l);
+    }
+    return true;
+}
+
+inline
+auto
+simulated_network::
+make_link() ->
+    std::shared_ptr<link>
+{
+    auto l = std::make_shared<link>();
+    links_.push_back(l);
+    return l;
+}
+
+inline
+auto
+simulated_network::
+jitter(link const& l) ->
+    duration
+{
+    if(l.cond.jitter.count() <= 0)
+        return duration{0};
+    // The engine is fully specified by the standard, the
+    // distributions are not, so the sample is made here.
+    auto const range = static_cast<std::uint64_t>(
+        l.cond.jitter.count()) + 1;
+    return duration{static_cast<duration::rep>(
+        static_cast<std::uint64_t>(rng_()) % range)};
+}
+
+inline
+void
+simulated_network::
+send(link& l, std::size_t n)
+{
+    if(l.cond.window != 0)
+        l.unacked += n;
+    auto const delay = l.cond.rtt / 2;
+    while(n > 0)
+    {
+        auto const size = l.cond.segment_size != 0 ?
+            (std::min)(n, l.cond.segment_size) : n;
+        auto start = (std::max)(now_, l.busy);
+        if(l.cond.bandwidth != 0)
+            start += duration{static_cast<duration::rep>(
+                size * std::uint64_t{1000000000} /
+                    l.cond.bandwidth)};
+        l.busy = start;
+        // segments arrive in order, regardless of jitter
+        l.last = (std::max)(l.last, start + delay + jitter(l));
+        l.flight.push_back({l.last, size});
+        n -= size;
+    }
+}
+
+inline
+void
+simulated_network::
+send_fin(link& l)
+{
+    l.closed = true;
+    l.fin_time = (std::max)(l.last,
+        (std::max)(now_, l.busy) + l.cond.rtt / 2 + jitter(l));
+}
+
+inline
+void
+simulated_network::
+on_read(link& l, std::size_t n)
+{
+    if(l.cond.window == 0)
+        return;
+    l.last_credit = (std::max)(l.last_credit,
+        now_ + l.cond.rtt / 2 + jitter(l));
+    l.credits.push_back({l.last_credit, n});
+}
+
+inline
+void
+simulated_network::
+notify(link& l)
+{
+    if(l.rop && (*l.rop)())
+        l.rop.reset();
+    if(l.wop && (*l.wop)())
+        l.wop.reset();
+}
+
+//------------------------------------------------------------------------------
+
+template<class Handler, class Buffers>
+class simulated_stream::read_op
+    : public simulated_stream::op_base
+{
+    simulated_stream& s_;
+    Buffers b_;
+    Handler h_;
+
+public:
+    template<class DeducedHandler>
+    read_op(simulated_stream& s,
+            Buffers const& b, DeducedHandler&& h)
+        : s_(s)
+        , b_(b)
+        , h_(std::forward<DeducedHandler>(h))
+    {
+    }
+
+    bool
+    operator()() override
+    {
+        error_code ec;
+        std::size_t bytes_transferred;
+        if(! s_.try_read(b_, bytes_transferred, ec))
+            return false;
+        asio::post(
+            s_.get_executor(),
+            bind_handler(
+                std::move(h_),
+                ec,
+                bytes_transferred));
+        return true;
+    }
+};
+
+template<class Handler, class Buffers>
+class simulated_stream::write_op
+    : public simulated_stream::op_base
+{
+    simulated_stream& s_;
+    Buffers b_;
+    Handler h_;
+
+public:
+    template<class DeducedHandler>
+    write_op(simulated_stream& s,
+            Buffers const& b, DeducedHandler&& h)
+        : s_(s)
+        , b_(b)
+        , h_(std::forward<DeducedHandler>(h))
+    {
+    }
+
+    bool
+    operator()() override
+    {
+        error_code ec;
+        std::size_t bytes_transferred;
+        if(! s_.try_write(b_, bytes_transferred, ec))
+            return false;
+        asio::post(
+            s_.get_executor(),
+            bind_handler(
+                std::move(h_),
+                ec,
+                bytes_transferred));
+        return true;
+    }
+};
+
+//------------------------------------------------------------------------------
+
+inline
+simulated_stream::
+~simulated_stream()
+{
+    disconnect();
+}
+
+inline
+simulated_stream::
+simulated_stream(simulated_stream&& other) = default;
+
+inline
+simulated_stream&
+simulated_stream::
+operator=(simulated_stream&& other)
+{
+    if(this != &other)
+    {
+        disconnect();
+        net_ = other.net_;
+        in_ = std::move(other.in_);
+        out_ = std::move(other.out_);
+        nread_ = other.nread_;
+        nwrite_ = other.nwrite_;
+        read_max_ = other.read_max_;
+        write_max_ = other.write_max_;
+    }
+    return *this;
+}
+
+inline
+simulated_stream::
+simulated_stream(simulated_network& net)
+    : net_(&net)
+{
+}
+
+inline
+void
+simulated_stream::
+connect(
+    simulated_stream& remote,
+    network_conditions const& cond)
+{
+    BOOST_ASSERT(net_ == remote.net_);
+    BOOST_ASSERT(! out_);
+    BOOST_ASSERT(! remote.out_);
+    in_ = net_->make_link();
+    remote.in_ = net_->make_link();
+    in_->cond = cond;
+    remote.in_->cond = cond;
+    out_ = remote.in_;
+    remote.out_ = in_;
+}
+
+inline
+void
+simulated_stream::
+close()
+{
+    if(! out_ || out_->closed)
+        return;
+    net_->send_fin(*out_);
+}
+
+template<class MutableBufferSequence>
+std::size_t
+simulated_stream::
+read_some(MutableBufferSequence const& buffers)
+{
+    static_assert(asio::is_mutable_buffer_sequence<
+            MutableBufferSequence>::value,
+        "MutableBufferSequence requirements not met");
+    error_code ec;
+    auto const n = read_some(buffers, ec);
+    if(ec)
+        BOOST_THROW_EXCEPTION(system_error{ec});
+    return n;
+}
+
+template<class MutableBufferSequence>
+std::size_t
+simulated_stream::
+read_some(MutableBufferSequence const& buffers,
+    error_code& ec)
+{
+    static_assert(asio::is_mutable_buffer_sequence<
+            MutableBufferSequence>::value,
+        "MutableBufferSequence requirements not met");
+    BOOST_ASSERT(! in_ || ! in_->rop);
+    std::size_t bytes_transferred;
+    while(! try_read(buffers, bytes_transferred, ec))
+    {
+        if(! net_->step())
+        {
+            ec = asio::error::would_block;
+            return 0;
+        }
+    }
+    return bytes_transferred;
+}
+
+template<class MutableBufferSequence, class ReadHandler>
+ASIO_INITFN_RESULT_TYPE(
+    ReadHandler, void(error_code, std::size_t))
+simulated_stream::
+async_read_some(
+    MutableBufferSequence const& buffers,
+    ReadHandler&& handler)
+{
+    static_assert(asio::is_mutable_buffer_sequence<
+            MutableBufferSequence>::value,
+        "MutableBufferSequence requirements not met");
+    BEAST_HANDLER_INIT(
+        ReadHandler, void(error_code, std::size_t));
+    error_code ec;
+    std::size_t bytes_transferred;
+    if(try_read(buffers, bytes_transferred, ec))
+    {
+        asio::post(
+            get_executor(),
+            bind_handler(
+                std::move(init.completion_handler),
+                ec,
+                bytes_transferred));
+    }
+    else
+    {
+        BOOST_ASSERT(! in_->rop);
+        in_->rop.reset(new read_op<ASIO_HANDLER_TYPE(
+            ReadHandler, void(error_code, std::size_t)),
+                MutableBufferSequence>{*this, buffers,
+                    std::move(init.completion_handler)});
+    }
+    return init.result.get();
+}
+
+template<class ConstBufferSequence>
+std::size_t
+simulated_stream::
+write_some(ConstBufferSequence const& buffers)
+{
+    static_assert(asio::is_const_buffer_sequence<
+            ConstBufferSequence>::value,
+        "ConstBufferSequence requirements not met");
+    error_code ec;
+    auto const bytes_transferred =
+        write_some(buffers, ec);
+    if(ec)
+        BOOST_THROW_EXCEPTION(system_error{ec});
+    return bytes_transferred;
+}
+
+template<class ConstBufferSequence>
+std::size_t
+simulated_stream::
+write_some(
+    ConstBufferSequence const& buffers, error_code& ec)
+{
+    static_assert(asio::is_const_buffer_sequence<
+            ConstBufferSequence>::value,
+        "ConstBufferSequence requirements not met");
+    BOOST_ASSERT(! out_ || ! out_->wop);
+    std::size_t bytes_transferred;
+    while(! try_write(buffers, bytes_transferred, ec))
+    {
+        if(! net_->step())
+        {
+            ec = asio::error::would_block;
+            return 0;
+        }
+    }
+    return bytes_transferred;
+}
+
+template<class ConstBufferSequence, class WriteHandler>
+ASIO_INITFN_RESULT_TYPE(
+    WriteHandler, void(error_code, std::size_t))
+simulated_stream::
+async_write_some(ConstBufferSequence const& buffers,
+    WriteHandler&& handler)
+{
+    static_assert(asio::is_const_buffer_sequence<
+            ConstBufferSequence>::value,
+        "ConstBufferSequence requirements not met");
+    BEAST_HANDLER_INIT(
+        WriteHandler, void(error_code, std::size_t));
+    error_code ec;
+    std::size_t bytes_transferred;
+    if(try_write(buffers, bytes_transferred, ec))
+    {
+        asio::post(
+            get_executor(),
+            bind_handler(
+                std::move(init.completion_handler),
+                ec,
+                bytes_transferred));
+    }
+    else
+    {
+        BOOST_ASSERT(! out_->wop);
+        out_->wop.reset(new write_op<ASIO_HANDLER_TYPE(
+            WriteHandler, void(error_code, std::size_t)),
+                ConstBufferSequence>{*this, buffers,
+                    std::move(init.completion_handler)});
+    }
+    return init.result.get();
+}
+
+template<class MutableBufferSequence>
+bool
+simulated_stream::
+try_read(
+    MutableBufferSequence const& buffers,
+    std::size_t& bytes_transferred,
+    error_code& ec)
+{
+    bytes_transferred = 0;
+    if(! in_)
+    {
+        ec = asio::error::not_connected;
+        return true;
+    }
+    if(asio::buffer_size(buffers) == 0)
+    {
+        ec.assign(0, ec.category());
+        return true;
+    }
+    auto& l = *in_;
+    if(l.readable == 0)
+    {
+        if(! l.fin)
+            return false;
+        ++nread_;
+        ec = asio::error::eof;
+        return true;
+    }
+    bytes_transferred = asio::buffer_copy(buffers,
+        buffers_prefix((std::min)(l.readable, read_max_),
+            l.b.data()));
+    l.b.consume(bytes_transferred);
+    l.readable -= bytes_transferred;
+    net_->on_read(l, bytes_transferred);
+    ++nread_;
+    ec.assign(0, ec.category());
+    return true;
+}
+
+template<class ConstBufferSequence>
+bool
+simulated_stream::
+try_write(
+    ConstBufferSequence const& buffers,
+    std::size_t& bytes_transferred,
+    error_code& ec)
+{
+    bytes_transferred = 0;
+    if(! out_ || out_->orphaned)
+    {
+        ec = asio::error::connection_reset;
+        return true;
+    }
+    BOOST_ASSERT(! out_->closed);
+    auto n = (std::min)(
+        asio::buffer_size(buffers), write_max_);
+    if(n == 0)
+    {
+        ec.assign(0, ec.category());
+        return true;
+    }
+    auto& l = *out_;
+    if(l.cond.window != 0)
+    {
+        if(l.unacked >= l.cond.window)
+            return false;
+        n = (std::min)(n, l.cond.window - l.unacked);
+    }
+    if(l.cond.partial_writes && n > 1)
+        n = 1 + static_cast<std::size_t>(net_->rng_() % n);
+    bytes_transferred = asio::buffer_copy(
+        l.b.prepare(n), buffers);
+    l.b.commit(bytes_transferred);
+    net_->send(l, bytes_transferred);
+    ++nwrite_;
+    ec.assign(0, ec.category());
+    return true;
+}
+
+inline
+void
+simulated_stream::
+disconnect()
+{
+    if(out_)
+    {
+        out_->wop.reset();
+        close();
+        out_.reset();
+    }
+    if(in_)
+    {
+        // a pending write of the peer fails now
+        in_->rop.reset();
+        in_->orphaned = true;
+        net_->notify(*in_);
+        in_.reset();
+    }
+}
+
+inline
+void
+teardown(
+websocket::role_type,
+simulated_stream& s,
+std::error_code& ec)
+{
+    s.close();
+    ec.assign(0, ec.category());
+}
+
+template<class TeardownHandler>
+inline
+void
+async_teardown(
+websocket::role_type,
+simulated_stream& s,
+TeardownHandler&& handler)
+{
+    s.close();
+    asio::post(
+        s.get_executor(),
+        bind_handler(std::move(handler), error_code{}));
+}
+
+} // test
+} // beast
+
+#endif
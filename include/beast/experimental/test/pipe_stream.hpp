@@ -0,0 +1,381 @@
+//
+// Copyright (c) 2016-2017 Vinnie Falco (vinnie dot falco at gmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/boostorg/beast
+//
+
+#ifndef BEAST_TEST_PIPE_STREAM_HPP
+#define BEAST_TEST_PIPE_STREAM_HPP
+
+#include <beast/core/error.hpp>
+#include <beast/websocket/teardown.hpp>
+#include <asio/async_result.hpp>
+#include <asio/buffer.hpp>
+#include <asio/io_context.hpp>
+#include <atomic>
+#include <cstddef>
+#include <limits>
+#include <memory>
+
+namespace beast {
+namespace test {
+
+/** A two-way in-process stream for measuring performance
+
+    An instance of this class is one end of a connection whose
+    two directions are each a fixed size ring buffer with a single
+    producer and a single consumer. Writes copy data into the
+    ring read by the peer, and reads copy data out of the ring
+    written by the peer. The positions in each ring are atomic
+    counters, so no locks are taken and no system calls are made
+    while data is moving. The two ends of a connection may be used
+    from different threads, which allows a client and a server to
+    be run against each other in one process without the cost and
+    variance of the kernel's network stack.
+
+    A blocking operation which can not make progress, because the
+    ring is empty when reading or full when writing, spins until
+    the peer catches up, yielding the thread after a while. An
+    asynchronous operation which can not make progress posts itself
+    to the executor and tries again, likewise yielding the thread
+    when it has been retried many times. An `io_context` with a
+    pending operation on a pipe stream never runs out of work and
+    never blocks in the operating system. For the same reason,
+    `io_context::poll` does not return while such an operation is
+    pending; use `io_context::poll_one` instead.
+
+    Unlike @ref stream, this class does not support fail counts or
+    inspecting the input area. Use @ref stream for correctness tests
+    and pipe streams for benchmarks.
+
+    @par Thread Safety
+        @e Distinct @e objects: Safe.@n
+        @e Shared @e objects: Unsafe.
+        Each end of a connection may be used by a different thread.
+
+    @par Concepts
+        @li @b SyncReadStream
+        @li @b SyncWriteStream
+        @li @b AsyncReadStream
+        @li @b AsyncWriteStream
+*/
+class pipe_stream
+{
+    template<class Handler, class Buffers>
+    class read_op;
+
+    template<class Handler, class Buffers>
+    class write_op;
+
+    enum class status
+    {
+        ok,
+        eof,
+        reset
+    };
+
+    // Each counter is written by one side only, and is kept
+    // on its own cache line to avoid false sharing.
+    struct pipe
+    {
+        std::unique_ptr<char[]> buf;
+        std::size_t mask;
+        char pad0[64];
+        std::atomic<std::size_t> head; // octets written
+        char pad1[64];
+        std::atomic<std::size_t> tail; // octets read
+        char pad2[64];
+        std::atomic<status> code;      // set by the producer
+        std::atomic<bool> orphaned;    // set by the consumer
+
+        explicit
+        pipe(std::size_t capacity);
+    };
+
+    asio::io_context* ioc_;
+    std::shared_ptr<pipe> in_;
+    std::shared_ptr<pipe> out_;
+    std::size_t capacity_;
+    std::size_t head_ = 0;  // cached in_->head
+    std::size_t tail_ = 0;  // cached out_->tail
+    std::size_t nread_ = 0;
+    std::size_t nwrite_ = 0;
+    std::size_t read_max_ =
+        (std::numeric_limits<std::size_t>::max)();
+    std::size_t write_max_ =
+        (std::numeric_limits<std::size_t>::max)();
+
+public:
+    /// The type of the lowest layer.
+    using lowest_layer_type = pipe_stream;
+
+    /// The type of the executor associated with the object.
+    using executor_type =
+        asio::io_context::executor_type;
+
+    /** Destructor
+
+        If a connection is established while the stream is destroyed,
+        the peer will see the error `asio::error::connection_reset`
+        when performing any reads or writes, after reading the data
+        which was already written.
+    */
+    ~pipe_stream();
+
+    /** Move Constructor
+
+        Moving the stream while operations are pending
+        results in undefined behavior.
+    */
+    pipe_stream(pipe_stream&& other);
+
+    /** Move Assignment
+
+        Moving the stream while operations are pending
+        results in undefined behavior.
+    */
+    pipe_stream&
+    operator=(pipe_stream&& other);
+
+    /** Construct a stream
+
+        The stream will be created in a disconnected state.
+
+        @param ioc The `io_context` object that the stream will use to
+        dispatch handlers for any asynchronous operations.
+
+        @param capacity The size of the ring buffer holding the data
+        written by the peer, rounded up to a power of two.
+    */
+    explicit
+    pipe_stream(
+        asio::io_context& ioc,
+        std::size_t capacity = 64 * 1024);
+
+    /// Establish a connection
+    void
+    connect(pipe_stream& remote);
+
+    /// Return the executor associated with the object.
+    executor_type
+    get_executor() noexcept
+    {
+        return ioc_->get_executor();
+    }
+
+    /// Get a reference to the lowest layer
+    lowest_layer_type&
+    lowest_layer()
+    {
+        return *this;
+    }
+
+    /// Get a const reference to the lowest layer
+    lowest_layer_type const&
+    lowest_layer() const
+    {
+        return *this;
+    }
+
+    /// Set the maximum number of bytes returned by read_some
+    void
+    read_size(std::size_t n)
+    {
+        read_max_ = n;
+    }
+
+    /// Set the maximum number of bytes returned by write_some
+    void
+    write_size(std::size_t n)
+    {
+        write_max_ = n;
+    }
+
+    /// Return the number of reads
+    std::size_t
+    nread() const
+    {
+        return nread_;
+    }
+
+    /// Return the number of writes
+    std::size_t
+    nwrite() const
+    {
+        return nwrite_;
+    }
+
+    /** Close the stream.
+
+        The other end of the connection will see
+        `error::eof` after reading all the remaining data.
+    */
+    void
+    close();
+
+    /** Read some data from the stream.
+
+        This function is used to read data from the stream. The function
+        call will block until one or more bytes of data has been read
+        successfully, or until an error occurs.
+
+        @param buffers The buffers into which the data will be read.
+
+        @returns The number of bytes read.
+
+        @throws std::system_error Thrown on failure.
+    */
+    template<class MutableBufferSequence>
+    std::size_t
+    read_some(MutableBufferSequence const& buffers);
+
+    /** Read some data from the stream.
+
+        This function is used to read data from the stream. The function
+        call will block until one or more bytes of data has been read
+        successfully, or until an error occurs.
+
+        @param buffers The buffers into which the data will be read.
+
+        @param ec Set to indicate what error occurred, if any.
+
+        @returns The number of bytes read.
+    */
+    template<class MutableBufferSequence>
+    std::size_t
+    read_some(MutableBufferSequence const& buffers,
+        error_code& ec);
+
+    /** Start an asynchronous read.
+
+        This function is used to asynchronously read one or more bytes
+        of data from the stream. The function call always returns
+        immediately.
+
+        @param buffers The buffers into which the data will be read.
+        Although the buffers object may be copied as necessary,
+        ownership of the underlying buffers is retained by the caller,
+        which must guarantee that they remain valid until the handler
+        is called.
+
+        @param handler The handler to be called when the read operation
+        completes. Copies will be made of the handler as required. The
+        equivalent function signature of the handler must be:
+        @code void handler(
+          const std::error_code& error, // Result of operation.
+          std::size_t bytes_transferred // Number of bytes read.
+        ); @endcode
+    */
+    template<class MutableBufferSequence, class ReadHandler>
+    ASIO_INITFN_RESULT_TYPE(
+        ReadHandler, void(error_code, std::size_t))
+    async_read_some(MutableBufferSequence const& buffers,
+        ReadHandler&& handler);
+
+    /** Write some data to the stream.
+
+        This function is used to write data on the stream. The function
+        call will block until one or more bytes of data has been written
+        successfully, or until an error occurs.
+
+        @param buffers The data to be written.
+
+        @returns The number of bytes written.
+
+        @throws std::system_error Thrown on failure.
+    */
+    template<class ConstBufferSequence>
+    std::size_t
+    write_some(ConstBufferSequence const& buffers);
+
+    /** Write some data to the stream.
+
+        This function is used to write data on the stream. The function
+        call will block until one or more bytes of data has been written
+        successfully, or until an error occurs.
+
+        @param buffers The data to be written.
+
+        @param ec Set to indicate what error occurred, if any.
+
+        @returns The number of bytes written.
+    */
+    template<class ConstBufferSequence>
+    std::size_t
+    write_some(
+        ConstBufferSequence const& buffers, error_code& ec);
+
+    /** Start an asynchronous write.
+
+        This function is used to asynchronously write one or more bytes
+        of data to the stream. The function call always returns
+        immediately.
+
+        @param buffers The data to be written to the stream. Although
+        the buffers object may be copied as necessary, ownership of the
+        underlying buffers is retained by the caller, which must
+        guarantee that they remain valid until the handler is called.
+
+        @param handler The handler to be called when the write operation
+        completes. Copies will be made of the handler as required. The
+        equivalent function signature of the handler must be:
+        @code void handler(
+          const std::error_code& error, // Result of operation.
+          std::size_t bytes_transferred // Number of bytes written.
+        ); @endcode
+    */
+    template<class ConstBufferSequence, class WriteHandler>
+    ASIO_INITFN_RESULT_TYPE(
+        WriteHandler, void(error_code, std::size_t))
+    async_write_some(ConstBufferSequence const& buffers,
+        WriteHandler&& handler);
+
+#if ! BEAST_DOXYGEN
+    friend
+    void
+    teardown(
+        websocket::role_type,
+        pipe_stream& s,
+        std::error_code& ec);
+
+    template<class TeardownHandler>
+    friend
+    void
+    async_teardown(
+        websocket::role_type role,
+        pipe_stream& s,
+        TeardownHandler&& handler);
+#endif
+
+private:
+    template<class MutableBufferSequence>
+    bool
+    try_read(
+        MutableBufferSequence const& buffers,
+        std::size_t& bytes_transferred,
+        error_code& ec);
+
+    template<class ConstBufferSequence>
+    bool
+    try_write(
+        ConstBufferSequence const& buffers,
+        std::size_t& bytes_transferred,
+        error_code& ec);
+
+    static
+    void
+    wait(std::size_t& spins);
+
+    void
+    disconnect();
+};
+
+} // test
+} // beast
+
+#include <beast/experimental/test/impl/pipe_stream.ipp>
+
+#endif
@@ -0,0 +1,547 @@
+//
+// Copyright (c) 2016-2017 Vinnie Falco (vinnie dot falco at gmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/boostorg/beast
+//
+
+#ifndef BEAST_TEST_SIMULATED_STREAM_HPP
+#define BEAST_TEST_SIMULATED_STREAM_HPP
+
+#include <beast/core/error.hpp>
+#include <beast/core/flat_buffer.hpp>
+#include <beast/websocket/teardown.hpp>
+#include <asio/async_result.hpp>
+#include <asio/buffer.hpp>
+#include <asio/io_context.hpp>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace beast {
+namespace test {
+
+/** The conditions of a connection between two simulated streams.
+
+    Both directions of a connection have the same conditions,
+    and are simulated independently of each other.
+*/
+struct network_conditions
+{
+    /** The number of octets per second sent in each direction.
+
+        Each segment occupies the sending side of the connection
+        for its size divided by the bandwidth, and segments are sent
+        one after the other. Zero means the bandwidth is unlimited.
+    */
+    std::uint64_t bandwidth = 0;
+
+    /** The round trip time.
+
+        Half of the round trip time is added to the time at which
+        each segment arrives, and to the time at which the sender
+        learns that data was read by the peer.
+    */
+    std::chrono::nanoseconds rtt{0};
+
+    /** The largest random delay added to the one way trip time.
+
+        Each segment and each window update is delayed by a random
+        amount up to this value. Segments still arrive in the order
+        in which they were sent.
+    */
+    std::chrono::nanoseconds jitter{0};
+
+    /** The largest segment.
+
+        Writes are split into segments of at most this many octets,
+        and the data in a segment becomes readable all at once.
+        The default is the usual TCP payload in an Ethernet frame.
+    */
+    std::size_t segment_size = 1460;
+
+    /** The size of the receive window.
+
+        This is the largest number of octets which may be written
+        and not yet known by the writer to have been read by the
+        peer. A write to a connection whose window is full waits
+        until the peer reads, and half a round trip has passed.
+        Zero means the window is unlimited.
+    */
+    std::size_t window = 64 * 1024;
+
+    /** Whether writes may transfer less than the window allows.
+
+        When `true`, each write transfers a random number of octets
+        between one and the most that the window allows, as a real
+        socket may do when the send buffer is nearly full.
+    */
+    bool partial_writes = false;
+};
+
+class simulated_stream;
+
+/** A simulated network with a virtual clock.
+
+    This object holds the virtual clock and the source of random
+    numbers shared by a set of connected @ref simulated_stream
+    objects. Data written to a simulated stream becomes readable
+    by the peer when the virtual clock reaches the time at which
+    it arrives, according to the @ref network_conditions of the
+    connection. The clock only advances when the network is run
+    and every handler which is ready has been invoked, so the
+    outcome of a simulation depends only on the conditions, the
+    seed and the program, and not on the speed of the computer.
+
+    Asynchronous operations on simulated streams do not count as
+    outstanding work for the `io_context`. Call @ref run instead of
+    `io_context::run` to invoke handlers and advance the clock.
+
+    @par Thread Safety
+        @e Distinct @e objects: Safe.@n
+        @e Shared @e objects: Unsafe.
+        The network and all of its streams must be used from
+        the same implicit or explicit strand.
+*/
+class simulated_network
+{
+    friend class simulated_stream;
+
+    struct link;
+
+    asio::io_context& ioc_;
+    std::mt19937 rng_;
+    std::chrono::nanoseconds now_{0};
+    std::vector<std::weak_ptr<link>> links_;
+
+public:
+    /// The type of duration measured by the virtual clock.
+    using duration = std::chrono::nanoseconds;
+
+    /// Destructor
+    ~simulated_network() = default;
+
+    simulated_network(simulated_network const&) = delete;
+    simulated_network& operator=(simulated_network const&) = delete;
+
+    /** Constructor
+
+        @param ioc The `io_context` used by the streams of the
+        network to invoke the handlers of asynchronous operations.
+
+        @param seed The seed of the random numbers used for jitter
+        and partial writes. Two simulations with the same seed and
+        the same sequence of operations have the same outcome.
+    */
+    explicit
+    simulated_network(
+        asio::io_context& ioc,
+        std::uint32_t seed = 1);
+
+    /// Return the `io_context` associated with the network
+    asio::io_context&
+    get_io_context()
+    {
+        return ioc_;
+    }
+
+    /// Return the time elapsed on the virtual clock
+    duration
+    now() const
+    {
+        return now_;
+    }
+
+    /** Run the simulation.
+
+        This invokes handlers which are ready on the `io_context`.
+        When there are none, the clock advances to the next time
+        at which data arrives or a window opens, operations which
+        can now complete are completed, and the process repeats.
+        The function returns when no handler is ready and nothing
+        is in flight.
+
+        @returns The number of handlers invoked.
+    */
+    std::size_t
+    run();
+
+    /** Advance the clock to the next event.
+
+        Data which arrives and windows which open at that time are
+        delivered, and asynchronous operations which can complete
+        are completed, by posting their handlers. No handlers are
+        invoked by this function.
+
+        @returns `false` if nothing was in flight.
+    */
+    bool
+    step();
+
+private:
+    std::shared_ptr<link>
+    make_link();
+
+    duration
+    jitter(link const& l);
+
+    void
+    send(link& l, std::size_t n);
+
+    void
+    send_fin(link& l);
+
+    void
+    on_read(link& l, std::size_t n);
+
+    void
+    notify(link& l);
+};
+
+/** A stream which simulates a network connection.
+
+    An instance of this class is one end of a connection on a
+    @ref simulated_network. Data written to the stream is split into
+    segments which arrive at the peer after the delay given by the
+    bandwidth, the round trip time and the jitter of the connection.
+    A write transfers no more than the receive window allows, and
+    waits when the window is full until the peer reads data and
+    the window update arrives. Reads complete with the data which
+    has arrived by the time on the virtual clock.
+
+    This allows the effects of buffering, flushing, and timing
+    decisions made by a protocol implementation to be measured
+    in virtual time, deterministically, on a single thread,
+    without sockets.
+
+    A synchronous operation which can not complete advances the
+    virtual clock until it can. If it could never complete because
+    nothing is in flight, for example when the peer has not yet
+    written, it fails with `asio::error::would_block`. Synchronous
+    operations do not invoke handlers.
+
+    @par Thread Safety
+        @e Distinct @e objects: Safe.@n
+        @e Shared @e objects: Unsafe.
+        The stream must be used from the same implicit or
+        explicit strand as its network.
+
+    @par Concepts
+        @li @b SyncReadStream
+        @li @b SyncWriteStream
+        @li @b AsyncReadStream
+        @li @b AsyncWriteStream
+*/
+class simulated_stream
+{
+    friend class simulated_network;
+
+    struct op_base
+    {
+        virtual ~op_base() = default;
+
+        // Returns `true` if the operation completed
+        virtual bool operator()() = 0;
+    };
+
+    template<class Handler, class Buffers>
+    class read_op;
+
+    template<class Handler, class Buffers>
+    class write_op;
+
+    simulated_network* net_;
+    std::shared_ptr<simulated_network::link> in_;
+    std::shared_ptr<simulated_network::link> out_;
+    std::size_t nread_ = 0;
+    std::size_t nwrite_ = 0;
+    std::size_t read_max_ =
+        (std::numeric_limits<std::size_t>::max)();
+    std::size_t write_max_ =
+        (std::numeric_limits<std::size_t>::max)();
+
+public:
+    /// The type of the lowest layer.
+    using lowest_layer_type = simulated_stream;
+
+    /// The type of the executor associated with the object.
+    using executor_type =
+        asio::io_context::executor_type;
+
+    /** Destructor
+
+        Pending asynchronous operations are abandoned without
+        invoking their handlers. If a connection is established,
+        the peer reads the data which was already written followed
+        by `asio::error::eof`, and its writes fail with
+        `asio::error::connection_reset`.
+    */
+    ~simulated_stream();
+
+    /** Move Constructor
+
+        Moving the stream while operations are pending
+        results in undefined behavior.
+    */
+    simulated_stream(simulated_stream&& other);
+
+    /** Move Assignment
+
+        Moving the stream while operations are pending
+        results in undefined behavior.
+    */
+    simulated_stream&
+    operator=(simulated_stream&& other);
+
+    /** Construct a stream
+
+        The stream will be created in a disconnected state.
+
+        @param net The network on which the stream communicates.
+    */
+    explicit
+    simulated_stream(simulated_network& net);
+
+    /** Establish a connection
+
+        @param remote The other end of the connection, which must
+        belong to the same network and be disconnected.
+
+        @param cond The conditions of the connection.
+    */
+    void
+    connect(
+        simulated_stream& remote,
+        network_conditions const& cond = {});
+
+    /// Return the network of the stream
+    simulated_network&
+    network()
+    {
+        return *net_;
+    }
+
+    /// Return the executor associated with the object.
+    executor_type
+    get_executor() noexcept
+    {
+        return net_->get_io_context().get_executor();
+    }
+
+    /// Get a reference to the lowest layer
+    lowest_layer_type&
+    lowest_layer()
+    {
+        return *this;
+    }
+
+    /// Get a const reference to the lowest layer
+    lowest_layer_type const&
+    lowest_layer() const
+    {
+        return *this;
+    }
+
+    /// Set the maximum number of bytes returned by read_some
+    void
+    read_size(std::size_t n)
+    {
+        read_max_ = n;
+    }
+
+    /// Set the maximum number of bytes returned by write_some
+    void
+    write_size(std::size_t n)
+    {
+        write_max_ = n;
+    }
+
+    /// Return the number of reads
+    std::size_t
+    nread() const
+    {
+        return nread_;
+    }
+
+    /// Return the number of writes
+    std::size_t
+    nwrite() const
+    {
+        return nwrite_;
+    }
+
+    /** Close the stream.
+
+        The other end of the connection will see
+        `error::eof` after reading all the remaining data,
+        once the end of the data has arrived.
+    */
+    void
+    close();
+
+    /** Read some data from the stream.
+
+        This function is used to read data from the stream. The function
+        call will advance the virtual clock until one or more bytes of
+        data has been read successfully, or until an error occurs.
+
+        @param buffers The buffers into which the data will be read.
+
+        @returns The number of bytes read.
+
+        @throws std::system_error Thrown on failure.
+    */
+    template<class MutableBufferSequence>
+    std::size_t
+    read_some(MutableBufferSequence const& buffers);
+
+    /** Read some data from the stream.
+
+        This function is used to read data from the stream. The function
+        call will advance the virtual clock until one or more bytes of
+        data has been read successfully, or until an error occurs.
+
+        @param buffers The buffers into which the data will be read.
+
+        @param ec Set to indicate what error occurred, if any.
+
+        @returns The number of bytes read.
+    */
+    template<class MutableBufferSequence>
+    std::size_t
+    read_some(MutableBufferSequence const& buffers,
+        error_code& ec);
+
+    /** Start an asynchronous read.
+
+        This function is used to asynchronously read one or more bytes
+        of data from the stream. The function call always returns
+        immediately.
+
+        @param buffers The buffers into which the data will be read.
+        Although the buffers object may be copied as necessary,
+        ownership of the underlying buffers is retained by the caller,
+        which must guarantee that they remain valid until the handler
+        is called.
+
+        @param handler The handler to be called when the read operation
+        completes. Copies will be made of the handler as required. The
+        equivalent function signature of the handler must be:
+        @code void handler(
+          const std::error_code& error, // Result of operation.
+          std::size_t bytes_transferred // Number of bytes read.
+        ); @endcode
+    */
+    template<class MutableBufferSequence, class ReadHandler>
+    ASIO_INITFN_RESULT_TYPE(
+        ReadHandler, void(error_code, std::size_t))
+    async_read_some(MutableBufferSequence const& buffers,
+        ReadHandler&& handler);
+
+    /** Write some data to the stream.
+
+        This function is used to write data on the stream. The function
+        call will advance the virtual clock until one or more bytes of
+        data has been written successfully, or until an error occurs.
+
+        @param buffers The data to be written.
+
+        @returns The number of bytes written.
+
+        @throws std::system_error Thrown on failure.
+    */
+    template<class ConstBufferSequence>
+    std::size_t
+    write_some(ConstBufferSequence const& buffers);
+
+    /** Write some data to the stream.
+
+        This function is used to write data on the stream. The function
+        call will advance the virtual clock until one or more bytes of
+        data has been written successfully, or until an error occurs.
+
+        @param buffers The data to be written.
+
+        @param ec Set to indicate what error occurred, if any.
+
+        @returns The number of bytes written.
+    */
+    template<class ConstBufferSequence>
+    std::size_t
+    write_some(
+        ConstBufferSequence const& buffers, error_code& ec);
+
+    /** Start an asynchronous write.
+
+        This function is used to asynchronously write one or more bytes
+        of data to the stream. The function call always returns
+        immediately.
+
+        @param buffers The data to be written to the stream. Although
+        the buffers object may be copied as necessary, ownership of the
+        underlying buffers is retained by the caller, which must
+        guarantee that they remain valid until the handler is called.
+
+        @param handler The handler to be called when the write operation
+        completes. Copies will be made of the handler as required. The
+        equivalent function signature of the handler must be:
+        @code void handler(
+          const std::error_code& error, // Result of operation.
+          std::size_t bytes_transferred // Number of bytes written.
+        ); @endcode
+    */
+    template<class ConstBufferSequence, class WriteHandler>
+    ASIO_INITFN_RESULT_TYPE(
+        WriteHandler, void(error_code, std::size_t))
+    async_write_some(ConstBufferSequence const& buffers,
+        WriteHandler&& handler);
+
+#if ! BEAST_DOXYGEN
+    friend
+    void
+    teardown(
+        websocket::role_type,
+        simulated_stream& s,
+        std::error_code& ec);
+
+    template<class TeardownHandler>
+    friend
+    void
+    async_teardown(
+        websocket::role_type role,
+        simulated_stream& s,
+        TeardownHandler&& handler);
+#endif
+
+private:
+    template<class MutableBufferSequence>
+    bool
+    try_read(
+        MutableBufferSequence const& buffers,
+        std::size_t& bytes_transferred,
+        error_code& ec);
+
+    template<class ConstBufferSequence>
+    bool
+    try_write(
+        ConstBufferSequence const& buffers,
+        std::size_t& bytes_transferred,
+        error_code& ec);
+
+    void
+    disconnect();
+};
+
+} // test
+} // beast
+
+#include <beast/experimental/test/impl/simulated_stream.ipp>
+
+#endif
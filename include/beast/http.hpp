@@ -12,17 +12,25 @@
 
 #include <beast/core/detail/config.hpp>
 
+#include <beast/http/async_file_body.hpp>
 #include <beast/http/basic_dynamic_body.hpp>
 #include <beast/http/basic_parser.hpp>
 #include <beast/http/buffer_body.hpp>
+#include <beast/http/cached_file_body.hpp>
 #include <beast/http/chunk_encode.hpp>
+#include <beast/http/compressed_body.hpp>
+#include <beast/http/content_coding.hpp>
+#include <beast/http/decompressing_body.hpp>
 #include <beast/http/dynamic_body.hpp>
 #include <beast/http/empty_body.hpp>
 #include <beast/http/error.hpp>
 #include <beast/http/field.hpp>
 #include <beast/http/fields.hpp>
 #include <beast/http/file_body.hpp>
+#include <beast/http/file_cache.hpp>
+#include <beast/http/fragments_body.hpp>
 #include <beast/http/message.hpp>
+#include <beast/http/mmap_body.hpp>
 #include <beast/http/parser.hpp>
 #include <beast/http/read.hpp>
 #include <beast/http/rfc7230.hpp>
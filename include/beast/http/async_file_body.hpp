@@ -0,0 +1,516 @@
+//
+// Copyright (c) 2016-2017 Vinnie Falco (vinnie dot falco at gmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/boostorg/beast
+//
+
+#ifndef BEAST_HTTP_ASYNC_FILE_BODY_HPP
+#define BEAST_HTTP_ASYNC_FILE_BODY_HPP
+
+#include <beast/core/bind_handler.hpp>
+#include <beast/core/error.hpp>
+#include <beast/core/file.hpp>
+#include <beast/core/file_base.hpp>
+#include <beast/core/type_traits.hpp>
+#include <beast/core/detail/allocator.hpp>
+#include <beast/http/error.hpp>
+#include <beast/http/message.hpp>
+#include <beast/http/detail/file_read_buffer.hpp>
+#include <asio/associated_allocator.hpp>
+#include <asio/associated_executor.hpp>
+#include <asio/buffer.hpp>
+#include <asio/executor.hpp>
+#include <asio/executor_work_guard.hpp>
+#include <asio/post.hpp>
+#include <boost/assert.hpp>
+#include <boost/optional.hpp>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+namespace beast {
+namespace http {
+
+/** A message body which reads a file on a separate executor.
+
+    This body serializes a file like @ref basic_file_body, but
+    the file is read by function objects submitted to an executor
+    chosen by the caller, typically that of an `asio::thread_pool`
+    reserved for file I/O. While a read is in progress the writer
+    fails with @ref error::need_more, and the stream algorithms
+    @ref write_some, @ref async_write_some and the functions built
+    on them wait for the read to finish instead of reporting the
+    error. A slow disk then delays only the message being sent,
+    rather than every connection served by the same thread.
+
+    The writer reads ahead: while one buffer is being sent, the
+    next piece of the file is read into another one. The amount
+    read at once grows from 64KB up to the limit set with
+    @ref value_type::read_size.
+
+    If no executor is set, the file is read synchronously as
+    with @ref basic_file_body.
+
+    Messages using this body type may be serialized but not
+    parsed.
+
+    @tparam File The implementation to use for accessing files.
+    This type must meet the requirements of @b File.
+*/
+template<class File>
+struct basic_async_file_body
+{
+    static_assert(is_file<File>::value,
+        "File requirements not met");
+
+    /// The type of File this body uses
+    using file_type = File;
+
+    /// The type of the @ref message::body member.
+    class value_type
+    {
+        friend struct basic_async_file_body;
+
+        // Shared with a read in progress, which
+        // may outlive the writer and the message.
+        std::shared_ptr<File> file_;
+        std::uint64_t size_ = 0;
+        std::size_t read_size_ = 1024 * 1024;
+        boost::optional<asio::executor> ex_;
+
+    public:
+        /// Constructor
+        value_type() = default;
+
+        /// Constructor
+        value_type(value_type&&) = default;
+
+        /// Move assignment
+        value_type& operator=(value_type&&) = default;
+
+        /// Returns `true` if the file is open
+        bool
+        is_open() const
+        {
+            return file_ && file_->is_open();
+        }
+
+        /// Returns the size of the file if open
+        std::uint64_t
+        size() const
+        {
+            return size_;
+        }
+
+        /// Returns the largest number of bytes read at once
+        std::size_t
+        read_size() const
+        {
+            return read_size_;
+        }
+
+        /** Set the largest number of bytes read at once
+
+            @param n The number of bytes. This may not be zero.
+            The default is 1MB.
+        */
+        void
+        read_size(std::size_t n)
+        {
+            BOOST_ASSERT(n > 0);
+            read_size_ = n;
+        }
+
+        /** Set the executor used to read the file
+
+            Reads are submitted with `asio::post`. A read keeps
+            the file and its buffer alive, so the writer and the
+            message may be destroyed without waiting for it, and
+            a read which never runs is simply discarded.
+        */
+        void
+        executor(asio::executor ex)
+        {
+            ex_.emplace(std::move(ex));
+        }
+
+        /// Read the file synchronously from now on
+        void
+        clear_executor()
+        {
+            ex_ = boost::none;
+        }
+
+        /** Close the file if open
+
+            If a read is in progress, the file is closed
+            when it finishes.
+        */
+        void
+        close()
+        {
+            file_.reset();
+            size_ = 0;
+        }
+
+        /** Open a file at the given path with the specified mode
+
+            @param path The utf-8 encoded path to the file
+
+            @param mode The file mode to use
+
+            @param ec Set to the error, if any occurred
+        */
+        void
+        open(char const* path, file_mode mode, error_code& ec)
+        {
+            close();
+            file_ = std::make_shared<File>();
+            file_->open(path, mode, ec);
+            if(ec)
+            {
+                close();
+                return;
+            }
+            size_ = file_->size(ec);
+            if(ec)
+                close();
+        }
+
+        /** Set the open file
+
+            Any previously set file will be closed.
+
+            @param file The file to set. The file must be open.
+
+            @param ec Set to the error, if any occurred
+        */
+        void
+        reset(File&& file, error_code& ec)
+        {
+            close();
+            file_ = std::make_shared<File>(std::move(file));
+            size_ = file_->size(ec);
+        }
+    };
+
+    /// Returns the size of the body
+    static
+    std::uint64_t
+    size(value_type const& body)
+    {
+        return body.size();
+    }
+
+    /** The algorithm for serializing the body
+
+        Meets the requirements of @b BodyWriter. In addition to
+        the usual members, the writer provides `wait` and
+        `async_wait`, which the stream algorithms use to wait
+        for a read in progress.
+    */
+#if BEAST_DOXYGEN
+    using writer = implementation_defined;
+#else
+    class writer;
+#endif
+
+private:
+    // Handlers waiting for a read to finish
+    struct waiter
+    {
+        virtual ~waiter() = default;
+
+        virtual
+        void
+        destroy() = 0;
+
+        virtual
+        void
+        complete(error_code ec) = 0;
+    };
+
+    template<class Handler>
+    class waiter_impl : public waiter
+    {
+        Handler h_;
+        asio::executor_work_guard<
+            asio::associated_executor_t<Handler>> wg_;
+
+        using alloc_type = typename beast::detail::allocator_traits<
+            asio::associated_allocator_t<Handler>>::template
+                rebind_alloc<waiter_impl>;
+
+        using alloc_traits =
+            beast::detail::allocator_traits<alloc_type>;
+
+    public:
+        template<class DeducedHandler>
+        explicit
+        waiter_impl(DeducedHandler&& h)
+            : h_(std::forward<DeducedHandler>(h))
+            , wg_(asio::get_associated_executor(h_))
+        {
+        }
+
+        // Allocated using the handler's allocator
+        template<class DeducedHandler>
+        static
+        waiter*
+        create(DeducedHandler&& h)
+        {
+            alloc_type alloc{asio::get_associated_allocator(h)};
+            auto const d =
+                [&alloc](waiter_impl* p)
+                {
+                    alloc_traits::deallocate(alloc, p, 1);
+                };
+            std::unique_ptr<waiter_impl, decltype(d)> p{
+                alloc_traits::allocate(alloc, 1), d};
+            alloc_traits::construct(alloc, p.get(),
+                std::forward<DeducedHandler>(h));
+            return p.release();
+        }
+
+        void
+        destroy() override
+        {
+            Handler h(std::move(h_));
+            alloc_type alloc{asio::get_associated_allocator(h)};
+            alloc_traits::destroy(alloc, this);
+            alloc_traits::deallocate(alloc, this, 1);
+        }
+
+        void
+        complete(error_code ec) override
+        {
+            // Free the memory before the handler runs
+            Handler h(std::move(h_));
+            auto wg = std::move(wg_);
+            alloc_type alloc{asio::get_associated_allocator(h)};
+            alloc_traits::destroy(alloc, this);
+            alloc_traits::deallocate(alloc, this, 1);
+            asio::post(wg.get_executor(),
+                bind_handler(std::move(h), ec));
+        }
+    };
+
+    // State shared with the read running on the executor
+    struct state
+    {
+        std::mutex m;
+        std::condition_variable cv;
+        std::shared_ptr<File> file;
+        detail::file_read_buffer buf[2];
+        asio::mutable_buffer out;   // where the read stores data
+        std::size_t nread = 0;      // result of the last read
+        error_code ec;              // error from the last read
+        bool busy = false;          // a read is in progress
+        bool ready = false;         // the last read is unclaimed
+        waiter* w = nullptr;
+
+        state(std::shared_ptr<File> f, std::size_t limit)
+            : file(std::move(f))
+            , buf{detail::file_read_buffer{limit},
+                  detail::file_read_buffer{limit}}
+        {
+        }
+
+        ~state()
+        {
+            if(w)
+                w->destroy();
+        }
+    };
+
+    struct read_op
+    {
+        std::shared_ptr<state> sp;
+
+        void
+        operator()() const
+        {
+            auto& st = *sp;
+            error_code ec;
+            auto const n = st.file->read(
+                st.out.data(), st.out.size(), ec);
+            waiter* w;
+            {
+                std::lock_guard<std::mutex> lock(st.m);
+                st.nread = n;
+                st.ec = ec;
+                st.busy = false;
+                st.ready = true;
+                w = st.w;
+                st.w = nullptr;
+            }
+            st.cv.notify_all();
+            if(w)
+                w->complete({});
+        }
+    };
+};
+
+#if ! BEAST_DOXYGEN
+
+template<class File>
+class basic_async_file_body<File>::writer
+{
+    value_type& body_;
+    std::shared_ptr<state> sp_;
+    std::uint64_t remain_;      // bytes not yet requested
+    std::size_t requested_ = 0; // size of the read in progress
+    int next_ = 0;              // buffer of the read in progress
+
+    void
+    start()
+    {
+        auto& st = *sp_;
+        st.out = st.buf[next_].prepare(remain_);
+        requested_ = st.out.size();
+        remain_ -= requested_;
+        st.buf[next_].commit();
+        st.busy = true;
+        asio::post(*body_.ex_, read_op{sp_});
+    }
+
+public:
+    using const_buffers_type =
+        asio::const_buffer;
+
+    template<bool isRequest, class Fields>
+    writer(header<isRequest, Fields>&, value_type& b)
+        : body_(b)
+        , sp_(std::make_shared<state>(b.file_, b.read_size_))
+        , remain_(b.size_)
+    {
+        BOOST_ASSERT(body_.is_open());
+    }
+
+    void
+    init(error_code& ec)
+    {
+        if(body_.ex_ && remain_ > 0)
+        {
+            std::lock_guard<std::mutex> lock(sp_->m);
+            start();
+        }
+        ec.assign(0, ec.category());
+    }
+
+    boost::optional<std::pair<const_buffers_type, bool>>
+    get(error_code& ec)
+    {
+        auto& st = *sp_;
+        if(! body_.ex_)
+        {
+            if(remain_ == 0)
+            {
+                ec.assign(0, ec.category());
+                return boost::none;
+            }
+            auto const b = st.buf[0].prepare(remain_);
+            auto const n = st.file->read(b.data(), b.size(), ec);
+            if(ec)
+                return boost::none;
+            if(n == 0)
+            {
+                // The file was truncated
+                ec = make_error_code(errc::io_error);
+                return boost::none;
+            }
+            remain_ -= n;
+            st.buf[0].commit();
+            ec.assign(0, ec.category());
+            return {{const_buffers_type{b.data(), n}, remain_ > 0}};
+        }
+        std::lock_guard<std::mutex> lock(st.m);
+        if(st.busy)
+        {
+            ec = error::need_more;
+            return boost::none;
+        }
+        if(! st.ready)
+        {
+            ec.assign(0, ec.category());
+            return boost::none;
+        }
+        st.ready = false;
+        if(st.ec)
+        {
+            ec = st.ec;
+            return boost::none;
+        }
+        if(st.nread != requested_)
+        {
+            // The file was truncated
+            ec = make_error_code(errc::io_error);
+            return boost::none;
+        }
+        const_buffers_type const result{st.out.data(), st.nread};
+        // Read the next piece into the other buffer
+        // while the caller sends this one.
+        next_ = 1 - next_;
+        if(remain_ > 0)
+            start();
+        ec.assign(0, ec.category());
+        return {{result, st.busy}};
+    }
+
+    /// Block until a read in progress is finished
+    void
+    wait(error_code& ec)
+    {
+        std::unique_lock<std::mutex> lock(sp_->m);
+        sp_->cv.wait(lock, [this]{ return ! sp_->busy; });
+        ec.assign(0, ec.category());
+    }
+
+    /** Invoke a handler when a read in progress is finished
+
+        The handler has the signature `void(error_code)` and
+        is invoked as if by `asio::post`.
+    */
+    template<class WaitHandler>
+    void
+    async_wait(WaitHandler&& handler)
+    {
+        using handler_type =
+            typename std::decay<WaitHandler>::type;
+        auto const w = waiter_impl<handler_type>::create(
+            std::forward<WaitHandler>(handler));
+        {
+            std::lock_guard<std::mutex> lock(sp_->m);
+            if(sp_->busy)
+            {
+                BOOST_ASSERT(! sp_->w);
+                sp_->w = w;
+                return;
+            }
+        }
+        w->complete({});
+    }
+};
+
+#endif
+
+/// A message body which reads a file on a separate executor.
+using async_file_body = basic_async_file_body<file>;
+
+#if ! BEAST_DOXYGEN
+// operator<< is not supported for async_file_body
+template<bool isRequest, class File, class Fields>
+std::ostream&
+operator<<(std::ostream& os, message<
+    isRequest, basic_async_file_body<File>, Fields> const& msg) = delete;
+#endif
+
+} // http
+} // beast
+
+#endif
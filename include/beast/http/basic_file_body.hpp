@@ -15,6 +15,7 @@
 #include <beast/core/file_base.hpp>
 #include <beast/core/type_traits.hpp>
 #include <beast/http/message.hpp>
+#include <beast/http/detail/file_read_buffer.hpp>
 #include <boost/assert.hpp>
 #include <boost/optional.hpp>
 #include <algorithm>
@@ -95,6 +96,9 @@ class basic_file_body<File>::value_type
     // The cached file size
     std::uint64_t file_size_ = 0;
 
+    // The largest amount the writer reads at once
+    std::size_t read_size_ = 1024 * 1024;
+
 public:
     /** Destructor.
 
@@ -125,6 +129,35 @@ public:
         return file_size_;
     }
 
+    /// Returns the file
+    File&
+    file()
+    {
+        return file_;
+    }
+
+    /// Returns the largest number of bytes the writer reads at once
+    std::size_t
+    read_size() const
+    {
+        return read_size_;
+    }
+
+    /** Set the largest number of bytes the writer reads at once
+
+        The writer starts with reads of 64KB, or less if the
+        limit is smaller, and doubles the amount after each
+        read until it reaches the limit. The default is 1MB.
+
+        @param n The number of bytes. This may not be zero.
+    */
+    void
+    read_size(std::size_t n)
+    {
+        BOOST_ASSERT(n > 0);
+        read_size_ = n;
+    }
+
     /// Close the file if open
     void
     close();
@@ -228,7 +261,10 @@ class basic_file_body<File>::writer
 {
     value_type& body_;      // The body we are reading from
     std::uint64_t remain_;  // The number of unread bytes
-    char buf_[4096];        // Small buffer for reading
+    std::uint64_t offset_;  // The position of the next read
+    detail::file_read_buffer buf_; // Pooled buffer for reading
+
+    using has_prefetch = detail::has_prefetch<File>;
 
 public:
     // The type of buffer sequence returned by `get`.
@@ -296,6 +332,8 @@ basic_file_body<File>::
 writer::
 writer(header<isRequest, Fields>& h, value_type& b)
     : body_(b)
+    , offset_(0)
+    , buf_(b.read_size_)
 {
     boost::ignore_unused(h);
 
@@ -317,6 +355,17 @@ init(error_code& ec)
     // either set the error to some value, or set it
     // to indicate no error.
     //
+    // If the file can be told which bytes we want next,
+    // we need to know where reading starts.
+    if(has_prefetch::value)
+    {
+        offset_ = body_.file_.pos(ec);
+        if(ec)
+            return;
+        detail::file_prefetch(body_.file_,
+            offset_, buf_.size(), has_prefetch{});
+    }
+
     // We don't do anything fancy so set "no error"
     ec.assign(0, ec.category());
 }
@@ -324,7 +373,9 @@ init(error_code& ec)
 // This function is called repeatedly by the serializer to
 // retrieve the buffers representing the body. Our strategy
 // is to read into our buffer and return it until we have
-// read through the whole file.
+// read through the whole file. Each read is larger than the
+// one before, up to the limit set in the body, so that big
+// files take few system calls and few socket writes.
 //
 template<class File>
 auto
@@ -333,13 +384,8 @@ writer::
 get(error_code& ec) ->
     boost::optional<std::pair<const_buffers_type, bool>>
 {
-    // Calculate the smaller of our buffer size,
-    // or the amount of unread data in the file.
-    auto const amount =  remain_ > sizeof(buf_) ?
-        sizeof(buf_) : static_cast<std::size_t>(remain_);
-
     // Handle the case where the file is zero length
-    if(amount == 0)
+    if(remain_ == 0)
     {
         // Modify the error code to indicate success
         // This is required by the error_code specification.
@@ -352,8 +398,12 @@ get(error_code& ec) ->
         return boost::none;
     }
 
+    // Get the smaller of our read size,
+    // or the amount of unread data in the file.
+    auto const b = buf_.prepare(remain_);
+
     // Now read the next buffer
-    auto const nread = body_.file_.read(buf_, amount, ec);
+    auto const nread = body_.file_.read(b.data(), b.size(), ec);
     if(ec)
         return boost::none;
 
@@ -361,8 +411,18 @@ get(error_code& ec) ->
     BOOST_ASSERT(nread != 0);
     BOOST_ASSERT(nread <= remain_);
 
-    // Update the amount remaining based on what we got
+    // Update the amount remaining based on what we got,
+    // and ask for the next read to be larger.
     remain_ -= nread;
+    offset_ += nread;
+    buf_.commit();
+
+    // Let the file start reading the next piece while
+    // the caller is sending this one.
+    if(remain_ > 0)
+        detail::file_prefetch(body_.file_, offset_,
+            (std::min<std::uint64_t>)(remain_, buf_.size()),
+            has_prefetch{});
 
     // Return the buffer to the caller.
     //
@@ -374,8 +434,8 @@ get(error_code& ec) ->
     //
     ec.assign(0, ec.category());
     return {{
-        const_buffers_type{buf_, nread},    // buffer to return.
-        remain_ > 0                         // `true` if there are more buffers.
+        const_buffers_type{b.data(), nread}, // buffer to return.
+        remain_ > 0                          // `true` if there are more buffers.
         }};
 }
 
@@ -548,6 +548,27 @@ public:
     void
     put_eof(error_code& ec);
 
+    /** Inform the parser that body octets were stored directly.
+
+        Stream algorithms which move the body of a message with
+        a known Content-Length into its storage without passing
+        it through @ref put call this function afterwards, so
+        that the parser can track the remaining length and
+        finish the message when it is complete.
+
+        @note Only valid after parsing a complete header, when
+        @ref content_length returns a value, and before the
+        message is done.
+
+        @param n The number of body octets stored. This may not
+        be greater than the remaining length returned by
+        @ref content_length.
+
+        @param ec Set to the error, if any occurred.
+    */
+    void
+    commit_body(std::uint64_t n, error_code& ec);
+
 private:
     inline
     Derived&
@@ -0,0 +1,299 @@
+//
+// Copyright (c) 2016-2017 Vinnie Falco (vinnie dot falco at gmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/boostorg/beast
+//
+
+#ifndef BEAST_HTTP_CACHED_FILE_BODY_HPP
+#define BEAST_HTTP_CACHED_FILE_BODY_HPP
+
+#include <beast/http/file_cache.hpp>
+
+#if BEAST_USE_POSIX_FILE
+
+#include <beast/core/detail/config.hpp>
+#include <beast/http/compressed_body.hpp>
+#include <beast/http/content_coding.hpp>
+#include <beast/http/message.hpp>
+#include <beast/http/status.hpp>
+#include <asio/buffer.hpp>
+#include <boost/optional.hpp>
+#include <cstdint>
+#include <utility>
+
+namespace beast {
+namespace http {
+
+/** A @b Body which sends a file from a @ref file_cache.
+
+    The body holds a reference to a cached entry and one of its
+    representations. Resident representations are sent directly
+    from memory in a single buffer, while others are read from
+    the descriptor held open by the cache, so no file is opened
+    or inspected while the message is serialized. Since the
+    writer does not modify the body, the same message may be
+    serialized by several threads at once.
+
+    Use @ref prepare_cached_response to select the representation
+    from the request and to answer conditional requests.
+
+    Messages using this body type may be serialized but not
+    parsed.
+
+    @par Example
+    @code
+    auto const entry = cache.get(path, ec);
+    if(ec)
+        return ...;
+    response<cached_file_body> res;
+    prepare_cached_response(req, res, entry);
+    write(sock, res, ec);
+    @endcode
+
+    @note This body is only available on POSIX systems.
+*/
+struct cached_file_body
+{
+    /// The type of the body member when used in a message.
+    class value_type
+    {
+        friend struct cached_file_body;
+
+        file_cache::entry_ptr entry_;
+        file_cache::representation const* rep_ = nullptr;
+
+    public:
+        /// Constructor
+        value_type() = default;
+
+        /** Set the body to a representation of a cached file.
+
+            @param entry The cached file.
+
+            @param coding The content coding to send. If the
+            entry has no representation with this coding,
+            the identity representation is used instead.
+
+            @return The content coding of the representation
+            which was selected.
+        */
+        content_coding
+        assign(file_cache::entry_ptr entry,
+            content_coding coding = content_coding::identity)
+        {
+            entry_ = std::move(entry);
+            if( coding == content_coding::gzip &&
+                entry_->gzip())
+            {
+                rep_ = entry_->gzip();
+                return content_coding::gzip;
+            }
+            rep_ = &entry_->identity();
+            return content_coding::identity;
+        }
+
+        /// Remove the file, leaving an empty body
+        void
+        clear()
+        {
+            entry_.reset();
+            rep_ = nullptr;
+        }
+
+        /// Returns the cached file, or `nullptr` if none
+        file_cache::entry_ptr const&
+        entry() const
+        {
+            return entry_;
+        }
+
+        /// Returns the selected representation, or `nullptr` if none
+        file_cache::representation const*
+        representation() const
+        {
+            return rep_;
+        }
+
+        /// Returns the number of octets in the body
+        std::uint64_t
+        size() const
+        {
+            return rep_ ? rep_->size() : 0;
+        }
+    };
+
+    /** Returns the payload size of the body
+
+        When this body is used with @ref message::prepare_payload,
+        the Content-Length will be set to the payload size, and
+        any chunked Transfer-Encoding will be removed.
+    */
+    static
+    std::uint64_t
+    size(value_type const& body)
+    {
+        return body.size();
+    }
+
+    /** The algorithm for serializing the body
+
+        Meets the requirements of @b BodyWriter.
+    */
+#if BEAST_DOXYGEN
+    using writer = implementation_defined;
+#else
+    class writer
+    {
+        value_type const& body_;
+        std::uint64_t pos_ = 0;
+        char buf_[4096];
+
+    public:
+        using const_buffers_type =
+            asio::const_buffer;
+
+        template<bool isRequest, class Fields>
+        explicit
+        writer(header<isRequest, Fields> const&, value_type const& b)
+            : body_(b)
+        {
+        }
+
+        void
+        init(error_code& ec)
+        {
+            ec.assign(0, ec.category());
+        }
+
+        boost::optional<std::pair<const_buffers_type, bool>>
+        get(error_code& ec)
+        {
+            auto const rep = body_.rep_;
+            if(! rep || pos_ >= rep->size())
+            {
+                ec.assign(0, ec.category());
+                return boost::none;
+            }
+            if(rep->resident())
+            {
+                ec.assign(0, ec.category());
+                pos_ = rep->size();
+                return {{const_buffers_type{
+                    rep->data().data(), rep->data().size()}, false}};
+            }
+            auto const n = rep->read(pos_, buf_, sizeof(buf_), ec);
+            if(ec)
+                return boost::none;
+            if(n == 0)
+            {
+                // The file was truncated after it was cached,
+                // and the Content-Length can no longer be met.
+                ec = make_error_code(errc::io_error);
+                return boost::none;
+            }
+            pos_ += n;
+            return {{const_buffers_type{buf_, n},
+                pos_ < rep->size()}};
+        }
+    };
+#endif
+};
+
+namespace detail {
+
+// Returns `true` if an If-None-Match list matches the tag.
+// The weak comparison is used as required by rfc7232.
+inline
+bool
+etag_list_matches(string_view list, string_view etag)
+{
+    auto it = list.begin();
+    auto const end = list.end();
+    for(;;)
+    {
+        while(it != end && (*it == ' ' ||
+                *it == '\t' || *it == ','))
+            ++it;
+        if(it == end)
+            return false;
+        if(*it == '*')
+            return true;
+        if(end - it > 2 && it[0] == 'W' && it[1] == '/')
+            it += 2;
+        if(*it != '"')
+            return false;
+        auto const first = it;
+        ++it;
+        while(it != end && *it != '"')
+            ++it;
+        if(it == end)
+            return false;
+        ++it;
+        if(string_view(first, it - first) == etag)
+            return true;
+    }
+}
+
+} // detail
+
+/** Prepare a response which sends a cached file.
+
+    This function selects the gzip representation of the entry if
+    it has one and the Accept-Encoding field of the request prefers
+    it, and sets the ETag and Content-Encoding fields to match. If
+    the entry has a gzip representation, "Accept-Encoding" is added
+    to the Vary field. When the If-None-Match field of the request
+    matches the entity tag, the response is set to 304 Not Modified
+    with an empty body. Otherwise the status is set to 200 OK and
+    @ref message::prepare_payload is called, which sets the
+    Content-Length.
+
+    @param req The request being answered.
+
+    @param res The response to prepare.
+
+    @param entry The cached file to send.
+*/
+template<class Body, class RequestFields, class Fields>
+void
+prepare_cached_response(
+    request<Body, RequestFields> const& req,
+    response<cached_file_body, Fields>& res,
+    file_cache::entry_ptr entry)
+{
+    auto coding = content_coding::identity;
+    bool const vary = entry->gzip() != nullptr;
+    if(vary)
+        coding = negotiate_content_coding(
+            req[field::accept_encoding]);
+    coding = res.body().assign(std::move(entry), coding);
+    auto const& rep = *res.body().representation();
+    res.set(field::etag, rep.etag());
+    if(coding == content_coding::identity)
+        res.erase(field::content_encoding);
+    else
+        res.set(field::content_encoding, to_string(coding));
+    if(vary)
+        detail::vary_accept_encoding(res);
+    auto const inm = req[field::if_none_match];
+    if(! inm.empty() && detail::etag_list_matches(inm, rep.etag()))
+    {
+        res.result(status::not_modified);
+        res.body().clear();
+        res.content_length(boost::none);
+        res.chunked(false);
+        return;
+    }
+    res.result(status::ok);
+    res.prepare_payload();
+}
+
+} // http
+} // beast
+
+#endif
+
+#endif
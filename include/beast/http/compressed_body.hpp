@@ -0,0 +1,463 @@
+//
+// Copyright (c) 2016-2017 Vinnie Falco (vinnie dot falco at gmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/boostorg/beast
+//
+
+#ifndef BEAST_HTTP_COMPRESSED_BODY_HPP
+#define BEAST_HTTP_COMPRESSED_BODY_HPP
+
+#include <beast/core/detail/config.hpp>
+#include <beast/core/buffers_suffix.hpp>
+#include <beast/http/content_coding.hpp>
+#include <beast/http/error.hpp>
+#include <beast/http/message.hpp>
+#include <beast/http/rfc7230.hpp>
+#include <beast/http/type_traits.hpp>
+#include <beast/http/detail/codec_pool.hpp>
+#include <beast/zlib/deflate_stream.hpp>
+#include <beast/zlib/detail/checksum.hpp>
+#include <asio/buffer.hpp>
+#include <boost/optional.hpp>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+
+namespace beast {
+namespace http {
+
+namespace detail {
+
+struct deflate_codec
+{
+    static std::size_t constexpr buffer_size = 8192;
+
+    zlib::deflate_stream zs;
+    int level = -2; // settings of the last reset
+    char buf[buffer_size];
+    deflate_codec* next = nullptr;
+};
+
+// Add Accept-Encoding to the Vary field, so
+// caches keep the representations apart.
+template<class Fields>
+void
+vary_accept_encoding(Fields& f)
+{
+    auto const vary = f[field::vary];
+    if(vary.empty())
+        f.set(field::vary, "Accept-Encoding");
+    else if(! token_list{vary}.exists("Accept-Encoding") &&
+            ! token_list{vary}.exists("*"))
+        f.set(field::vary,
+            vary.to_string() + ", Accept-Encoding");
+}
+
+} // detail
+
+/** A @b Body which applies a content coding to another body.
+
+    This body wraps the algorithm for serializing another body
+    type, and compresses the octets it produces on the fly with
+    @ref zlib::deflate_stream, using the gzip or deflate content
+    coding. Memory use for each message is bounded by the size
+    of the compression state, regardless of the size of the
+    payload. The compression state and the output buffer are
+    obtained from a per-thread cache when serialization starts,
+    and returned when the serializer is destroyed, so that they
+    are reused by subsequent messages.
+
+    Each call to the serializer produces at most 8192 octets of
+    coded body, which is then subject to the limit set with
+    @ref serializer::limit.
+
+    Since the size of the coded payload is not known ahead of
+    time, this body has no `size` function. Call
+    @ref prepare_compressed_payload to set the Content-Encoding
+    field and the chunked Transfer-Encoding.
+
+    Messages using this body type may be serialized but not
+    parsed. To receive a compressed body, use
+    @ref decompressing_body.
+
+    @par Example
+    @code
+    response<compressed_body<file_body>> res;
+    res.body().coding = negotiate_content_coding(
+        req[field::accept_encoding]);
+    res.body().body.open("index.html", file_mode::scan, ec);
+    prepare_compressed_payload(res);
+    @endcode
+
+    @tparam Body The body type whose serialized octets are
+    compressed. This must meet the requirements of @b Body,
+    and its writer must meet the requirements of @b BodyWriter.
+*/
+template<class Body>
+struct compressed_body
+{
+    static_assert(is_body<Body>::value,
+        "Body requirements not met");
+
+    static_assert(is_body_writer<Body>::value,
+        "BodyWriter requirements not met");
+
+    /// The type of the body member when used in a message.
+    struct value_type
+    {
+        /// The body holding the uncompressed payload.
+        typename Body::value_type body;
+
+        /** The content coding to apply.
+
+            If this is @ref content_coding::identity, the
+            octets are copied without transformation. Any
+            other value besides gzip and deflate results in
+            @ref error::bad_content_coding.
+        */
+        content_coding coding = content_coding::gzip;
+
+        /** The compression level.
+
+            This is an integer from 0 to 9 inclusive, or
+            -1 for the default which is currently 6.
+        */
+        int level = -1;
+    };
+
+    /** The algorithm for serializing the body
+
+        Meets the requirements of @b BodyWriter.
+    */
+#if BEAST_DOXYGEN
+    using writer = implementation_defined;
+#else
+    class writer;
+#endif
+};
+
+#if ! BEAST_DOXYGEN
+
+template<class Body>
+class compressed_body<Body>::writer
+{
+    using pool = detail::codec_pool<detail::deflate_codec>;
+    using inner_buffers_type =
+        typename Body::writer::const_buffers_type;
+
+    enum state
+    {
+        s_header,
+        s_body,
+        s_trailer,
+        s_done
+    };
+
+    typename Body::writer wr_;
+    value_type& body_;
+    typename pool::pointer c_;
+    boost::optional<buffers_suffix<inner_buffers_type>> in_;
+    zlib::Flush flush_ = zlib::Flush::none;
+    state s_ = s_header;
+    bool more_ = true;          // the inner writer has more
+    bool stalled_ = false;      // the inner writer needs a buffer
+    std::uint32_t check_ = 0;   // crc32 or adler32 of input
+    std::uint32_t total_ = 0;   // input size modulo 2^32
+    std::uint8_t tail_[8];
+    std::size_t tail_pos_ = 0;
+    std::size_t tail_len_ = 0;
+
+    // Append the framing before the deflate data
+    std::size_t
+    prefix(std::uint8_t* p)
+    {
+        switch(body_.coding)
+        {
+        case content_coding::gzip:
+            // ID1 ID2 CM FLG MTIME(4) XFL OS
+            p[0] = 0x1f; p[1] = 0x8b; p[2] = 8; p[3] = 0;
+            p[4] = 0; p[5] = 0; p[6] = 0; p[7] = 0;
+            p[8] = 0; p[9] = 255;
+            check_ = 0;
+            return 10;
+
+        case content_coding::deflate:
+        {
+            // CMF: deflate with a 32K window
+            // FLG: FLEVEL and FCHECK, no dictionary
+            auto const level = c_->level;
+            unsigned const flevel =
+                level < 2 && level >= 0 ? 0 :
+                level <= 5 && level >= 2 ? 1 :
+                (level == 6 || level < 0) ? 2 : 3;
+            unsigned const h = (0x78 << 8) | (flevel << 6);
+            p[0] = 0x78;
+            p[1] = static_cast<std::uint8_t>(
+                (flevel << 6) + 31 - h % 31);
+            check_ = 1;
+            return 2;
+        }
+
+        default:
+            break;
+        }
+        return 0;
+    }
+
+    // Prepare the framing after the deflate data
+    void
+    suffix()
+    {
+        if(body_.coding == content_coding::gzip)
+        {
+            for(int i = 0; i < 4; ++i)
+                tail_[i] = static_cast<std::uint8_t>(check_ >> (8 * i));
+            for(int i = 0; i < 4; ++i)
+                tail_[4 + i] = static_cast<std::uint8_t>(total_ >> (8 * i));
+            tail_len_ = 8;
+        }
+        else if(body_.coding == content_coding::deflate)
+        {
+            for(int i = 0; i < 4; ++i)
+                tail_[i] = static_cast<std::uint8_t>(check_ >> (24 - 8 * i));
+            tail_len_ = 4;
+        }
+        tail_pos_ = 0;
+        s_ = s_trailer;
+    }
+
+    void
+    update(void const* data, std::size_t size)
+    {
+        if(body_.coding == content_coding::gzip)
+            check_ = zlib::detail::crc32(check_, data, size);
+        else
+            check_ = zlib::detail::adler32(check_, data, size);
+        total_ += static_cast<std::uint32_t>(size);
+    }
+
+    // Returns the first non-empty input buffer, or
+    // an empty buffer if all the input was consumed.
+    asio::const_buffer
+    input()
+    {
+        if(in_)
+        {
+            for(auto const b : *in_)
+            {
+                asio::const_buffer const cb{b};
+                if(cb.size() > 0)
+                    return cb;
+            }
+            in_ = boost::none;
+        }
+        return {};
+    }
+
+public:
+    using const_buffers_type =
+        asio::const_buffer;
+
+    template<bool isRequest, class Fields>
+    writer(header<isRequest, Fields>& h, value_type& b)
+        : wr_(h, b.body)
+        , body_(b)
+    {
+    }
+
+    void
+    init(error_code& ec)
+    {
+        wr_.init(ec);
+        if(ec)
+            return;
+        if( body_.coding != content_coding::identity &&
+            body_.coding != content_coding::gzip &&
+            body_.coding != content_coding::deflate)
+        {
+            ec = error::bad_content_coding;
+            return;
+        }
+        c_ = pool::acquire();
+        if(body_.coding != content_coding::identity)
+        {
+            auto const level =
+                body_.level == -1 ? 6 : body_.level;
+            if(c_->level == level)
+            {
+                c_->zs.reset();
+            }
+            else
+            {
+                c_->zs.reset(level, 15, 8,
+                    zlib::Strategy::normal);
+                c_->level = level;
+            }
+        }
+    }
+
+    boost::optional<std::pair<const_buffers_type, bool>>
+    get(error_code& ec)
+    {
+        ec.assign(0, ec.category());
+        if(s_ == s_done)
+            return boost::none;
+        auto const out = reinterpret_cast<
+            std::uint8_t*>(c_->buf);
+        auto const size = sizeof(c_->buf);
+        std::size_t n = 0;
+        if(s_ == s_header)
+        {
+            n = prefix(out);
+            s_ = s_body;
+        }
+        while(n < size && s_ != s_done)
+        {
+            if(s_ == s_trailer)
+            {
+                auto const amount = (std::min)(
+                    size - n, tail_len_ - tail_pos_);
+                std::memcpy(out + n, tail_ + tail_pos_, amount);
+                n += amount;
+                tail_pos_ += amount;
+                if(tail_pos_ == tail_len_)
+                    s_ = s_done;
+                break;
+            }
+            auto b = input();
+            if( b.size() == 0 && more_ &&
+                flush_ == zlib::Flush::none)
+            {
+                if(stalled_)
+                {
+                    // Report the stall only after returning
+                    // everything produced before it, and do not
+                    // ask the inner writer again until then.
+                    if(n > 0)
+                        break;
+                    stalled_ = false;
+                    ec = error::need_buffer;
+                    return boost::none;
+                }
+                auto result = wr_.get(ec);
+                if(ec == error::need_buffer)
+                {
+                    ec.assign(0, ec.category());
+                    stalled_ = true;
+                    // Flush the pending output so the peer
+                    // receives all the data provided so far.
+                    if(body_.coding != content_coding::identity)
+                        flush_ = zlib::Flush::sync;
+                    continue;
+                }
+                else if(ec)
+                {
+                    return boost::none;
+                }
+                else if(! result)
+                {
+                    more_ = false;
+                }
+                else
+                {
+                    more_ = result->second;
+                    in_.emplace(result->first);
+                    continue;
+                }
+            }
+            if(body_.coding == content_coding::identity)
+            {
+                if(b.size() == 0)
+                {
+                    if(! more_)
+                        s_ = s_done;
+                    continue;
+                }
+                auto const amount =
+                    (std::min)(size - n, b.size());
+                std::memcpy(out + n, b.data(), amount);
+                n += amount;
+                in_->consume(amount);
+                continue;
+            }
+            if(b.size() == 0 && ! more_)
+                flush_ = zlib::Flush::finish;
+            zlib::z_params zs;
+            zs.next_in = b.data();
+            zs.avail_in = b.size();
+            zs.next_out = out + n;
+            zs.avail_out = size - n;
+            c_->zs.write(zs, flush_, ec);
+            auto const used = b.size() - zs.avail_in;
+            if(used > 0)
+            {
+                update(b.data(), used);
+                in_->consume(used);
+            }
+            n = size - zs.avail_out;
+            if(ec == zlib::error::end_of_stream)
+            {
+                ec.assign(0, ec.category());
+                suffix();
+            }
+            else if(ec == zlib::error::need_buffers)
+            {
+                // A repeated flush with no new input
+                ec.assign(0, ec.category());
+                BOOST_ASSERT(flush_ == zlib::Flush::sync);
+                flush_ = zlib::Flush::none;
+            }
+            else if(ec)
+            {
+                return boost::none;
+            }
+            else if(flush_ == zlib::Flush::sync && zs.avail_out > 0)
+            {
+                // flush complete
+                flush_ = zlib::Flush::none;
+            }
+        }
+        if(n == 0)
+        {
+            BOOST_ASSERT(s_ == s_done);
+            return boost::none;
+        }
+        return {{const_buffers_type{out, n}, s_ != s_done}};
+    }
+};
+
+#endif
+
+/** Prepare a message with a compressed body for sending.
+
+    This function sets the Content-Encoding field to the coding
+    in the body, or removes it for @ref content_coding::identity.
+    For responses, "Accept-Encoding" is added to the Vary field
+    so caches keep the variants apart. Then the function calls
+    @ref message::prepare_payload, which removes any Content-Length
+    and sets the chunked Transfer-Encoding for HTTP/1.1.
+
+    @param msg The message to prepare.
+*/
+template<bool isRequest, class Body, class Fields>
+void
+prepare_compressed_payload(
+    message<isRequest, compressed_body<Body>, Fields>& msg)
+{
+    auto const coding = msg.body().coding;
+    if(coding == content_coding::identity)
+        msg.erase(field::content_encoding);
+    else
+        msg.set(field::content_encoding, to_string(coding));
+    if(! isRequest)
+        detail::vary_accept_encoding(msg);
+    msg.prepare_payload();
+}
+
+} // http
+} // beast
+
+#endif
@@ -0,0 +1,100 @@
+//
+// Copyright (c) 2016-2017 Vinnie Falco (vinnie dot falco at gmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/boostorg/beast
+//
+
+#ifndef BEAST_HTTP_CONTENT_CODING_HPP
+#define BEAST_HTTP_CONTENT_CODING_HPP
+
+#include <beast/core/detail/config.hpp>
+#include <beast/core/string.hpp>
+#include <iosfwd>
+
+namespace beast {
+namespace http {
+
+/** Content codings supported by the compressing and decompressing bodies.
+
+    A content coding is a transformation applied to a representation,
+    as indicated by the Content-Encoding and Accept-Encoding fields.
+
+    @see https://tools.ietf.org/html/rfc7231#section-3.1.2.1
+*/
+enum class content_coding
+{
+    /** An unrecognized content coding.
+
+        This value is returned when a string does not name one
+        of the codings listed here.
+    */
+    unknown = 0,
+
+    /// The absence of any transformation
+    identity,
+
+    /// The zlib format (rfc1950) containing deflate data (rfc1951)
+    deflate,
+
+    /// The gzip format (rfc1952). "x-gzip" is treated as equivalent.
+    gzip
+};
+
+/** Converts a string to a content coding.
+
+    The comparison is case-insensitive. If the string does not
+    name a known content coding, @ref content_coding::unknown
+    is returned.
+*/
+content_coding
+string_to_content_coding(string_view s);
+
+/// Returns the text representation of a content coding.
+string_view
+to_string(content_coding c);
+
+/// Write the text for a content coding to an output stream.
+inline
+std::ostream&
+operator<<(std::ostream& os, content_coding c)
+{
+    return os << to_string(c);
+}
+
+/** Choose a content coding for a response from an Accept-Encoding value.
+
+    This parses the value of an Accept-Encoding field using the
+    rules in rfc7231 section 5.3.4, including quality values and
+    the "*" wildcard, and returns the most preferred coding among
+    @ref content_coding::gzip and @ref content_coding::deflate.
+    When both are equally preferred, gzip is chosen. If neither
+    is acceptable, or the identity coding has a strictly higher
+    quality value, @ref content_coding::identity is returned.
+
+    An empty string, which is also what a missing field looks
+    like, results in @ref content_coding::identity.
+
+    @par Example
+    @code
+    request<string_body> req;
+    ...
+    auto const coding = negotiate_content_coding(
+        req[field::accept_encoding]);
+    @endcode
+
+    @param s The value of the Accept-Encoding field.
+
+    @see https://tools.ietf.org/html/rfc7231#section-5.3.4
+*/
+content_coding
+negotiate_content_coding(string_view s);
+
+} // http
+} // beast
+
+#include <beast/http/impl/content_coding.ipp>
+
+#endif
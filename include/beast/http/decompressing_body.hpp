@@ -0,0 +1,572 @@
+//
+// Copyright (c) 2016-2017 Vinnie Falco (vinnie dot falco at gmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/boostorg/beast
+//
+
+#ifndef BEAST_HTTP_DECOMPRESSING_BODY_HPP
+#define BEAST_HTTP_DECOMPRESSING_BODY_HPP
+
+#include <beast/core/detail/config.hpp>
+#include <beast/http/content_coding.hpp>
+#include <beast/http/error.hpp>
+#include <beast/http/message.hpp>
+#include <beast/http/rfc7230.hpp>
+#include <beast/http/type_traits.hpp>
+#include <beast/http/detail/codec_pool.hpp>
+#include <beast/zlib/inflate_stream.hpp>
+#include <beast/zlib/detail/checksum.hpp>
+#include <beast/core/detail/type_traits.hpp>
+#include <asio/buffer.hpp>
+#include <boost/optional.hpp>
+#include <cstdint>
+#include <cstring>
+
+namespace beast {
+namespace http {
+
+namespace detail {
+
+struct inflate_codec
+{
+    static std::size_t constexpr buffer_size = 8192;
+
+    zlib::inflate_stream is;
+    std::uint8_t buf[buffer_size];
+    inflate_codec* next = nullptr;
+};
+
+} // detail
+
+/** A @b Body which removes a content coding while parsing.
+
+    This body wraps the algorithm for parsing another body type.
+    When the message has a Content-Encoding of gzip or deflate,
+    the incoming octets are decompressed on the fly with
+    @ref zlib::inflate_stream and the decoded octets are passed
+    to the reader of the wrapped body. The coded payload is
+    never stored, and memory use for each message is bounded by
+    the size of the decompression state. The decompression state
+    and the output buffer are obtained from a per-thread cache
+    when parsing starts, and returned when the parser is
+    destroyed, so that they are reused by subsequent messages.
+
+    The parser's body limit applies to the coded payload as it
+    is received. Since a small coded payload may expand to a
+    very large one, this body enforces a separate limit on the
+    number of decoded octets, reporting @ref error::body_limit
+    when it is exceeded.
+
+    If the Content-Encoding field is absent or only lists
+    identity, octets are passed to the wrapped reader without
+    transformation, subject to the same limit. A coding other
+    than gzip, deflate, or identity, or more than one coding,
+    results in @ref error::bad_content_coding. A payload which
+    is malformed, truncated, or fails its checksum results in
+    @ref error::bad_encoded_body, while errors in the compressed
+    data itself are reported using the codes in @ref zlib::error.
+
+    Messages using this body type may be parsed but not
+    serialized. To send a compressed body, use
+    @ref compressed_body.
+
+    @par Example
+    @code
+    request_parser<decompressing_body<string_body>> p;
+    p.get().body().limit = 64 * 1024 * 1024;
+    read(sock, buffer, p, ec);
+    @endcode
+
+    @tparam Body The body type which receives the decoded
+    octets. This must meet the requirements of @b Body, and
+    its reader must meet the requirements of @b BodyReader.
+*/
+template<class Body>
+struct decompressing_body
+{
+    static_assert(is_body<Body>::value,
+        "Body requirements not met");
+
+    static_assert(is_body_reader<Body>::value,
+        "BodyReader requirements not met");
+
+    /// The type of the body member when used in a message.
+    struct value_type
+    {
+        /// The body holding the decoded payload.
+        typename Body::value_type body;
+
+        /** The maximum number of decoded octets.
+
+            The default is 8MB.
+        */
+        std::uint64_t limit = 8 * 1024 * 1024;
+
+        /** The content coding which was removed.
+
+            This is set by the reader from the Content-Encoding
+            field of the message being parsed.
+        */
+        content_coding coding = content_coding::identity;
+    };
+
+    /** The algorithm for parsing the body
+
+        Meets the requirements of @b BodyReader.
+    */
+#if BEAST_DOXYGEN
+    using reader = implementation_defined;
+#else
+    class reader;
+#endif
+};
+
+#if ! BEAST_DOXYGEN
+
+template<class Body>
+class decompressing_body<Body>::reader
+{
+    using pool = detail::codec_pool<detail::inflate_codec>;
+
+    enum state
+    {
+        s_gzip_header,
+        s_gzip_extra_len,
+        s_gzip_extra,
+        s_gzip_name,
+        s_gzip_comment,
+        s_gzip_hcrc,
+        s_zlib_header,
+        s_data,
+        s_trailer,
+        s_done
+    };
+
+    // gzip header flags
+    static std::uint8_t constexpr f_hcrc = 2;
+    static std::uint8_t constexpr f_extra = 4;
+    static std::uint8_t constexpr f_name = 8;
+    static std::uint8_t constexpr f_comment = 16;
+
+    typename Body::reader rd_;
+    value_type& body_;
+    void const* fields_;
+    content_coding(*get_coding_)(void const*);
+    typename pool::pointer c_;
+    state s_ = s_done;
+    std::uint8_t flags_ = 0;    // gzip header flags to process
+    std::uint8_t hdr_[10];      // fixed size framing
+    std::size_t have_ = 0;      // octets in hdr_
+    std::size_t need_ = 0;      // octets wanted in hdr_
+    std::size_t skip_ = 0;      // gzip extra field remaining
+    std::size_t held_ = 0;      // input octets reported as unused
+    std::size_t pos_ = 0;       // decoded octets delivered
+    std::size_t len_ = 0;       // decoded octets in buf
+    std::uint64_t total_ = 0;   // decoded octets
+    std::uint32_t check_ = 0;   // crc32 or adler32 of output
+    std::uint32_t size_ = 0;    // member size modulo 2^32
+
+    // Determine the coding from the Content-Encoding field
+    template<class Fields>
+    static
+    content_coding
+    get_coding(void const* fields)
+    {
+        auto const& f = *static_cast<Fields const*>(fields);
+        auto coding = content_coding::identity;
+        for(auto const& s : token_list{f[field::content_encoding]})
+        {
+            auto const c = string_to_content_coding(s);
+            if(c == content_coding::identity)
+                continue;
+            if(c == content_coding::unknown ||
+                coding != content_coding::identity)
+                return content_coding::unknown;
+            coding = c;
+        }
+        return coding;
+    }
+
+    // Collect fixed size framing, returns `true` when complete
+    bool
+    fill(std::uint8_t const*& p, std::uint8_t const* end)
+    {
+        auto const amount = (std::min)(
+            need_ - have_, static_cast<std::size_t>(end - p));
+        std::memcpy(hdr_ + have_, p, amount);
+        p += amount;
+        have_ += amount;
+        return have_ == need_;
+    }
+
+    void
+    expect(state s, std::size_t n)
+    {
+        s_ = s;
+        have_ = 0;
+        need_ = n;
+    }
+
+    void
+    start()
+    {
+        if(body_.coding == content_coding::gzip)
+        {
+            expect(s_gzip_header, 10);
+            check_ = 0;
+        }
+        else
+        {
+            expect(s_zlib_header, 2);
+            check_ = 1;
+        }
+        size_ = 0;
+    }
+
+    // Advance past the optional parts of the gzip header
+    void
+    next_header()
+    {
+        if(flags_ & f_extra)
+            expect(s_gzip_extra_len, 2);
+        else if(flags_ & f_name)
+            s_ = s_gzip_name;
+        else if(flags_ & f_comment)
+            s_ = s_gzip_comment;
+        else if(flags_ & f_hcrc)
+            expect(s_gzip_hcrc, 2);
+        else
+            s_ = s_data;
+    }
+
+    // Pass decoded octets to the inner reader
+    bool
+    deliver(error_code& ec)
+    {
+        while(pos_ < len_)
+        {
+            pos_ += rd_.put(asio::const_buffer{
+                c_->buf + pos_, len_ - pos_}, ec);
+            if(ec)
+                return false;
+        }
+        return true;
+    }
+
+    bool
+    verify()
+    {
+        std::uint32_t check = 0;
+        if(body_.coding == content_coding::gzip)
+        {
+            std::uint32_t size = 0;
+            for(int i = 0; i < 4; ++i)
+            {
+                check |= std::uint32_t{hdr_[i]} << (8 * i);
+                size |= std::uint32_t{hdr_[4 + i]} << (8 * i);
+            }
+            return check == check_ && size == size_;
+        }
+        for(int i = 0; i < 4; ++i)
+            check |= std::uint32_t{hdr_[i]} << (24 - 8 * i);
+        return check == check_;
+    }
+
+    // Returns the number of input octets consumed
+    std::size_t
+    decode(std::uint8_t const* p,
+        std::size_t n, error_code& ec)
+    {
+        auto const p0 = p;
+        auto const end = p + n;
+        while(! ec)
+        {
+            switch(s_)
+            {
+            case s_gzip_header:
+                if(! fill(p, end))
+                    return p - p0;
+                // ID1 ID2 CM FLG, reserved flags must be zero
+                if( hdr_[0] != 0x1f || hdr_[1] != 0x8b ||
+                    hdr_[2] != 8 || (hdr_[3] & 0xe0) != 0)
+                {
+                    ec = error::bad_encoded_body;
+                    break;
+                }
+                flags_ = hdr_[3];
+                next_header();
+                break;
+
+            case s_gzip_extra_len:
+                if(! fill(p, end))
+                    return p - p0;
+                skip_ = hdr_[0] | (std::size_t{hdr_[1]} << 8);
+                s_ = s_gzip_extra;
+                break;
+
+            case s_gzip_extra:
+            {
+                auto const amount = (std::min)(skip_,
+                    static_cast<std::size_t>(end - p));
+                p += amount;
+                skip_ -= amount;
+                if(skip_ > 0)
+                    return p - p0;
+                flags_ &= ~f_extra;
+                next_header();
+                break;
+            }
+
+            case s_gzip_name:
+            case s_gzip_comment:
+            {
+                // zero-terminated string
+                auto const z = static_cast<std::uint8_t const*>(
+                    std::memchr(p, 0, end - p));
+                if(! z)
+                    return end - p0;
+                p = z + 1;
+                flags_ &= s_ == s_gzip_name ? ~f_name : ~f_comment;
+                next_header();
+                break;
+            }
+
+            case s_gzip_hcrc:
+                if(! fill(p, end))
+                    return p - p0;
+                flags_ &= ~f_hcrc;
+                next_header();
+                break;
+
+            case s_zlib_header:
+                if(! fill(p, end))
+                    return p - p0;
+                // CM must be deflate with at most a 32K window,
+                // the header must pass FCHECK, and preset
+                // dictionaries are not supported.
+                if( (hdr_[0] & 0x0f) != 8 || (hdr_[0] >> 4) > 7 ||
+                    ((hdr_[0] << 8) | hdr_[1]) % 31 != 0 ||
+                    (hdr_[1] & 0x20) != 0)
+                {
+                    ec = error::bad_encoded_body;
+                    break;
+                }
+                s_ = s_data;
+                break;
+
+            case s_data:
+            {
+                zlib::z_params zs;
+                zs.next_in = p;
+                zs.avail_in = end - p;
+                zs.next_out = c_->buf;
+                zs.avail_out = sizeof(c_->buf);
+                c_->is.write(zs, zlib::Flush::none, ec);
+                p = end - zs.avail_in;
+                len_ = sizeof(c_->buf) - zs.avail_out;
+                pos_ = 0;
+                if(ec == zlib::error::end_of_stream)
+                {
+                    ec.assign(0, ec.category());
+                    expect(s_trailer, body_.coding ==
+                        content_coding::gzip ? 8 : 4);
+                }
+                else if(ec == zlib::error::need_buffers)
+                {
+                    // no progress is possible without more input
+                    ec.assign(0, ec.category());
+                }
+                else if(ec)
+                {
+                    return p - p0;
+                }
+                if(len_ > 0)
+                {
+                    if(body_.coding == content_coding::gzip)
+                        check_ = zlib::detail::crc32(
+                            check_, c_->buf, len_);
+                    else
+                        check_ = zlib::detail::adler32(
+                            check_, c_->buf, len_);
+                    size_ += static_cast<std::uint32_t>(len_);
+                    total_ += len_;
+                    if(total_ > body_.limit)
+                    {
+                        ec = error::body_limit;
+                        return p - p0;
+                    }
+                    if(! deliver(ec))
+                        return p - p0;
+                }
+                if(s_ == s_data && p == end && zs.avail_out > 0)
+                    return p - p0;
+                break;
+            }
+
+            case s_trailer:
+                if(! fill(p, end))
+                    return p - p0;
+                if(! verify())
+                {
+                    ec = error::bad_encoded_body;
+                    break;
+                }
+                s_ = s_done;
+                break;
+
+            case s_done:
+                if(p == end)
+                    return p - p0;
+                // gzip allows concatenated members
+                if(body_.coding != content_coding::gzip)
+                {
+                    ec = error::bad_encoded_body;
+                    break;
+                }
+                c_->is.reset();
+                start();
+                break;
+            }
+        }
+        return p - p0;
+    }
+
+public:
+    template<bool isRequest, class Fields>
+    explicit
+    reader(header<isRequest, Fields>& h, value_type& b)
+        : rd_(h, b.body)
+        , body_(b)
+        , fields_(static_cast<Fields const*>(&h))
+        , get_coding_(&get_coding<Fields>)
+    {
+    }
+
+    void
+    init(boost::optional<
+        std::uint64_t> const& length, error_code& ec)
+    {
+        // The parser constructs the reader before
+        // the header is received, so look at it now.
+        body_.coding = get_coding_(fields_);
+        switch(body_.coding)
+        {
+        case content_coding::identity:
+            if(length && *length > body_.limit)
+            {
+                ec = error::body_limit;
+                return;
+            }
+            rd_.init(length, ec);
+            return;
+
+        case content_coding::gzip:
+        case content_coding::deflate:
+            // The decoded size is not known
+            rd_.init(boost::none, ec);
+            if(ec)
+                return;
+            c_ = pool::acquire();
+            c_->is.reset();
+            start();
+            return;
+
+        default:
+            ec = error::bad_content_coding;
+            return;
+        }
+    }
+
+    template<class ConstBufferSequence>
+    std::size_t
+    put(ConstBufferSequence const& buffers,
+        error_code& ec)
+    {
+        ec.assign(0, ec.category());
+        if(body_.coding == content_coding::identity)
+        {
+            auto const size = asio::buffer_size(buffers);
+            if(size > body_.limit - total_)
+            {
+                ec = error::body_limit;
+                return 0;
+            }
+            auto const n = rd_.put(buffers, ec);
+            total_ += n;
+            return n;
+        }
+        if(! deliver(ec))
+            return 0;
+        std::size_t used = 0;
+        for(auto b : beast::detail::buffers_range(buffers))
+        {
+            auto p = static_cast<
+                std::uint8_t const*>(b.data());
+            auto n = b.size();
+            if(held_ > 0)
+            {
+                // already decoded during the previous call
+                auto const amount = (std::min)(held_, n);
+                p += amount;
+                n -= amount;
+                held_ -= amount;
+                used += amount;
+            }
+            used += decode(p, n, ec);
+            if(ec)
+                break;
+        }
+        if( ec == error::need_buffer && used > 0 &&
+            used == asio::buffer_size(buffers))
+        {
+            // The inner reader has not accepted all of the
+            // decoded octets. Claim one less input octet so
+            // the parser calls again instead of finishing.
+            --used;
+            held_ = 1;
+        }
+        return used;
+    }
+
+    void
+    finish(error_code& ec)
+    {
+        ec.assign(0, ec.category());
+        if(body_.coding != content_coding::identity)
+        {
+            if(! deliver(ec))
+                return;
+            // An empty payload is allowed
+            bool const empty = have_ == 0 && (
+                s_ == s_gzip_header || s_ == s_zlib_header);
+            if(s_ != s_done && ! empty)
+            {
+                ec = error::bad_encoded_body;
+                return;
+            }
+        }
+        rd_.finish(ec);
+    }
+};
+
+template<class Body>
+std::uint8_t constexpr decompressing_body<Body>::reader::f_hcrc;
+
+template<class Body>
+std::uint8_t constexpr decompressing_body<Body>::reader::f_extra;
+
+template<class Body>
+std::uint8_t constexpr decompressing_body<Body>::reader::f_name;
+
+template<class Body>
+std::uint8_t constexpr decompressing_body<Body>::reader::f_comment;
+
+#endif
+
+} // http
+} // beast
+
+#endif
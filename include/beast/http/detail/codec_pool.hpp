@@ -0,0 +1,163 @@
+//
+// Copyright (c) 2016-2017 Vinnie Falco (vinnie dot falco at gmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/boostorg/beast
+//
+
+#ifndef BEAST_HTTP_DETAIL_CODEC_POOL_HPP
+#define BEAST_HTTP_DETAIL_CODEC_POOL_HPP
+
+#include <cstdlib>
+#include <memory>
+
+// Turn this on to avoid using thread_local
+//#define BEAST_NO_THREAD_LOCAL 1
+
+#ifdef BEAST_NO_THREAD_LOCAL
+#include <mutex>
+#endif
+
+namespace beast {
+namespace http {
+namespace detail {
+
+/*  A cache of idle codec objects.
+
+    Compression state is large (hundreds of kilobytes for
+    deflate) and expensive to allocate, but a body only needs
+    it while its message is being serialized or parsed. Bodies
+    obtain a codec here and return it when they are destroyed,
+    so that later messages reuse the memory. Up to `max_idle`
+    codecs are kept for each thread. The same pool also holds
+    the read buffers of file bodies.
+
+    `Codec` must be default constructible and have a data
+    member `Codec* next`.
+*/
+template<class Codec>
+class codec_pool
+{
+    static std::size_t constexpr max_idle = 4;
+
+    struct list
+    {
+        Codec* head = nullptr;
+        std::size_t size = 0;
+
+        ~list()
+        {
+            while(head)
+            {
+                auto const next = head->next;
+                delete head;
+                head = next;
+            }
+        }
+
+        Codec*
+        pop()
+        {
+            auto const p = head;
+            if(p)
+            {
+                head = p->next;
+                --size;
+            }
+            return p;
+        }
+
+        bool
+        push(Codec* p)
+        {
+            if(size >= max_idle)
+                return false;
+            p->next = head;
+            head = p;
+            ++size;
+            return true;
+        }
+    };
+
+#ifndef BEAST_NO_THREAD_LOCAL
+    static
+    list&
+    local()
+    {
+        thread_local list l;
+        return l;
+    }
+
+#else
+    static
+    list&
+    local()
+    {
+        static list l;
+        return l;
+    }
+
+    static
+    std::mutex&
+    mutex()
+    {
+        static std::mutex m;
+        return m;
+    }
+
+#endif
+
+    static
+    Codec*
+    pop()
+    {
+    #ifdef BEAST_NO_THREAD_LOCAL
+        std::lock_guard<std::mutex> lock(mutex());
+    #endif
+        return local().pop();
+    }
+
+    static
+    bool
+    push(Codec* p)
+    {
+    #ifdef BEAST_NO_THREAD_LOCAL
+        std::lock_guard<std::mutex> lock(mutex());
+    #endif
+        return local().push(p);
+    }
+
+public:
+    struct deleter
+    {
+        void
+        operator()(Codec* p) const
+        {
+            if(! push(p))
+                delete p;
+        }
+    };
+
+    using pointer = std::unique_ptr<Codec, deleter>;
+
+    /// Return an idle codec, or a newly constructed one
+    static
+    pointer
+    acquire()
+    {
+        if(auto const p = pop())
+            return pointer{p};
+        return pointer{new Codec};
+    }
+};
+
+template<class Codec>
+std::size_t constexpr codec_pool<Codec>::max_idle;
+
+} // detail
+} // http
+} // beast
+
+#endif
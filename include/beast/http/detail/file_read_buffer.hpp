@@ -0,0 +1,129 @@
+//
+// Copyright (c) 2016-2017 Vinnie Falco (vinnie dot falco at gmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/boostorg/beast
+//
+
+#ifndef BEAST_HTTP_DETAIL_FILE_READ_BUFFER_HPP
+#define BEAST_HTTP_DETAIL_FILE_READ_BUFFER_HPP
+
+#include <beast/core/detail/type_traits.hpp>
+#include <beast/http/detail/codec_pool.hpp>
+#include <asio/buffer.hpp>
+#include <boost/assert.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+namespace beast {
+namespace http {
+namespace detail {
+
+// Determines if File has a member `prefetch(offset, n)`
+template<class File, class = void>
+struct has_prefetch : std::false_type {};
+
+template<class File>
+struct has_prefetch<File, beast::detail::void_t<decltype(
+    std::declval<File const&>().prefetch(
+        std::declval<std::uint64_t>(),
+        std::declval<std::uint64_t>()))>> : std::true_type {};
+
+template<class File>
+void
+file_prefetch(File const& file,
+    std::uint64_t offset, std::uint64_t n, std::true_type)
+{
+    file.prefetch(offset, n);
+}
+
+template<class File>
+void
+file_prefetch(File const&,
+    std::uint64_t, std::uint64_t, std::false_type)
+{
+}
+
+struct file_read_block
+{
+    std::unique_ptr<char[]> data;
+    std::size_t capacity = 0;
+    file_read_block* next = nullptr;
+};
+
+/*  The buffer used by file body writers to read the file.
+
+    Storage comes from a per-thread pool, so serializing many
+    files does not allocate for every message. The amount read
+    at once starts small, so that short files and responses which
+    are abandoned early are cheap, and doubles after each read up
+    to the limit chosen for the body.
+*/
+class file_read_buffer
+{
+    codec_pool<file_read_block>::pointer p_;
+    std::size_t limit_;
+    std::size_t size_;
+
+public:
+    enum : std::size_t
+    {
+        initial_size = 64 * 1024
+    };
+
+    explicit
+    file_read_buffer(std::size_t limit)
+        : limit_(limit)
+        , size_((std::min)(
+            std::size_t{initial_size}, limit))
+    {
+        BOOST_ASSERT(limit > 0);
+    }
+
+    // Returns the amount which the next read should request
+    std::size_t
+    size() const
+    {
+        return size_;
+    }
+
+    // Returns storage for reading at most `remain` bytes
+    asio::mutable_buffer
+    prepare(std::uint64_t remain)
+    {
+        if(! p_)
+        {
+            p_ = codec_pool<file_read_block>::acquire();
+            // Size the storage once, for the largest read
+            // this body will make.
+            auto const capacity = static_cast<std::size_t>(
+                (std::min<std::uint64_t>)(remain, limit_));
+            if(p_->capacity < capacity)
+            {
+                p_->data.reset(new char[capacity]);
+                p_->capacity = capacity;
+            }
+        }
+        return {p_->data.get(), static_cast<std::size_t>(
+            (std::min<std::uint64_t>)(remain,
+                (std::min)(size_, p_->capacity)))};
+    }
+
+    // Called after each read, to grow the next one
+    void
+    commit()
+    {
+        size_ = size_ > limit_ / 2 ? limit_ : size_ * 2;
+    }
+};
+
+} // detail
+} // http
+} // beast
+
+#endif
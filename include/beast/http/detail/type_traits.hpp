@@ -10,7 +10,9 @@
 #ifndef BEAST_HTTP_DETAIL_TYPE_TRAITS_HPP
 #define BEAST_HTTP_DETAIL_TYPE_TRAITS_HPP
 
+#include <beast/core/error.hpp>
 #include <beast/core/detail/type_traits.hpp>
+#include <asio/buffer.hpp>
 #include <boost/optional.hpp>
 #include <cstdint>
 
@@ -95,6 +97,73 @@ struct is_body_sized<T, beast::detail::void_t<
         T::size(std::declval<typename T::value_type const&>())
     )>> : std::true_type {};
 
+/** Determine if a @b BodyWriter can wait for its next buffers
+
+    A writer whose `get` fails with @ref error::need_more while
+    its buffers are produced elsewhere may provide `wait(ec)`,
+    which blocks until `get` can make progress. The synchronous
+    stream write algorithms use it instead of reporting the error.
+*/
+template<class T, class = void>
+struct is_body_writer_waitable : std::false_type {};
+
+template<class T>
+struct is_body_writer_waitable<T, beast::detail::void_t<decltype(
+    std::declval<T&>().wait(std::declval<error_code&>())
+    )>> : std::true_type {};
+
+struct wait_handler
+{
+    void operator()(error_code);
+};
+
+/** Determine if a @b BodyWriter can wait asynchronously
+
+    Such a writer may provide `async_wait(handler)`, which invokes
+    a handler with the signature `void(error_code)` once `get` can
+    make progress. The asynchronous stream write algorithms use it
+    instead of reporting the error.
+*/
+template<class T, class = void>
+struct is_body_writer_async_waitable : std::false_type {};
+
+template<class T>
+struct is_body_writer_async_waitable<T, beast::detail::void_t<decltype(
+    std::declval<T&>().async_wait(std::declval<wait_handler>())
+    )>> : std::true_type {};
+
+/** Determine if a @b BodyReader can store octets in place
+
+    A reader may provide `prepare(n, ec)`, which returns a
+    mutable buffer of `n` octets at the end of the body, and
+    `commit(n)`, which appends the first `n` octets written
+    there. The rest of the buffer is removed from the body by
+    `finish`, or at once by `commit(0)`. The stream read
+    algorithms use these to read a body of known length
+    directly into its storage instead of through the read
+    buffer.
+*/
+template<class T, class = void>
+struct is_body_reader_direct : std::false_type {};
+
+template<class T>
+struct is_body_reader_direct<T, beast::detail::void_t<decltype(
+    std::declval<asio::mutable_buffer&>() =
+        std::declval<T&>().prepare(
+            std::declval<std::size_t>(),
+            std::declval<error_code&>()),
+    std::declval<T&>().commit(std::declval<std::size_t>())
+    )>> : std::true_type {};
+
+// `true` if Derived is a parser whose body reader
+// can store octets in place
+template<class T>
+struct has_direct_body : std::false_type {};
+
+template<bool isRequest, class Body, class Allocator>
+struct has_direct_body<parser<isRequest, Body, Allocator>>
+    : is_body_reader_direct<typename Body::reader> {};
+
 template<class T>
 struct is_fields_helper : T
 {
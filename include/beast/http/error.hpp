@@ -41,6 +41,10 @@ enum class error
         This error is returned during parsing when additional
         octets are needed. The caller should append more data
         to the existing buffer and retry the parse operaetion.
+
+        During serialization, a body writer returns this error
+        when its next buffers are not ready yet, for example
+        while @ref async_file_body is reading the file.
     */
     need_more,
 
@@ -143,7 +147,17 @@ enum class error
     bad_chunk_extension,
 
     /// An obs-fold exceeded an internal limit.
-    bad_obs_fold
+    bad_obs_fold,
+
+    //
+    // (content coding errors)
+    //
+
+    /// The content coding is unknown or not supported.
+    bad_content_coding,
+
+    /// The coded body is malformed or fails its checksum.
+    bad_encoded_body
 };
 
 } // http
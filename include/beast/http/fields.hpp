@@ -703,6 +703,20 @@ private:
     template<class OtherAlloc>
     friend class basic_fields;
 
+    // Interpretation of the Connection, Transfer-Encoding
+    // and Content-Length fields, kept current by every
+    // modifier so the corresponding accessors are O(1).
+    struct metadata
+    {
+        bool close = false;             // Connection has "close"
+        bool keep_alive = false;        // Connection has "keep-alive"
+        bool chunked = false;           // last coding is "chunked"
+        bool content_length = false;    // Content-Length present
+    };
+
+    void
+    update_metadata(field name);
+
     value_type&
     new_element(field name,
         string_view sname, string_view value);
@@ -752,6 +766,7 @@ private:
     list_t list_;
     string_view method_;
     string_view target_or_reason_;
+    metadata md_;
 };
 
 /// A typical HTTP header fields container
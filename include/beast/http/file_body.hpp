@@ -28,6 +28,7 @@ using file_body = basic_file_body<file>;
 } // http
 } // beast
 
+#include <beast/http/impl/file_body_posix.ipp>
 #include <beast/http/impl/file_body_win32.ipp>
 
 #endif
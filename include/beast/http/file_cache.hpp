@@ -0,0 +1,321 @@
+//
+// Copyright (c) 2016-2017 Vinnie Falco (vinnie dot falco at gmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/boostorg/beast
+//
+
+#ifndef BEAST_HTTP_FILE_CACHE_HPP
+#define BEAST_HTTP_FILE_CACHE_HPP
+
+#include <beast/core/file_posix.hpp>
+
+#if BEAST_USE_POSIX_FILE
+
+#include <beast/core/detail/config.hpp>
+#include <beast/core/error.hpp>
+#include <beast/core/string.hpp>
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace beast {
+namespace http {
+
+/** A cache of static files for serving with @ref cached_file_body.
+
+    Serving a file with @ref file_body costs an open, a stat, and
+    a series of reads on every request. This cache keeps what is
+    learned from those calls across requests:
+
+    @li Files no larger than @ref resident_limit are read once
+    and held in memory, and their descriptors are closed.
+
+    @li Larger files are kept open, and their contents are read
+    with `pread` so that any number of responses may share the
+    same descriptor at once.
+
+    @li A gzip representation of each file is loaded once from a
+    sibling file with the ".gz" suffix if one exists and is not
+    older than the file, or else produced once with
+    @ref zlib::deflate_stream when the file is no larger than
+    @ref compress_limit. It is kept only if it is smaller than
+    the file.
+
+    @li Each representation carries a strong entity tag derived
+    from the size, modification time, and inode of its file.
+
+    A cached entry is revalidated by comparing the result of
+    `stat` against the file it was loaded from, and against the
+    ".gz" sibling or its absence, at most once per
+    @ref revalidate_interval. Until then, entries are returned
+    without making any system calls. Entries are immutable and
+    reference counted, so a response keeps its entry alive even
+    if the cache replaces or removes it.
+
+    @par Thread Safety
+    @e Distinct @e objects: Safe.@n
+    @e Shared @e objects: Safe, except that the settings
+    must not be changed while other threads use the cache.
+
+    @note This class is only available on POSIX systems.
+*/
+class file_cache
+{
+public:
+    /// One stored form of a file
+    class representation
+    {
+        friend class file_cache;
+
+        file_posix file_;
+        std::string data_;
+        std::string etag_;
+        std::uint64_t size_ = 0;
+        bool resident_ = false;
+
+    public:
+        /// Returns the number of octets in the representation
+        std::uint64_t
+        size() const
+        {
+            return size_;
+        }
+
+        /// Returns the strong entity tag, including the quotes
+        string_view
+        etag() const
+        {
+            return etag_;
+        }
+
+        /// Returns `true` if the octets are held in memory
+        bool
+        resident() const
+        {
+            return resident_;
+        }
+
+        /** Returns the octets held in memory.
+
+            The result is empty unless @ref resident
+            returns `true`.
+        */
+        string_view
+        data() const
+        {
+            return data_;
+        }
+
+        /** Read octets from the representation.
+
+            This reads from the open file without changing
+            its position, and may be called from any number
+            of threads at once. The octets are copied from
+            memory if the representation is resident.
+
+            @param offset The offset to read from.
+
+            @param buffer The location to store the octets.
+
+            @param n The maximum number of octets to read.
+
+            @param ec Set to the error, if any occurred.
+
+            @return The number of octets read, which will be
+            less than `n` only at the end of the file.
+        */
+        std::size_t
+        read(std::uint64_t offset, void* buffer,
+            std::size_t n, error_code& ec) const;
+    };
+
+private:
+    // What is known about a file from stat
+    struct file_info
+    {
+        std::uint64_t dev = 0;
+        std::uint64_t ino = 0;
+        std::uint64_t size = 0;
+        std::uint64_t mtime = 0;    // nanoseconds
+        std::time_t last_modified = 0;
+    };
+
+public:
+    /// A cached file
+    class entry
+    {
+        friend class file_cache;
+
+        representation identity_;
+        representation gzip_;
+        bool has_gzip_ = false;
+        std::time_t last_modified_ = 0;
+
+        // The files the entry was loaded from
+        file_info file_;
+        file_info sibling_;
+        bool has_sibling_ = false;
+
+    public:
+        /// Returns the representation without a content coding
+        representation const&
+        identity() const
+        {
+            return identity_;
+        }
+
+        /// Returns the gzip representation, or `nullptr` if none
+        representation const*
+        gzip() const
+        {
+            return has_gzip_ ? &gzip_ : nullptr;
+        }
+
+        /// Returns the modification time of the file
+        std::time_t
+        last_modified() const
+        {
+            return last_modified_;
+        }
+    };
+
+    /// A shared reference to a cached file
+    using entry_ptr = std::shared_ptr<entry const>;
+
+    /// The clock used to schedule revalidation
+    using clock_type = std::chrono::steady_clock;
+
+private:
+    struct slot
+    {
+        entry_ptr e;
+        clock_type::time_point checked;
+    };
+
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, slot> map_;
+    std::size_t resident_limit_ = 64 * 1024;
+    std::size_t compress_limit_ = 1024 * 1024;
+    clock_type::duration interval_ = std::chrono::seconds(1);
+
+    static
+    bool
+    same(file_info const& lhs, file_info const& rhs);
+
+    static
+    bool
+    stat_file(char const* path, file_info& info);
+
+    static
+    bool
+    fresh(std::string const& path, entry const& e);
+
+    void
+    load(representation& rep, char const* path,
+        char const* suffix, file_info& info, error_code& ec);
+
+    void
+    compress(entry& e, error_code& ec);
+
+    entry_ptr
+    load(std::string const& path, error_code& ec);
+
+public:
+    /// Constructor
+    file_cache() = default;
+
+    /// Returns the size at or below which files are held in memory
+    std::size_t
+    resident_limit() const
+    {
+        return resident_limit_;
+    }
+
+    /** Set the size at or below which files are held in memory.
+
+        The default is 64KB. This applies to entries loaded
+        after the call.
+    */
+    void
+    resident_limit(std::size_t n)
+    {
+        resident_limit_ = n;
+    }
+
+    /// Returns the size at or below which files are compressed
+    std::size_t
+    compress_limit() const
+    {
+        return compress_limit_;
+    }
+
+    /** Set the size at or below which files are compressed.
+
+        The default is 1MB. A value of zero disables compression,
+        although gzip siblings are still used. The compressed
+        representation is held in memory. This applies to entries
+        loaded after the call.
+    */
+    void
+    compress_limit(std::size_t n)
+    {
+        compress_limit_ = n;
+    }
+
+    /// Returns the time between checks of a file for changes
+    clock_type::duration
+    revalidate_interval() const
+    {
+        return interval_;
+    }
+
+    /** Set the time between checks of a file for changes.
+
+        The default is one second. A value of zero checks
+        the file on every call to @ref get.
+    */
+    void
+    revalidate_interval(clock_type::duration d)
+    {
+        interval_ = d;
+    }
+
+    /** Return the entry for a file, loading it if needed.
+
+        @param path The utf-8 encoded path to a regular file.
+
+        @param ec Set to the error, if any occurred.
+
+        @return The entry, or `nullptr` on error.
+    */
+    entry_ptr
+    get(string_view path, error_code& ec);
+
+    /// Remove the entry for a file, if present
+    void
+    erase(string_view path);
+
+    /// Remove all entries
+    void
+    clear();
+
+    /// Returns the number of entries
+    std::size_t
+    size() const;
+};
+
+} // http
+} // beast
+
+#include <beast/http/impl/file_cache.ipp>
+
+#endif
+
+#endif
@@ -0,0 +1,222 @@
+//
+// Copyright (c) 2016-2017 Vinnie Falco (vinnie dot falco at gmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/boostorg/beast
+//
+
+#ifndef BEAST_HTTP_FRAGMENTS_BODY_HPP
+#define BEAST_HTTP_FRAGMENTS_BODY_HPP
+
+#include <beast/core/detail/config.hpp>
+#include <beast/core/detail/buffers_ref.hpp>
+#include <beast/http/message.hpp>
+#include <asio/buffer.hpp>
+#include <boost/optional.hpp>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace beast {
+namespace http {
+
+/** A @b Body made of shared, immutable fragments.
+
+    This body holds a list of buffers which are sent one after
+    another, such as a cached page header, a cached document and
+    a footer. Each fragment refers to memory kept alive by a
+    shared owner, so the same fragments may be used by any number
+    of messages at once, on any number of threads, without being
+    copied. The writer returns every fragment in a single buffer
+    sequence, which the stream can send with one gathered write.
+
+    The memory referenced by a fragment must not be modified
+    while any message holding it is alive.
+
+    Messages using this body type may be serialized but not
+    parsed.
+
+    @par Example
+    @code
+    static auto const header =
+        std::make_shared<std::string const>("<html><body>");
+    static auto const footer =
+        std::make_shared<std::string const>("</body></html>");
+
+    response<fragments_body> res;
+    res.body().push_back(header);
+    res.body().push_back(content);  // std::shared_ptr<std::string const>
+    res.body().push_back(footer);
+    res.prepare_payload();
+    @endcode
+*/
+struct fragments_body
+{
+    /// The type of the body member when used in a message.
+    class value_type
+    {
+        friend struct fragments_body;
+
+        std::vector<asio::const_buffer> buffers_;
+        std::vector<std::shared_ptr<void const>> owners_;
+        std::uint64_t size_ = 0;
+
+    public:
+        /// The type of buffer sequence returned by @ref buffers
+        using const_buffers_type =
+            std::vector<asio::const_buffer>;
+
+        /// Constructor
+        value_type() = default;
+
+        /// Returns the number of octets in the body
+        std::uint64_t
+        size() const
+        {
+            return size_;
+        }
+
+        /// Returns `true` if the body has no octets
+        bool
+        empty() const
+        {
+            return size_ == 0;
+        }
+
+        /// Returns the fragments as a @b ConstBufferSequence
+        const_buffers_type const&
+        buffers() const
+        {
+            return buffers_;
+        }
+
+        /// Reserve space for `n` fragments
+        void
+        reserve(std::size_t n)
+        {
+            buffers_.reserve(n);
+            owners_.reserve(n);
+        }
+
+        /// Remove all fragments, releasing their owners
+        void
+        clear()
+        {
+            buffers_.clear();
+            owners_.clear();
+            size_ = 0;
+        }
+
+        /** Append a fragment held by a shared pointer.
+
+            The fragment is the memory returned by `asio::buffer(*p)`,
+            so `T` may be any type accepted by that function, such as
+            `std::string`, `std::vector<char>` or an array.
+
+            @param p The owner of the fragment. If this is null,
+            nothing is appended.
+        */
+        template<class T>
+        void
+        push_back(std::shared_ptr<T> const& p)
+        {
+            if(p)
+                push_back(p, asio::const_buffer(asio::buffer(*p)));
+        }
+
+        /** Append a fragment kept alive by an owner.
+
+            This may be used to send part of a larger object, or an
+            object which `asio::buffer` does not accept.
+
+            @param owner The object keeping the memory alive. A copy
+            is stored with the body.
+
+            @param buffer The memory to send.
+        */
+        void
+        push_back(std::shared_ptr<void const> owner,
+            asio::const_buffer buffer)
+        {
+            if(buffer.size() == 0)
+                return;
+            buffers_.push_back(buffer);
+            if(owner)
+                owners_.emplace_back(std::move(owner));
+            size_ += buffer.size();
+        }
+
+        /** Append a fragment which needs no owner.
+
+            The memory must remain valid for as long as the body
+            is used, for example a string literal.
+
+            @param buffer The memory to send.
+        */
+        void
+        push_back(asio::const_buffer buffer)
+        {
+            push_back(nullptr, buffer);
+        }
+    };
+
+    /** Returns the payload size of the body
+
+        When this body is used with @ref message::prepare_payload,
+        the Content-Length will be set to the payload size, and
+        any chunked Transfer-Encoding will be removed.
+    */
+    static
+    std::uint64_t
+    size(value_type const& body)
+    {
+        return body.size();
+    }
+
+    /** The algorithm for serializing the body
+
+        Meets the requirements of @b BodyWriter.
+    */
+#if BEAST_DOXYGEN
+    using writer = implementation_defined;
+#else
+    class writer
+    {
+        value_type const& body_;
+
+    public:
+        using const_buffers_type = beast::detail::buffers_ref<
+            value_type::const_buffers_type>;
+
+        template<bool isRequest, class Fields>
+        explicit
+        writer(header<isRequest, Fields> const&, value_type const& b)
+            : body_(b)
+        {
+        }
+
+        void
+        init(error_code& ec)
+        {
+            ec.assign(0, ec.category());
+        }
+
+        boost::optional<std::pair<const_buffers_type, bool>>
+        get(error_code& ec)
+        {
+            ec.assign(0, ec.category());
+            if(body_.buffers_.empty())
+                return boost::none;
+            return {{const_buffers_type{body_.buffers_}, false}};
+        }
+    };
+#endif
+};
+
+} // http
+} // beast
+
+#endif
@@ -295,6 +295,34 @@ put_eof(error_code& ec)
     state_ = state::complete;
 }
 
+template<bool isRequest, class Derived>
+void
+basic_parser<isRequest, Derived>::
+commit_body(std::uint64_t n, error_code& ec)
+{
+    BOOST_ASSERT(
+        state_ == state::body0 ||
+        state_ == state::body);
+    BOOST_ASSERT(n <= len_);
+    if(state_ == state::body0)
+    {
+        impl().on_body_init_impl(content_length(), ec);
+        if(ec)
+            return;
+        state_ = state::body;
+    }
+    len_ -= n;
+    if(len_ > 0)
+    {
+        ec.assign(0, ec.category());
+        return;
+    }
+    impl().on_finish_impl(ec);
+    if(ec)
+        return;
+    state_ = state::complete;
+}
+
 template<bool isRequest, class Derived>
 template<class ConstBufferSequence>
 std::size_t
@@ -0,0 +1,146 @@
+//
+// Copyright (c) 2016-2017 Vinnie Falco (vinnie dot falco at gmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/boostorg/beast
+//
+
+#ifndef BEAST_HTTP_IMPL_CONTENT_CODING_IPP
+#define BEAST_HTTP_IMPL_CONTENT_CODING_IPP
+
+#include <beast/http/rfc7230.hpp>
+#include <boost/throw_exception.hpp>
+#include <stdexcept>
+
+namespace beast {
+namespace http {
+
+namespace detail {
+
+// Parse a qvalue, returning thousandths or -1 on error
+//
+//  qvalue = ( "0" [ "." 0*3DIGIT ] )
+//         / ( "1" [ "." 0*3("0") ] )
+//
+inline
+int
+parse_qvalue(string_view s)
+{
+    if(s.empty() || (s[0] != '0' && s[0] != '1'))
+        return -1;
+    int q = (s[0] - '0') * 1000;
+    s.remove_prefix(1);
+    if(s.empty())
+        return q;
+    if(s[0] != '.' || s.size() > 4)
+        return -1;
+    s.remove_prefix(1);
+    int scale = 100;
+    for(auto c : s)
+    {
+        if(c < '0' || c > '9')
+            return -1;
+        q += (c - '0') * scale;
+        scale /= 10;
+    }
+    if(q > 1000)
+        return -1;
+    return q;
+}
+
+template<class = void>
+content_coding
+negotiate_content_coding(string_view s)
+{
+    // quality of each coding, or -1 if not listed
+    int q_gzip = -1;
+    int q_deflate = -1;
+    int q_identity = -1;
+    int q_any = -1;
+    for(auto const& ext : ext_list{s})
+    {
+        int q = 1000;
+        for(auto const& param : ext.second)
+        {
+            if(iequals(param.first, "q"))
+            {
+                q = parse_qvalue(param.second);
+                break;
+            }
+        }
+        if(q < 0)
+            continue; // ignore malformed entries
+        if(ext.first == "*")
+            q_any = q;
+        else switch(string_to_content_coding(ext.first))
+        {
+        case content_coding::gzip:      q_gzip = q; break;
+        case content_coding::deflate:   q_deflate = q; break;
+        case content_coding::identity:  q_identity = q; break;
+        default:
+            break;
+        }
+    }
+    if(q_gzip < 0)
+        q_gzip = q_any < 0 ? 0 : q_any;
+    if(q_deflate < 0)
+        q_deflate = q_any < 0 ? 0 : q_any;
+    // identity is always acceptable, but only
+    // competes when the client lists it
+    if(q_identity < 0)
+        q_identity = q_any < 0 ? 0 : q_any;
+    // prefer gzip on a tie, deflate is often misimplemented
+    auto const best = q_gzip >= q_deflate ?
+        content_coding::gzip : content_coding::deflate;
+    auto const q_best = q_gzip >= q_deflate ?
+        q_gzip : q_deflate;
+    if(q_best == 0 || q_identity > q_best)
+        return content_coding::identity;
+    return best;
+}
+
+} // detail
+
+inline
+content_coding
+string_to_content_coding(string_view s)
+{
+    if(iequals(s, "gzip") || iequals(s, "x-gzip"))
+        return content_coding::gzip;
+    if(iequals(s, "deflate"))
+        return content_coding::deflate;
+    if(iequals(s, "identity"))
+        return content_coding::identity;
+    return content_coding::unknown;
+}
+
+inline
+string_view
+to_string(content_coding c)
+{
+    switch(c)
+    {
+    case content_coding::identity:  return "identity";
+    case content_coding::deflate:   return "deflate";
+    case content_coding::gzip:      return "gzip";
+    case content_coding::unknown:
+        return "<unknown>";
+    }
+
+    BOOST_THROW_EXCEPTION(std::invalid_argument{
+        "unknown content coding"});
+}
+
+inline
+content_coding
+negotiate_content_coding(string_view s)
+{
+    return detail::negotiate_content_coding(s);
+}
+
+} // http
+} // beast
+
+#endif
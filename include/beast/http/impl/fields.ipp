@@ -364,9 +364,11 @@ basic_fields(basic_fields&& other) noexcept
     , list_(std::move(other.list_))
     , method_(other.method_)
     , target_or_reason_(other.target_or_reason_)
+    , md_(other.md_)
 {
     other.method_ = {};
     other.target_or_reason_ = {};
+    other.md_ = {};
 }
 
 template<class Allocator>
@@ -385,6 +387,10 @@ basic_fields(basic_fields&& other, Allocator const& alloc)
         list_ = std::move(other.list_);
         method_ = other.method_;
         target_or_reason_ = other.target_or_reason_;
+        md_ = other.md_;
+        other.method_ = {};
+        other.target_or_reason_ = {};
+        other.md_ = {};
     }
 }
 
@@ -531,6 +537,7 @@ clear()
     delete_list();
     set_.clear();
     list_.clear();
+    md_ = {};
 }
 
 template<class Allocator>
@@ -568,6 +575,7 @@ insert(field name,
         BOOST_ASSERT(count(sname) == 0);
         set_.insert_before(before, e);
         list_.push_back(e);
+        update_metadata(name);
         return;
     }
     auto const last = std::prev(before);
@@ -577,6 +585,7 @@ insert(field name,
         BOOST_ASSERT(count(sname) == 0);
         set_.insert_before(before, e);
         list_.push_back(e);
+        update_metadata(name);
         return;
     }
     // keep duplicate fields together in the list
@@ -612,9 +621,11 @@ erase(const_iterator pos) ->
 {
     auto next = pos;
     auto& e = *next++;
-    set_.erase(e);
+    auto const name = e.name();
+    set_.erase(set_.iterator_to(e));
     list_.erase(pos);
     delete_element(const_cast<value_type&>(e));
+    update_metadata(name);
     return next;
 }
 
@@ -640,6 +651,8 @@ erase(string_view name)
             list_.erase(list_.iterator_to(*e));
             delete_element(*e);
         });
+    if(n > 0)
+        update_metadata(string_to_field(name));
     return n;
 }
 
@@ -912,16 +925,7 @@ bool
 basic_fields<Allocator>::
 get_chunked_impl() const
 {
-    auto const te = token_list{
-        (*this)[field::transfer_encoding]};
-    for(auto it = te.begin(); it != te.end();)
-    {
-        auto const next = std::next(it);
-        if(next == te.end())
-            return iequals(*it, "chunked");
-        it = next;
-    }
-    return false;
+    return md_.chunked;
 }
 
 template<class Allocator>
@@ -929,18 +933,9 @@ bool
 basic_fields<Allocator>::
 get_keep_alive_impl(unsigned version) const
 {
-    auto const it = find(field::connection);
     if(version < 11)
-    {
-        if(it == end())
-            return false;
-        return token_list{
-            it->value()}.exists("keep-alive");
-    }
-    if(it == end())
-        return true;
-    return ! token_list{
-        it->value()}.exists("close");
+        return md_.keep_alive;
+    return ! md_.close;
 }
 
 template<class Allocator>
@@ -948,7 +943,7 @@ bool
 basic_fields<Allocator>::
 has_content_length_impl() const
 {
-    return count(field::content_length) > 0;
+    return md_.content_length;
 }
 
 template<class Allocator>
@@ -985,6 +980,8 @@ void
 basic_fields<Allocator>::
 set_chunked_impl(bool value)
 {
+    if(md_.chunked == value)
+        return; // nothing to do
     auto it = find(field::transfer_encoding);
     if(value)
     {
@@ -994,18 +991,6 @@ set_chunked_impl(bool value)
             set(field::transfer_encoding, "chunked");
             return;
         }
-        auto const te = token_list{it->value()};
-        for(auto itt = te.begin();;)
-        {
-            auto const next = std::next(itt);
-            if(next == te.end())
-            {
-                if(iequals(*itt, "chunked"))
-                    return; // already set
-                break;
-            }
-            itt = next;
-        }
         static_string<max_static_buffer> buf;
         if(it->value().size() <= buf.size() + 9)
         {
@@ -1035,8 +1020,7 @@ set_chunked_impl(bool value)
         return;
     }
     // filter "chunked"
-    if(it == end())
-        return;
+    BOOST_ASSERT(it != end());
     try
     {
         static_string<max_static_buffer> buf;
@@ -1084,7 +1068,10 @@ set_content_length_impl(
     boost::optional<std::uint64_t> const& value)
 {
     if(! value)
-        erase(field::content_length);
+    {
+        if(md_.content_length)
+            erase(field::content_length);
+    }
     else
         set(field::content_length, *value);
 }
@@ -1095,6 +1082,17 @@ basic_fields<Allocator>::
 set_keep_alive_impl(
     unsigned version, bool keep_alive)
 {
+    // Skip rebuilding the field when the
+    // tokens already say what is wanted.
+    if(version < 11)
+    {
+        if(! md_.close && md_.keep_alive == keep_alive)
+            return;
+    }
+    else if(! md_.keep_alive && md_.close != keep_alive)
+    {
+        return;
+    }
     // VFALCO What about Proxy-Connection ?
     auto const value = (*this)[field::connection];
     try
@@ -1133,6 +1131,60 @@ set_keep_alive_impl(
 
 //------------------------------------------------------------------------------
 
+template<class Allocator>
+void
+basic_fields<Allocator>::
+update_metadata(field name)
+{
+    switch(name)
+    {
+    case field::connection:
+    {
+        md_.close = false;
+        md_.keep_alive = false;
+        auto const it = find(field::connection);
+        if(it == end())
+            break;
+        for(auto const& s : token_list{it->value()})
+        {
+            if(iequals(s, "close"))
+                md_.close = true;
+            else if(iequals(s, "keep-alive"))
+                md_.keep_alive = true;
+        }
+        break;
+    }
+
+    case field::transfer_encoding:
+    {
+        md_.chunked = false;
+        auto const it = find(field::transfer_encoding);
+        if(it == end())
+            break;
+        auto const te = token_list{it->value()};
+        for(auto itt = te.begin(); itt != te.end();)
+        {
+            auto const next = std::next(itt);
+            if(next == te.end())
+            {
+                md_.chunked = iequals(*itt, "chunked");
+                break;
+            }
+            itt = next;
+        }
+        break;
+    }
+
+    case field::content_length:
+        md_.content_length =
+            find(field::content_length) != end();
+        break;
+
+    default:
+        break;
+    }
+}
+
 template<class Allocator>
 auto
 basic_fields<Allocator>::
@@ -1190,6 +1242,7 @@ set_element(value_type& e)
     {
         set_.insert_before(it, e);
         list_.push_back(e);
+        update_metadata(e.name());
         return;
     }
     for(;;)
@@ -1206,6 +1259,7 @@ set_element(value_type& e)
     }
     set_.insert_before(it, e);
     list_.push_back(e);
+    update_metadata(e.name());
 }
 
 template<class Allocator>
@@ -1308,8 +1362,10 @@ move_assign(basic_fields& other, std::true_type)
     list_ = std::move(other.list_);
     method_ = other.method_;
     target_or_reason_ = other.target_or_reason_;
+    md_ = other.md_;
     other.method_ = {};
     other.target_or_reason_ = {};
+    other.md_ = {};
     this->member() = other.member();
 }
 
@@ -1331,8 +1387,10 @@ move_assign(basic_fields& other, std::false_type)
         list_ = std::move(other.list_);
         method_ = other.method_;
         target_or_reason_ = other.target_or_reason_;
+        md_ = other.md_;
         other.method_ = {};
         other.target_or_reason_ = {};
+        other.md_ = {};
     }
 }
 
@@ -1369,6 +1427,7 @@ swap(basic_fields& other, std::true_type)
     swap(list_, other.list_);
     swap(method_, other.method_);
     swap(target_or_reason_, other.target_or_reason_);
+    swap(md_, other.md_);
 }
 
 template<class Allocator>
@@ -1383,6 +1442,7 @@ swap(basic_fields& other, std::false_type)
     swap(list_, other.list_);
     swap(method_, other.method_);
     swap(target_or_reason_, other.target_or_reason_);
+    swap(md_, other.md_);
 }
 
 } // http
@@ -0,0 +1,590 @@
+//
+// Copyright (c) 2016-2017 Vinnie Falco (vinnie dot falco at gmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/boostorg/beast
+//
+
+#ifndef BEAST_HTTP_IMPL_FILE_BODY_POSIX_IPP
+#define BEAST_HTTP_IMPL_FILE_BODY_POSIX_IPP
+
+#include <beast/core/file_posix.hpp>
+
+// Turn this off to read file bodies through the parser
+// even where splice(2) is available
+#if ! defined(BEAST_USE_SPLICE)
+# if BEAST_USE_POSIX_FILE && defined(__linux__)
+#  define BEAST_USE_SPLICE 1
+# else
+#  define BEAST_USE_SPLICE 0
+# endif
+#endif
+
+#if BEAST_USE_SPLICE
+
+#include <beast/core/bind_handler.hpp>
+#include <beast/core/type_traits.hpp>
+#include <beast/http/parser.hpp>
+#include <beast/http/read.hpp>
+#include <asio/associated_allocator.hpp>
+#include <asio/associated_executor.hpp>
+#include <asio/async_result.hpp>
+#include <asio/basic_stream_socket.hpp>
+#include <asio/coroutine.hpp>
+#include <asio/error.hpp>
+#include <asio/executor_work_guard.hpp>
+#include <asio/handler_continuation_hook.hpp>
+#include <asio/handler_invoke_hook.hpp>
+#include <asio/post.hpp>
+#include <boost/assert.hpp>
+#include <boost/throw_exception.hpp>
+#include <algorithm>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace beast {
+namespace http {
+
+namespace detail {
+
+/*  A pipe used to move body octets from a socket into a
+    file without copying them through user space.
+
+    If the socket or the file does not support splice(2),
+    the octets are moved with read and write instead and
+    `fallback` returns `true`. The caller should then read
+    the rest of the body through the parser.
+*/
+class splice_pipe
+{
+    int fd_[2];
+    std::size_t capacity_ = 0;
+    bool fallback_ = false;
+
+    void
+    drain(int to, std::size_t n, error_code& ec);
+
+public:
+    splice_pipe()
+    {
+        fd_[0] = -1;
+        fd_[1] = -1;
+    }
+
+    splice_pipe(splice_pipe&& other)
+        : capacity_(other.capacity_)
+        , fallback_(other.fallback_)
+    {
+        fd_[0] = other.fd_[0];
+        fd_[1] = other.fd_[1];
+        other.fd_[0] = -1;
+        other.fd_[1] = -1;
+    }
+
+    splice_pipe& operator=(splice_pipe&&) = delete;
+
+    ~splice_pipe()
+    {
+        if(fd_[0] != -1)
+            ::close(fd_[0]);
+        if(fd_[1] != -1)
+            ::close(fd_[1]);
+    }
+
+    bool
+    fallback() const
+    {
+        return fallback_;
+    }
+
+    // Move up to `n` octets from the socket into the file,
+    // returning the number moved. Zero without an error
+    // means the end of the stream, unless `fallback` is set.
+    std::size_t
+    transfer(int from, int to, std::uint64_t n, error_code& ec);
+};
+
+inline
+void
+splice_pipe::
+drain(int to, std::size_t n, error_code& ec)
+{
+    char buf[4096];
+    while(n > 0)
+    {
+        auto const nread = ::read(fd_[0], buf,
+            (std::min)(n, sizeof(buf)));
+        if(nread < 0)
+        {
+            if(errno == EINTR)
+                continue;
+            ec.assign(errno, generic_category());
+            return;
+        }
+        BOOST_ASSERT(nread > 0);
+        std::size_t written = 0;
+        while(written < static_cast<std::size_t>(nread))
+        {
+            auto const result = ::write(to, buf + written,
+                static_cast<std::size_t>(nread) - written);
+            if(result < 0)
+            {
+                if(errno == EINTR)
+                    continue;
+                ec.assign(errno, generic_category());
+                return;
+            }
+            written += static_cast<std::size_t>(result);
+        }
+        n -= static_cast<std::size_t>(nread);
+    }
+    ec.assign(0, ec.category());
+}
+
+inline
+std::size_t
+splice_pipe::
+transfer(int from, int to, std::uint64_t n, error_code& ec)
+{
+    BOOST_ASSERT(! fallback_);
+    if(fd_[0] == -1)
+    {
+        if(::pipe2(fd_, O_CLOEXEC) != 0)
+        {
+            ec.assign(errno, generic_category());
+            return 0;
+        }
+        // A larger pipe moves more octets per call. If the
+        // size can't be changed the default is used instead.
+        ::fcntl(fd_[1], F_SETPIPE_SZ, 1024 * 1024);
+        auto const size = ::fcntl(fd_[1], F_GETPIPE_SZ);
+        capacity_ = size > 0 ?
+            static_cast<std::size_t>(size) : 65536;
+    }
+    // Never ask for more than the pipe holds, or
+    // splice would block on the full pipe.
+    auto const amount = static_cast<std::size_t>(
+        (std::min<std::uint64_t>)(n, capacity_));
+    ssize_t result;
+    do
+    {
+        result = ::splice(from, nullptr,
+            fd_[1], nullptr, amount, SPLICE_F_MOVE);
+    }
+    while(result < 0 && errno == EINTR);
+    if(result < 0)
+    {
+        if(errno == EAGAIN || errno == EWOULDBLOCK)
+        {
+            ec = asio::error::would_block;
+            return 0;
+        }
+        if(errno == EINVAL || errno == ENOSYS)
+        {
+            // The socket does not support splice
+            fallback_ = true;
+            ec.assign(0, ec.category());
+            return 0;
+        }
+        ec.assign(errno, generic_category());
+        return 0;
+    }
+    auto const size = static_cast<std::size_t>(result);
+    std::size_t moved = 0;
+    while(moved < size)
+    {
+        auto const m = ::splice(fd_[0], nullptr,
+            to, nullptr, size - moved, SPLICE_F_MOVE);
+        if(m < 0)
+        {
+            if(errno == EINTR)
+                continue;
+            if(errno == EINVAL)
+            {
+                // The file does not support splice
+                fallback_ = true;
+                drain(to, size - moved, ec);
+                if(ec)
+                    return 0;
+                break;
+            }
+            ec.assign(errno, generic_category());
+            return 0;
+        }
+        moved += static_cast<std::size_t>(m);
+    }
+    ec.assign(0, ec.category());
+    return size;
+}
+
+// Give the parser the octets already in the buffer, and
+// return `true` if the rest of the body may be spliced.
+template<class DynamicBuffer, bool isRequest, class Allocator>
+bool
+splice_prepare(
+    DynamicBuffer& buffer,
+    parser<isRequest, basic_file_body<file_posix>, Allocator>& p,
+    std::size_t& bytes_transferred,
+    error_code& ec)
+{
+    ec.assign(0, ec.category());
+    if(p.is_done() || ! p.content_length())
+        return false;
+    while(buffer.size() > 0 && ! p.is_done())
+    {
+        auto const n = p.put(buffer.data(), ec);
+        if(ec)
+            return false;
+        buffer.consume(n);
+        bytes_transferred += n;
+    }
+    if(p.is_done())
+        return false;
+    // Let the body prepare the file before octets reach it
+    p.commit_body(0, ec);
+    return ! ec;
+}
+
+// Move part of the remaining body from the socket to the file
+template<class Protocol, bool isRequest, class Allocator>
+std::size_t
+splice_some(
+    asio::basic_stream_socket<Protocol>& sock,
+    parser<isRequest, basic_file_body<file_posix>, Allocator>& p,
+    splice_pipe& pipe,
+    error_code& ec)
+{
+    auto const n = pipe.transfer(
+        sock.native_handle(),
+        p.get().body().file().native_handle(),
+        *p.content_length(), ec);
+    if(ec)
+        return 0;
+    if(n == 0)
+    {
+        if(! pipe.fallback())
+        {
+            p.put_eof(ec);
+            BOOST_ASSERT(ec);
+        }
+        return 0;
+    }
+    p.commit_body(n, ec);
+    return n;
+}
+
+//------------------------------------------------------------------------------
+
+template<
+    class Protocol, class DynamicBuffer,
+    bool isRequest, class Allocator,
+    class Handler>
+class read_splice_op
+    : public asio::coroutine
+{
+    using parser_type = parser<isRequest,
+        basic_file_body<file_posix>, Allocator>;
+
+    asio::basic_stream_socket<Protocol>& sock_;
+    asio::executor_work_guard<decltype(std::declval<
+        asio::basic_stream_socket<Protocol>&>().get_executor())> wg_;
+    DynamicBuffer& b_;
+    parser_type& p_;
+    splice_pipe pipe_;
+    std::size_t bytes_transferred_ = 0;
+    Handler h_;
+    bool cont_ = false;
+
+public:
+    read_splice_op(read_splice_op&&) = default;
+    read_splice_op(read_splice_op const&) = delete;
+
+    template<class DeducedHandler>
+    read_splice_op(
+        DeducedHandler&& h,
+        asio::basic_stream_socket<Protocol>& s,
+        DynamicBuffer& b,
+        parser_type& p)
+        : sock_(s)
+        , wg_(sock_.get_executor())
+        , b_(b)
+        , p_(p)
+        , h_(std::forward<DeducedHandler>(h))
+    {
+    }
+
+    using allocator_type =
+        asio::associated_allocator_t<Handler>;
+
+    allocator_type
+    get_allocator() const noexcept
+    {
+        return (asio::get_associated_allocator)(h_);
+    }
+
+    using executor_type =
+        asio::associated_executor_t<Handler, decltype(std::declval<
+            asio::basic_stream_socket<Protocol>&>().get_executor())>;
+
+    executor_type
+    get_executor() const noexcept
+    {
+        return (asio::get_associated_executor)(
+            h_, sock_.get_executor());
+    }
+
+    void
+    operator()(
+        error_code ec,
+        std::size_t bytes_transferred = 0,
+        bool cont = true);
+
+    friend
+    bool asio_handler_is_continuation(read_splice_op* op)
+    {
+        using asio::asio_handler_is_continuation;
+        return op->cont_ ? true :
+            asio_handler_is_continuation(
+                std::addressof(op->h_));
+    }
+
+    template<class Function>
+    friend
+    void asio_handler_invoke(Function&& f, read_splice_op* op)
+    {
+        using asio::asio_handler_invoke;
+        asio_handler_invoke(f, std::addressof(op->h_));
+    }
+};
+
+template<
+    class Protocol, class DynamicBuffer,
+    bool isRequest, class Allocator,
+    class Handler>
+void
+read_splice_op<Protocol, DynamicBuffer,
+    isRequest, Allocator, Handler>::
+operator()(
+    error_code ec,
+    std::size_t bytes_transferred,
+    bool cont)
+{
+    cont_ = cont;
+    ASIO_CORO_REENTER(*this)
+    {
+        if(! p_.is_header_done())
+        {
+            ASIO_CORO_YIELD
+            http::async_read_header(
+                sock_, b_, p_.base(), std::move(*this));
+            bytes_transferred_ += bytes_transferred;
+            if(ec)
+                goto upcall;
+        }
+        if(! splice_prepare(b_, p_, bytes_transferred_, ec))
+        {
+            if(ec)
+                goto upcall;
+            goto fallback;
+        }
+        // Asio keeps the descriptor non-blocking while
+        // it performs asynchronous operations, do the same.
+        sock_.native_non_blocking(true, ec);
+        if(ec)
+            goto upcall;
+        while(! p_.is_done())
+        {
+            if(pipe_.fallback())
+                goto fallback;
+            bytes_transferred_ += splice_some(
+                sock_, p_, pipe_, ec);
+            if(ec == asio::error::would_block)
+            {
+                ASIO_CORO_YIELD
+                sock_.async_wait(
+                    asio::socket_base::wait_read,
+                        std::move(*this));
+                if(ec)
+                    goto upcall;
+            }
+            else if(ec)
+            {
+                goto upcall;
+            }
+        }
+        goto upcall;
+
+    fallback:
+        ASIO_CORO_YIELD
+        http::async_read(sock_, b_, p_.base(), std::move(*this));
+        bytes_transferred_ += bytes_transferred;
+
+    upcall:
+        if(! cont_)
+        {
+            ASIO_CORO_YIELD
+            asio::post(sock_.get_executor(),
+                bind_handler(std::move(*this), ec));
+        }
+        h_(ec, bytes_transferred_);
+    }
+}
+
+} // detail
+
+//------------------------------------------------------------------------------
+
+/*  These overloads read the body of a message with a known
+    Content-Length directly from the socket into the file,
+    using splice(2) through a pipe. Octets the parser has
+    already buffered are written first. Limits and errors
+    are reported exactly as by the generic algorithms.
+*/
+
+template<
+    class Protocol, class DynamicBuffer,
+    bool isRequest, class Allocator>
+std::size_t
+read(
+    asio::basic_stream_socket<Protocol>& sock,
+    DynamicBuffer& buffer,
+    parser<isRequest,
+        basic_file_body<file_posix>, Allocator>& p,
+    error_code& ec)
+{
+    static_assert(
+        asio::is_dynamic_buffer<DynamicBuffer>::value,
+        "DynamicBuffer requirements not met");
+    p.eager(true);
+    std::size_t bytes_transferred = 0;
+    if(! p.is_header_done())
+    {
+        bytes_transferred =
+            http::read_header(sock, buffer, p.base(), ec);
+        if(ec)
+            return bytes_transferred;
+    }
+    if(! detail::splice_prepare(
+        buffer, p, bytes_transferred, ec))
+    {
+        if(ec)
+            return bytes_transferred;
+        return bytes_transferred +
+            http::read(sock, buffer, p.base(), ec);
+    }
+    detail::splice_pipe pipe;
+    while(! p.is_done())
+    {
+        if(pipe.fallback())
+            return bytes_transferred +
+                http::read(sock, buffer, p.base(), ec);
+        bytes_transferred +=
+            detail::splice_some(sock, p, pipe, ec);
+        if(ec == asio::error::would_block &&
+            ! sock.non_blocking())
+        {
+            sock.wait(asio::socket_base::wait_read, ec);
+            if(ec)
+                return bytes_transferred;
+        }
+        else if(ec)
+        {
+            return bytes_transferred;
+        }
+    }
+    return bytes_transferred;
+}
+
+template<
+    class Protocol, class DynamicBuffer,
+    bool isRequest, class Allocator>
+std::size_t
+read(
+    asio::basic_stream_socket<Protocol>& sock,
+    DynamicBuffer& buffer,
+    parser<isRequest,
+        basic_file_body<file_posix>, Allocator>& p)
+{
+    error_code ec;
+    auto const bytes_transferred =
+        http::read(sock, buffer, p, ec);
+    if(ec)
+        BOOST_THROW_EXCEPTION(system_error{ec});
+    return bytes_transferred;
+}
+
+template<
+    class Protocol, class DynamicBuffer,
+    bool isRequest, class Allocator,
+    class ReadHandler>
+ASIO_INITFN_RESULT_TYPE(
+    ReadHandler, void(error_code, std::size_t))
+async_read(
+    asio::basic_stream_socket<Protocol>& sock,
+    DynamicBuffer& buffer,
+    parser<isRequest,
+        basic_file_body<file_posix>, Allocator>& p,
+    ReadHandler&& handler)
+{
+    static_assert(
+        asio::is_dynamic_buffer<DynamicBuffer>::value,
+        "DynamicBuffer requirements not met");
+    p.eager(true);
+    BEAST_HANDLER_INIT(
+        ReadHandler, void(error_code, std::size_t));
+    detail::read_splice_op<
+        Protocol, DynamicBuffer, isRequest, Allocator,
+        ASIO_HANDLER_TYPE(ReadHandler,
+            void(error_code, std::size_t))>{
+                std::move(init.completion_handler), sock, buffer, p}(
+                    {}, 0, false);
+    return init.result.get();
+}
+
+/*  The algorithms which read a message pass the base class of
+    their parser, so that these are preferred over the ones in
+    namespace asio found through argument dependent lookup.
+*/
+
+template<
+    class Protocol, class DynamicBuffer,
+    bool isRequest, class Allocator>
+std::size_t
+read(
+    asio::basic_stream_socket<Protocol>& sock,
+    DynamicBuffer& buffer,
+    basic_parser<isRequest, parser<isRequest,
+        basic_file_body<file_posix>, Allocator>>& p,
+    error_code& ec)
+{
+    return http::read(sock, buffer, static_cast<parser<isRequest,
+        basic_file_body<file_posix>, Allocator>&>(p), ec);
+}
+
+template<
+    class Protocol, class DynamicBuffer,
+    bool isRequest, class Allocator,
+    class ReadHandler>
+ASIO_INITFN_RESULT_TYPE(
+    ReadHandler, void(error_code, std::size_t))
+async_read(
+    asio::basic_stream_socket<Protocol>& sock,
+    DynamicBuffer& buffer,
+    basic_parser<isRequest, parser<isRequest,
+        basic_file_body<file_posix>, Allocator>>& p,
+    ReadHandler&& handler)
+{
+    return http::async_read(sock, buffer, static_cast<parser<isRequest,
+        basic_file_body<file_posix>, Allocator>&>(p),
+            std::forward<ReadHandler>(handler));
+}
+
+} // http
+} // beast
+
+#endif
+
+#endif
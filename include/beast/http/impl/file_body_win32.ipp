@@ -16,6 +16,7 @@
 #include <beast/core/type_traits.hpp>
 #include <beast/core/detail/clamp.hpp>
 #include <beast/http/serializer.hpp>
+#include <beast/http/detail/file_read_buffer.hpp>
 #include <asio/associated_allocator.hpp>
 #include <asio/associated_executor.hpp>
 #include <asio/async_result.hpp>
@@ -71,6 +72,7 @@ struct basic_file_body<file_win32>
         std::uint64_t size_ = 0;    // cached file size
         std::uint64_t first_;       // starting offset of the range
         std::uint64_t last_;        // ending offset of the range
+        std::size_t read_size_ = 1024 * 1024; // largest read
 
     public:
         ~value_type() = default;
@@ -90,6 +92,19 @@ struct basic_file_body<file_win32>
             return size_;
         }
 
+        std::size_t
+        read_size() const
+        {
+            return read_size_;
+        }
+
+        void
+        read_size(std::size_t n)
+        {
+            BOOST_ASSERT(n > 0);
+            read_size_ = n;
+        }
+
         void
         close();
 
@@ -118,7 +133,7 @@ struct basic_file_body<file_win32>
 
         value_type& body_;  // The body we are reading from
         std::uint64_t pos_; // The current position in the file
-        char buf_[4096];    // Small buffer for reading
+        detail::file_read_buffer buf_; // Pooled buffer for reading
 
     public:
         using const_buffers_type =
@@ -127,6 +142,7 @@ struct basic_file_body<file_win32>
         template<bool isRequest, class Fields>
         writer(header<isRequest, Fields>&, value_type& b)
             : body_(b)
+            , buf_(b.read_size_)
         {
         }
 
@@ -140,21 +156,21 @@ struct basic_file_body<file_win32>
         boost::optional<std::pair<const_buffers_type, bool>>
         get(error_code& ec)
         {
-            std::size_t const n = (std::min)(sizeof(buf_),
-                beast::detail::clamp(body_.last_ - pos_));
-            if(n == 0)
+            if(pos_ >= body_.last_)
             {
                 ec.assign(0, ec.category());
                 return boost::none;
             }
-            auto const nread = body_.file_.read(buf_, n, ec);
+            auto const b = buf_.prepare(body_.last_ - pos_);
+            auto const nread = body_.file_.read(b.data(), b.size(), ec);
             if(ec)
                 return boost::none;
             BOOST_ASSERT(nread != 0);
             pos_ += nread;
+            buf_.commit();
             ec.assign(0, ec.category());
             return {{
-                {buf_, nread},          // buffer to return.
+                {b.data(), nread},      // buffer to return.
                 pos_ < body_.last_}};   // `true` if there are more buffers.
         }
     };
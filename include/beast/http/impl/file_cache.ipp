@@ -0,0 +1,381 @@
+//
+// Copyright (c) 2016-2017 Vinnie Falco (vinnie dot falco at gmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/boostorg/beast
+//
+
+#ifndef BEAST_HTTP_IMPL_FILE_CACHE_IPP
+#define BEAST_HTTP_IMPL_FILE_CACHE_IPP
+
+#include <beast/http/compressed_body.hpp>
+#include <beast/http/string_body.hpp>
+#include <algorithm>
+#include <cstring>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <limits.h>
+
+namespace beast {
+namespace http {
+
+namespace detail {
+
+inline
+std::uint64_t
+file_cache_mtime(struct stat const& st)
+{
+#ifdef __APPLE__
+    auto const& ts = st.st_mtimespec;
+#else
+    auto const& ts = st.st_mtim;
+#endif
+    return static_cast<std::uint64_t>(ts.tv_sec) * 1000000000 +
+        static_cast<std::uint64_t>(ts.tv_nsec);
+}
+
+inline
+void
+file_cache_append_hex(std::string& s, std::uint64_t v)
+{
+    char buf[16];
+    auto p = buf + sizeof(buf);
+    do
+    {
+        *--p = "0123456789abcdef"[v & 0xf];
+        v >>= 4;
+    }
+    while(v);
+    s.append(p, buf + sizeof(buf));
+}
+
+} // detail
+
+inline
+std::size_t
+file_cache::
+representation::
+read(std::uint64_t offset, void* buffer,
+    std::size_t n, error_code& ec) const
+{
+    if(offset >= size_)
+    {
+        ec.assign(0, ec.category());
+        return 0;
+    }
+    n = static_cast<std::size_t>((std::min<std::uint64_t>)(
+        n, size_ - offset));
+    if(resident_)
+    {
+        std::memcpy(buffer, data_.data() + offset, n);
+        ec.assign(0, ec.category());
+        return n;
+    }
+    std::size_t nread = 0;
+    while(n > 0)
+    {
+        auto const amount = static_cast<ssize_t>((std::min)(
+            n, static_cast<std::size_t>(SSIZE_MAX)));
+        auto const result = ::pread(file_.native_handle(),
+            buffer, amount, static_cast<off_t>(offset));
+        if(result == -1)
+        {
+            auto const ev = errno;
+            if(ev == EINTR)
+                continue;
+            ec.assign(ev, generic_category());
+            return nread;
+        }
+        if(result == 0)
+        {
+            // the file was truncated
+            break;
+        }
+        n -= result;
+        nread += result;
+        offset += result;
+        buffer = reinterpret_cast<char*>(buffer) + result;
+    }
+    ec.assign(0, ec.category());
+    return nread;
+}
+
+//------------------------------------------------------------------------------
+
+inline
+bool
+file_cache::
+same(file_info const& lhs, file_info const& rhs)
+{
+    return
+        lhs.dev == rhs.dev &&
+        lhs.ino == rhs.ino &&
+        lhs.size == rhs.size &&
+        lhs.mtime == rhs.mtime;
+}
+
+inline
+bool
+file_cache::
+stat_file(char const* path, file_info& info)
+{
+    struct stat st;
+    if(::stat(path, &st) != 0)
+        return false;
+    info.dev = static_cast<std::uint64_t>(st.st_dev);
+    info.ino = static_cast<std::uint64_t>(st.st_ino);
+    info.size = static_cast<std::uint64_t>(st.st_size);
+    info.mtime = detail::file_cache_mtime(st);
+    info.last_modified = st.st_mtime;
+    return true;
+}
+
+inline
+bool
+file_cache::
+fresh(std::string const& path, entry const& e)
+{
+    file_info info;
+    if(! stat_file(path.c_str(), info) || ! same(info, e.file_))
+        return false;
+    // A sibling which appeared, changed, or
+    // disappeared also makes the entry stale.
+    file_info gz;
+    if(! stat_file((path + ".gz").c_str(), gz))
+        return ! e.has_sibling_;
+    return e.has_sibling_ && same(gz, e.sibling_);
+}
+
+inline
+void
+file_cache::
+load(representation& rep, char const* path,
+    char const* suffix, file_info& info, error_code& ec)
+{
+    rep.file_.open(path, file_mode::scan, ec);
+    if(ec)
+        return;
+    // Use the open descriptor, in case
+    // the path was replaced meanwhile.
+    struct stat st;
+    if(::fstat(rep.file_.native_handle(), &st) != 0)
+    {
+        ec.assign(errno, generic_category());
+        return;
+    }
+    if(! S_ISREG(st.st_mode))
+    {
+        ec = make_error_code(S_ISDIR(st.st_mode) ?
+            errc::is_a_directory : errc::invalid_argument);
+        return;
+    }
+    info.dev = static_cast<std::uint64_t>(st.st_dev);
+    info.ino = static_cast<std::uint64_t>(st.st_ino);
+    info.size = static_cast<std::uint64_t>(st.st_size);
+    info.mtime = detail::file_cache_mtime(st);
+    info.last_modified = st.st_mtime;
+
+    rep.size_ = info.size;
+    rep.etag_ = "\"";
+    detail::file_cache_append_hex(rep.etag_, info.size);
+    rep.etag_ += '-';
+    detail::file_cache_append_hex(rep.etag_, info.mtime);
+    rep.etag_ += '-';
+    detail::file_cache_append_hex(rep.etag_, info.ino);
+    rep.etag_ += suffix;
+    rep.etag_ += '"';
+
+    if(info.size <= resident_limit_)
+    {
+        rep.data_.resize(static_cast<std::size_t>(info.size));
+        auto const n = rep.read(0, &rep.data_[0], rep.data_.size(), ec);
+        if(ec)
+            return;
+        if(n != rep.data_.size())
+        {
+            // truncated while loading, try again later
+            ec = make_error_code(errc::resource_unavailable_try_again);
+            return;
+        }
+        rep.file_.close(ec);
+        if(ec)
+            return;
+        rep.resident_ = true;
+    }
+}
+
+inline
+void
+file_cache::
+compress(entry& e, error_code& ec)
+{
+    auto const& id = e.identity_;
+    response<compressed_body<string_body>> res;
+    if(id.resident_)
+    {
+        res.body().body = id.data_;
+    }
+    else
+    {
+        res.body().body.resize(static_cast<std::size_t>(id.size_));
+        auto const n = id.read(0,
+            &res.body().body[0], res.body().body.size(), ec);
+        if(ec)
+            return;
+        res.body().body.resize(n);
+    }
+    // Compression happens once, so use the best level
+    res.body().coding = content_coding::gzip;
+    res.body().level = 9;
+    compressed_body<string_body>::writer w{res, res.body()};
+    w.init(ec);
+    if(ec)
+        return;
+    auto& out = e.gzip_.data_;
+    for(;;)
+    {
+        auto const result = w.get(ec);
+        if(ec)
+            return;
+        if(! result)
+            break;
+        auto const b = result->first;
+        out.append(static_cast<char const*>(b.data()), b.size());
+        if(! result->second)
+            break;
+    }
+    if(out.size() >= id.size_)
+    {
+        out = {};
+        return;
+    }
+    e.gzip_.size_ = out.size();
+    e.gzip_.etag_.assign(id.etag_.data(), id.etag_.size() - 1);
+    e.gzip_.etag_ += "-gz\"";
+    e.gzip_.resident_ = true;
+    e.has_gzip_ = true;
+}
+
+inline
+auto
+file_cache::
+load(std::string const& path, error_code& ec) ->
+    entry_ptr
+{
+    auto e = std::make_shared<entry>();
+    file_info info;
+    load(e->identity_, path.c_str(), "", info, ec);
+    if(ec)
+        return nullptr;
+    e->file_ = info;
+    e->last_modified_ = info.last_modified;
+
+    // Prefer a precompressed sibling which
+    // is up to date and smaller than the file
+    {
+        error_code ec2;
+        file_info gz;
+        auto const gz_path = path + ".gz";
+        load(e->gzip_, gz_path.c_str(), "-gz", gz, ec2);
+        // Remembered even when not used, so that replacing
+        // it is noticed on revalidation. If it could not be
+        // loaded, remember what revalidation will see.
+        if(! ec2 || stat_file(gz_path.c_str(), gz))
+        {
+            e->sibling_ = gz;
+            e->has_sibling_ = true;
+        }
+        if( ! ec2 && gz.mtime >= info.mtime &&
+            gz.size < info.size)
+            e->has_gzip_ = true;
+        else
+            e->gzip_ = {};
+    }
+    if( ! e->has_gzip_ && info.size > 0 &&
+        info.size <= compress_limit_)
+    {
+        compress(*e, ec);
+        if(ec)
+            return nullptr;
+    }
+    return e;
+}
+
+inline
+auto
+file_cache::
+get(string_view path, error_code& ec) ->
+    entry_ptr
+{
+    auto const key = path.to_string();
+    auto const now = clock_type::now();
+    entry_ptr e;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto const it = map_.find(key);
+        if(it != map_.end())
+        {
+            if(now - it->second.checked < interval_)
+            {
+                ec.assign(0, ec.category());
+                return it->second.e;
+            }
+            e = it->second.e;
+        }
+    }
+    if(e && fresh(key, *e))
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto const it = map_.find(key);
+        if(it != map_.end() && it->second.e == e)
+            it->second.checked = now;
+        ec.assign(0, ec.category());
+        return e;
+    }
+    // Load outside the lock, since it may
+    // read and compress the whole file.
+    e = load(key, ec);
+    std::lock_guard<std::mutex> lock(mutex_);
+    if(ec)
+    {
+        map_.erase(key);
+        return nullptr;
+    }
+    map_[key] = slot{e, now};
+    return e;
+}
+
+inline
+void
+file_cache::
+erase(string_view path)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    map_.erase(path.to_string());
+}
+
+inline
+void
+file_cache::
+clear()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    map_.clear();
+}
+
+inline
+std::size_t
+file_cache::
+size() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return map_.size();
+}
+
+} // http
+} // beast
+
+#endif
@@ -0,0 +1,179 @@
+//
+// Copyright (c) 2016-2017 Vinnie Falco (vinnie dot falco at gmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/boostorg/beast
+//
+
+#ifndef BEAST_HTTP_IMPL_MMAP_BODY_IPP
+#define BEAST_HTTP_IMPL_MMAP_BODY_IPP
+
+#include <limits>
+#include <sys/types.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace beast {
+namespace http {
+
+namespace detail {
+
+inline
+std::uint64_t
+mmap_body_mtime(struct stat const& st)
+{
+#ifdef __APPLE__
+    auto const& ts = st.st_mtimespec;
+#else
+    auto const& ts = st.st_mtim;
+#endif
+    return static_cast<std::uint64_t>(ts.tv_sec) * 1000000000 +
+        static_cast<std::uint64_t>(ts.tv_nsec);
+}
+
+} // detail
+
+inline
+mmap_body::
+mapping::
+~mapping()
+{
+    if(addr_)
+        ::munmap(addr_, size_);
+}
+
+inline
+auto
+mmap_body::
+mapping::
+create(char const* path,
+    mmap_options const& opts, error_code& ec) ->
+        std::shared_ptr<mapping const>
+{
+    auto m = std::make_shared<mapping>();
+    m->file_.open(path, file_mode::read, ec);
+    if(ec)
+        return nullptr;
+    struct stat st;
+    if(::fstat(m->file_.native_handle(), &st) != 0)
+    {
+        ec.assign(errno, generic_category());
+        return nullptr;
+    }
+    if(! S_ISREG(st.st_mode))
+    {
+        ec = make_error_code(S_ISDIR(st.st_mode) ?
+            errc::is_a_directory : errc::invalid_argument);
+        return nullptr;
+    }
+    if(static_cast<std::uint64_t>(st.st_size) >
+        (std::numeric_limits<std::size_t>::max)())
+    {
+        ec = make_error_code(errc::file_too_large);
+        return nullptr;
+    }
+    m->dev_ = static_cast<std::uint64_t>(st.st_dev);
+    m->ino_ = static_cast<std::uint64_t>(st.st_ino);
+    m->mtime_ = detail::mmap_body_mtime(st);
+    m->size_ = static_cast<std::size_t>(st.st_size);
+    if(m->size_ == 0)
+    {
+        // Empty files cannot be mapped
+        ec.assign(0, ec.category());
+        return m;
+    }
+    int flags = MAP_SHARED;
+#ifdef MAP_POPULATE
+    if(opts.populate)
+        flags |= MAP_POPULATE;
+#endif
+    auto const addr = ::mmap(nullptr, m->size_, PROT_READ,
+        flags, m->file_.native_handle(), 0);
+    if(addr == MAP_FAILED)
+    {
+        ec.assign(errno, generic_category());
+        return nullptr;
+    }
+    m->addr_ = addr;
+#ifndef MAP_POPULATE
+    if(opts.populate)
+        ::madvise(addr, m->size_, MADV_WILLNEED);
+#endif
+    // Advice is only a hint, so errors are ignored
+    if(opts.sequential)
+        ::madvise(addr, m->size_, MADV_SEQUENTIAL);
+    ec.assign(0, ec.category());
+    return m;
+}
+
+//------------------------------------------------------------------------------
+
+inline
+mmap_body::mapping_ptr
+mmap_cache::
+get(string_view path, error_code& ec)
+{
+    auto const key = path.to_string();
+    struct stat st;
+    if(::stat(key.c_str(), &st) != 0)
+    {
+        ec.assign(errno, generic_category());
+        std::lock_guard<std::mutex> lock(mutex_);
+        map_.erase(key);
+        return nullptr;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto const it = map_.find(key);
+        if(it != map_.end())
+        {
+            auto m = it->second.lock();
+            if( m &&
+                m->dev_ == static_cast<std::uint64_t>(st.st_dev) &&
+                m->ino_ == static_cast<std::uint64_t>(st.st_ino) &&
+                m->size_ == static_cast<std::uint64_t>(st.st_size) &&
+                m->mtime_ == detail::mmap_body_mtime(st))
+            {
+                ec.assign(0, ec.category());
+                return m;
+            }
+        }
+    }
+    auto m = mmap_body::mapping::create(key.c_str(), opts_, ec);
+    std::lock_guard<std::mutex> lock(mutex_);
+    if(ec)
+    {
+        map_.erase(key);
+        return nullptr;
+    }
+    map_[key] = m;
+    // Drop entries whose mappings were released
+    for(auto it = map_.begin(); it != map_.end();)
+    {
+        if(it->second.expired())
+            it = map_.erase(it);
+        else
+            ++it;
+    }
+    return m;
+}
+
+inline
+std::size_t
+mmap_cache::
+size()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::size_t n = 0;
+    for(auto const& e : map_)
+        if(! e.second.expired())
+            ++n;
+    return n;
+}
+
+} // http
+} // beast
+
+#endif
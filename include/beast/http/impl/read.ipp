@@ -29,12 +29,87 @@
 #include <boost/config.hpp>
 #include <boost/optional.hpp>
 #include <boost/throw_exception.hpp>
+#include <algorithm>
 
 namespace beast {
 namespace http {
 
 namespace detail {
 
+// Returns the number of body octets to read directly into
+// the body's storage, or zero to read through the buffer.
+template<bool isRequest, class Derived, class DynamicBuffer>
+std::size_t
+body_read_size(
+    basic_parser<isRequest, Derived> const& p,
+    DynamicBuffer const& b)
+{
+    if(! has_direct_body<Derived>::value ||
+        b.size() > 0 || ! p.is_header_done() ||
+        p.is_done() || ! p.content_length())
+        return 0;
+    return static_cast<std::size_t>(
+        (std::min<std::uint64_t>)(*p.content_length(), 65536));
+}
+
+template<bool isRequest, class Derived>
+asio::mutable_buffer
+prepare_body(
+    basic_parser<isRequest, Derived>& p,
+    std::size_t n, error_code& ec,
+    std::true_type)
+{
+    return static_cast<Derived&>(p).prepare_body(n, ec);
+}
+
+template<bool isRequest, class Derived>
+asio::mutable_buffer
+prepare_body(
+    basic_parser<isRequest, Derived>&,
+    std::size_t, error_code& ec,
+    std::false_type)
+{
+    BOOST_ASSERT(false);
+    ec.assign(0, ec.category());
+    return {};
+}
+
+// Store octets read into the buffer returned by prepare_body,
+// where `ec` holds the result of the read.
+template<bool isRequest, class Derived>
+std::size_t
+commit_body(
+    basic_parser<isRequest, Derived>& p,
+    std::size_t n, error_code& ec,
+    std::true_type)
+{
+    if(ec)
+    {
+        error_code ignored;
+        static_cast<Derived&>(p).commit_body(0, ignored);
+        if(ec == asio::error::eof)
+        {
+            BOOST_ASSERT(n == 0);
+            p.put_eof(ec);
+            BOOST_ASSERT(ec);
+        }
+        return 0;
+    }
+    static_cast<Derived&>(p).commit_body(n, ec);
+    return n;
+}
+
+template<bool isRequest, class Derived>
+std::size_t
+commit_body(
+    basic_parser<isRequest, Derived>&,
+    std::size_t, error_code&,
+    std::false_type)
+{
+    BOOST_ASSERT(false);
+    return 0;
+}
+
 //------------------------------------------------------------------------------
 
 template<class Stream, class DynamicBuffer,
@@ -47,10 +122,13 @@ class read_some_op
         std::declval<Stream&>().get_executor())> wg_;
     DynamicBuffer& b_;
     basic_parser<isRequest, Derived>& p_;
+    asio::mutable_buffer body_;
     std::size_t bytes_transferred_ = 0;
     Handler h_;
     bool cont_ = false;
 
+    using is_direct = has_direct_body<Derived>;
+
 public:
     read_some_op(read_some_op&&) = default;
     read_some_op(read_some_op const&) = delete;
@@ -138,6 +216,19 @@ operator()(
                 break;
 
         do_read:
+            if(body_read_size(p_, b_) > 0)
+            {
+                // read the body without copying it
+                body_ = prepare_body(p_,
+                    body_read_size(p_, b_), ec, is_direct{});
+                if(ec)
+                    break;
+                ASIO_CORO_YIELD
+                s_.async_read_some(body_, std::move(*this));
+                bytes_transferred_ += commit_body(
+                    p_, bytes_transferred, ec, is_direct{});
+                break;
+            }
             try
             {
                 mb.emplace(b_.prepare(
@@ -341,7 +432,6 @@ class read_msg_op
         DynamicBuffer& b;
         message_type& m;
         parser_type p;
-        std::size_t bytes_transferred = 0;
         bool cont = false;
 
         data(Handler const&, Stream& s_,
@@ -427,23 +517,10 @@ operator()(
     d.cont = cont;
     ASIO_CORO_REENTER(*this)
     {
-        for(;;)
-        {
-            ASIO_CORO_YIELD
-            async_read_some(
-                d.s, d.b, d.p, std::move(*this));
-            if(ec)
-                goto upcall;
-            d.bytes_transferred +=
-                bytes_transferred;
-            if(d.p.is_done())
-            {
-                d.m = d.p.release();
-                goto upcall;
-            }
-        }
-    upcall:
-        bytes_transferred = d.bytes_transferred;
+        ASIO_CORO_YIELD
+        async_read(d.s, d.b, d.p.base(), std::move(*this));
+        if(! ec)
+            d.m = d.p.release();
         {
             auto wg = std::move(d.wg);
             d_.invoke(ec, bytes_transferred);
@@ -512,6 +589,20 @@ read_some(
                 break;
         }
     do_read:
+        if(auto const size =
+            detail::body_read_size(parser, buffer))
+        {
+            // read the body without copying it
+            using is_direct = detail::has_direct_body<Derived>;
+            auto const mb = detail::prepare_body(
+                parser, size, ec, is_direct{});
+            if(ec)
+                break;
+            auto const n = stream.read_some(mb, ec);
+            bytes_transferred += detail::commit_body(
+                parser, n, ec, is_direct{});
+            break;
+        }
         boost::optional<typename
             DynamicBuffer::mutable_buffers_type> b;
         try
@@ -91,11 +91,19 @@ next(error_code& ec, Visit&& visit)
             goto go_header_only;
         auto result = wr_.get(ec);
         if(ec == error::need_more)
+        {
+            // The body is not ready, send the header first
+            ec.assign(0, ec.category());
+            more_ = true;
             goto go_header_only;
+        }
         if(ec)
             return;
         if(! result)
+        {
+            more_ = false;
             goto go_header_only;
+        }
         more_ = result->second;
         v_.template emplace<2>(
             boost::in_place_init,
@@ -152,11 +160,19 @@ next(error_code& ec, Visit&& visit)
             goto go_header_only_c;
         auto result = wr_.get(ec);
         if(ec == error::need_more)
+        {
+            // The body is not ready, send the header first
+            ec.assign(0, ec.category());
+            more_ = true;
             goto go_header_only_c;
+        }
         if(ec)
             return;
         if(! result)
+        {
+            more_ = false;
             goto go_header_only_c;
+        }
         more_ = result->second;
         if(! more_)
         {
@@ -312,7 +328,7 @@ consume(std::size_t n)
             break;
         fwr_ = boost::none;
         header_done_ = true;
-        if(! split_)
+        if(! split_ && ! more_)
             goto go_complete;
         s_ = do_body;
         break;
@@ -356,7 +372,7 @@ consume(std::size_t n)
             break;
         fwr_ = boost::none;
         header_done_ = true;
-        if(! split_)
+        if(! split_ && ! more_)
         {
             s_ = do_final_c;
             break;
@@ -15,6 +15,7 @@
 #include <beast/core/ostream.hpp>
 #include <beast/core/handler_ptr.hpp>
 #include <beast/core/type_traits.hpp>
+#include <beast/core/detail/buffer_array.hpp>
 #include <beast/core/detail/config.hpp>
 #include <asio/associated_allocator.hpp>
 #include <asio/associated_executor.hpp>
@@ -33,6 +34,12 @@ namespace beast {
 namespace http {
 namespace detail {
 
+// The serializer's buffers are nested views, so they are
+// flattened once before each call to write_some instead of
+// being iterated again by the stream. Asio passes at most
+// 64 buffers to a socket in one call.
+using write_buffers_type = beast::detail::buffer_array<64>;
+
 template<
     class Stream, class Handler,
     bool isRequest, class Body, class Fields>
@@ -44,6 +51,9 @@ class write_some_op
     serializer<isRequest,Body, Fields>& sr_;
     Handler h_;
 
+    using is_waitable = is_body_writer_async_waitable<
+        typename Body::writer>;
+
     class lambda
     {
         write_some_op& op_;
@@ -65,7 +75,7 @@ class write_some_op
             invoked = true;
             ec.assign(0, ec.category());
             return op_.s_.async_write_some(
-                buffers, std::move(op_));
+                write_buffers_type{buffers}, std::move(op_));
         }
     };
 
@@ -105,11 +115,28 @@ public:
     void
     operator()();
 
+    void
+    operator()(error_code ec);
+
     void
     operator()(
         error_code ec,
         std::size_t bytes_transferred);
 
+    void
+    wait(error_code, std::true_type)
+    {
+        sr_.writer_impl().async_wait(std::move(*this));
+    }
+
+    void
+    wait(error_code ec, std::false_type)
+    {
+        asio::post(
+            s_.get_executor(),
+            bind_handler(std::move(*this), ec, 0));
+    }
+
     friend
     bool asio_handler_is_continuation(write_some_op* op)
     {
@@ -140,6 +167,12 @@ operator()()
     {
         lambda f{*this};
         sr_.next(ec, f);
+        if(ec == error::need_more)
+        {
+            // The body is still producing its buffers
+            BOOST_ASSERT(! f.invoked);
+            return wait(ec, is_waitable{});
+        }
         if(ec)
         {
             BOOST_ASSERT(! f.invoked);
@@ -161,6 +194,20 @@ operator()()
         bind_handler(std::move(*this), ec, 0));
 }
 
+template<
+    class Stream, class Handler,
+    bool isRequest, class Body, class Fields>
+void
+write_some_op<
+    Stream, Handler, isRequest, Body, Fields>::
+operator()(error_code ec)
+{
+    // The body writer finished waiting
+    if(ec)
+        return h_(ec, 0);
+    (*this)();
+}
+
 template<
     class Stream, class Handler,
     bool isRequest, class Body, class Fields>
@@ -443,8 +490,8 @@ public:
         ConstBufferSequence const& buffers)
     {
         invoked = true;
-        bytes_transferred =
-            stream_.write_some(buffers, ec);
+        bytes_transferred = stream_.write_some(
+            write_buffers_type{buffers}, ec);
     }
 };
 
@@ -474,6 +521,21 @@ public:
     }
 };
 
+template<class Writer>
+bool
+writer_wait(Writer& w, error_code& ec, std::true_type)
+{
+    w.wait(ec);
+    return true;
+}
+
+template<class Writer>
+bool
+writer_wait(Writer&, error_code&, std::false_type)
+{
+    return false;
+}
+
 template<
     class SyncWriteStream,
     bool isRequest, class Body, class Fields>
@@ -486,7 +548,21 @@ write_some_impl(
     if(! sr.is_done())
     {
         write_some_lambda<SyncWriteStream> f{stream};
-        sr.next(ec, f);
+        for(;;)
+        {
+            sr.next(ec, f);
+            // Block until the body produces its buffers
+            if(ec == error::need_more && writer_wait(
+                sr.writer_impl(), ec,
+                is_body_writer_waitable<
+                    typename Body::writer>{}))
+            {
+                if(ec)
+                    return 0;
+                continue;
+            }
+            break;
+        }
         if(ec)
             return f.bytes_transferred;
         if(f.invoked)
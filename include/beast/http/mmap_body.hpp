@@ -0,0 +1,387 @@
+//
+// Copyright (c) 2016-2017 Vinnie Falco (vinnie dot falco at gmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/boostorg/beast
+//
+
+#ifndef BEAST_HTTP_MMAP_BODY_HPP
+#define BEAST_HTTP_MMAP_BODY_HPP
+
+#include <beast/core/file_posix.hpp>
+
+#if BEAST_USE_POSIX_FILE
+
+#include <beast/core/detail/config.hpp>
+#include <beast/core/error.hpp>
+#include <beast/core/string.hpp>
+#include <beast/http/message.hpp>
+#include <asio/buffer.hpp>
+#include <boost/optional.hpp>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+namespace beast {
+namespace http {
+
+/// Options for mapping files with @ref mmap_body
+struct mmap_options
+{
+    /** Read the whole file into the page cache when it is mapped.
+
+        This uses `MAP_POPULATE` where available, so that
+        serializing the body does not wait on page faults.
+        The default is `false`.
+    */
+    bool populate = false;
+
+    /** Advise the system that the mapping is read in order.
+
+        This uses `madvise` with `MADV_SEQUENTIAL`, which
+        increases read-ahead and frees pages sooner once they
+        are sent. The default is `true`.
+    */
+    bool sequential = true;
+};
+
+/** A @b Body which sends a file from a read-only memory mapping.
+
+    The writer hands the mapped pages to the serializer directly,
+    so the octets are never copied into an intermediate buffer.
+    This keeps writes zero-copy even through streams such as
+    `ssl_stream`, where sending the file from its descriptor is
+    not possible.
+
+    Mappings are immutable and reference counted, and may be
+    shared by any number of messages at once, which can each
+    send a different range of the file. Use @ref mmap_cache to
+    share one mapping among concurrent requests for a file.
+
+    Touching the pages of a mapping past the end of a file which
+    was truncated raises `SIGBUS`. To avoid this, the mapping
+    keeps the file open and the writer checks its size before
+    presenting each piece of at most @ref mmap_body::chunk_size
+    octets, failing with `errc::io_error` when the file became
+    too short. A file which shrinks while a piece is being sent
+    can still raise the signal, so files being served should be
+    replaced by renaming rather than modified in place.
+
+    Messages using this body type may be serialized but not
+    parsed.
+
+    @note This body is only available on POSIX systems.
+*/
+struct mmap_body
+{
+    /// The largest number of octets presented by the writer at once
+    static std::size_t constexpr chunk_size = 1024 * 1024;
+
+    /// A read-only memory mapping of a whole file
+    class mapping
+    {
+        file_posix file_;
+        void* addr_ = nullptr;
+        std::size_t size_ = 0;
+
+        // The file the mapping was created from
+        std::uint64_t dev_ = 0;
+        std::uint64_t ino_ = 0;
+        std::uint64_t mtime_ = 0;
+
+        friend class mmap_cache;
+
+    public:
+        /// Destructor
+        ~mapping();
+
+        /// Constructor
+        mapping() = default;
+
+        mapping(mapping const&) = delete;
+        mapping& operator=(mapping const&) = delete;
+
+        /** Map a file.
+
+            @param path The utf-8 encoded path to a regular file.
+
+            @param opts The options to use.
+
+            @param ec Set to the error, if any occurred.
+
+            @return The mapping, or `nullptr` on error.
+        */
+        static
+        std::shared_ptr<mapping const>
+        create(char const* path,
+            mmap_options const& opts, error_code& ec);
+
+        /// Returns the mapped octets
+        string_view
+        data() const
+        {
+            return {static_cast<char const*>(addr_), size_};
+        }
+
+        /// Returns the number of mapped octets
+        std::size_t
+        size() const
+        {
+            return size_;
+        }
+
+        /** Returns the current size of the file.
+
+            This may be less than @ref size if the file was
+            truncated after it was mapped.
+        */
+        std::uint64_t
+        file_size(error_code& ec) const
+        {
+            return file_.size(ec);
+        }
+    };
+
+    /// A shared reference to a mapping
+    using mapping_ptr = std::shared_ptr<mapping const>;
+
+    /// The type of the @ref message::body member.
+    class value_type
+    {
+        friend struct mmap_body;
+
+        mapping_ptr map_;
+        std::size_t offset_ = 0;
+        std::size_t size_ = 0;
+
+    public:
+        /// Constructor
+        value_type() = default;
+
+        /// Returns `true` if the body refers to a mapping
+        bool
+        is_open() const
+        {
+            return map_ != nullptr;
+        }
+
+        /// Returns the number of octets in the body
+        std::uint64_t
+        size() const
+        {
+            return size_;
+        }
+
+        /// Returns the mapping, or `nullptr` if none
+        mapping_ptr const&
+        get_mapping() const
+        {
+            return map_;
+        }
+
+        /// Returns the octets of the body
+        string_view
+        data() const
+        {
+            return map_ ? map_->data().substr(
+                offset_, size_) : string_view{};
+        }
+
+        /// Release the mapping, leaving an empty body
+        void
+        close()
+        {
+            map_.reset();
+            offset_ = 0;
+            size_ = 0;
+        }
+
+        /** Map a file and use all of it as the body.
+
+            @param path The utf-8 encoded path to a regular file.
+
+            @param ec Set to the error, if any occurred.
+
+            @param opts The options to use.
+        */
+        void
+        open(char const* path, error_code& ec,
+            mmap_options const& opts = {})
+        {
+            auto m = mapping::create(path, opts, ec);
+            if(ec)
+                return;
+            reset(std::move(m));
+        }
+
+        /// Use all of an existing mapping as the body
+        void
+        reset(mapping_ptr m)
+        {
+            size_ = m->size();
+            offset_ = 0;
+            map_ = std::move(m);
+        }
+
+        /** Use a range of an existing mapping as the body.
+
+            @param m The mapping.
+
+            @param offset The offset of the first octet.
+
+            @param length The number of octets.
+
+            @param ec Set to `errc::invalid_argument` if the
+            range extends past the end of the mapping.
+        */
+        void
+        reset(mapping_ptr m, std::uint64_t offset,
+            std::uint64_t length, error_code& ec)
+        {
+            if( offset > m->size() ||
+                length > m->size() - offset)
+            {
+                ec = make_error_code(errc::invalid_argument);
+                return;
+            }
+            offset_ = static_cast<std::size_t>(offset);
+            size_ = static_cast<std::size_t>(length);
+            map_ = std::move(m);
+            ec.assign(0, ec.category());
+        }
+    };
+
+    /** Returns the payload size of the body
+
+        When this body is used with @ref message::prepare_payload,
+        the Content-Length will be set to the payload size, and
+        any chunked Transfer-Encoding will be removed.
+    */
+    static
+    std::uint64_t
+    size(value_type const& body)
+    {
+        return body.size();
+    }
+
+    /** The algorithm for serializing the body
+
+        Meets the requirements of @b BodyWriter.
+    */
+#if BEAST_DOXYGEN
+    using writer = implementation_defined;
+#else
+    class writer
+    {
+        value_type const& body_;
+        std::size_t pos_ = 0;
+
+    public:
+        using const_buffers_type =
+            asio::const_buffer;
+
+        template<bool isRequest, class Fields>
+        explicit
+        writer(header<isRequest, Fields> const&, value_type const& b)
+            : body_(b)
+        {
+        }
+
+        void
+        init(error_code& ec)
+        {
+            ec.assign(0, ec.category());
+        }
+
+        boost::optional<std::pair<const_buffers_type, bool>>
+        get(error_code& ec)
+        {
+            if(pos_ >= body_.size_)
+            {
+                ec.assign(0, ec.category());
+                return boost::none;
+            }
+            auto const n = (std::min)(
+                std::size_t{chunk_size}, body_.size_ - pos_);
+            auto const offset = body_.offset_ + pos_;
+            auto const size = body_.map_->file_size(ec);
+            if(ec)
+                return boost::none;
+            if(size < offset + n)
+            {
+                // The file was truncated, and reading
+                // these pages would raise SIGBUS.
+                ec = make_error_code(errc::io_error);
+                return boost::none;
+            }
+            pos_ += n;
+            return {{const_buffers_type{
+                body_.map_->data().data() + offset, n},
+                pos_ < body_.size_}};
+        }
+    };
+#endif
+};
+
+/** A cache which shares mappings of the same file.
+
+    Each call to @ref get checks the file with `stat`, and returns
+    the existing mapping if one is still in use by a message and
+    the file has not changed since it was mapped. Otherwise the
+    file is mapped again. The cache does not keep mappings alive
+    by itself; a mapping is released when the last message using
+    it is destroyed.
+
+    @par Thread Safety
+    @e Distinct @e objects: Safe.@n
+    @e Shared @e objects: Safe.
+
+    @note This class is only available on POSIX systems.
+*/
+class mmap_cache
+{
+    std::mutex mutex_;
+    std::unordered_map<std::string,
+        std::weak_ptr<mmap_body::mapping const>> map_;
+    mmap_options opts_;
+
+public:
+    /** Constructor
+
+        @param opts The options to use when mapping files.
+    */
+    explicit
+    mmap_cache(mmap_options const& opts = {})
+        : opts_(opts)
+    {
+    }
+
+    /** Return a mapping of a file.
+
+        @param path The utf-8 encoded path to a regular file.
+
+        @param ec Set to the error, if any occurred.
+
+        @return The mapping, or `nullptr` on error.
+    */
+    mmap_body::mapping_ptr
+    get(string_view path, error_code& ec);
+
+    /// Returns the number of mappings in use
+    std::size_t
+    size();
+};
+
+} // http
+} // beast
+
+#include <beast/http/impl/mmap_body.ipp>
+
+#endif
+
+#endif
@@ -295,9 +295,72 @@ public:
         cb_b_ = std::ref(cb);
     }
 
+    /** Return storage in the body for octets read from a stream
+
+        The stream read algorithms call this function, after the
+        header is complete and when the body has a known length,
+        to read the body directly into its storage. It is only
+        available when the body's reader can store octets in
+        place, as do the readers of @ref basic_string_body,
+        @ref span_body and @ref vector_body.
+
+        The returned buffer remains valid until the next call to
+        @ref commit_body, which must happen before any other
+        member function is called.
+
+        @param n The size of the buffer. This may not be greater
+        than the remaining length returned by @ref content_length.
+
+        @param ec Set to the error, if any occurred.
+    */
+    asio::mutable_buffer
+    prepare_body(std::size_t n, error_code& ec)
+    {
+        if(! rd_inited_)
+        {
+            base_type::commit_body(0, ec);
+            if(ec)
+                return {};
+        }
+        return rd_.prepare(n, ec);
+    }
+
+    /** Inform the parser that body octets were stored directly.
+
+        If the octets were written to the buffer returned by
+        @ref prepare_body, the unused part of that buffer is
+        removed from the body when the message is complete,
+        or at once if `n` is zero.
+
+        @param n The number of body octets stored. This may not
+        be greater than the remaining length returned by
+        @ref content_length.
+
+        @param ec Set to the error, if any occurred.
+    */
+    void
+    commit_body(std::uint64_t n, error_code& ec)
+    {
+        commit_body_impl(n,
+            detail::is_body_reader_direct<typename Body::reader>{});
+        base_type::commit_body(n, ec);
+    }
+
 private:
     friend class basic_parser<isRequest, parser>;
 
+    void
+    commit_body_impl(std::uint64_t n, std::true_type)
+    {
+        if(rd_inited_)
+            rd_.commit(static_cast<std::size_t>(n));
+    }
+
+    void
+    commit_body_impl(std::uint64_t, std::false_type)
+    {
+    }
+
     parser(std::true_type);
     parser(std::false_type);
 
@@ -111,6 +111,25 @@ public:
             return n;
         }
 
+        asio::mutable_buffer
+        prepare(std::size_t n, error_code& ec)
+        {
+            if(n > body_.size())
+            {
+                ec = error::buffer_overflow;
+                return {};
+            }
+            ec.assign(0, ec.category());
+            return {body_.data(), n};
+        }
+
+        void
+        commit(std::size_t n)
+        {
+            body_ = value_type{
+                body_.data() + n, body_.size() - n};
+        }
+
         void
         finish(error_code& ec)
         {
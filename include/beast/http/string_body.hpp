@@ -76,6 +76,7 @@ public:
     class reader
     {
         value_type& body_;
+        std::size_t size_ = 0;  // octets stored
 
     public:
         template<bool isRequest, class Fields>
@@ -107,6 +108,7 @@ public:
                     return;
                 }
             }
+            size_ = body_.size();
             ec.assign(0, ec.category());
         }
 
@@ -118,7 +120,7 @@ public:
             using asio::buffer_size;
             using asio::buffer_copy;
             auto const extra = buffer_size(buffers);
-            auto const size = body_.size();
+            auto const size = size_;
             try
             {
                 body_.resize(size + extra);
@@ -129,6 +131,7 @@ public:
                 return 0;
             }
             ec.assign(0, ec.category());
+            size_ += extra;
             CharT* dest = &body_[size];
             for(auto b : beast::detail::buffers_range(buffers))
             {
@@ -139,9 +142,39 @@ public:
             return extra;
         }
 
+        asio::mutable_buffer
+        prepare(std::size_t n, error_code& ec)
+        {
+            // Octets past the stored body are kept between
+            // calls, so the container is cleared only once.
+            if(body_.size() < size_ + n)
+            {
+                try
+                {
+                    body_.resize(size_ + n);
+                }
+                catch(std::exception const&)
+                {
+                    ec = error::buffer_overflow;
+                    return {};
+                }
+            }
+            ec.assign(0, ec.category());
+            return {&body_[size_], n};
+        }
+
+        void
+        commit(std::size_t n)
+        {
+            size_ += n;
+            if(n == 0)
+                body_.resize(size_);
+        }
+
         void
         finish(error_code& ec)
         {
+            body_.resize(size_);
             ec.assign(0, ec.category());
         }
     };
@@ -71,6 +71,7 @@ public:
     class reader
     {
         value_type& body_;
+        std::size_t size_ = 0;  // octets stored
 
     public:
         template<bool isRequest, class Fields>
@@ -102,6 +103,7 @@ public:
                     return;
                 }
             }
+            size_ = body_.size();
             ec.assign(0, ec.category());
         }
 
@@ -113,7 +115,7 @@ public:
             using asio::buffer_size;
             using asio::buffer_copy;
             auto const n = buffer_size(buffers);
-            auto const len = body_.size();
+            auto const len = size_;
             try
             {
                 body_.resize(len + n);
@@ -124,13 +126,44 @@ public:
                 return 0;
             }
             ec.assign(0, ec.category());
+            size_ += n;
             return buffer_copy(asio::buffer(
                 &body_[0] + len, n), buffers);
         }
 
+        asio::mutable_buffer
+        prepare(std::size_t n, error_code& ec)
+        {
+            // Octets past the stored body are kept between
+            // calls, so the container is cleared only once.
+            if(body_.size() < size_ + n)
+            {
+                try
+                {
+                    body_.resize(size_ + n);
+                }
+                catch(std::exception const&)
+                {
+                    ec = error::buffer_overflow;
+                    return {};
+                }
+            }
+            ec.assign(0, ec.category());
+            return {&body_[0] + size_, n};
+        }
+
+        void
+        commit(std::size_t n)
+        {
+            size_ += n;
+            if(n == 0)
+                body_.resize(size_);
+        }
+
         void
         finish(error_code& ec)
         {
+            body_.resize(size_);
             ec.assign(0, ec.category());
         }
     };
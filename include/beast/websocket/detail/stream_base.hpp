@@ -356,6 +356,13 @@ struct stream_base : stream_prng
         zlib::Flush flush,
         error_code& ec);
 
+    void
+    inflate_last(
+        zlib::z_params& zs,
+        zlib::Flush flush,
+        role_type role,
+        error_code& ec);
+
     void
     do_context_takeover_read(role_type role);
 };
@@ -403,6 +410,15 @@ struct stream_base<false> : stream_prng
     {
     }
 
+    void
+    inflate_last(
+        zlib::z_params&,
+        zlib::Flush,
+        role_type,
+        error_code&)
+    {
+    }
+
     void
     do_context_takeover_read(role_type)
     {
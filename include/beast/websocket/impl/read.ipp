@@ -50,18 +50,43 @@ inflate(
     this->pmd_->zi.write(zs, flush, ec);
 }
 
+// Inflate the remaining payload of the current message.
+// Without context takeover the output is not kept in
+// the window, since the next message cannot refer to it.
+//
+template<>
+inline
+void
+stream_base<true>::
+inflate_last(
+    zlib::z_params& zs,
+    zlib::Flush flush,
+    role_type role,
+    error_code& ec)
+{
+    if((role == role_type::client &&
+            pmd_config_.server_no_context_takeover) ||
+       (role == role_type::server &&
+            pmd_config_.client_no_context_takeover))
+        this->pmd_->zi.write_final(zs, flush, ec);
+    else
+        this->pmd_->zi.write(zs, flush, ec);
+}
+
 template<>
 inline
 void
 stream_base<true>::
 do_context_takeover_read(role_type role)
 {
+    // Release the window between messages, it
+    // is allocated again only when needed.
     if((role == role_type::client &&
             pmd_config_.server_no_context_takeover) ||
        (role == role_type::server &&
             pmd_config_.client_no_context_takeover))
     {
-        pmd_->zi.reset();
+        pmd_->zi.clear();
     }
 }
 
@@ -591,7 +616,10 @@ operator()(
                 {
                     break;
                 }
-                ws_.inflate(zs, zlib::Flush::sync, ec);
+                if(ws_.rd_fh_.fin && zs.avail_in == ws_.rd_remain_)
+                    ws_.inflate_last(zs, zlib::Flush::sync, ws_.role_, ec);
+                else
+                    ws_.inflate(zs, zlib::Flush::sync, ec);
                 if(! ws_.check_ok(ec))
                     goto upcall;
                 if(ws_.rd_msg_max_ && beast::detail::sum_exceeds(
@@ -1318,7 +1346,10 @@ loop:
             {
                 break;
             }
-            this->inflate(zs, zlib::Flush::sync, ec);
+            if(rd_fh_.fin && zs.avail_in == rd_remain_)
+                this->inflate_last(zs, zlib::Flush::sync, role_, ec);
+            else
+                this->inflate(zs, zlib::Flush::sync, ec);
             if(! check_ok(ec))
                 return bytes_written;
             if(rd_msg_max_ && beast::detail::sum_exceeds(
@@ -15,6 +15,7 @@
 #include <beast/zlib/deflate_stream.hpp>
 #include <beast/zlib/error.hpp>
 #include <beast/zlib/inflate_stream.hpp>
+#include <beast/zlib/train_dictionary.hpp>
 #include <beast/zlib/zlib.hpp>
 
 #endif
@@ -51,13 +51,114 @@ namespace zlib {
     (zlib format), rfc1951 (deflate format) and rfc1952 (gzip format).
 */
 
+class deflate_stream;
+
+/** A preset dictionary prepared for use with @ref deflate_stream.
+
+    A preset dictionary is a sequence of bytes which the compressor
+    treats as if it had been compressed immediately before the
+    message, so that strings in the message may be encoded as
+    references to the dictionary. This greatly improves the
+    compression ratio of short messages which share a common
+    vocabulary, such as JSON objects with the same keys. The
+    decompressor must be given the same bytes, using
+    @ref inflate_stream::dictionary.
+
+    Constructing this object inserts the dictionary into the hash
+    chains once and saves the result. Priming a stream with it
+    copies the saved state instead of hashing the dictionary again
+    for every message. The object is not modified by use, so one
+    instance may be shared by any number of streams and threads.
+
+    The saved state depends on the window size and memory level.
+    When it is used with a stream having different settings, the
+    dictionary is inserted the slow way instead. Only the bytes
+    which fit in the window given upon construction are kept, so
+    a stream with a larger window will not see the rest.
+
+    @see deflate_stream::dictionary
+*/
+class deflate_dictionary
+{
+    friend class deflate_stream;
+
+    detail::dictionary_state st_;
+
+    void
+    init(deflate_stream& ds, void const* data, std::size_t size);
+
+public:
+    /** Constructor.
+
+        The dictionary is prepared for a stream using the
+        window size and memory level of a default constructed
+        @ref deflate_stream.
+
+        @param data A pointer to the dictionary. The most commonly
+        used strings should be placed at the end. The bytes are
+        copied.
+
+        @param size The size of the dictionary. Only the last
+        bytes which fit in the window are used.
+    */
+    deflate_dictionary(void const* data, std::size_t size);
+
+    /** Constructor.
+
+        The dictionary is prepared for a stream using the
+        specified window size and memory level.
+
+        @param data A pointer to the dictionary. The most commonly
+        used strings should be placed at the end. The bytes are
+        copied.
+
+        @param size The size of the dictionary. Only the last
+        bytes which fit in the window are used.
+
+        @param windowBits The base two logarithm of the window size.
+
+        @param memLevel The memory level, from 1 to 9.
+
+        @throws std::invalid_argument if the settings are invalid.
+    */
+    deflate_dictionary(
+        void const* data,
+        std::size_t size,
+        int windowBits,
+        int memLevel);
+
+    /// Return a pointer to the bytes of the dictionary which are used
+    void const*
+    data() const
+    {
+        return st_.window.data();
+    }
+
+    /// Return the number of bytes of the dictionary which are used
+    std::size_t
+    size() const
+    {
+        return st_.window.size();
+    }
+};
+
 /** Raw deflate compressor.
 
     This is a port of zlib's "deflate" functionality to C++.
+
+    Unlike zlib, when a long stretch of input produces almost no
+    matches, such as already compressed or encrypted data, the
+    compressor stops searching for matches for a while and emits
+    those bytes as literals, which are normally sent as stored
+    blocks. The search resumes periodically, so compression picks
+    up again when the input becomes compressible. For this reason
+    the output for such input is not identical to that of zlib.
 */
 class deflate_stream
     : private detail::deflate_stream
 {
+    friend class deflate_dictionary;
+
 public:
     /** Construct a default deflate stream.
 
@@ -81,6 +182,27 @@ public:
         reset(6, 15, DEF_MEM_LEVEL, Strategy::normal);
     }
 
+    /** Construct a default deflate stream using an allocator.
+
+        The stream is constructed with the same settings as the
+        default constructor. All dynamically allocated internal
+        buffers are obtained from a copy of the specified allocator,
+        which may be used to draw the memory from an arena or pool.
+        The allocator is type-erased; the total amount of memory
+        requested may be computed ahead of time using
+        @ref memory_size.
+
+        @param alloc The allocator to use. It must meet the
+        requirements of @b Allocator.
+    */
+    template<class Allocator>
+    explicit
+    deflate_stream(Allocator const& alloc)
+        : detail::deflate_stream(alloc)
+    {
+        reset(6, 15, DEF_MEM_LEVEL, Strategy::normal);
+    }
+
     /** Reset the stream and compression settings.
 
         This function initializes the stream to the specified
@@ -109,6 +231,12 @@ public:
         followed by `reset` with the same compression settings,
         without deallocating the internal buffers.
 
+        It is intended for reusing the stream for each message
+        when compressed messages are independent. Instead of
+        clearing the entire hash table, only the entries for the
+        input compressed since the last reset are removed, so the
+        cost is proportional to the size of the previous message.
+
         @note Any unprocessed input or pending output from
         previous calls are discarded.
     */
@@ -133,6 +261,33 @@ public:
         doClear();
     }
 
+    /** Returns the dynamic memory needed for the given settings.
+
+        This function returns the number of bytes which the stream
+        allocates for its window, hash tables and pending output
+        buffer when using the specified settings. The memory is
+        requested as one block, upon the first call to @ref write
+        after a reset which changes these settings. The size of
+        the stream object itself, `sizeof(deflate_stream)`, is not
+        included.
+
+        For the default settings of `windowBits = 15` and
+        `memLevel = 8` the result is 256KB. In general the result
+        is `(1 << (windowBits + 2)) + (1 << (memLevel + 9))`.
+
+        @param windowBits The base two logarithm of the window size.
+
+        @param memLevel The memory level, from 1 to 9.
+
+        @throws std::invalid_argument if the settings are invalid.
+    */
+    static
+    std::size_t
+    memory_size(int windowBits, int memLevel)
+    {
+        return doMemorySize(windowBits, memLevel);
+    }
+
     /** Returns the upper limit on the size of a compressed block.
 
         This function makes a conservative estimate of the maximum number
@@ -355,8 +510,92 @@ public:
     {
         return doPrime(bits, value, ec);
     }
+
+    /** Set a preset dictionary.
+
+        This function initializes the compression dictionary from
+        the given bytes without producing any compressed output. It
+        must be called after construction or a reset, before the
+        first call to @ref write. The decompressor must be given
+        the same dictionary before decompressing the output, using
+        @ref inflate_stream::dictionary.
+
+        The dictionary should consist of strings which are likely
+        to be encountered later in the data to be compressed, with
+        the most commonly used strings preferably put towards the
+        end of the dictionary. Only the last bytes which fit in the
+        window are used.
+
+        When the same dictionary is used for many messages, prefer
+        the overload which accepts a @ref deflate_dictionary.
+
+        @param dict A pointer to the dictionary.
+
+        @param size The size of the dictionary.
+
+        @param ec Set to `error::stream_error` if input has
+        already been provided to @ref write.
+    */
+    void
+    dictionary(void const* dict, std::size_t size, error_code& ec)
+    {
+        doDictionary(static_cast<Byte const*>(dict),
+            static_cast<uInt>(size), ec);
+    }
+
+    /** Set a preset dictionary which was prepared ahead of time.
+
+        This function has the same effect as the overload which
+        accepts the bytes of the dictionary. When the stream has
+        been reset and uses the same window size and memory level
+        as the prepared dictionary, the saved hash chains are
+        copied in and the cost is proportional to the size of the
+        dictionary rather than to the work of hashing it.
+
+        @param dict The prepared dictionary. It is not modified.
+
+        @param ec Set to `error::stream_error` if input has
+        already been provided to @ref write.
+    */
+    void
+    dictionary(deflate_dictionary const& dict, error_code& ec)
+    {
+        doDictionary(dict.st_, ec);
+    }
 };
 
+inline
+void
+deflate_dictionary::
+init(deflate_stream& ds, void const* data, std::size_t size)
+{
+    error_code ec;
+    ds.dictionary(data, size, ec);
+    BOOST_ASSERT(! ec);
+    ds.doSaveDictionary(st_);
+}
+
+inline
+deflate_dictionary::
+deflate_dictionary(void const* data, std::size_t size)
+{
+    deflate_stream ds;
+    init(ds, data, size);
+}
+
+inline
+deflate_dictionary::
+deflate_dictionary(
+    void const* data,
+    std::size_t size,
+    int windowBits,
+    int memLevel)
+{
+    deflate_stream ds;
+    ds.reset(6, windowBits, memLevel, Strategy::normal);
+    init(ds, data, size);
+}
+
 /** Returns the upper limit on the size of a compressed block.
 
     This function makes a conservative estimate of the maximum number
@@ -0,0 +1,98 @@
+//
+// Copyright (c) 2016-2017 Vinnie Falco (vinnie dot falco at gmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/boostorg/beast
+//
+
+#ifndef BEAST_ZLIB_DETAIL_CHECKSUM_HPP
+#define BEAST_ZLIB_DETAIL_CHECKSUM_HPP
+
+#include <cstdint>
+#include <cstdlib>
+
+namespace beast {
+namespace zlib {
+namespace detail {
+
+/*  Checksums used by the framing around raw deflate data.
+
+    The codecs in this library produce and consume raw deflate
+    data only. The zlib format (rfc1950) appends an Adler-32
+    of the uncompressed data, and the gzip format (rfc1952)
+    appends a CRC-32. These are only needed by code which
+    adds or removes that framing, such as the HTTP content
+    coding bodies.
+*/
+
+template<class = void>
+std::uint32_t const*
+crc32_table()
+{
+    struct table
+    {
+        std::uint32_t v[256];
+
+        table()
+        {
+            for(std::uint32_t n = 0; n < 256; ++n)
+            {
+                auto c = n;
+                for(int k = 0; k < 8; ++k)
+                    c = (c & 1) ? 0xedb88320 ^ (c >> 1) : c >> 1;
+                v[n] = c;
+            }
+        }
+    };
+    static table const t;
+    return t.v;
+}
+
+/// Update a running CRC-32 (rfc1952) with more data
+inline
+std::uint32_t
+crc32(std::uint32_t crc,
+    void const* data, std::size_t size)
+{
+    auto const t = crc32_table();
+    auto p = static_cast<std::uint8_t const*>(data);
+    crc = crc ^ 0xffffffff;
+    while(size--)
+        crc = t[(crc ^ *p++) & 0xff] ^ (crc >> 8);
+    return crc ^ 0xffffffff;
+}
+
+/// Update a running Adler-32 (rfc1950) with more data
+inline
+std::uint32_t
+adler32(std::uint32_t adler,
+    void const* data, std::size_t size)
+{
+    // largest n such that 255n(n+1)/2 + (n+1)(65520) < 2^32
+    std::size_t const nmax = 5552;
+    std::uint32_t const base = 65521;
+    auto p = static_cast<std::uint8_t const*>(data);
+    std::uint32_t a = adler & 0xffff;
+    std::uint32_t b = adler >> 16;
+    while(size > 0)
+    {
+        auto n = size < nmax ? size : nmax;
+        size -= n;
+        while(n--)
+        {
+            a += *p++;
+            b += a;
+        }
+        a %= base;
+        b %= base;
+    }
+    return (b << 16) | a;
+}
+
+} // detail
+} // zlib
+} // beast
+
+#endif
@@ -39,10 +39,10 @@
 
 #include <beast/zlib/zlib.hpp>
 #include <beast/zlib/detail/ranges.hpp>
+#include <beast/zlib/detail/storage.hpp>
 #include <beast/core/detail/type_traits.hpp>
 #include <boost/assert.hpp>
 #include <boost/config.hpp>
-#include <boost/make_unique.hpp>
 #include <boost/optional.hpp>
 #include <boost/throw_exception.hpp>
 #include <cstdint>
@@ -51,6 +51,8 @@
 #include <memory>
 #include <stdexcept>
 #include <type_traits>
+#include <utility>
+#include <vector>
 
 namespace beast {
 namespace zlib {
@@ -106,6 +108,24 @@ namespace detail {
  *
  */
 
+/*  The state of the hash chains after inserting a preset dictionary.
+
+    This is computed once for a dictionary and a given window size
+    and memory level, and copied into a freshly reset stream instead
+    of hashing the dictionary again for every message.
+*/
+struct dictionary_state
+{
+    std::vector<std::uint8_t> window;   // the part of the dictionary used
+    std::vector<std::uint16_t> prev;    // prev[] for each inserted string
+    std::vector<std::pair<
+        std::uint16_t, std::uint16_t>> head; // non-zero head_[] entries
+    unsigned ins_h = 0;
+    unsigned insert = 0;
+    unsigned w_bits = 0;
+    unsigned hash_bits = 0;
+};
+
 class deflate_stream
 {
 protected:
@@ -186,6 +206,19 @@ protected:
     */
     static std::size_t constexpr kWinInit = maxMatch;
 
+    /*  Each literal adds one to a counter and each match subtracts
+        eight times its length. When the counter reaches kSkipTrigger
+        the input is considered incompressible, and the following bytes
+        are emitted as literals without searching for matches. Random
+        data still produces an occasional short match by chance, which
+        is why a match does not simply reset the counter. The number
+        of bytes skipped doubles, up to a limit, each time the search
+        resumes and still finds almost nothing.
+    */
+    static std::size_t constexpr kSkipTrigger = 8192;
+    static std::size_t constexpr kSkipMin = 4096;
+    static std::size_t constexpr kSkipMax = 32768;
+
     // Describes a single value and its code string.
     struct ct_data
     {
@@ -300,8 +333,7 @@ protected:
     lut_type const& lut_;
 
     bool inited_ = false;
-    std::size_t buf_size_;
-    std::unique_ptr<std::uint8_t[]> buf_;
+    storage buf_;
 
     int status_;                    // as the name implies
     Byte* pending_buf_;             // output still pending
@@ -453,6 +485,9 @@ protected:
     std::uint32_t static_len_;      // bit length of current block with static trees
     uInt matches_;                  // number of string matches in current block
     uInt insert_;                   // bytes at end of window left to insert
+    uInt literal_run_;              // literals not offset by matches
+    uInt skip_;                     // bytes left to emit without searching
+    uInt skip_len_;                 // length of the next skip
 
     /*  Output buffer.
         Bits are inserted starting at the bottom (least significant bits).
@@ -478,6 +513,14 @@ protected:
     {
     }
 
+    template<class Allocator>
+    explicit
+    deflate_stream(Allocator const& alloc)
+        : lut_(get_lut())
+        , buf_(alloc)
+    {
+    }
+
     /*  In order to simplify the code, particularly on 16 bit machines, match
         distances are limited to MAX_DIST instead of WSIZE.
     */
@@ -562,6 +605,29 @@ protected:
             (unsigned)(hash_size_-1)*sizeof(*head_));
     }
 
+    /*  Remove the strings inserted from the first n bytes of the
+        window from the hash table. Every non-zero head is the
+        position of a string whose hash is the index of that head,
+        so rehashing the used part of the window finds all of them.
+        When little data was compressed since the table was last
+        cleared this is much cheaper than clearing every head.
+    */
+    void
+    clear_hash(uInt n)
+    {
+        if(n > hash_size_ / 16)
+            return clear_hash();
+        if(n < minMatch)
+            return;
+        uInt h = window_[0];
+        update_hash(h, window_[1]);
+        for(uInt str = 0; str + minMatch <= n; ++str)
+        {
+            update_hash(h, window_[str + minMatch-1]);
+            head_[h] = 0;
+        }
+    }
+
     /*  Compares two subtrees, using the tree depth as tie breaker
         when the subtrees have equal frequency. This minimizes the
         worst case length.
@@ -668,15 +734,19 @@ protected:
     template<class = void> void doReset             (int level, int windowBits, int memLevel, Strategy strategy);
     template<class = void> void doReset             ();
     template<class = void> void doClear             ();
+    template<class = void> static std::size_t doMemorySize(int windowBits, int memLevel);
     template<class = void> std::size_t doUpperBound (std::size_t sourceLen) const;
     template<class = void> void doTune              (int good_length, int max_lazy, int nice_length, int max_chain);
     template<class = void> void doParams            (z_params& zs, int level, Strategy strategy, error_code& ec);
     template<class = void> void doWrite             (z_params& zs, boost::optional<Flush> flush, error_code& ec);
     template<class = void> void doDictionary        (Byte const* dict, uInt dictLength, error_code& ec);
+    template<class = void> void doDictionary        (dictionary_state const& d, error_code& ec);
+    template<class = void> void doSaveDictionary    (dictionary_state& d) const;
     template<class = void> void doPrime             (int bits, int value, error_code& ec);
     template<class = void> void doPending           (unsigned* value, int* bits);
 
     template<class = void> void init                ();
+    template<class = void> void init_stream         ();
     template<class = void> void lm_init             ();
     template<class = void> void init_block          ();
     template<class = void> void pqdownheap          (ct_data const* tree, int k);
@@ -699,6 +769,9 @@ protected:
     template<class = void> void tr_stored_block     (char *bu, std::uint32_t stored_len, int last);
     template<class = void> void tr_tally_dist       (std::uint16_t dist, std::uint8_t len, bool& flush);
     template<class = void> void tr_tally_lit        (std::uint8_t c, bool& flush);
+    template<class = void> bool tr_skip_lit         ();
+    template<class = void> void tr_skip_check       ();
+    template<class = void> void tr_skip_match       (uInt len);
 
     template<class = void> void tr_flush_block      (z_params& zs, char *buf, std::uint32_t stored_len, int last);
     template<class = void> void fill_window         (z_params& zs);
@@ -932,7 +1005,13 @@ void
 deflate_stream::
 doReset()
 {
-    inited_ = false;
+    if(! inited_)
+        return;
+    // Keep the buffers and forget only the
+    // strings which were inserted since the
+    // hash table was last cleared.
+    clear_hash(strstart_ + lookahead_);
+    init_stream();
 }
 
 template<class>
@@ -941,7 +1020,35 @@ deflate_stream::
 doClear()
 {
     inited_ = false;
-    buf_.reset();
+    buf_.clear();
+}
+
+template<class>
+std::size_t
+deflate_stream::
+doMemorySize(int windowBits, int memLevel)
+{
+    // until 256-byte window bug fixed
+    if(windowBits == 8)
+        windowBits = 9;
+
+    if(windowBits < 8 || windowBits > 15)
+        BOOST_THROW_EXCEPTION(std::invalid_argument{
+            "invalid windowBits"});
+
+    if(memLevel < 1 || memLevel > max_mem_level)
+        BOOST_THROW_EXCEPTION(std::invalid_argument{
+            "invalid memLevel"});
+
+    std::size_t const w_size = std::size_t{1} << windowBits;
+    std::size_t const hash_size = std::size_t{1} << (memLevel + 7);
+    std::size_t const lit_bufsize = std::size_t{1} << (memLevel + 6);
+
+    return
+        w_size * 2*sizeof(Byte) +                       // window
+        w_size * sizeof(std::uint16_t) +                // prev
+        hash_size * sizeof(std::uint16_t) +             // head
+        lit_bufsize * (sizeof(std::uint16_t)+2);        // pending, d_buf, l_buf
 }
 
 template<class>
@@ -1139,7 +1246,7 @@ doWrite(z_params& zs, boost::optional<Flush> flush, error_code& ec)
                  */
                 if(flush == Flush::full)
                 {
-                    clear_hash(); // forget history
+                    clear_hash(strstart_ + lookahead_); // forget history
                     if(lookahead_ == 0)
                     {
                         strstart_ = 0;
@@ -1164,20 +1271,19 @@ doWrite(z_params& zs, boost::optional<Flush> flush, error_code& ec)
     }
 }
 
-// VFALCO Warning: untested
 template<class>
 void
 deflate_stream::
 doDictionary(Byte const* dict, uInt dictLength, error_code& ec)
 {
+    maybe_init();
+
     if(lookahead_)
     {
         ec = error::stream_error;
         return;
     }
 
-    maybe_init();
-
     /* if dict would fill window, just replace the history */
     if(dictLength >= w_size_)
     {
@@ -1220,6 +1326,62 @@ doDictionary(Byte const* dict, uInt dictLength, error_code& ec)
     match_available_ = 0;
 }
 
+template<class>
+void
+deflate_stream::
+doDictionary(dictionary_state const& d, error_code& ec)
+{
+    maybe_init();
+
+    if(lookahead_)
+    {
+        ec = error::stream_error;
+        return;
+    }
+
+    // The saved hash chains are only usable on an empty window
+    // with the same geometry, otherwise insert the bytes again.
+    if(strstart_ != 0 || block_start_ != 0 || insert_ != 0 ||
+        d.w_bits != w_bits_ || d.hash_bits != hash_bits_)
+        return doDictionary(d.window.data(),
+            static_cast<uInt>(d.window.size()), ec);
+
+    auto const n = static_cast<uInt>(d.window.size());
+    std::memcpy(window_, d.window.data(), n);
+    std::memcpy(prev_, d.prev.data(),
+        d.prev.size() * sizeof(*prev_));
+    for(auto const& e : d.head)
+        head_[e.first] = e.second;
+    ins_h_ = d.ins_h;
+    strstart_ = n;
+    block_start_ = (long)strstart_;
+    insert_ = d.insert;
+    lookahead_ = 0;
+    match_length_ = prev_length_ = minMatch-1;
+    match_available_ = 0;
+}
+
+// Save the hash chains after inserting only a dictionary
+template<class>
+void
+deflate_stream::
+doSaveDictionary(dictionary_state& d) const
+{
+    BOOST_ASSERT(inited_ && lookahead_ == 0);
+    BOOST_ASSERT(static_cast<long>(strstart_) == block_start_);
+    d.window.assign(window_, window_ + strstart_);
+    d.prev.assign(prev_, prev_ + (strstart_ - insert_));
+    d.head.clear();
+    for(uInt i = 0; i < hash_size_; ++i)
+        if(head_[i] != 0)
+            d.head.emplace_back(
+                static_cast<std::uint16_t>(i), head_[i]);
+    d.ins_h = ins_h_;
+    d.insert = insert_;
+    d.w_bits = w_bits_;
+    d.hash_bits = hash_bits_;
+}
+
 template<class>
 void
 deflate_stream::
@@ -1286,12 +1448,7 @@ init()
     auto const noverlay = lit_bufsize_ * (sizeof(std::uint16_t)+2);
     auto const needed   = nwindow + nprev + nhead + noverlay;
 
-    if(! buf_ || buf_size_ != needed)
-    {
-        buf_ = boost::make_unique_noinit<
-            std::uint8_t[]>(needed);
-        buf_size_ = needed;
-    }
+    buf_.reset(needed);
 
     window_ = reinterpret_cast<Byte*>(buf_.get());
     prev_   = reinterpret_cast<std::uint16_t*>(buf_.get() + nwindow);
@@ -1316,6 +1473,18 @@ init()
     d_buf_ = overlay + lit_bufsize_ / sizeof(std::uint16_t);
     l_buf_ = pending_buf_ + (1 + sizeof(std::uint16_t)) * lit_bufsize_;
 
+    clear_hash();
+
+    init_stream();
+}
+
+/*  Prepare the allocated state for a new stream
+*/
+template<class>
+void
+deflate_stream::
+init_stream()
+{
     pending_ = 0;
     pending_out_ = pending_buf_;
 
@@ -1328,7 +1497,8 @@ init()
     inited_ = true;
 }
 
-/*  Initialize the "longest match" routines for a new zlib stream
+/*  Initialize the "longest match" routines for a new zlib stream.
+    The caller is responsible for clearing the hash table.
 */
 template<class>
 void
@@ -1337,8 +1507,6 @@ lm_init()
 {
     window_size_ = (std::uint32_t)2L*w_size_;
 
-    clear_hash();
-
     /* Set the default configuration parameters:
      */
     // VFALCO TODO just copy the config struct
@@ -1354,6 +1522,9 @@ lm_init()
     match_length_ = prev_length_ = minMatch-1;
     match_available_ = 0;
     ins_h_ = 0;
+    literal_run_ = 0;
+    skip_ = 0;
+    skip_len_ = kSkipMin;
 }
 
 // Initialize a new block.
@@ -2076,6 +2247,63 @@ tr_tally_lit(std::uint8_t c, bool& flush)
     flush = (last_lit_ == lit_bufsize_-1);
 }
 
+/*  Emit up to skip_ bytes of the lookahead as literals, without
+    inserting strings or searching for matches. The block is then
+    sent with Huffman codes or stored, whichever is smaller, so
+    random data is copied almost at the speed of memcpy.
+    Returns true if the block must be flushed.
+*/
+template<class>
+bool
+deflate_stream::
+tr_skip_lit()
+{
+    bool flush = false;
+    while(skip_ && lookahead_ && ! flush)
+    {
+        tr_tally_lit(window_[strstart_], flush);
+        --skip_;
+        --lookahead_;
+        ++strstart_;
+    }
+    if(skip_ == 0 && lookahead_ >= minMatch)
+    {
+        // Restart the rolling hash for the next search
+        ins_h_ = window_[strstart_];
+        update_hash(ins_h_, window_[strstart_+1]);
+    }
+    return flush;
+}
+
+// Account for a literal, and start skipping after too many
+template<class>
+void
+deflate_stream::
+tr_skip_check()
+{
+    if(++literal_run_ < kSkipTrigger)
+        return;
+    literal_run_ = 0;
+    skip_ = skip_len_;
+    if(skip_len_ < kSkipMax)
+        skip_len_ *= 2;
+}
+
+// Account for a match
+template<class>
+void
+deflate_stream::
+tr_skip_match(uInt len)
+{
+    if(literal_run_ > 8 * len)
+    {
+        literal_run_ -= 8 * len;
+        return;
+    }
+    literal_run_ = 0;
+    skip_len_ = kSkipMin;
+}
+
 //------------------------------------------------------------------------------
 
 /*  Determine the best encoding for the current block: dynamic trees,
@@ -2621,6 +2849,17 @@ f_fast(z_params& zs, Flush flush) ->
                 break; /* flush the current block */
         }
 
+        if(skip_)
+        {
+            if(tr_skip_lit())
+            {
+                flush_block(zs, false);
+                if(zs.avail_out == 0)
+                    return need_more;
+            }
+            continue;
+        }
+
         /* Insert the string window[strstart .. strstart+2] in the
          * dictionary, and set hash_head to the head of the hash chain:
          */
@@ -2642,6 +2881,7 @@ f_fast(z_params& zs, Flush flush) ->
         }
         if(match_length_ >= minMatch)
         {
+            tr_skip_match(match_length_);
             tr_tally_dist(static_cast<std::uint16_t>(strstart_ - match_start_),
                 static_cast<std::uint8_t>(match_length_ - minMatch), bflush);
 
@@ -2679,6 +2919,7 @@ f_fast(z_params& zs, Flush flush) ->
         {
             /* No match, output a literal byte */
             tr_tally_lit(window_[strstart_], bflush);
+            tr_skip_check();
             lookahead_--;
             strstart_++;
         }
@@ -2737,6 +2978,27 @@ f_slow(z_params& zs, Flush flush) ->
                 break; /* flush the current block */
         }
 
+        if(skip_)
+        {
+            /* Emit the literal held for lazy evaluation
+             * and forget any match found for it.
+             */
+            bflush = false;
+            if(match_available_)
+            {
+                tr_tally_lit(window_[strstart_-1], bflush);
+                match_available_ = 0;
+                match_length_ = minMatch-1;
+            }
+            if(bflush || tr_skip_lit())
+            {
+                flush_block(zs, false);
+                if(zs.avail_out == 0)
+                    return need_more;
+            }
+            continue;
+        }
+
         /* Insert the string window[strstart .. strstart+2] in the
          * dictionary, and set hash_head to the head of the hash chain:
          */
@@ -2778,6 +3040,8 @@ f_slow(z_params& zs, Flush flush) ->
             /* Do not insert strings in hash table beyond this. */
             uInt max_insert = strstart_ + lookahead_ - minMatch;
 
+            tr_skip_match(prev_length_);
+
             tr_tally_dist(
                 static_cast<std::uint16_t>(strstart_ -1 - prev_match_),
                 static_cast<std::uint8_t>(prev_length_ - minMatch), bflush);
@@ -2813,6 +3077,7 @@ f_slow(z_params& zs, Flush flush) ->
              * is longer, truncate the previous match to a single literal.
              */
             tr_tally_lit(window_[strstart_-1], bflush);
+            tr_skip_check();
             if(bflush)
                 flush_block(zs, false);
             strstart_++;
@@ -62,9 +62,19 @@ protected:
         w_.reset(15);
     }
 
+    template<class Allocator>
+    explicit
+    inflate_stream(Allocator const& alloc)
+        : w_(alloc)
+    {
+        w_.reset(15);
+    }
+
     template<class = void> void doClear();
     template<class = void> void doReset(int windowBits);
-    template<class = void> void doWrite(z_params& zs, Flush flush, error_code& ec);
+    template<class = void> static std::size_t doMemorySize(int windowBits);
+    template<class = void> void doDictionary(Byte const* dict, uInt dictLength);
+    template<class = void> void doWrite(z_params& zs, Flush flush, bool final, error_code& ec);
 
     void
     doReset()
@@ -255,12 +265,35 @@ void
 inflate_stream::
 doClear()
 {
+    w_.clear();
+    doReset();
+}
+
+template<class>
+std::size_t
+inflate_stream::
+doMemorySize(int windowBits)
+{
+    if(windowBits < 8 || windowBits > 15)
+        BOOST_THROW_EXCEPTION(std::domain_error{
+            "windowBits out of range"});
+    return std::size_t{1} << windowBits;
+}
+
+template<class>
+void
+inflate_stream::
+doDictionary(Byte const* dict, uInt dictLength)
+{
+    // A raw stream has no dictionary id, the
+    // bytes are simply placed in the window.
+    w_.write(dict, dictLength);
 }
 
 template<class>
 void
 inflate_stream::
-doWrite(z_params& zs, Flush flush, error_code& ec)
+doWrite(z_params& zs, Flush flush, bool final, error_code& ec)
 {
     ranges r;
     r.in.first = reinterpret_cast<
@@ -283,9 +316,13 @@ doWrite(z_params& zs, Flush flush, error_code& ec)
              */
 
 
-            // VFALCO TODO Don't allocate update the window unless necessary
-            if(/*wsize_ ||*/ (r.out.used() && mode_ < BAD &&
-                    (mode_ < CHECK || flush != Flush::finish)))
+            // The window is only needed if later input may refer
+            // back to this output. It is not updated when the
+            // caller says the input is final and all of it was
+            // decompressed, so small messages never allocate it.
+            if(r.out.used() && mode_ < BAD &&
+                    (mode_ < CHECK || flush != Flush::finish) &&
+                    ! (final && ! r.in.avail() && r.out.avail()))
                 w_.write(r.out.first, r.out.used());
 
             zs.next_in = r.in.next;
@@ -0,0 +1,214 @@
+//
+// Copyright (c) 2016-2017 Vinnie Falco (vinnie dot falco at gmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/boostorg/beast
+//
+
+#ifndef BEAST_ZLIB_DETAIL_STORAGE_HPP
+#define BEAST_ZLIB_DETAIL_STORAGE_HPP
+
+#include <beast/core/detail/allocator.hpp>
+#include <beast/core/detail/empty_base_optimization.hpp>
+#include <boost/assert.hpp>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <utility>
+
+namespace beast {
+namespace zlib {
+namespace detail {
+
+/*  A single block of dynamic memory used by a codec.
+
+    The codecs keep all of their variable sized state in one
+    block: the deflate window, hash chains and pending buffer,
+    or the inflate sliding window. The block is obtained from
+    an optional caller supplied allocator, which is type-erased
+    so that the codec classes do not need to be templates.
+    When no allocator is given, `operator new` is used.
+*/
+class storage
+{
+    struct base
+    {
+        virtual ~base() = default;
+        virtual std::uint8_t* allocate(std::size_t n) = 0;
+        virtual void deallocate(std::uint8_t* p, std::size_t n) = 0;
+        virtual void destroy() = 0;
+    };
+
+    template<class Allocator>
+    class impl;
+
+    base* a_ = nullptr;
+    std::uint8_t* p_ = nullptr;
+    std::size_t n_ = 0;
+
+public:
+    storage() = default;
+
+    template<class Allocator>
+    explicit
+    storage(Allocator const& alloc);
+
+    storage(storage&& other) noexcept
+        : a_(other.a_)
+        , p_(other.p_)
+        , n_(other.n_)
+    {
+        other.a_ = nullptr;
+        other.p_ = nullptr;
+        other.n_ = 0;
+    }
+
+    storage&
+    operator=(storage&& other) noexcept
+    {
+        if(this != &other)
+        {
+            clear();
+            if(a_)
+                a_->destroy();
+            a_ = other.a_;
+            p_ = other.p_;
+            n_ = other.n_;
+            other.a_ = nullptr;
+            other.p_ = nullptr;
+            other.n_ = 0;
+        }
+        return *this;
+    }
+
+    ~storage()
+    {
+        clear();
+        if(a_)
+            a_->destroy();
+    }
+
+    std::uint8_t*
+    get() const
+    {
+        return p_;
+    }
+
+    std::size_t
+    size() const
+    {
+        return n_;
+    }
+
+    explicit
+    operator bool() const
+    {
+        return p_ != nullptr;
+    }
+
+    // Ensure exactly n bytes are allocated.
+    // Contents are unspecified after a reallocation.
+    void
+    reset(std::size_t n)
+    {
+        if(p_ && n_ == n)
+            return;
+        clear();
+        p_ = a_ ? a_->allocate(n) : new std::uint8_t[n];
+        n_ = n;
+    }
+
+    // Release the memory, keeping the allocator
+    void
+    clear()
+    {
+        if(! p_)
+            return;
+        if(a_)
+            a_->deallocate(p_, n_);
+        else
+            delete[] p_;
+        p_ = nullptr;
+        n_ = 0;
+    }
+};
+
+template<class Allocator>
+class storage::impl
+    : public base
+    , private beast::detail::empty_base_optimization<
+        typename beast::detail::allocator_traits<Allocator>::
+            template rebind_alloc<std::uint8_t>>
+{
+    using alloc_type = typename beast::detail::allocator_traits<
+        Allocator>::template rebind_alloc<std::uint8_t>;
+
+    using alloc_traits =
+        beast::detail::allocator_traits<alloc_type>;
+
+    using self_alloc_type = typename beast::detail::allocator_traits<
+        Allocator>::template rebind_alloc<impl>;
+
+    using self_alloc_traits =
+        beast::detail::allocator_traits<self_alloc_type>;
+
+public:
+    explicit
+    impl(Allocator const& alloc)
+        : beast::detail::empty_base_optimization<
+            alloc_type>(alloc)
+    {
+    }
+
+    static
+    impl*
+    construct(Allocator const& alloc)
+    {
+        self_alloc_type a(alloc);
+        auto const p = self_alloc_traits::allocate(a, 1);
+        try
+        {
+            return ::new(static_cast<void*>(&*p)) impl(alloc);
+        }
+        catch(...)
+        {
+            self_alloc_traits::deallocate(a, p, 1);
+            throw;
+        }
+    }
+
+    std::uint8_t*
+    allocate(std::size_t n) override
+    {
+        return &*alloc_traits::allocate(this->member(), n);
+    }
+
+    void
+    deallocate(std::uint8_t* p, std::size_t n) override
+    {
+        alloc_traits::deallocate(this->member(), p, n);
+    }
+
+    void
+    destroy() override
+    {
+        self_alloc_type a(this->member());
+        this->~impl();
+        self_alloc_traits::deallocate(a, this, 1);
+    }
+};
+
+template<class Allocator>
+storage::
+storage(Allocator const& alloc)
+    : a_(impl<Allocator>::construct(alloc))
+{
+}
+
+} // detail
+} // zlib
+} // beast
+
+#endif
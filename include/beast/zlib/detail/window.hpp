@@ -37,11 +37,10 @@
 #ifndef BEAST_ZLIB_DETAIL_WINDOW_HPP
 #define BEAST_ZLIB_DETAIL_WINDOW_HPP
 
+#include <beast/zlib/detail/storage.hpp>
 #include <boost/assert.hpp>
-#include <boost/make_unique.hpp>
 #include <cstdint>
 #include <cstring>
-#include <memory>
 
 namespace beast {
 namespace zlib {
@@ -49,13 +48,22 @@ namespace detail {
 
 class window
 {
-    std::unique_ptr<std::uint8_t[]> p_;
+    storage p_;
     std::uint16_t i_ = 0;
     std::uint16_t size_ = 0;
     std::uint16_t capacity_ = 0;
     std::uint8_t bits_ = 0;
 
 public:
+    window() = default;
+
+    template<class Allocator>
+    explicit
+    window(Allocator const& alloc)
+        : p_(alloc)
+    {
+    }
+
     int
     bits() const
     {
@@ -77,6 +85,15 @@ public:
     void
     reset(int bits);
 
+    // Release the memory, keeping the size
+    void
+    clear()
+    {
+        p_.clear();
+        i_ = 0;
+        size_ = 0;
+    }
+
     void
     read(std::uint8_t* out, std::size_t pos, std::size_t n);
 
@@ -92,7 +109,7 @@ reset(int bits)
 {
     if(bits_ != bits)
     {
-        p_.reset();
+        p_.clear();
         bits_ = static_cast<std::uint8_t>(bits);
         capacity_ = 1U << bits_;
     }
@@ -105,22 +122,23 @@ void
 window::
 read(std::uint8_t* out, std::size_t pos, std::size_t n)
 {
+    auto const p = p_.get();
     if(i_ >= size_)
     {
         // window is contiguous
-        std::memcpy(out, &p_[i_ - pos], n);
+        std::memcpy(out, &p[i_ - pos], n);
         return;
     }
     auto i = ((i_ - pos) + capacity_) % capacity_;
     auto m = capacity_ - i;
     if(n <= m)
     {
-        std::memcpy(out, &p_[i], n);
+        std::memcpy(out, &p[i], n);
         return;
     }
-    std::memcpy(out, &p_[i], m);
+    std::memcpy(out, &p[i], m);
     out += m;
-    std::memcpy(out, &p_[0], n - m);
+    std::memcpy(out, &p[0], n - m);
 }
 
 template<class>
@@ -129,18 +147,18 @@ window::
 write(std::uint8_t const* in, std::size_t n)
 {
     if(! p_)
-        p_ = boost::make_unique<
-            std::uint8_t[]>(capacity_);
+        p_.reset(capacity_);
+    auto const p = p_.get();
     if(n >= capacity_)
     {
         i_ = 0;
         size_ = capacity_;
-        std::memcpy(&p_[0], in + (n - size_), size_);
+        std::memcpy(&p[0], in + (n - size_), size_);
         return;
     }
     if(i_ + n <= capacity_)
     {
-        std::memcpy(&p_[i_], in, n);
+        std::memcpy(&p[i_], in, n);
         if(size_ >= capacity_ - n)
             size_ = capacity_;
         else
@@ -151,10 +169,10 @@ write(std::uint8_t const* in, std::size_t n)
         return;
     }
     auto m = capacity_ - i_;
-    std::memcpy(&p_[i_], in, m);
+    std::memcpy(&p[i_], in, m);
     in += m;
     i_ = static_cast<std::uint16_t>(n - m);
-    std::memcpy(&p_[0], in, i_);
+    std::memcpy(&p[0], in, i_);
     size_ = capacity_;
 }
 
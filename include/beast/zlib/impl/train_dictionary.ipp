@@ -0,0 +1,182 @@
+//
+// Copyright (c) 2016-2017 Vinnie Falco (vinnie dot falco at gmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/boostorg/beast
+//
+
+#ifndef BEAST_ZLIB_IMPL_TRAIN_DICTIONARY_IPP
+#define BEAST_ZLIB_IMPL_TRAIN_DICTIONARY_IPP
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+namespace beast {
+namespace zlib {
+
+namespace detail {
+
+/*  Greedy dictionary selection.
+
+    Every string of k bytes in the samples is given an id, and
+    a weight equal to the number of samples containing it. The
+    trainer repeatedly picks the segment of a sample with the
+    largest total weight, then sets the weight of the strings in
+    that segment to zero so that later picks favor new content.
+*/
+class dictionary_trainer
+{
+    static std::size_t constexpr k = 8;         // string length
+    static std::size_t constexpr segment = 64;  // piece length
+
+    std::vector<string_view> samples_;
+    std::vector<std::vector<std::uint32_t>> ids_;
+    std::vector<std::uint32_t> weight_;
+
+public:
+    void
+    insert(string_view s)
+    {
+        samples_.push_back(s);
+    }
+
+    std::string
+    train(std::size_t size)
+    {
+        index();
+        std::vector<string_view> pieces;
+        std::size_t total = 0;
+        while(total < size)
+        {
+            auto const piece = pick();
+            if(piece.empty())
+                break;
+            pieces.push_back(piece);
+            total += piece.size();
+        }
+        // Least valuable first, so the best
+        // piece is nearest to the message.
+        std::string result;
+        result.reserve(total);
+        for(auto it = pieces.rbegin(); it != pieces.rend(); ++it)
+            result.append(it->data(), it->size());
+        if(result.size() > size)
+            result.erase(0, result.size() - size);
+        return result;
+    }
+
+private:
+    void
+    index()
+    {
+        std::unordered_map<std::uint64_t, std::uint32_t> m;
+        std::vector<std::uint32_t> seen;
+        ids_.resize(samples_.size());
+        for(std::size_t i = 0; i < samples_.size(); ++i)
+        {
+            auto const s = samples_[i];
+            if(s.size() < k)
+                continue;
+            auto& ids = ids_[i];
+            ids.resize(s.size() - k + 1);
+            for(std::size_t j = 0; j < ids.size(); ++j)
+            {
+                std::uint64_t key;
+                std::memcpy(&key, s.data() + j, k);
+                auto const id = m.emplace(key,
+                    static_cast<std::uint32_t>(m.size())).first->second;
+                if(id == weight_.size())
+                {
+                    weight_.push_back(0);
+                    seen.push_back(0);
+                }
+                // count each sample once
+                if(seen[id] != i + 1)
+                {
+                    seen[id] = static_cast<std::uint32_t>(i + 1);
+                    ++weight_[id];
+                }
+                ids[j] = id;
+            }
+        }
+        // A string found in only one sample does not help
+        // to compress the others.
+        if(samples_.size() > 1)
+            for(auto& w : weight_)
+                if(w < 2)
+                    w = 0;
+    }
+
+    string_view
+    pick()
+    {
+        std::uint64_t best = 0;
+        std::size_t best_sample = 0;
+        std::size_t best_pos = 0;
+        std::size_t best_len = 0;
+        for(std::size_t i = 0; i < samples_.size(); ++i)
+        {
+            auto const& ids = ids_[i];
+            if(ids.empty())
+                continue;
+            // number of strings starting in a piece
+            auto const n = (std::min)(
+                segment - k + 1, ids.size());
+            std::uint64_t sum = 0;
+            for(std::size_t j = 0; j < n; ++j)
+                sum += weight_[ids[j]];
+            for(std::size_t j = 0;; ++j)
+            {
+                if(sum > best)
+                {
+                    best = sum;
+                    best_sample = i;
+                    best_pos = j;
+                    best_len = n + k - 1;
+                }
+                if(j + n >= ids.size())
+                    break;
+                sum -= weight_[ids[j]];
+                sum += weight_[ids[j + n]];
+            }
+        }
+        if(best == 0)
+            return {};
+        auto const& ids = ids_[best_sample];
+        for(std::size_t j = best_pos;
+                j < best_pos + best_len - k + 1; ++j)
+            weight_[ids[j]] = 0;
+        return samples_[best_sample].substr(best_pos, best_len);
+    }
+};
+
+} // detail
+
+template<class ForwardIterator>
+std::string
+train_dictionary(
+    ForwardIterator first,
+    ForwardIterator last,
+    std::size_t size)
+{
+    static_assert(std::is_convertible<typename
+        std::iterator_traits<ForwardIterator>::value_type,
+            string_view>::value,
+        "ForwardIterator value type requirements not met");
+    detail::dictionary_trainer t;
+    for(; first != last; ++first)
+        t.insert(*first);
+    return t.train(size);
+}
+
+} // zlib
+} // beast
+
+#endif
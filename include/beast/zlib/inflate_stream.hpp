@@ -70,6 +70,43 @@ public:
     */
     inflate_stream() = default;
 
+    /** Construct a raw deflate decompression stream using an allocator.
+
+        The window size is set to the default of 15 bits. The
+        sliding window is obtained from a copy of the specified
+        allocator, which may be used to draw the memory from an
+        arena or pool. The allocator is type-erased; the amount
+        of memory requested may be computed ahead of time using
+        @ref memory_size.
+
+        @param alloc The allocator to use. It must meet the
+        requirements of @b Allocator.
+    */
+    template<class Allocator>
+    explicit
+    inflate_stream(Allocator const& alloc)
+        : detail::inflate_stream(alloc)
+    {
+    }
+
+    /** Returns the dynamic memory needed for the given window size.
+
+        This function returns the number of bytes which the stream
+        allocates for its sliding window when using the specified
+        window size. All other state is stored in the stream object
+        itself, whose size is `sizeof(inflate_stream)`.
+
+        @param windowBits The base two logarithm of the window size.
+
+        @throws std::domain_error if the window size is out of range.
+    */
+    static
+    std::size_t
+    memory_size(int windowBits)
+    {
+        return doMemorySize(windowBits);
+    }
+
     /** Reset the stream.
 
         This puts the stream in a newly constructed state with
@@ -96,7 +133,10 @@ public:
 
     /** Put the stream in a newly constructed state.
 
-        All dynamically allocated memory is de-allocated.
+        All dynamically allocated memory is de-allocated. The
+        window size and the allocator are left unchanged. This
+        may be used to release the sliding window between
+        independent messages; it is allocated again when needed.
     */
     void
     clear()
@@ -104,6 +144,28 @@ public:
         doClear();
     }
 
+    /** Set a preset dictionary.
+
+        This function places the given bytes in the sliding window,
+        as if they had been decompressed immediately before the
+        next output. It must be given the same dictionary which was
+        used by the compressor, and called after construction or a
+        reset, before the first call to @ref write. Only the last
+        bytes which fit in the window are used.
+
+        @param dict A pointer to the dictionary.
+
+        @param size The size of the dictionary.
+
+        @see deflate_stream::dictionary
+    */
+    void
+    dictionary(void const* dict, std::size_t size)
+    {
+        doDictionary(static_cast<Byte const*>(dict),
+            static_cast<uInt>(size));
+    }
+
     /** Decompress input and produce output.
 
         This function decompresses as much data as possible, and stops when
@@ -208,7 +270,34 @@ public:
     void
     write(z_params& zs, Flush flush, error_code& ec)
     {
-        doWrite(zs, flush, ec);
+        doWrite(zs, flush, false, ec);
+    }
+
+    /** Decompress the final input of a message.
+
+        This function behaves as @ref write, except that if all of
+        the input is consumed and there is space remaining in the
+        output buffer, the output produced by this call is not added
+        to the sliding window. This avoids allocating and filling
+        the window for messages which are decompressed in a single
+        call, such as small messages fitting in the output buffer.
+
+        If input remains or the output buffer was filled, the window
+        is updated as usual so that `write` or `write_final` may be
+        called again to continue decompression.
+
+        The caller is responsible for ensuring that no input provided
+        after this call refers back to output produced before it. For
+        example, this is the case for the last input of a message when
+        the stream is reset or cleared before the next message, as
+        with WebSocket permessage-deflate without context takeover.
+
+        @see write
+    */
+    void
+    write_final(z_params& zs, Flush flush, error_code& ec)
+    {
+        doWrite(zs, flush, true, ec);
     }
 };
 
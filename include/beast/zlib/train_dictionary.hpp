@@ -0,0 +1,63 @@
+//
+// Copyright (c) 2016-2017 Vinnie Falco (vinnie dot falco at gmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/boostorg/beast
+//
+
+#ifndef BEAST_ZLIB_TRAIN_DICTIONARY_HPP
+#define BEAST_ZLIB_TRAIN_DICTIONARY_HPP
+
+#include <beast/core/detail/config.hpp>
+#include <beast/core/string.hpp>
+#include <cstdlib>
+#include <string>
+
+namespace beast {
+namespace zlib {
+
+/** Build a preset dictionary from sample messages.
+
+    This function selects the pieces of the samples which contain
+    the most strings shared by many different samples, and returns
+    them concatenated with the most valuable piece at the end,
+    where the compressor encodes references to it most cheaply.
+    The result may be used with @ref deflate_dictionary,
+    @ref deflate_stream::dictionary and
+    @ref inflate_stream::dictionary.
+
+    The samples should be representative of the messages to be
+    compressed; a few hundred to a few thousand of them is usually
+    enough. The running time is proportional to the total size of
+    the samples multiplied by the size of the dictionary, so this
+    is meant to be run ahead of time rather than on a live path.
+
+    @param first An iterator to the first sample.
+
+    @param last An iterator to one past the last sample.
+
+    @param size The maximum size of the dictionary. Dictionaries
+    larger than the window size of the compressor are not useful,
+    for short messages a few kilobytes are typical.
+
+    @return The dictionary, which is empty if the samples have
+    nothing in common.
+
+    @tparam ForwardIterator An iterator whose value type is
+    convertible to @ref string_view.
+*/
+template<class ForwardIterator>
+std::string
+train_dictionary(
+    ForwardIterator first,
+    ForwardIterator last,
+    std::size_t size);
+
+} // zlib
+} // beast
+
+#include <beast/zlib/impl/train_dictionary.ipp>
+
+#endif
@@ -0,0 +1,221 @@
+//
+// Copyright (c) 2016-2017 Vinnie Falco (vinnie dot falco at gmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/boostorg/beast
+//
+
+// Test that header file is self-contained.
+#include <beast/core/buffer_pool.hpp>
+
+#include <beast/core/buffers_to_string.hpp>
+#include <beast/core/flat_buffer.hpp>
+#include <beast/core/multi_buffer.hpp>
+#include <beast/core/ostream.hpp>
+#include <beast/http/fields.hpp>
+#include <beast/unit_test/suite.hpp>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+namespace beast {
+
+class buffer_pool_test : public beast::unit_test::suite
+{
+public:
+    static
+    bool
+    is_aligned(void* p)
+    {
+        return reinterpret_cast<std::uintptr_t>(p) %
+            alignof(std::max_align_t) == 0;
+    }
+
+    void
+    testPool()
+    {
+        auto const s0 = buffer_pool::stats();
+
+        // Blocks of the same size class are reused
+        auto const p1 = buffer_pool::allocate(100);
+        BEAST_EXPECT(is_aligned(p1));
+        std::memset(p1, 0, 128);
+        buffer_pool::deallocate(p1, 100);
+        auto const p2 = buffer_pool::allocate(128);
+        BEAST_EXPECT(p2 == p1);
+        auto const p3 = buffer_pool::allocate(65);
+        BEAST_EXPECT(p3 != p2);
+        BEAST_EXPECT(is_aligned(p3));
+        buffer_pool::deallocate(p3, 65);
+        buffer_pool::deallocate(p2, 128);
+
+        // Every size class
+        std::vector<void*> v;
+        for(std::size_t n = 0; n <= buffer_pool::max_size;
+            n = n ? n * 2 : 1)
+        {
+            auto const p = buffer_pool::allocate(n);
+            BEAST_EXPECT(is_aligned(p));
+            std::memset(p, 'x', n);
+            v.push_back(p);
+        }
+        for(std::size_t i = 0, n = 0; i < v.size();
+                ++i, n = n ? n * 2 : 1)
+            buffer_pool::deallocate(v[i], n);
+
+        // Larger than max_size
+        auto const n = buffer_pool::max_size + 1;
+        auto const p4 = buffer_pool::allocate(n);
+        std::memset(p4, 0, n);
+        buffer_pool::deallocate(p4, n);
+
+        auto const s1 = buffer_pool::stats();
+        BEAST_EXPECT(s1.allocations - s0.allocations == 26);
+        BEAST_EXPECT(s1.deallocations - s0.deallocations == 26);
+        BEAST_EXPECT(s1.cache_hits - s0.cache_hits >= 1);
+        BEAST_EXPECT(s1.large_allocations - s0.large_allocations == 1);
+        BEAST_EXPECT(s1.bytes_in_use == s0.bytes_in_use);
+        BEAST_EXPECT(s1.bytes_reserved >= buffer_pool::slab_size);
+        BEAST_EXPECT(s1.bytes_reserved % buffer_pool::slab_size == 0);
+    }
+
+    void
+    testThreads()
+    {
+        auto const s0 = buffer_pool::stats();
+        std::size_t const count = 4;
+        std::size_t const blocks = 1000;
+
+        // Blocks allocated on one thread are
+        // deallocated on another.
+        std::vector<std::vector<void*>> v(count);
+        {
+            std::vector<std::thread> threads;
+            for(std::size_t i = 0; i < count; ++i)
+                threads.emplace_back(
+                    [&v, i, blocks]
+                    {
+                        for(std::size_t j = 0; j < blocks; ++j)
+                        {
+                            auto const p = buffer_pool::allocate(512);
+                            std::memset(p, static_cast<int>(i), 512);
+                            v[i].push_back(p);
+                        }
+                    });
+            for(auto& t : threads)
+                t.join();
+        }
+        auto const s1 = buffer_pool::stats();
+        BEAST_EXPECT(s1.allocations - s0.allocations == count * blocks);
+        BEAST_EXPECT(s1.bytes_in_use - s0.bytes_in_use ==
+            count * blocks * 512);
+        {
+            std::vector<std::thread> threads;
+            for(std::size_t i = 0; i < count; ++i)
+                threads.emplace_back(
+                    [&v, i, count]
+                    {
+                        for(auto p : v[(i + 1) % count])
+                            buffer_pool::deallocate(p, 512);
+                    });
+            for(auto& t : threads)
+                t.join();
+        }
+        auto const s2 = buffer_pool::stats();
+        BEAST_EXPECT(s2.deallocations - s0.deallocations ==
+            count * blocks);
+        BEAST_EXPECT(s2.bytes_in_use == s0.bytes_in_use);
+        BEAST_EXPECT(s2.depot_transfers > s0.depot_transfers);
+
+        // Blocks left by the exited threads are reused
+        // instead of carving new slab memory.
+        std::vector<void*> w;
+        for(std::size_t i = 0; i < count * blocks; ++i)
+            w.push_back(buffer_pool::allocate(512));
+        for(auto p : w)
+            buffer_pool::deallocate(p, 512);
+        auto const s3 = buffer_pool::stats();
+        BEAST_EXPECT(s3.bytes_reserved == s2.bytes_reserved);
+    }
+
+    void
+    testHugePages()
+    {
+        buffer_pool::huge_pages(true);
+        // Use enough memory to require a new slab
+        std::vector<void*> v;
+        auto const s0 = buffer_pool::stats();
+        for(std::size_t i = 0; i < 4; ++i)
+        {
+            auto const p = buffer_pool::allocate(
+                buffer_pool::max_size);
+            std::memset(p, 0, buffer_pool::max_size);
+            v.push_back(p);
+        }
+        auto const s1 = buffer_pool::stats();
+        BEAST_EXPECT(s1.bytes_reserved > s0.bytes_reserved);
+        BEAST_EXPECT(s1.bytes_huge_pages <= s1.bytes_reserved);
+        for(auto p : v)
+            buffer_pool::deallocate(p, buffer_pool::max_size);
+        buffer_pool::huge_pages(false);
+    }
+
+    void
+    testAllocator()
+    {
+        pool_allocator<char> a1;
+        pool_allocator<int> a2{a1};
+        BEAST_EXPECT(a1 == a2);
+        BEAST_EXPECT(! (a1 != a2));
+
+        auto const s0 = buffer_pool::stats();
+        {
+            basic_flat_buffer<pool_allocator<char>> b;
+            ostream(b) << "Hello, world!";
+            BEAST_EXPECT(buffers_to_string(b.data()) == "Hello, world!");
+            b.consume(7);
+            b.shrink_to_fit();
+            BEAST_EXPECT(buffers_to_string(b.data()) == "world!");
+            auto b2 = b;
+            BEAST_EXPECT(buffers_to_string(b2.data()) == "world!");
+        }
+        {
+            basic_multi_buffer<pool_allocator<char>> b;
+            for(int i = 0; i < 100; ++i)
+                ostream(b) << std::string(100, 'a' + i % 26);
+            BEAST_EXPECT(b.size() == 10000);
+            b.consume(5000);
+            BEAST_EXPECT(b.size() == 5000);
+        }
+        {
+            http::basic_fields<pool_allocator<char>> f;
+            f.insert(http::field::user_agent, "test");
+            f.insert("X-Custom", "value");
+            BEAST_EXPECT(f[http::field::user_agent] == "test");
+            BEAST_EXPECT(f["X-Custom"] == "value");
+            f.erase("X-Custom");
+            BEAST_EXPECT(f.count("X-Custom") == 0);
+        }
+        auto const s1 = buffer_pool::stats();
+        BEAST_EXPECT(s1.allocations > s0.allocations);
+        BEAST_EXPECT(s1.allocations - s0.allocations ==
+            s1.deallocations - s0.deallocations);
+        BEAST_EXPECT(s1.bytes_in_use == s0.bytes_in_use);
+    }
+
+    void
+    run() override
+    {
+        testPool();
+        testThreads();
+        testHugePages();
+        testAllocator();
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(beast,core,buffer_pool);
+
+} // beast
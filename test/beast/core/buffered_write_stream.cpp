@@ -0,0 +1,397 @@
+//
+// Copyright (c) 2016-2017 Vinnie Falco (vinnie dot falco at gmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/boostorg/beast
+//
+
+// Test that header file is self-contained.
+#include <beast/core/buffered_write_stream.hpp>
+
+#include <beast/core/flat_buffer.hpp>
+#include <beast/core/multi_buffer.hpp>
+#include <beast/experimental/test/stream.hpp>
+#include <beast/http/string_body.hpp>
+#include <beast/http/write.hpp>
+#include <beast/unit_test/suite.hpp>
+#include <asio/buffer.hpp>
+#include <asio/io_context.hpp>
+#include <string>
+
+namespace beast {
+
+class buffered_write_stream_test : public unit_test::suite
+{
+public:
+    using stream_type =
+        buffered_write_stream<test::stream, flat_buffer>;
+
+    // Writes the pieces of a string one after the
+    // other, each from the handler of the previous.
+    struct writer
+    {
+        buffered_write_stream<
+            test::stream&, multi_buffer>& s;
+        std::string const& v;
+        std::size_t step;
+        std::size_t pos;
+        std::size_t* n;
+
+        void
+        operator()(error_code ec, std::size_t bytes_transferred)
+        {
+            if(ec)
+                return;
+            pos += bytes_transferred;
+            if(pos >= v.size())
+            {
+                ++*n;
+                return;
+            }
+            s.async_write_some(asio::buffer(v.data() + pos,
+                (std::min)(step, v.size() - pos)), *this);
+        }
+    };
+
+    void
+    testSpecialMembers()
+    {
+        asio::io_context ioc;
+        {
+            stream_type bws(ioc);
+            stream_type bws2(std::move(bws));
+            bws = std::move(bws2);
+            BEAST_EXPECT(&bws.get_executor().context() == &ioc);
+            BEAST_EXPECT(! bws.auto_flush());
+            bws.auto_flush(true);
+            BEAST_EXPECT(bws.auto_flush());
+        }
+        {
+            test::stream ts{ioc};
+            buffered_write_stream<test::stream&, flat_buffer> bws(ts);
+            BEAST_EXPECT(&bws.next_layer() == &ts);
+        }
+    }
+
+    void
+    testWrite()
+    {
+        using asio::buffer;
+        asio::io_context ioc;
+
+        // small writes are coalesced
+        {
+            test::stream tr{ioc};
+            stream_type bws{ioc};
+            bws.next_layer().connect(tr);
+            bws.capacity(100);
+            error_code ec;
+            std::string s;
+            for(int i = 0; i < 10; ++i)
+            {
+                std::string const v(5, static_cast<char>('a' + i));
+                BEAST_EXPECT(bws.write_some(buffer(v), ec) == 5);
+                BEAST_EXPECTS(! ec, ec.message());
+                s += v;
+            }
+            BEAST_EXPECT(bws.next_layer().nwrite() == 0);
+            BEAST_EXPECT(bws.buffer().size() == 50);
+            BEAST_EXPECT(tr.str().empty());
+
+            // exceeds the capacity
+            std::string const v(60, '*');
+            BEAST_EXPECT(bws.write_some(buffer(v), ec) == 60);
+            BEAST_EXPECTS(! ec, ec.message());
+            s += v;
+            BEAST_EXPECT(bws.next_layer().nwrite() == 1);
+            BEAST_EXPECT(bws.buffer().size() == 0);
+            BEAST_EXPECT(tr.str() == s);
+
+            // flush
+            bws.flush(ec);
+            BEAST_EXPECTS(! ec, ec.message());
+            BEAST_EXPECT(bws.next_layer().nwrite() == 1);
+            bws.write_some(buffer("Hello", 5));
+            bws.flush();
+            s += "Hello";
+            BEAST_EXPECT(bws.next_layer().nwrite() == 2);
+            BEAST_EXPECT(tr.str() == s);
+        }
+
+        // partial writes by the next layer
+        {
+            test::stream tr{ioc};
+            stream_type bws{ioc};
+            bws.next_layer().connect(tr);
+            bws.next_layer().write_size(7);
+            bws.capacity(10);
+            std::string s;
+            for(int i = 0; i < 26; ++i)
+                s.append(static_cast<std::size_t>(i % 13),
+                    static_cast<char>('a' + i));
+            std::size_t pos = 0;
+            std::size_t i = 0;
+            error_code ec;
+            while(pos < s.size())
+            {
+                auto const n = (std::min)(
+                    1 + i++ % 13, s.size() - pos);
+                auto const bytes_transferred = bws.write_some(
+                    buffer(s.data() + pos, n), ec);
+                if(! BEAST_EXPECTS(! ec, ec.message()))
+                    break;
+                BEAST_EXPECT(bytes_transferred > 0);
+                BEAST_EXPECT(bws.buffer().size() <= 10);
+                pos += bytes_transferred;
+            }
+            bws.flush(ec);
+            BEAST_EXPECTS(! ec, ec.message());
+            BEAST_EXPECT(tr.str() == s);
+        }
+
+        // unbuffered
+        {
+            test::stream tr{ioc};
+            stream_type bws{ioc};
+            bws.next_layer().connect(tr);
+            bws.capacity(0);
+            bws.write_some(buffer("Hello", 5));
+            BEAST_EXPECT(bws.next_layer().nwrite() == 1);
+            BEAST_EXPECT(tr.str() == "Hello");
+        }
+
+        // failure
+        {
+            test::fail_count fc{1};
+            test::stream ts{ioc, fc};
+            test::stream tr{ioc};
+            ts.connect(tr);
+            buffered_write_stream<test::stream&, flat_buffer> bws(ts);
+            error_code ec;
+            bws.write_some(buffer("Hello", 5), ec);
+            BEAST_EXPECTS(! ec, ec.message());
+            bws.flush(ec);
+            BEAST_EXPECT(ec == test::error::test_failure);
+            BEAST_EXPECT(bws.buffer().size() == 5);
+            try
+            {
+                bws.flush();
+                fail("", __FILE__, __LINE__);
+            }
+            catch(system_error const& se)
+            {
+                BEAST_EXPECT(se.code() == test::error::test_failure);
+            }
+        }
+    }
+
+    void
+    testAsyncWrite()
+    {
+        using asio::buffer;
+        std::string s;
+        for(int i = 0; i < 1000; ++i)
+            s.push_back(static_cast<char>('a' + i % 26));
+
+        // explicit flush
+        {
+            asio::io_context ioc;
+            test::stream ts{ioc};
+            test::stream tr{ioc};
+            ts.connect(tr);
+            buffered_write_stream<test::stream&, multi_buffer> bws(ts);
+            bws.capacity(2000);
+            std::size_t n = 0;
+            bws.async_write_some(buffer(s), writer{bws, s, 10, 0, &n});
+            BEAST_EXPECT(n == 0);
+            ioc.run();
+            ioc.restart();
+            BEAST_EXPECT(n == 1);
+            BEAST_EXPECT(ts.nwrite() == 0);
+            bws.async_flush(
+                [&](error_code ec)
+                {
+                    BEAST_EXPECTS(! ec, ec.message());
+                    ++n;
+                });
+            BEAST_EXPECT(n == 1);
+            ioc.run();
+            BEAST_EXPECT(n == 2);
+            BEAST_EXPECT(ts.nwrite() == 1);
+            BEAST_EXPECT(tr.str() == s);
+        }
+
+        // size threshold
+        {
+            asio::io_context ioc;
+            test::stream ts{ioc};
+            test::stream tr{ioc};
+            ts.connect(tr);
+            ts.write_size(150);
+            buffered_write_stream<test::stream&, multi_buffer> bws(ts);
+            bws.capacity(100);
+            std::size_t n = 0;
+            writer{bws, s, 7, 0, &n}({}, 0);
+            ioc.run();
+            ioc.restart();
+            BEAST_EXPECT(n == 1);
+            BEAST_EXPECT(ts.nwrite() < 20);
+            BEAST_EXPECT(bws.buffer().size() <= 100);
+            bws.async_flush(
+                [&](error_code ec)
+                {
+                    BEAST_EXPECTS(! ec, ec.message());
+                    ++n;
+                });
+            ioc.run();
+            BEAST_EXPECT(n == 2);
+            BEAST_EXPECT(tr.str() == s);
+        }
+
+        // automatic flush
+        {
+            asio::io_context ioc;
+            test::stream ts{ioc};
+            test::stream tr{ioc};
+            ts.connect(tr);
+            buffered_write_stream<test::stream&, multi_buffer> bws(ts);
+            bws.capacity(2000);
+            bws.auto_flush(true);
+            std::size_t n = 0;
+            writer{bws, s, 10, 0, &n}({}, 0);
+            ioc.run();
+            ioc.restart();
+            BEAST_EXPECT(n == 1);
+            BEAST_EXPECT(ts.nwrite() == 1);
+            BEAST_EXPECT(bws.buffer().size() == 0);
+            BEAST_EXPECT(tr.str() == s);
+
+            // a write made while the flush is in progress waits for it
+            tr.clear();
+            bws.async_write_some(buffer("Hello", 5),
+                [&](error_code ec, std::size_t bytes_transferred)
+                {
+                    BEAST_EXPECTS(! ec, ec.message());
+                    BEAST_EXPECT(bytes_transferred == 5);
+                });
+            ioc.run_one(); // completion
+            ioc.run_one(); // automatic flush
+            BEAST_EXPECT(ts.nwrite() == 2);
+            BEAST_EXPECT(bws.buffer().size() == 5);
+            bws.async_write_some(buffer(", world!", 8),
+                [&](error_code ec, std::size_t bytes_transferred)
+                {
+                    BEAST_EXPECTS(! ec, ec.message());
+                    BEAST_EXPECT(bytes_transferred == 8);
+                    BEAST_EXPECT(tr.str() == "Hello");
+                    ++n;
+                });
+            ioc.run();
+            BEAST_EXPECT(n == 2);
+            BEAST_EXPECT(ts.nwrite() == 3);
+            BEAST_EXPECT(bws.buffer().size() == 0);
+            BEAST_EXPECT(tr.str() == "Hello, world!");
+        }
+
+        // failure in the automatic flush
+        {
+            asio::io_context ioc;
+            test::fail_count fc{1};
+            test::stream ts{ioc, fc};
+            test::stream tr{ioc};
+            ts.connect(tr);
+            buffered_write_stream<test::stream&, multi_buffer> bws(ts);
+            bws.auto_flush(true);
+            bws.async_write_some(buffer("Hello", 5),
+                [&](error_code ec, std::size_t bytes_transferred)
+                {
+                    BEAST_EXPECTS(! ec, ec.message());
+                    BEAST_EXPECT(bytes_transferred == 5);
+                });
+            ioc.run();
+            ioc.restart();
+            bool invoked = false;
+            bws.async_write_some(buffer("Hello", 5),
+                [&](error_code ec, std::size_t)
+                {
+                    BEAST_EXPECT(ec == test::error::test_failure);
+                    invoked = true;
+                });
+            ioc.run();
+            BEAST_EXPECT(invoked);
+        }
+    }
+
+    void
+    testHttp()
+    {
+        asio::io_context ioc;
+
+        // http::write
+        {
+            http::response<http::string_body> res;
+            res.version(11);
+            res.result(http::status::ok);
+            res.set(http::field::server, "test");
+            res.body() = std::string(100, '*');
+            res.prepare_payload();
+
+            test::stream tr{ioc};
+            stream_type bws{ioc};
+            bws.next_layer().connect(tr);
+            error_code ec;
+            for(int i = 0; i < 5; ++i)
+            {
+                http::write(bws, res, ec);
+                BEAST_EXPECTS(! ec, ec.message());
+            }
+            bws.flush(ec);
+            BEAST_EXPECTS(! ec, ec.message());
+            BEAST_EXPECT(bws.next_layer().nwrite() == 1);
+
+            test::stream tr2{ioc};
+            test::stream ts{ioc};
+            ts.connect(tr2);
+            for(int i = 0; i < 5; ++i)
+                http::write(ts, res);
+            BEAST_EXPECT(tr.str() == tr2.str());
+
+            tr.clear();
+            bws.auto_flush(true);
+            bws.next_layer().write_size(300);
+            int n = 0;
+            http::async_write(bws, res,
+                [&](error_code ec, std::size_t)
+                {
+                    BEAST_EXPECTS(! ec, ec.message());
+                    http::async_write(bws, res,
+                        [&](error_code ec, std::size_t)
+                        {
+                            BEAST_EXPECTS(! ec, ec.message());
+                            ++n;
+                        });
+                });
+            ioc.run();
+            ioc.restart();
+            BEAST_EXPECT(n == 1);
+            BEAST_EXPECT(tr.str().size() ==
+                2 * tr2.str().size() / 5);
+        }
+
+    }
+
+    void
+    run() override
+    {
+        testSpecialMembers();
+        testWrite();
+        testAsyncWrite();
+        testHttp();
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(beast,core,buffered_write_stream);
+
+} // beast
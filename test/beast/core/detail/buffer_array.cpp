@@ -0,0 +1,156 @@
+//
+// Copyright (c) 2016-2017 Vinnie Falco (vinnie dot falco at gmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+// Test that header file is self-contained.
+#include <beast/core/detail/buffer_array.hpp>
+
+#include <beast/core/buffers_cat.hpp>
+#include <beast/core/buffers_prefix.hpp>
+#include <beast/core/buffers_suffix.hpp>
+#include <beast/core/buffers_to_string.hpp>
+#include <beast/core/detail/buffers_ref.hpp>
+#include <beast/core/multi_buffer.hpp>
+#include <beast/core/ostream.hpp>
+#include <beast/unit_test/suite.hpp>
+#include <array>
+#include <iterator>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace beast {
+namespace detail {
+
+class buffer_array_test : public beast::unit_test::suite
+{
+public:
+    // The non-empty buffers of a sequence, found by iterating
+    template<class ConstBufferSequence>
+    static
+    std::vector<asio::const_buffer>
+    expected(ConstBufferSequence const& buffers, std::size_t n)
+    {
+        std::vector<asio::const_buffer> v;
+        for(auto it = asio::buffer_sequence_begin(buffers);
+            it != asio::buffer_sequence_end(buffers) && v.size() < n;
+                ++it)
+        {
+            asio::const_buffer const b = *it;
+            if(b.size() > 0)
+                v.push_back(b);
+        }
+        return v;
+    }
+
+    template<std::size_t N, class ConstBufferSequence>
+    void
+    check(ConstBufferSequence const& buffers)
+    {
+        buffer_array<N> const a{buffers};
+        auto const v = expected(buffers, N);
+        if(! BEAST_EXPECT(static_cast<std::size_t>(
+                std::distance(a.begin(), a.end())) == v.size()))
+            return;
+        auto it = a.begin();
+        for(auto const& b : v)
+        {
+            BEAST_EXPECT(it->data() == b.data());
+            BEAST_EXPECT(it->size() == b.size());
+            ++it;
+        }
+    }
+
+    template<class ConstBufferSequence>
+    void
+    check(ConstBufferSequence const& buffers)
+    {
+        check<1>(buffers);
+        check<3>(buffers);
+        check<64>(buffers);
+    }
+
+    void
+    testViews()
+    {
+        std::string const s = "Hello, world!";
+        asio::const_buffer const b0;
+        asio::const_buffer const b1{s.data(), 5};
+        asio::const_buffer const b2{s.data() + 5, 2};
+        asio::const_buffer const b3{s.data() + 7, 6};
+        std::array<asio::const_buffer, 3> const a1{{b1, b0, b2}};
+
+        check(b1);
+        check(b0);
+        check(a1);
+        check(asio::buffer(&s[0], s.size()));
+        check(make_buffers_ref(a1));
+
+        auto const c1 = buffers_cat(b1, b0, b2, b3);
+        auto const c2 = buffers_cat(a1, b0, c1, b3);
+        using c2_t = std::decay<decltype(c2)>::type;
+        using a1_t = std::decay<decltype(a1)>::type;
+        check(c1);
+        check(c2);
+        check(make_buffers_ref(c2));
+
+        // every prefix and suffix
+        for(std::size_t i = 0; i <= 2 * s.size() + 1; ++i)
+        {
+            check(beast::buffers_prefix(i, c2));
+            check(buffers_cat(b3, beast::buffers_prefix(i, c2), b1));
+            check(buffers_cat(beast::buffers_prefix(i, a1),
+                beast::buffers_prefix(i, c1)));
+            buffers_suffix<c2_t> cb{c2};
+            cb.consume(i);
+            check(cb);
+            check(beast::buffers_prefix(i / 2, cb));
+            buffers_suffix<a1_t> cb1{a1};
+            cb1.consume(i);
+            check(cb1);
+            check(buffers_cat(b2, cb1));
+        }
+
+        // dynamic buffer sequences
+        multi_buffer b;
+        for(int i = 0; i < 10; ++i)
+            ostream(b) << std::string(1000, 'a' + i);
+        check(b.data());
+        check(buffers_cat(b1, b.data(), b2));
+        check(beast::buffers_prefix(4321, b.data()));
+    }
+
+    void
+    testCopy()
+    {
+        std::string const s = "Hello, world!";
+        auto const c = buffers_cat(
+            asio::const_buffer{s.data(), 5},
+            asio::const_buffer{s.data() + 5, 8});
+        buffer_array<4> a1{c};
+        BEAST_EXPECT(buffers_to_string(a1) == s);
+        auto a2 = a1;
+        BEAST_EXPECT(buffers_to_string(a2) == s);
+        a2 = buffer_array<4>{};
+        BEAST_EXPECT(buffers_to_string(a2).empty());
+        a2 = a1;
+        BEAST_EXPECT(buffers_to_string(a2) == s);
+        a2.assign(beast::buffers_prefix(3, c));
+        BEAST_EXPECT(buffers_to_string(a2) == "Hel");
+    }
+
+    void
+    run() override
+    {
+        testViews();
+        testCopy();
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(beast,core,buffer_array);
+
+} // detail
+} // beast
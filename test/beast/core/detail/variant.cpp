@@ -438,10 +438,37 @@ public:
         BEAST_EXPECT(Q<1>::count() == 0);
     }
 
+    void
+    testTrivial()
+    {
+        BOOST_STATIC_ASSERT(is_variant_trivial<int, char const*>::value);
+        BOOST_STATIC_ASSERT(! is_variant_trivial<int, std::string>::value);
+
+        variant<int, char const*> v;
+        v.emplace<2>("Hello");
+        auto v1 = v;
+        BEAST_EXPECT(v1.index() == 2);
+        BEAST_EXPECT(v1 == v);
+        v.emplace<1>(42);
+        v1 = v;
+        BEAST_EXPECT(v1.index() == 1);
+        BEAST_EXPECT(v1.get<1>() == 42);
+        auto v2 = std::move(v1);
+        BEAST_EXPECT(v1.index() == 0);
+        BEAST_EXPECT(v2.get<1>() == 42);
+        v1 = std::move(v2);
+        BEAST_EXPECT(v2.index() == 0);
+        BEAST_EXPECT(v1.get<1>() == 42);
+        v1.reset();
+        BEAST_EXPECT(v1.index() == 0);
+        BEAST_EXPECT(v1 == v2);
+    }
+
     void
     run()
     {
         testVariant();
+        testTrivial();
     }
 };
 
@@ -341,10 +341,185 @@ public:
         }
     }
 
+    void
+    testPolicy()
+    {
+        // defaults
+        {
+            flat_buffer b;
+            BEAST_EXPECT(b.policy().growth_factor == 0);
+            BEAST_EXPECT(b.policy().compact_ratio == 0);
+            BEAST_EXPECT(b.policy().shrink_after == 0);
+        }
+
+        // geometric growth
+        {
+            flat_buffer_policy policy;
+            policy.growth_factor = 2;
+            flat_buffer b;
+            b.policy(policy);
+            std::string const s(1000, '*');
+            b.commit(asio::buffer_copy(
+                b.prepare(1000), asio::buffer(s)));
+            BEAST_EXPECT(b.capacity() == 1000);
+            b.consume(900);
+            b.prepare(1500);
+            BEAST_EXPECT(b.capacity() == 2000);
+            BEAST_EXPECT(buffers_to_string(b.data()) ==
+                std::string(100, '*'));
+            b.commit(1500);
+            b.consume(1500);
+            b.prepare(2500);
+            BEAST_EXPECT(b.capacity() == 4000);
+            BEAST_EXPECT(b.size() == 100);
+
+            // limited by max_size
+            flat_buffer b2{3000};
+            b2.policy(policy);
+            b2.commit(b2.prepare(1000).size());
+            b2.consume(900);
+            b2.commit(b2.prepare(1500).size());
+            BEAST_EXPECT(b2.capacity() == 2000);
+            b2.commit(b2.prepare(1300).size());
+            BEAST_EXPECT(b2.capacity() == 3000);
+            try
+            {
+                b2.prepare(101);
+                fail("", __FILE__, __LINE__);
+            }
+            catch(std::length_error const&)
+            {
+                pass();
+            }
+        }
+
+        // lazy compaction
+        {
+            flat_buffer_policy policy;
+            policy.compact_ratio = 0.5f;
+            flat_buffer b;
+            b.policy(policy);
+            std::string const s = std::string(1000, 'a') + "bcd";
+            b.commit(asio::buffer_copy(
+                b.prepare(2000), asio::buffer(s)));
+            auto const p = b.data().data();
+            b.consume(900);
+
+            // read_size asks only for the space after the data
+            BEAST_EXPECT(read_size(b, 65536) == 997);
+            b.commit(b.prepare(read_size(b, 65536)).size());
+            BEAST_EXPECT(b.capacity() == 2000);
+            BEAST_EXPECT(b.size() == 1100);
+            b.consume(1097);
+
+            // the space before the data is now large enough
+            BEAST_EXPECT(read_size(b, 65536) == 1997);
+            b.prepare(read_size(b, 65536));
+            BEAST_EXPECT(b.capacity() == 2000);
+            BEAST_EXPECT(b.data().data() == p);
+        }
+        {
+            // a prepare which does not fit after the
+            // data reallocates instead of moving it
+            flat_buffer_policy policy;
+            policy.growth_factor = 2;
+            policy.compact_ratio = 0.5f;
+            flat_buffer b;
+            b.policy(policy);
+            std::string const s = std::string(1000, 'a') + "bcd";
+            b.commit(asio::buffer_copy(
+                b.prepare(2000), asio::buffer(s)));
+            b.consume(100);
+            b.prepare(1047);
+            BEAST_EXPECT(b.capacity() == 4000);
+            BEAST_EXPECT(buffers_to_string(b.data()) ==
+                std::string(900, 'a') + "bcd");
+
+            // without growth the data is moved
+            policy.growth_factor = 0;
+            b.policy(policy);
+            b.consume(803);
+            b.commit(b.prepare(100).size());
+            auto const size = b.size();
+            b.prepare(4000 - size);
+            BEAST_EXPECT(b.capacity() == 4000);
+        }
+        {
+            // the data is moved when the buffer cannot grow
+            flat_buffer_policy policy;
+            policy.compact_ratio = 0.5f;
+            flat_buffer b{1000};
+            b.policy(policy);
+            b.commit(b.prepare(1000).size());
+            auto const p = b.data().data();
+            b.consume(100);
+            b.prepare(100);
+            BEAST_EXPECT(b.capacity() == 1000);
+            BEAST_EXPECT(b.data().data() == p);
+        }
+
+        // shrink after idle
+        {
+            flat_buffer_policy policy;
+            policy.shrink_after = 3;
+            flat_buffer b;
+            b.policy(policy);
+            b.commit(b.prepare(4000).size());
+            b.consume(4000);
+            BEAST_EXPECT(b.capacity() == 4000);
+            for(int i = 0; i < 2; ++i)
+            {
+                b.commit(b.prepare(100).size());
+                b.consume(100);
+            }
+            // the period included a large prepare
+            BEAST_EXPECT(b.capacity() == 4000);
+            for(int i = 0; i < 2; ++i)
+            {
+                b.commit(b.prepare(100).size());
+                b.consume(100);
+                BEAST_EXPECT(b.capacity() == 4000);
+            }
+            b.commit(b.prepare(100).size());
+            b.consume(50);
+            BEAST_EXPECT(b.capacity() == 4000);
+            b.consume(50);
+            BEAST_EXPECT(b.capacity() == 0);
+            b.commit(asio::buffer_copy(
+                b.prepare(3), asio::buffer("xyz", 3)));
+            BEAST_EXPECT(buffers_to_string(b.data()) == "xyz");
+        }
+
+        // copy, move and swap
+        {
+            flat_buffer_policy policy;
+            policy.growth_factor = 1.5f;
+            policy.compact_ratio = 0.25f;
+            policy.shrink_after = 8;
+            flat_buffer b1;
+            b1.policy(policy);
+            flat_buffer b2{b1};
+            BEAST_EXPECT(b2.policy().shrink_after == 8);
+            flat_buffer b3{std::move(b2)};
+            BEAST_EXPECT(b3.policy().compact_ratio == 0.25f);
+            flat_buffer b4;
+            b4 = b3;
+            BEAST_EXPECT(b4.policy().growth_factor == 1.5f);
+            flat_buffer b5;
+            b5 = std::move(b4);
+            BEAST_EXPECT(b5.policy().shrink_after == 8);
+            flat_buffer b6;
+            swap(b5, b6);
+            BEAST_EXPECT(b5.policy().shrink_after == 0);
+            BEAST_EXPECT(b6.policy().shrink_after == 8);
+        }
+    }
+
     void
     run() override
     {
         testBuffer();
+        testPolicy();
     }
 };
 
@@ -12,6 +12,7 @@
 
 #include "buffer_test.hpp"
 
+#include <beast/core/buffer_pool.hpp>
 #include <beast/core/ostream.hpp>
 #include <beast/core/string.hpp>
 #include <beast/core/type_traits.hpp>
@@ -580,6 +581,138 @@ public:
         }
     }
 
+    void
+    testPolicy()
+    {
+        using asio::buffer_size;
+        using pool_multi_buffer =
+            basic_multi_buffer<pool_allocator<char>>;
+
+        // Stream data through a buffer holding a steady
+        // amount, and return the number of allocations made.
+        auto const stream =
+            [this](pool_multi_buffer& b, std::size_t rounds)
+            {
+                auto const s0 = buffer_pool::stats();
+                auto s = buffers_to_string(b.data());
+                for(std::size_t i = 0; i < rounds; ++i)
+                {
+                    std::string const t(3000,
+                        static_cast<char>('a' + i % 26));
+                    ostream(b) << t;
+                    s += t;
+                    b.consume(3000);
+                    s.erase(0, 3000);
+                    BEAST_EXPECT(buffers_to_string(b.data()) == s);
+                }
+                return buffer_pool::stats().allocations -
+                    s0.allocations;
+            };
+
+        auto const s0 = buffer_pool::stats();
+
+        // default
+        {
+            pool_multi_buffer b;
+            ostream(b) << std::string(1000, '*');
+            BEAST_EXPECT(b.policy().element_size == 0);
+            BEAST_EXPECT(b.policy().free_elements == 0);
+            stream(b, 10);
+            BEAST_EXPECT(stream(b, 100) > 0);
+        }
+
+        // fixed size elements
+        {
+            multi_buffer_policy policy;
+            policy.element_size = 4096;
+            policy.free_elements = 4;
+            pool_multi_buffer b;
+            b.policy(policy);
+            auto const mb = b.prepare(10000);
+            BEAST_EXPECT(buffer_size(mb) == 10000);
+            BEAST_EXPECT(std::distance(mb.begin(), mb.end()) == 3);
+            for(auto it = mb.begin(); it != mb.end(); ++it)
+                BEAST_EXPECT(buffer_size(*it) < 4096);
+            ostream(b) << std::string(1000, '*');
+            stream(b, 10);
+            BEAST_EXPECT(stream(b, 100) == 0);
+
+            // move and swap keep the elements
+            pool_multi_buffer b2{std::move(b)};
+            BEAST_EXPECT(b2.policy().free_elements == 4);
+            BEAST_EXPECT(stream(b2, 100) == 0);
+            pool_multi_buffer b3;
+            swap(b2, b3);
+            BEAST_EXPECT(b3.policy().element_size == 4096);
+            BEAST_EXPECT(stream(b3, 100) == 0);
+            BEAST_EXPECT(b2.policy().element_size == 0);
+
+            // copies get the policy but not the elements
+            pool_multi_buffer b4{b3};
+            BEAST_EXPECT(b4.policy().element_size == 4096);
+            BEAST_EXPECT(eq(b3, b4));
+
+            // lowering the limit frees kept elements
+            auto const s1 = buffer_pool::stats();
+            b3.consume(b3.size());
+            policy.free_elements = 0;
+            b3.policy(policy);
+            BEAST_EXPECT(buffer_pool::stats().deallocations >
+                s1.deallocations);
+            BEAST_EXPECT(stream(b3, 10) > 0);
+        }
+
+        // adaptive size elements
+        {
+            multi_buffer_policy policy;
+            policy.free_elements = 2;
+            pool_multi_buffer b;
+            b.policy(policy);
+            ostream(b) << std::string(1000, '*');
+            stream(b, 10);
+            BEAST_EXPECT(stream(b, 100) == 0);
+        }
+
+        // switching to fixed size with kept elements
+        {
+            multi_buffer_policy policy;
+            policy.free_elements = 4;
+            pool_multi_buffer b;
+            b.policy(policy);
+            b.commit(buffer_size(b.prepare(100000)));
+            b.consume(b.size());
+            auto const s1 = buffer_pool::stats();
+            BEAST_EXPECT(s1.bytes_in_use - s0.bytes_in_use >= 100000);
+            policy.element_size = 4096;
+            b.policy(policy);
+            BEAST_EXPECT(buffer_pool::stats().bytes_in_use ==
+                s0.bytes_in_use);
+            auto const mb = b.prepare(10000);
+            BEAST_EXPECT(buffer_size(mb) == 10000);
+            for(auto it = mb.begin(); it != mb.end(); ++it)
+                BEAST_EXPECT(buffer_size(*it) < 4096);
+        }
+
+        // an element of the wrong size is not kept
+        {
+            multi_buffer_policy policy;
+            policy.free_elements = 4;
+            pool_multi_buffer b;
+            b.policy(policy);
+            b.commit(buffer_size(b.prepare(100000)));
+            policy.element_size = 4096;
+            b.policy(policy);
+            b.consume(b.size());
+            BEAST_EXPECT(buffer_pool::stats().bytes_in_use ==
+                s0.bytes_in_use);
+            for(std::size_t n : {1, 5000, 10000, 100000})
+                BEAST_EXPECT(buffer_size(b.prepare(n)) == n);
+        }
+
+        BEAST_EXPECT(buffer_pool::stats().bytes_in_use ==
+            s0.bytes_in_use);
+    }
+
     void
     run() override
     {
@@ -587,6 +720,7 @@ public:
         testMatrix2();
         testIterators();
         testMembers();
+        testPolicy();
     }
 };
 
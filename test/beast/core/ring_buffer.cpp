@@ -0,0 +1,239 @@
+//
+// Copyright (c) 2016-2017 Vinnie Falco (vinnie dot falco at gmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/boostorg/beast
+//
+
+// Test that header file is self-contained.
+#include <beast/core/ring_buffer.hpp>
+
+#if BEAST_USE_RING_BUFFER
+
+#include "buffer_test.hpp"
+
+#include <beast/core/buffered_read_stream.hpp>
+#include <beast/core/buffers_to_string.hpp>
+#include <beast/core/read_size.hpp>
+#include <beast/experimental/test/stream.hpp>
+#include <beast/http/read.hpp>
+#include <beast/http/string_body.hpp>
+#include <beast/websocket/stream.hpp>
+#include <beast/unit_test/suite.hpp>
+#include <asio/io_context.hpp>
+#include <string>
+#include <utility>
+
+namespace beast {
+
+BOOST_STATIC_ASSERT(
+    asio::is_dynamic_buffer<ring_buffer>::value);
+
+class ring_buffer_test : public beast::unit_test::suite
+{
+public:
+    void
+    testBuffer()
+    {
+        using namespace test;
+        using asio::buffer_size;
+
+        {
+            ring_buffer b;
+            BEAST_EXPECT(b.size() == 0);
+            BEAST_EXPECT(b.capacity() == 0);
+            BEAST_EXPECT(buffer_size(b.data()) == 0);
+            BEAST_EXPECT(buffer_size(b.prepare(0)) == 0);
+            b.commit(1);
+            BEAST_EXPECT(b.size() == 0);
+        }
+
+        // wrap around the end of the storage
+        {
+            ring_buffer b;
+            b.reserve(1);
+            auto const cap = b.capacity();
+            BEAST_EXPECT(cap > 0);
+            BEAST_EXPECT(cap % 4096 == 0);
+            std::string s;
+            for(std::size_t i = 0; i < cap; ++i)
+                s.push_back(static_cast<char>('a' + i % 26));
+            write_buffer(b, s.substr(0, cap - 10));
+            b.consume(cap - 20);
+            BEAST_EXPECT(b.size() == 10);
+            auto const p = b.data().data();
+
+            // the output sequence crosses the end
+            auto const mb = b.prepare(cap - 20);
+            BEAST_EXPECT(buffer_size(mb) == cap - 20);
+            BEAST_EXPECT(static_cast<char*>(mb.data()) ==
+                static_cast<char const*>(p) + 10);
+            b.commit(asio::buffer_copy(mb, asio::buffer(s)));
+            BEAST_EXPECT(b.capacity() == cap);
+            BEAST_EXPECT(b.size() == cap - 10);
+            BEAST_EXPECT(buffers_to_string(b.data()) ==
+                s.substr(cap - 20, 10) + s.substr(0, cap - 20));
+
+            // the input sequence crosses the end
+            b.consume(20);
+            BEAST_EXPECT(buffers_to_string(b.data()) ==
+                s.substr(10, cap - 30));
+            BEAST_EXPECT(b.data().data() <
+                static_cast<void const*>(p));
+
+            // copy
+            ring_buffer b2{b};
+            BEAST_EXPECT(buffers_to_string(b2.data()) ==
+                s.substr(10, cap - 30));
+            b2 = b;
+            BEAST_EXPECT(buffers_to_string(b2.data()) ==
+                s.substr(10, cap - 30));
+
+            // growing keeps the input sequence
+            b.prepare(cap);
+            BEAST_EXPECT(b.capacity() >= 2 * cap);
+            BEAST_EXPECT(buffers_to_string(b.data()) ==
+                s.substr(10, cap - 30));
+
+            // move
+            ring_buffer b3{std::move(b)};
+            BEAST_EXPECT(b.size() == 0);
+            BEAST_EXPECT(b.capacity() == 0);
+            BEAST_EXPECT(buffers_to_string(b3.data()) ==
+                s.substr(10, cap - 30));
+            b = std::move(b3);
+            BEAST_EXPECT(buffers_to_string(b.data()) ==
+                s.substr(10, cap - 30));
+
+            // consuming everything starts over
+            b.consume(b.size());
+            BEAST_EXPECT(b.size() == 0);
+            b.prepare(1);
+            BEAST_EXPECT(b.data().data() ==
+                b.prepare(1).data());
+        }
+
+        // maximum size
+        {
+            ring_buffer b{100};
+            BEAST_EXPECT(b.max_size() == 100);
+            b.commit(b.prepare(100).size());
+            try
+            {
+                b.prepare(1);
+                fail("", __FILE__, __LINE__);
+            }
+            catch(std::length_error const&)
+            {
+                pass();
+            }
+            try
+            {
+                b.reserve(101);
+                fail("", __FILE__, __LINE__);
+            }
+            catch(std::length_error const&)
+            {
+                pass();
+            }
+            b.consume(1);
+            b.prepare(1);
+            BEAST_EXPECT(read_size(b, 1000) == 1);
+        }
+    }
+
+    void
+    testStreams()
+    {
+        asio::io_context ioc;
+
+        // pipelined messages which wrap around the storage
+        {
+            std::string const req =
+                "POST / HTTP/1.1\r\n"
+                "Content-Length: 1000\r\n"
+                "\r\n" + std::string(1000, '*');
+            std::string s;
+            for(int i = 0; i < 20; ++i)
+                s += req;
+            test::stream ts{ioc, s};
+            ts.read_size(1500);
+            ring_buffer b;
+            b.reserve(4096);
+            for(int i = 0; i < 20; ++i)
+            {
+                http::request<http::string_body> m;
+                error_code ec;
+                http::read(ts, b, m, ec);
+                if(! BEAST_EXPECTS(! ec, ec.message()))
+                    break;
+                BEAST_EXPECT(m.body() == std::string(1000, '*'));
+            }
+            BEAST_EXPECT(b.capacity() == 4096);
+        }
+
+        // buffered_read_stream
+        {
+            std::string const s(10000, 'x');
+            buffered_read_stream<test::stream, ring_buffer> brs{ioc, s};
+            brs.capacity(1000);
+            std::string out;
+            char buf[700];
+            error_code ec;
+            while(out.size() < s.size())
+            {
+                auto const n = brs.read_some(
+                    asio::buffer(buf, sizeof(buf)), ec);
+                if(! BEAST_EXPECTS(! ec, ec.message()))
+                    break;
+                out.append(buf, n);
+            }
+            BEAST_EXPECT(out == s);
+        }
+
+        // websocket::stream
+        {
+            websocket::stream<test::stream> ws{ioc,
+                "GET / HTTP/1.1\r\n"
+                "Host: localhost\r\n"
+                "Upgrade: websocket\r\n"
+                "Connection: upgrade\r\n"
+                "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\n"
+                "Sec-WebSocket-Version: 13\r\n"
+                "\r\n"};
+            test::stream tr{ioc};
+            ws.next_layer().connect(tr);
+            error_code ec;
+            ws.accept(ec);
+            if(BEAST_EXPECTS(! ec, ec.message()))
+            {
+                ws.next_layer().append(string_view{
+                    "\x81\x85\x00\x00\x00\x00" "Hello"
+                    "\x81\x85\x00\x00\x00\x00" "World", 22});
+                ring_buffer b;
+                ws.read(b, ec);
+                BEAST_EXPECTS(! ec, ec.message());
+                BEAST_EXPECT(buffers_to_string(b.data()) == "Hello");
+                b.consume(3);
+                ws.read(b, ec);
+                BEAST_EXPECTS(! ec, ec.message());
+                BEAST_EXPECT(buffers_to_string(b.data()) == "loWorld");
+            }
+        }
+    }
+
+    void
+    run() override
+    {
+        testBuffer();
+        testStreams();
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(beast,core,ring_buffer);
+
+} // beast
+
+#endif
@@ -13,7 +13,11 @@
 #include <beast/test/websocket.hpp>
 #include <beast/test/yield_to.hpp>
 #include <beast/unit_test/suite.hpp>
+#include <array>
+#include <chrono>
+#include <functional>
 #include <initializer_list>
+#include <string>
 #include <vector>
 
 namespace beast {
@@ -23,6 +27,17 @@ class flat_stream_test
     , public test::enable_yield_to
 {
 public:
+    static
+    std::string
+    make_string(std::size_t size)
+    {
+        std::string s;
+        s.reserve(size);
+        for(std::size_t i = 0; i < size; ++i)
+            s.push_back(static_cast<char>('a' + i % 26));
+        return s;
+    }
+
     void
     testSplit()
     {
@@ -56,6 +71,263 @@ public:
         check({1,2,3,4},    3,    3, true);
     }
 
+    void
+    testFill()
+    {
+        auto const check =
+            [&](
+                std::initializer_list<int> v0,
+                std::size_t limit,
+                unsigned long count,
+                bool copy)
+            {
+                std::vector<asio::const_buffer> v;
+                v.reserve(v0.size());
+                for(auto const n : v0)
+                    v.emplace_back("", n);
+                auto const result =
+                    beast::detail::flat_stream_base::fill(v, limit);
+                BEAST_EXPECT(result.first == count);
+                BEAST_EXPECT(result.second == copy);
+                return result;
+            };
+        check({},           1,    0, false);
+        check({1,2},        1,    1, false);
+        check({1,2},        2,    2, true);
+        check({1,2},        3,    3, true);
+        check({1,2},        4,    3, true);
+        check({2,2},        2,    2, false);
+        check({0,2},        1,    1, true);
+        check({1,2,3},      4,    4, true);
+        check({1,2,3},      7,    6, true);
+        check({5,2,3},      4,    4, false);
+    }
+
+    void
+    testRecordSize()
+    {
+        using asio::buffer;
+        auto const s = make_string(5000);
+
+        flat_stream_policy policy;
+        policy.initial_record_size = 100;
+        policy.max_record_size = 1000;
+        policy.ramp_threshold = 1000;
+        policy.idle_timeout = std::chrono::hours(1);
+        std::vector<std::size_t> const sizes{
+            100, 100, 100, 100, 100, 100, 100, 100, 100, 100,
+            1000, 1000, 1000, 1000};
+
+        // ramp up
+        {
+            asio::io_context ioc;
+            test::stream tr{ioc};
+            flat_stream<test::stream> fs{ioc};
+            fs.next_layer().connect(tr);
+            fs.policy(policy);
+            std::vector<std::size_t> v;
+            std::size_t pos = 0;
+            while(pos < s.size())
+            {
+                auto const n = fs.write_some(
+                    buffer(s.data() + pos, s.size() - pos));
+                v.push_back(n);
+                pos += n;
+            }
+            BEAST_EXPECT(v == sizes);
+            BEAST_EXPECT(tr.str() == s);
+
+            // the burst continues
+            BEAST_EXPECT(fs.write_some(buffer(s)) == 1000);
+
+            // the burst starts over after the stream is idle
+            policy.idle_timeout = std::chrono::milliseconds(0);
+            fs.policy(policy);
+            BEAST_EXPECT(fs.write_some(buffer(s)) == 100);
+            policy.idle_timeout = std::chrono::hours(1);
+        }
+
+        // asynchronous
+        {
+            asio::io_context ioc;
+            test::stream tr{ioc};
+            flat_stream<test::stream> fs{ioc};
+            fs.next_layer().connect(tr);
+            fs.policy(policy);
+            std::vector<std::size_t> v;
+            std::size_t pos = 0;
+            std::function<void(error_code, std::size_t)> f =
+                [&](error_code ec, std::size_t n)
+                {
+                    if(! BEAST_EXPECTS(! ec, ec.message()))
+                        return;
+                    v.push_back(n);
+                    pos += n;
+                    if(pos < s.size())
+                        fs.async_write_some(buffer(
+                            s.data() + pos, s.size() - pos), f);
+                };
+            fs.async_write_some(buffer(s), f);
+            ioc.run();
+            BEAST_EXPECT(v == sizes);
+            BEAST_EXPECT(tr.str() == s);
+        }
+
+        // small buffers fill a record
+        {
+            asio::io_context ioc;
+            test::stream tr{ioc};
+            flat_stream<test::stream> fs{ioc};
+            fs.next_layer().connect(tr);
+            fs.policy(policy);
+            std::array<asio::const_buffer, 2> const b{{
+                buffer(s.data(), 10), buffer(s.data() + 10, 500)}};
+            BEAST_EXPECT(fs.write_some(b) == 100);
+            BEAST_EXPECT(tr.str() == s.substr(0, 100));
+        }
+
+        // disabled
+        {
+            asio::io_context ioc;
+            test::stream tr{ioc};
+            flat_stream<test::stream> fs{ioc};
+            fs.next_layer().connect(tr);
+            BEAST_EXPECT(fs.policy().initial_record_size == 1400);
+            policy.initial_record_size = 0;
+            fs.policy(policy);
+            BEAST_EXPECT(fs.write_some(buffer(s)) == s.size());
+            BEAST_EXPECT(tr.str() == s);
+        }
+    }
+
+    void
+    testRead()
+    {
+        using asio::buffer;
+        auto const s = make_string(10000);
+
+        // small reads are served from the internal buffer
+        {
+            asio::io_context ioc;
+            test::stream tr{ioc};
+            flat_stream<test::stream> fs{ioc};
+            fs.next_layer().connect(tr);
+            fs.next_layer().read_size(4000);
+            tr.write_some(buffer(s));
+            tr.close();
+            error_code ec;
+            std::string v;
+            char buf[100];
+            for(;;)
+            {
+                auto const n = fs.read_some(buffer(buf), ec);
+                if(ec)
+                    break;
+                v.append(buf, n);
+            }
+            BEAST_EXPECTS(ec == asio::error::eof, ec.message());
+            BEAST_EXPECT(v == s);
+            BEAST_EXPECT(fs.next_layer().nread() == 4);
+        }
+
+        // asynchronous
+        {
+            asio::io_context ioc;
+            test::stream tr{ioc};
+            flat_stream<test::stream> fs{ioc};
+            fs.next_layer().connect(tr);
+            fs.next_layer().read_size(4000);
+            tr.write_some(buffer(s));
+            tr.close();
+            std::string v;
+            char buf[100];
+            bool invoked = false;
+            std::function<void(error_code, std::size_t)> f =
+                [&](error_code ec, std::size_t n)
+                {
+                    if(ec)
+                    {
+                        BEAST_EXPECTS(ec == asio::error::eof,
+                            ec.message());
+                        invoked = true;
+                        return;
+                    }
+                    v.append(buf, n);
+                    fs.async_read_some(buffer(buf), f);
+                };
+            fs.async_read_some(buffer(buf), f);
+            BEAST_EXPECT(fs.next_layer().nread() == 1);
+            ioc.run();
+            BEAST_EXPECT(invoked);
+            BEAST_EXPECT(v == s);
+            BEAST_EXPECT(fs.next_layer().nread() == 4);
+        }
+
+        // disabled
+        {
+            asio::io_context ioc;
+            test::stream tr{ioc};
+            flat_stream<test::stream> fs{ioc};
+            fs.next_layer().connect(tr);
+            flat_stream_policy policy;
+            policy.read_buffer_size = 0;
+            fs.policy(policy);
+            tr.write_some(buffer(s));
+            std::string v;
+            char buf[100];
+            while(v.size() < s.size())
+                v.append(buf, fs.read_some(buffer(buf)));
+            BEAST_EXPECT(v == s);
+            BEAST_EXPECT(fs.next_layer().nread() == 100);
+        }
+
+        // the threshold adapts
+        {
+            asio::io_context ioc;
+            test::stream tr{ioc};
+            flat_stream<test::stream> fs{ioc};
+            fs.next_layer().connect(tr);
+            tr.write_some(buffer(s));
+            std::string v;
+            char buf[1000];
+
+            // a bulk read which gains nothing lowers the threshold
+            fs.next_layer().read_size(500);
+            v.append(buf, fs.read_some(buffer(buf)));
+            BEAST_EXPECT(v.size() == 500);
+            BEAST_EXPECT(fs.next_layer().nread() == 1);
+
+            // a direct read which fills the buffer restores it
+            fs.next_layer().read_size(4000);
+            v.append(buf, fs.read_some(buffer(buf)));
+            BEAST_EXPECT(v.size() == 1500);
+            BEAST_EXPECT(fs.next_layer().nread() == 2);
+
+            // bulk reads again
+            for(int i = 0; i < 4; ++i)
+                v.append(buf, fs.read_some(buffer(buf)));
+            BEAST_EXPECT(v.size() == 5500);
+            BEAST_EXPECT(fs.next_layer().nread() == 3);
+            BEAST_EXPECT(v == s.substr(0, v.size()));
+        }
+
+        // a read into a sequence of small buffers
+        {
+            asio::io_context ioc;
+            test::stream tr{ioc};
+            flat_stream<test::stream> fs{ioc};
+            fs.next_layer().connect(tr);
+            tr.write_some(buffer(s));
+            char buf[3][100];
+            std::array<asio::mutable_buffer, 3> const b{{
+                buffer(buf[0]), buffer(buf[1]), buffer(buf[2])}};
+            BEAST_EXPECT(fs.read_some(b) == 300);
+            BEAST_EXPECT(std::string(&buf[0][0], 300) ==
+                s.substr(0, 300));
+            BEAST_EXPECT(fs.next_layer().nread() == 1);
+        }
+    }
+
     void
     testHttp()
     {
@@ -97,6 +369,9 @@ public:
     run() override
     {
         testSplit();
+        testFill();
+        testRecordSize();
+        testRead();
         testHttp();
         testWebsocket();
     }
@@ -0,0 +1,317 @@
+//
+// Copyright (c) 2016-2017 Vinnie Falco (vinnie dot falco at gmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/boostorg/beast
+//
+
+// Test that header file is self-contained.
+#include <beast/experimental/test/pipe_stream.hpp>
+
+#include <beast/core/flat_buffer.hpp>
+#include <beast/http/read.hpp>
+#include <beast/http/string_body.hpp>
+#include <beast/http/write.hpp>
+#include <beast/unit_test/suite.hpp>
+#include <asio/io_context.hpp>
+#include <string>
+#include <thread>
+
+namespace beast {
+namespace test {
+
+class pipe_stream_test : public unit_test::suite
+{
+public:
+    static
+    std::string
+    make_string(std::size_t size)
+    {
+        std::string s;
+        s.reserve(size);
+        for(std::size_t i = 0; i < size; ++i)
+            s.push_back(static_cast<char>('a' + i % 26));
+        return s;
+    }
+
+    void
+    testMembers()
+    {
+        using asio::buffer;
+        asio::io_context ioc;
+        pipe_stream p1{ioc};
+        pipe_stream p2{ioc};
+        BEAST_EXPECT(&p1.get_executor().context() == &ioc);
+        BEAST_EXPECT(&p1.lowest_layer() == &p1);
+        p1.connect(p2);
+
+        pipe_stream p3{std::move(p1)};
+        pipe_stream p4{ioc};
+        p4 = std::move(p3);
+        p4.write_some(buffer("Hello", 5));
+        char buf[5];
+        BEAST_EXPECT(p2.read_some(buffer(buf)) == 5);
+        BEAST_EXPECT(std::string(buf, 5) == "Hello");
+        BEAST_EXPECT(p4.nwrite() == 1);
+        BEAST_EXPECT(p2.nread() == 1);
+
+        // not connected
+        error_code ec;
+        pipe_stream p5{ioc};
+        p5.write_some(buffer("x", 1), ec);
+        BEAST_EXPECT(ec == asio::error::connection_reset);
+        p5.read_some(buffer(buf), ec);
+        BEAST_EXPECT(ec == asio::error::not_connected);
+    }
+
+    void
+    testReadWrite()
+    {
+        using asio::buffer;
+        asio::io_context ioc;
+        auto const s = make_string(1000);
+
+        // chunking
+        {
+            pipe_stream p1{ioc};
+            pipe_stream p2{ioc};
+            p1.connect(p2);
+            p1.write_size(3);
+            p2.read_size(2);
+            BEAST_EXPECT(p1.write_some(buffer(s)) == 3);
+            char buf[10];
+            BEAST_EXPECT(p2.read_some(buffer(buf)) == 2);
+            BEAST_EXPECT(p2.read_some(buffer(buf)) == 1);
+            BEAST_EXPECT(std::string(buf, 1) == s.substr(2, 1));
+            BEAST_EXPECT(p1.write_some(buffer(buf, 0)) == 0);
+            BEAST_EXPECT(p2.read_some(buffer(buf, 0)) == 0);
+        }
+
+        // the ring wraps around
+        {
+            pipe_stream p1{ioc, 16};
+            pipe_stream p2{ioc, 16};
+            p1.connect(p2);
+            std::string v;
+            char buf[7];
+            std::size_t pos = 0;
+            while(v.size() < s.size())
+            {
+                if(pos < s.size())
+                    pos += p1.write_some(buffer(
+                        s.data() + pos, (std::min)(
+                            std::size_t{11}, s.size() - pos)));
+                v.append(buf, p2.read_some(buffer(buf)));
+            }
+            BEAST_EXPECT(v == s);
+        }
+
+        // close
+        {
+            pipe_stream p1{ioc};
+            pipe_stream p2{ioc};
+            p1.connect(p2);
+            p1.write_some(buffer("Hello", 5));
+            p1.close();
+            error_code ec;
+            char buf[10];
+            BEAST_EXPECT(p2.read_some(buffer(buf), ec) == 5);
+            BEAST_EXPECTS(! ec, ec.message());
+            p2.read_some(buffer(buf), ec);
+            BEAST_EXPECT(ec == asio::error::eof);
+
+            // the other direction is still open
+            p2.write_some(buffer("Hello", 5), ec);
+            BEAST_EXPECTS(! ec, ec.message());
+            BEAST_EXPECT(p1.read_some(buffer(buf), ec) == 5);
+        }
+
+        // destroy
+        {
+            pipe_stream p1{ioc};
+            error_code ec;
+            char buf[10];
+            {
+                pipe_stream p2{ioc};
+                p1.connect(p2);
+                p2.write_some(buffer("Hello", 5));
+            }
+            BEAST_EXPECT(p1.read_some(buffer(buf), ec) == 5);
+            BEAST_EXPECTS(! ec, ec.message());
+            p1.read_some(buffer(buf), ec);
+            BEAST_EXPECT(ec == asio::error::connection_reset);
+            p1.write_some(buffer("Hello", 5), ec);
+            BEAST_EXPECT(ec == asio::error::connection_reset);
+        }
+    }
+
+    void
+    testAsync()
+    {
+        using asio::buffer;
+        auto const s = make_string(1000);
+
+        // a read waits for a write
+        {
+            asio::io_context ioc;
+            pipe_stream p1{ioc};
+            pipe_stream p2{ioc};
+            p1.connect(p2);
+            char buf[10];
+            int n = 0;
+            p2.async_read_some(buffer(buf),
+                [&](error_code ec, std::size_t bytes_transferred)
+                {
+                    BEAST_EXPECTS(! ec, ec.message());
+                    BEAST_EXPECT(bytes_transferred == 5);
+                    BEAST_EXPECT(std::string(buf, 5) == "Hello");
+                    ++n;
+                });
+            ioc.poll_one();
+            BEAST_EXPECT(n == 0);
+            p1.async_write_some(buffer("Hello", 5),
+                [&](error_code ec, std::size_t bytes_transferred)
+                {
+                    BEAST_EXPECTS(! ec, ec.message());
+                    BEAST_EXPECT(bytes_transferred == 5);
+                    ++n;
+                });
+            BEAST_EXPECT(n == 0);
+            ioc.run();
+            BEAST_EXPECT(n == 2);
+        }
+
+        // a write waits for space
+        {
+            asio::io_context ioc;
+            pipe_stream p1{ioc, 16};
+            pipe_stream p2{ioc, 16};
+            p1.connect(p2);
+            BEAST_EXPECT(p1.write_some(buffer(s)) == 16);
+            int n = 0;
+            p1.async_write_some(buffer(s),
+                [&](error_code ec, std::size_t bytes_transferred)
+                {
+                    BEAST_EXPECTS(! ec, ec.message());
+                    BEAST_EXPECT(bytes_transferred == 4);
+                    ++n;
+                });
+            ioc.poll_one();
+            BEAST_EXPECT(n == 0);
+            char buf[4];
+            BEAST_EXPECT(p2.read_some(buffer(buf)) == 4);
+            ioc.run();
+            BEAST_EXPECT(n == 1);
+        }
+
+        // eof
+        {
+            asio::io_context ioc;
+            pipe_stream p1{ioc};
+            pipe_stream p2{ioc};
+            p1.connect(p2);
+            char buf[10];
+            bool invoked = false;
+            p2.async_read_some(buffer(buf),
+                [&](error_code ec, std::size_t)
+                {
+                    BEAST_EXPECT(ec == asio::error::eof);
+                    invoked = true;
+                });
+            ioc.poll_one();
+            p1.close();
+            ioc.run();
+            BEAST_EXPECT(invoked);
+        }
+    }
+
+    void
+    testThreads()
+    {
+        using asio::buffer;
+        auto const s = make_string(1024 * 1024);
+        asio::io_context ioc;
+        pipe_stream p1{ioc, 4096};
+        pipe_stream p2{ioc, 4096};
+        p1.connect(p2);
+        p2.read_size(1000);
+        std::thread t{
+            [&]
+            {
+                std::size_t pos = 0;
+                while(pos < s.size())
+                    pos += p1.write_some(buffer(
+                        s.data() + pos, s.size() - pos));
+                p1.close();
+            }};
+        std::string v;
+        v.reserve(s.size());
+        char buf[1500];
+        error_code ec;
+        for(;;)
+        {
+            auto const n = p2.read_some(buffer(buf), ec);
+            if(ec)
+                break;
+            v.append(buf, n);
+        }
+        t.join();
+        BEAST_EXPECTS(ec == asio::error::eof, ec.message());
+        BEAST_EXPECT(v == s);
+    }
+
+    void
+    testHttp()
+    {
+        asio::io_context ioc;
+        pipe_stream client{ioc};
+        pipe_stream server{ioc};
+        client.connect(server);
+        std::thread t{
+            [&]
+            {
+                flat_buffer b;
+                for(int i = 0; i < 100; ++i)
+                {
+                    http::request<http::string_body> req;
+                    http::read(server, b, req);
+                    http::response<http::string_body> res{
+                        http::status::ok, req.version()};
+                    res.body() = req.target().to_string();
+                    res.prepare_payload();
+                    http::write(server, res);
+                }
+            }};
+        flat_buffer b;
+        int n = 0;
+        for(int i = 0; i < 100; ++i)
+        {
+            http::request<http::string_body> req{
+                http::verb::get, "/" + std::to_string(i), 11};
+            http::write(client, req);
+            http::response<http::string_body> res;
+            http::read(client, b, res);
+            if(res.body() == "/" + std::to_string(i))
+                ++n;
+        }
+        t.join();
+        BEAST_EXPECT(n == 100);
+    }
+
+    void
+    run() override
+    {
+        testMembers();
+        testReadWrite();
+        testAsync();
+        testThreads();
+        testHttp();
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(beast,test,pipe_stream);
+
+} // test
+} // beast
@@ -0,0 +1,425 @@
+//
+// Copyright (c) 2016-2017 Vinnie Falco (vinnie dot falco at gmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/boostorg/beast
+//
+
+// Test that header file is self-contained.
+#include <beast/experimental/test/simulated_stream.hpp>
+
+#include <beast/core/flat_buffer.hpp>
+#include <beast/http/read.hpp>
+#include <beast/http/string_body.hpp>
+#include <beast/http/write.hpp>
+#include <beast/unit_test/suite.hpp>
+#include <asio/io_context.hpp>
+#include <string>
+#include <vector>
+
+namespace beast {
+namespace test {
+
+class simulated_stream_test : public unit_test::suite
+{
+public:
+    using ms = std::chrono::milliseconds;
+
+    void
+    testMembers()
+    {
+        using asio::buffer;
+        asio::io_context ioc;
+        simulated_network net{ioc};
+        simulated_stream s1{net};
+        simulated_stream s2{net};
+        BEAST_EXPECT(&s1.get_executor().context() == &ioc);
+        BEAST_EXPECT(&s1.lowest_layer() == &s1);
+        BEAST_EXPECT(&s1.network() == &net);
+        BEAST_EXPECT(&net.get_io_context() == &ioc);
+        BEAST_EXPECT(net.now() == ms(0));
+        s1.connect(s2);
+
+        simulated_stream s3{std::move(s1)};
+        simulated_stream s4{net};
+        s4 = std::move(s3);
+        BEAST_EXPECT(s4.write_some(buffer("Hello", 5)) == 5);
+        char buf[5];
+        BEAST_EXPECT(s2.read_some(buffer(buf)) == 5);
+        BEAST_EXPECT(std::string(buf, 5) == "Hello");
+        BEAST_EXPECT(s4.nwrite() == 1);
+        BEAST_EXPECT(s2.nread() == 1);
+
+        // not connected
+        error_code ec;
+        simulated_stream s5{net};
+        s5.write_some(buffer("x", 1), ec);
+        BEAST_EXPECT(ec == asio::error::connection_reset);
+        s5.read_some(buffer(buf), ec);
+        BEAST_EXPECT(ec == asio::error::not_connected);
+
+        // nothing in flight
+        s2.read_some(buffer(buf), ec);
+        BEAST_EXPECT(ec == asio::error::would_block);
+    }
+
+    void
+    testLatency()
+    {
+        using asio::buffer;
+        asio::io_context ioc;
+        simulated_network net{ioc};
+        simulated_stream s1{net};
+        simulated_stream s2{net};
+        network_conditions cond;
+        cond.rtt = ms(10);
+        s1.connect(s2, cond);
+        s1.write_some(buffer("Hello", 5));
+        BEAST_EXPECT(net.now() == ms(0));
+        char buf[10];
+        BEAST_EXPECT(s2.read_some(buffer(buf)) == 5);
+        BEAST_EXPECT(net.now() == ms(5));
+        s2.write_some(buffer("World", 5));
+        BEAST_EXPECT(s1.read_some(buffer(buf)) == 5);
+        BEAST_EXPECT(net.now() == ms(10));
+        BEAST_EXPECT(std::string(buf, 5) == "World");
+    }
+
+    void
+    testBandwidth()
+    {
+        using asio::buffer;
+        asio::io_context ioc;
+        simulated_network net{ioc};
+        simulated_stream s1{net};
+        simulated_stream s2{net};
+        network_conditions cond;
+        cond.bandwidth = 1000;
+        cond.segment_size = 100;
+        cond.window = 0;
+        s1.connect(s2, cond);
+        std::string const s(300, '*');
+        BEAST_EXPECT(s1.write_some(buffer(s)) == 300);
+
+        // each segment arrives when it has been sent
+        char buf[1000];
+        BEAST_EXPECT(s2.read_some(buffer(buf)) == 100);
+        BEAST_EXPECT(net.now() == ms(100));
+        BEAST_EXPECT(s2.read_some(buffer(buf)) == 100);
+        BEAST_EXPECT(net.now() == ms(200));
+
+        // the sender is busy until the previous data is sent
+        BEAST_EXPECT(s1.write_some(buffer(s)) == 300);
+        BEAST_EXPECT(s2.read_some(buffer(buf)) == 100);
+        BEAST_EXPECT(net.now() == ms(300));
+        BEAST_EXPECT(s2.read_some(buffer(buf)) == 100);
+        BEAST_EXPECT(net.now() == ms(400));
+    }
+
+    void
+    testWindow()
+    {
+        using asio::buffer;
+        asio::io_context ioc;
+        simulated_network net{ioc};
+        simulated_stream s1{net};
+        simulated_stream s2{net};
+        network_conditions cond;
+        cond.rtt = ms(10);
+        cond.window = 100;
+        s1.connect(s2, cond);
+        std::string const s(300, '*');
+        error_code ec;
+        BEAST_EXPECT(s1.write_some(buffer(s)) == 100);
+
+        // the peer never reads, so the window never opens
+        s1.write_some(buffer(s), ec);
+        BEAST_EXPECT(ec == asio::error::would_block);
+        BEAST_EXPECT(net.now() == ms(5));
+
+        // the window opens half a round trip after the read
+        char buf[1000];
+        BEAST_EXPECT(s2.read_some(buffer(buf)) == 100);
+        BEAST_EXPECT(s1.write_some(buffer(s)) == 100);
+        BEAST_EXPECT(net.now() == ms(10));
+
+        // a read of part of the data opens part of the window
+        s2.read_size(40);
+        BEAST_EXPECT(s2.read_some(buffer(buf)) == 40);
+        BEAST_EXPECT(net.now() == ms(15));
+        BEAST_EXPECT(s1.write_some(buffer(s)) == 40);
+        BEAST_EXPECT(net.now() == ms(20));
+    }
+
+    void
+    testWrites()
+    {
+        using asio::buffer;
+        std::string const s(1000, '*');
+
+        // the same seed gives the same sizes
+        auto const sizes =
+            [&](std::uint32_t seed)
+            {
+                asio::io_context ioc;
+                simulated_network net{ioc, seed};
+                simulated_stream s1{net};
+                simulated_stream s2{net};
+                network_conditions cond;
+                cond.window = 0;
+                cond.partial_writes = true;
+                s1.connect(s2, cond);
+                std::vector<std::size_t> v;
+                for(int i = 0; i < 10; ++i)
+                    v.push_back(s1.write_some(buffer(s)));
+                return v;
+            };
+        auto const v = sizes(1);
+        BEAST_EXPECT(sizes(1) == v);
+        BEAST_EXPECT(sizes(2) != v);
+        bool partial = false;
+        for(auto n : v)
+        {
+            BEAST_EXPECT(n >= 1 && n <= s.size());
+            if(n < s.size())
+                partial = true;
+        }
+        BEAST_EXPECT(partial);
+
+        // write_size
+        {
+            asio::io_context ioc;
+            simulated_network net{ioc};
+            simulated_stream s1{net};
+            simulated_stream s2{net};
+            s1.connect(s2);
+            s1.write_size(3);
+            BEAST_EXPECT(s1.write_some(buffer(s)) == 3);
+            BEAST_EXPECT(s1.write_some(buffer(s.data(), 0)) == 0);
+        }
+    }
+
+    void
+    testJitter()
+    {
+        using asio::buffer;
+        auto const run =
+            [&](std::uint32_t seed)
+            {
+                asio::io_context ioc;
+                simulated_network net{ioc, seed};
+                simulated_stream s1{net};
+                simulated_stream s2{net};
+                network_conditions cond;
+                cond.rtt = ms(10);
+                cond.jitter = ms(4);
+                cond.segment_size = 10;
+                cond.window = 0;
+                s1.connect(s2, cond);
+                std::string s;
+                for(int i = 0; i < 100; ++i)
+                    s.push_back(static_cast<char>('a' + i % 26));
+                s1.write_some(buffer(s));
+                std::string v;
+                std::vector<simulated_network::duration> times;
+                char buf[100];
+                while(v.size() < s.size())
+                {
+                    auto const n = s2.read_some(buffer(buf));
+                    v.append(buf, n);
+                    times.push_back(net.now());
+                }
+                // in order, and within the bounds
+                BEAST_EXPECT(v == s);
+                for(auto t : times)
+                    BEAST_EXPECT(t >= ms(5) && t <= ms(9));
+                return times;
+            };
+        BEAST_EXPECT(run(7) == run(7));
+    }
+
+    void
+    testClose()
+    {
+        using asio::buffer;
+        asio::io_context ioc;
+        simulated_network net{ioc};
+        network_conditions cond;
+        cond.rtt = ms(10);
+
+        // close
+        {
+            simulated_stream s1{net};
+            simulated_stream s2{net};
+            s1.connect(s2, cond);
+            s1.write_some(buffer("Hello", 5));
+            s1.close();
+            error_code ec;
+            char buf[10];
+            BEAST_EXPECT(s2.read_some(buffer(buf), ec) == 5);
+            BEAST_EXPECTS(! ec, ec.message());
+            s2.read_some(buffer(buf), ec);
+            BEAST_EXPECT(ec == asio::error::eof);
+
+            // the other direction is still open
+            s2.write_some(buffer("Hello", 5), ec);
+            BEAST_EXPECTS(! ec, ec.message());
+            BEAST_EXPECT(s1.read_some(buffer(buf), ec) == 5);
+        }
+
+        // destroy
+        {
+            simulated_stream s1{net};
+            error_code ec;
+            char buf[10];
+            {
+                simulated_stream s2{net};
+                s1.connect(s2, cond);
+                s2.write_some(buffer("Hello", 5));
+            }
+            BEAST_EXPECT(s1.read_some(buffer(buf), ec) == 5);
+            BEAST_EXPECTS(! ec, ec.message());
+            s1.read_some(buffer(buf), ec);
+            BEAST_EXPECT(ec == asio::error::eof);
+            s1.write_some(buffer("Hello", 5), ec);
+            BEAST_EXPECT(ec == asio::error::connection_reset);
+        }
+
+        // destroy with a pending write on the peer
+        {
+            simulated_stream s1{net};
+            cond.window = 5;
+            bool invoked = false;
+            {
+                simulated_stream s2{net};
+                s1.connect(s2, cond);
+                s1.write_some(buffer("Hello", 5));
+                s1.async_write_some(buffer("Hello", 5),
+                    [&](error_code ec, std::size_t)
+                    {
+                        BEAST_EXPECT(ec ==
+                            asio::error::connection_reset);
+                        invoked = true;
+                    });
+                net.run();
+                BEAST_EXPECT(! invoked);
+            }
+            net.run();
+            BEAST_EXPECT(invoked);
+        }
+    }
+
+    void
+    testAsync()
+    {
+        using asio::buffer;
+        asio::io_context ioc;
+        simulated_network net{ioc};
+        simulated_stream s1{net};
+        simulated_stream s2{net};
+        network_conditions cond;
+        cond.rtt = ms(10);
+        s1.connect(s2, cond);
+        char buf[10];
+        int n = 0;
+        s2.async_read_some(buffer(buf),
+            [&](error_code ec, std::size_t bytes_transferred)
+            {
+                BEAST_EXPECTS(! ec, ec.message());
+                BEAST_EXPECT(bytes_transferred == 5);
+                BEAST_EXPECT(net.now() == ms(5));
+                ++n;
+            });
+        s1.async_write_some(buffer("Hello", 5),
+            [&](error_code ec, std::size_t bytes_transferred)
+            {
+                BEAST_EXPECTS(! ec, ec.message());
+                BEAST_EXPECT(bytes_transferred == 5);
+                BEAST_EXPECT(net.now() == ms(0));
+                ++n;
+            });
+        BEAST_EXPECT(n == 0);
+        BEAST_EXPECT(net.run() == 2);
+        BEAST_EXPECT(n == 2);
+
+        // the window update for the read arrives last
+        BEAST_EXPECT(net.now() == ms(10));
+    }
+
+    void
+    testHttp()
+    {
+        asio::io_context ioc;
+        simulated_network net{ioc};
+        simulated_stream client{net};
+        simulated_stream server{net};
+        network_conditions cond;
+        cond.bandwidth = 1000 * 1000;
+        cond.rtt = ms(20);
+        cond.segment_size = 1000;
+        client.connect(server, cond);
+
+        flat_buffer sb;
+        http::request<http::string_body> sreq;
+        http::response<http::string_body> sres{http::status::ok, 11};
+        sres.body() = std::string(10000, '*');
+        sres.prepare_payload();
+        http::async_read(server, sb, sreq,
+            [&](error_code ec, std::size_t)
+            {
+                BEAST_EXPECTS(! ec, ec.message());
+                http::async_write(server, sres,
+                    [&](error_code ec, std::size_t)
+                    {
+                        BEAST_EXPECTS(! ec, ec.message());
+                    });
+            });
+
+        flat_buffer cb;
+        http::request<http::string_body> creq{http::verb::get, "/", 11};
+        http::response<http::string_body> cres;
+        simulated_network::duration done{0};
+        http::async_write(client, creq,
+            [&](error_code ec, std::size_t)
+            {
+                BEAST_EXPECTS(! ec, ec.message());
+                http::async_read(client, cb, cres,
+                    [&](error_code ec, std::size_t)
+                    {
+                        BEAST_EXPECTS(! ec, ec.message());
+                        done = net.now();
+                    });
+            });
+        net.run();
+        BEAST_EXPECT(cres.body() == sres.body());
+
+        // one round trip, plus the time to send the
+        // request and the response at one octet per
+        // microsecond, give or take the last segment
+        auto const header = std::chrono::microseconds(100);
+        auto const body = std::chrono::microseconds(10000);
+        BEAST_EXPECT(done > cond.rtt + body);
+        BEAST_EXPECT(done < cond.rtt + body + 2 * header);
+    }
+
+    void
+    run() override
+    {
+        testMembers();
+        testLatency();
+        testBandwidth();
+        testWindow();
+        testWrites();
+        testJitter();
+        testClose();
+        testAsync();
+        testHttp();
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(beast,test,simulated_stream);
+
+} // test
+} // beast
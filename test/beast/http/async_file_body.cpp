@@ -0,0 +1,425 @@
+//
+// Copyright (c) 2016-2017 Vinnie Falco (vinnie dot falco at gmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/boostorg/beast
+//
+
+// Test that header file is self-contained.
+#include <beast/http/async_file_body.hpp>
+
+#include <beast/core/file_stdio.hpp>
+#include <beast/http/file_body.hpp>
+#include <beast/experimental/test/stream.hpp>
+#include <beast/http/write.hpp>
+#include <beast/unit_test/suite.hpp>
+#include <asio/io_context.hpp>
+#include <asio/thread_pool.hpp>
+#include <boost/filesystem.hpp>
+#include <string>
+
+namespace beast {
+namespace http {
+
+BOOST_STATIC_ASSERT(is_body_writer<async_file_body>::value);
+BOOST_STATIC_ASSERT(! is_body_reader<async_file_body>::value);
+BOOST_STATIC_ASSERT(detail::is_body_writer_waitable<
+    async_file_body::writer>::value);
+BOOST_STATIC_ASSERT(! detail::is_body_writer_waitable<
+    basic_file_body<file>::writer>::value);
+BOOST_STATIC_ASSERT(detail::is_body_writer_async_waitable<
+    async_file_body::writer>::value);
+BOOST_STATIC_ASSERT(! detail::is_body_writer_async_waitable<
+    basic_file_body<file>::writer>::value);
+
+// A writer which can only wait synchronously
+struct sync_waitable_writer
+{
+    void wait(error_code&);
+};
+
+BOOST_STATIC_ASSERT(detail::is_body_writer_waitable<
+    sync_waitable_writer>::value);
+BOOST_STATIC_ASSERT(! detail::is_body_writer_async_waitable<
+    sync_waitable_writer>::value);
+
+class async_file_body_test
+    : public beast::unit_test::suite
+{
+public:
+    struct temp_file
+    {
+        std::string path;
+
+        explicit
+        temp_file(string_view s)
+            : path(boost::filesystem::unique_path().string())
+        {
+            error_code ec;
+            file f;
+            f.open(path.c_str(), file_mode::write, ec);
+            f.write(s.data(), s.size(), ec);
+        }
+
+        ~temp_file()
+        {
+            boost::system::error_code ec;
+            boost::filesystem::remove(path, ec);
+        }
+    };
+
+    static
+    std::string
+    make_text(std::size_t size)
+    {
+        std::string s;
+        s.reserve(size);
+        for(std::size_t i = 0; s.size() < size; ++i)
+            s += std::to_string(i) + "\n";
+        s.resize(size);
+        return s;
+    }
+
+    // Returns the body produced by the writer,
+    // waiting whenever a read is in progress.
+    template<class File>
+    std::string
+    drain(response<basic_async_file_body<File>>& res, error_code& ec)
+    {
+        std::string out;
+        typename basic_async_file_body<File>::writer w{res, res.body()};
+        w.init(ec);
+        if(ec)
+            return {};
+        for(;;)
+        {
+            auto const result = w.get(ec);
+            if(ec == error::need_more)
+            {
+                w.wait(ec);
+                if(ec)
+                    break;
+                continue;
+            }
+            if(ec || ! result)
+                break;
+            out.append(static_cast<char const*>(
+                result->first.data()), result->first.size());
+            if(! result->second)
+                break;
+        }
+        return out;
+    }
+
+    template<class File>
+    void
+    doTestWriter()
+    {
+        auto const s = make_text(1000000);
+        temp_file t{s};
+        asio::thread_pool pool{1};
+        error_code ec;
+
+        // synchronous
+        {
+            response<basic_async_file_body<File>> res;
+            res.body().open(t.path.c_str(), file_mode::scan, ec);
+            BEAST_EXPECTS(! ec, ec.message());
+            BEAST_EXPECT(res.body().is_open());
+            BEAST_EXPECT(res.body().size() == s.size());
+            res.body().read_size(100000);
+            BEAST_EXPECT(res.body().read_size() == 100000);
+            BEAST_EXPECT(drain(res, ec) == s);
+            BEAST_EXPECTS(! ec, ec.message());
+        }
+
+        // on the executor
+        for(std::size_t n : {1000, 64 * 1024, 1024 * 1024})
+        {
+            response<basic_async_file_body<File>> res;
+            res.body().open(t.path.c_str(), file_mode::scan, ec);
+            BEAST_EXPECTS(! ec, ec.message());
+            res.body().executor(pool.get_executor());
+            res.body().read_size(n);
+            BEAST_EXPECT(drain(res, ec) == s);
+            BEAST_EXPECTS(! ec, ec.message());
+        }
+
+        // empty file
+        {
+            temp_file t2{""};
+            response<basic_async_file_body<File>> res;
+            res.body().open(t2.path.c_str(), file_mode::scan, ec);
+            BEAST_EXPECTS(! ec, ec.message());
+            res.body().executor(pool.get_executor());
+            BEAST_EXPECT(drain(res, ec).empty());
+            BEAST_EXPECTS(! ec, ec.message());
+        }
+
+        // a writer may be destroyed while reading
+        {
+            response<basic_async_file_body<File>> res;
+            res.body().open(t.path.c_str(), file_mode::scan, ec);
+            res.body().executor(pool.get_executor());
+            typename basic_async_file_body<File>::writer w{res, res.body()};
+            w.init(ec);
+            BEAST_EXPECTS(! ec, ec.message());
+        }
+
+        // a read which does not run does not block the writer
+        {
+            asio::io_context ioc;
+            {
+                response<basic_async_file_body<File>> res;
+                res.body().open(t.path.c_str(), file_mode::scan, ec);
+                res.body().executor(ioc.get_executor());
+                typename basic_async_file_body<File>::writer w{
+                    res, res.body()};
+                w.init(ec);
+                BEAST_EXPECTS(! ec, ec.message());
+                auto const result = w.get(ec);
+                BEAST_EXPECT(ec == error::need_more);
+                BEAST_EXPECT(! result);
+            }
+            // and completes harmlessly afterwards
+            BEAST_EXPECT(ioc.run() == 1);
+        }
+
+        // the file is shorter than expected
+        {
+            File f;
+            f.open(t.path.c_str(), file_mode::scan, ec);
+            BEAST_EXPECTS(! ec, ec.message());
+            f.seek(s.size() - 10, ec);
+            BEAST_EXPECTS(! ec, ec.message());
+            response<basic_async_file_body<File>> res;
+            res.body().reset(std::move(f), ec);
+            BEAST_EXPECTS(! ec, ec.message());
+            res.body().executor(pool.get_executor());
+            drain(res, ec);
+            BEAST_EXPECTS(ec == errc::io_error, ec.message());
+        }
+    }
+
+    // Counts the allocations made with it
+    template<class T>
+    struct counting_allocator
+    {
+        using value_type = T;
+
+        std::size_t* count;
+
+        explicit
+        counting_allocator(std::size_t* count_)
+            : count(count_)
+        {
+        }
+
+        template<class U>
+        counting_allocator(counting_allocator<U> const& other)
+            : count(other.count)
+        {
+        }
+
+        T*
+        allocate(std::size_t n)
+        {
+            ++*count;
+            return std::allocator<T>{}.allocate(n);
+        }
+
+        void
+        deallocate(T* p, std::size_t n)
+        {
+            --*count;
+            std::allocator<T>{}.deallocate(p, n);
+        }
+
+        template<class U>
+        friend
+        bool
+        operator==(counting_allocator const& lhs,
+            counting_allocator<U> const& rhs)
+        {
+            return lhs.count == rhs.count;
+        }
+
+        template<class U>
+        friend
+        bool
+        operator!=(counting_allocator const& lhs,
+            counting_allocator<U> const& rhs)
+        {
+            return lhs.count != rhs.count;
+        }
+    };
+
+    struct wait_handler
+    {
+        std::size_t* count;
+        bool* invoked;
+        asio::io_context* ioc;
+
+        using allocator_type = counting_allocator<char>;
+
+        allocator_type
+        get_allocator() const noexcept
+        {
+            return allocator_type{count};
+        }
+
+        using executor_type = asio::io_context::executor_type;
+
+        executor_type
+        get_executor() const noexcept
+        {
+            return ioc->get_executor();
+        }
+
+        void
+        operator()(error_code)
+        {
+            *invoked = true;
+        }
+    };
+
+    void
+    testAsyncWait()
+    {
+        temp_file t{make_text(100000)};
+        error_code ec;
+
+        // the waiter is allocated with the handler's allocator
+        {
+            asio::io_context ioc;
+            std::size_t count = 0;
+            bool invoked = false;
+            response<async_file_body> res;
+            res.body().open(t.path.c_str(), file_mode::scan, ec);
+            BEAST_EXPECTS(! ec, ec.message());
+            res.body().executor(ioc.get_executor());
+            async_file_body::writer w{res, res.body()};
+            w.init(ec);
+            BEAST_EXPECTS(! ec, ec.message());
+            w.async_wait(wait_handler{&count, &invoked, &ioc});
+            BEAST_EXPECT(count == 1);
+            ioc.run();
+            BEAST_EXPECT(invoked);
+            BEAST_EXPECT(count == 0);
+        }
+
+        // and freed with it if the read never finishes
+        {
+            std::size_t count = 0;
+            bool invoked = false;
+            {
+                asio::io_context ioc;
+                response<async_file_body> res;
+                res.body().open(t.path.c_str(), file_mode::scan, ec);
+                BEAST_EXPECTS(! ec, ec.message());
+                res.body().executor(ioc.get_executor());
+                async_file_body::writer w{res, res.body()};
+                w.init(ec);
+                BEAST_EXPECTS(! ec, ec.message());
+                w.async_wait(wait_handler{&count, &invoked, &ioc});
+                BEAST_EXPECT(count == 1);
+            }
+            BEAST_EXPECT(! invoked);
+            BEAST_EXPECT(count == 0);
+        }
+    }
+
+    void
+    testWrite()
+    {
+        auto const s = make_text(500000);
+        temp_file t{s};
+        asio::thread_pool pool{2};
+        auto const expected =
+            "HTTP/1.1 200 OK\r\n"
+            "Content-Length: " + std::to_string(s.size()) + "\r\n"
+            "\r\n" + s;
+
+        // synchronous write waits for each read
+        {
+            asio::io_context ioc;
+            test::stream ts{ioc}, tr{ioc};
+            ts.connect(tr);
+            response<async_file_body> res{status::ok, 11};
+            error_code ec;
+            res.body().open(t.path.c_str(), file_mode::scan, ec);
+            BEAST_EXPECTS(! ec, ec.message());
+            res.body().executor(pool.get_executor());
+            res.prepare_payload();
+            write(ts, res, ec);
+            BEAST_EXPECTS(! ec, ec.message());
+            BEAST_EXPECT(tr.str() == expected);
+        }
+
+        // asynchronous write keeps the thread free
+        {
+            asio::io_context ioc;
+            test::stream ts{ioc}, tr{ioc};
+            ts.connect(tr);
+            response<async_file_body> res{status::ok, 11};
+            error_code ec;
+            res.body().open(t.path.c_str(), file_mode::scan, ec);
+            BEAST_EXPECTS(! ec, ec.message());
+            res.body().executor(pool.get_executor());
+            res.body().read_size(16 * 1024);
+            res.prepare_payload();
+            bool invoked = false;
+            async_write(ts, res,
+                [&](error_code ec, std::size_t n)
+                {
+                    invoked = true;
+                    BEAST_EXPECTS(! ec, ec.message());
+                    BEAST_EXPECT(n == expected.size());
+                });
+            ioc.run();
+            BEAST_EXPECT(invoked);
+            BEAST_EXPECT(tr.str() == expected);
+        }
+
+        // chunked
+        {
+            asio::io_context ioc;
+            test::stream ts{ioc}, tr{ioc};
+            ts.connect(tr);
+            response<async_file_body> res{status::ok, 11};
+            error_code ec;
+            res.body().open(t.path.c_str(), file_mode::scan, ec);
+            BEAST_EXPECTS(! ec, ec.message());
+            res.body().executor(pool.get_executor());
+            res.chunked(true);
+            async_write(ts, res,
+                [&](error_code ec, std::size_t)
+                {
+                    BEAST_EXPECTS(! ec, ec.message());
+                });
+            ioc.run();
+            auto const out = tr.str().to_string();
+            BEAST_EXPECT(out.size() > s.size());
+            BEAST_EXPECT(out.find(s.substr(0, 1000)) != std::string::npos);
+            BEAST_EXPECT(out.find(s.substr(s.size() - 1000)) !=
+                std::string::npos);
+            BEAST_EXPECT(out.substr(out.size() - 5) == "0\r\n\r\n");
+        }
+    }
+
+    void
+    run() override
+    {
+        doTestWriter<file_stdio>();
+        doTestWriter<file>();
+        testAsyncWait();
+        testWrite();
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(beast,http,async_file_body);
+
+} // http
+} // beast
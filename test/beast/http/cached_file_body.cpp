@@ -0,0 +1,259 @@
+//
+// Copyright (c) 2016-2017 Vinnie Falco (vinnie dot falco at gmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/boostorg/beast
+//
+
+// Test that header file is self-contained.
+#include <beast/http/cached_file_body.hpp>
+
+#if BEAST_USE_POSIX_FILE
+
+#include <beast/core/buffers_to_string.hpp>
+#include <beast/http/empty_body.hpp>
+#include <beast/http/serializer.hpp>
+#include <beast/unit_test/suite.hpp>
+#include <boost/filesystem.hpp>
+#include <string>
+
+namespace beast {
+namespace http {
+
+class cached_file_body_test
+    : public beast::unit_test::suite
+{
+public:
+    struct temp_file
+    {
+        std::string path;
+
+        explicit
+        temp_file(string_view s)
+            : path(boost::filesystem::unique_path().string())
+        {
+            error_code ec;
+            file_posix f;
+            f.open(path.c_str(), file_mode::write, ec);
+            f.write(s.data(), s.size(), ec);
+        }
+
+        ~temp_file()
+        {
+            boost::system::error_code ec;
+            boost::filesystem::remove(path, ec);
+        }
+    };
+
+    static
+    std::string
+    make_text(std::size_t size)
+    {
+        std::string s;
+        while(s.size() < size)
+            s += "function f(x) { return x * 2; }\n";
+        s.resize(size);
+        return s;
+    }
+
+    struct visitor
+    {
+        std::string& out;
+        std::size_t size;
+
+        template<class ConstBufferSequence>
+        void
+        operator()(error_code&,
+            ConstBufferSequence const& buffers)
+        {
+            size = asio::buffer_size(buffers);
+            out.append(buffers_to_string(buffers));
+        }
+    };
+
+    std::string
+    serialize(response<cached_file_body> const& res)
+    {
+        serializer<false, cached_file_body> sr{res};
+        std::string out;
+        error_code ec;
+        visitor visit{out, 0};
+        while(! sr.is_done())
+        {
+            sr.next(ec, visit);
+            if(! BEAST_EXPECTS(! ec, ec.message()))
+                break;
+            sr.consume(visit.size);
+        }
+        return out;
+    }
+
+    void
+    testBody()
+    {
+        auto const s = make_text(100000);
+        temp_file t{s};
+        error_code ec;
+        for(std::size_t limit : {0, 1000000})
+        {
+            file_cache cache;
+            cache.resident_limit(limit);
+            auto const e = cache.get(t.path, ec);
+            if(! BEAST_EXPECTS(! ec, ec.message()))
+                return;
+            BEAST_EXPECT(e->identity().resident() == (limit > 0));
+
+            response<cached_file_body> res{status::ok, 11};
+            BEAST_EXPECT(res.body().size() == 0);
+            BEAST_EXPECT(res.body().assign(e) == content_coding::identity);
+            BEAST_EXPECT(res.body().entry() == e);
+            BEAST_EXPECT(res.body().representation() == &e->identity());
+            BEAST_EXPECT(res.body().size() == s.size());
+            res.prepare_payload();
+            auto const out = serialize(res);
+            BEAST_EXPECT(out.size() > s.size());
+            BEAST_EXPECT(out.substr(out.size() - s.size()) == s);
+            BEAST_EXPECT(out.find("Content-Length: " +
+                std::to_string(s.size())) != std::string::npos);
+
+            // the same message may be sent again
+            BEAST_EXPECT(serialize(res) == out);
+
+            BEAST_EXPECT(res.body().assign(e, content_coding::gzip) ==
+                content_coding::gzip);
+            BEAST_EXPECT(res.body().representation() == e->gzip());
+            res.body().clear();
+            BEAST_EXPECT(! res.body().entry());
+            BEAST_EXPECT(res.body().size() == 0);
+        }
+    }
+
+    void
+    testEtagList()
+    {
+        auto const check =
+            [&](string_view list, bool result)
+            {
+                BEAST_EXPECTS(detail::etag_list_matches(
+                    list, "\"abc\"") == result, list);
+            };
+
+        check("", false);
+        check("\"abc\"", true);
+        check("W/\"abc\"", true);
+        check("*", true);
+        check("\"xyz\", \"abc\"", true);
+        check("\"xyz\",W/\"abc\"", true);
+        check("\"x,y\", \"abc\"", true);
+        check("\"xyz\"", false);
+        check("abc", false);
+        check("\"abc", false);
+        check("W/", false);
+        check(" , \"ab\"", false);
+    }
+
+    void
+    testPrepare()
+    {
+        auto const s = make_text(20000);
+        temp_file t{s};
+        file_cache cache;
+        error_code ec;
+        auto const e = cache.get(t.path, ec);
+        if(! BEAST_EXPECTS(! ec, ec.message()))
+            return;
+        if(! BEAST_EXPECT(e->gzip()))
+            return;
+
+        // identity
+        {
+            request<empty_body> req{verb::get, "/", 11};
+            response<cached_file_body> res;
+            res.set(field::content_encoding, "gzip");
+            prepare_cached_response(req, res, e);
+            BEAST_EXPECT(res.result() == status::ok);
+            BEAST_EXPECT(res[field::etag] == e->identity().etag());
+            BEAST_EXPECT(res[field::vary] == "Accept-Encoding");
+            BEAST_EXPECT(res.count(field::content_encoding) == 0);
+            BEAST_EXPECT(res[field::content_length] ==
+                std::to_string(s.size()));
+        }
+
+        // gzip
+        {
+            request<empty_body> req{verb::get, "/", 11};
+            req.set(field::accept_encoding, "gzip, deflate");
+            response<cached_file_body> res;
+            res.set(field::vary, "Origin");
+            prepare_cached_response(req, res, e);
+            BEAST_EXPECT(res.result() == status::ok);
+            BEAST_EXPECT(res[field::etag] == e->gzip()->etag());
+            BEAST_EXPECT(res[field::content_encoding] == "gzip");
+            BEAST_EXPECT(res[field::vary] == "Origin, Accept-Encoding");
+            BEAST_EXPECT(res[field::content_length] ==
+                std::to_string(e->gzip()->size()));
+            auto const out = serialize(res);
+            BEAST_EXPECT(out.substr(out.size() -
+                e->gzip()->data().size()) == e->gzip()->data());
+        }
+
+        // not modified
+        {
+            request<empty_body> req{verb::get, "/", 11};
+            req.set(field::accept_encoding, "gzip");
+            req.set(field::if_none_match,
+                "\"old\", W/" + e->gzip()->etag().to_string());
+            response<cached_file_body> res;
+            res.content_length(5);
+            prepare_cached_response(req, res, e);
+            BEAST_EXPECT(res.result() == status::not_modified);
+            BEAST_EXPECT(res[field::etag] == e->gzip()->etag());
+            BEAST_EXPECT(res.count(field::content_length) == 0);
+            BEAST_EXPECT(res.body().size() == 0);
+            auto const out = serialize(res);
+            BEAST_EXPECT(out.find("304") != std::string::npos);
+            BEAST_EXPECT(out.substr(out.size() - 4) == "\r\n\r\n");
+        }
+
+        // the tag of the other representation does not match
+        {
+            request<empty_body> req{verb::get, "/", 11};
+            req.set(field::if_none_match, e->gzip()->etag());
+            response<cached_file_body> res;
+            prepare_cached_response(req, res, e);
+            BEAST_EXPECT(res.result() == status::ok);
+            BEAST_EXPECT(res.body().size() == s.size());
+        }
+
+        // no Vary without a gzip representation
+        {
+            temp_file t2{"x"};
+            auto const e2 = cache.get(t2.path, ec);
+            BEAST_EXPECTS(! ec, ec.message());
+            request<empty_body> req{verb::get, "/", 11};
+            req.set(field::accept_encoding, "gzip");
+            response<cached_file_body> res;
+            prepare_cached_response(req, res, e2);
+            BEAST_EXPECT(res.count(field::vary) == 0);
+            BEAST_EXPECT(res.count(field::content_encoding) == 0);
+            BEAST_EXPECT(res[field::content_length] == "1");
+        }
+    }
+
+    void
+    run() override
+    {
+        testBody();
+        testEtagList();
+        testPrepare();
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(beast,http,cached_file_body);
+
+} // http
+} // beast
+
+#endif
@@ -0,0 +1,428 @@
+//
+// Copyright (c) 2016-2017 Vinnie Falco (vinnie dot falco at gmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/boostorg/beast
+//
+
+// Test that header file is self-contained.
+#include <beast/http/compressed_body.hpp>
+
+#include <beast/core/buffers_to_string.hpp>
+#include <beast/http/buffer_body.hpp>
+#include <beast/http/serializer.hpp>
+#include <beast/http/string_body.hpp>
+#include <beast/zlib/inflate_stream.hpp>
+#include <beast/unit_test/suite.hpp>
+#include <random>
+#include <string>
+#include <utility>
+
+namespace beast {
+namespace http {
+
+class compressed_body_test
+    : public beast::unit_test::suite
+{
+public:
+    static
+    std::string
+    make_text(std::size_t size)
+    {
+        static char const* const words[] = {
+            "the ", "quick ", "brown ", "fox ", "jumps ",
+            "over ", "lazy ", "dog ", "HTTP/1.1 ", "200 ",
+            "Content-Type: ", "text/html\r\n", "<div>", "</div>\n"};
+        std::mt19937 g{0};
+        std::string s;
+        s.reserve(size);
+        while(s.size() < size)
+            s += words[g() % (sizeof(words) / sizeof(words[0]))];
+        s.resize(size);
+        return s;
+    }
+
+    // Remove the gzip or zlib framing, inflate the
+    // raw deflate data and verify the trailer.
+    std::string
+    decode(std::string const& in, content_coding coding)
+    {
+        std::size_t pos;
+        if(coding == content_coding::gzip)
+        {
+            if(! BEAST_EXPECT(in.size() >= 18))
+                return {};
+            BEAST_EXPECT(static_cast<unsigned char>(in[0]) == 0x1f);
+            BEAST_EXPECT(static_cast<unsigned char>(in[1]) == 0x8b);
+            BEAST_EXPECT(in[2] == 8);
+            BEAST_EXPECT(in[3] == 0);
+            pos = 10;
+        }
+        else
+        {
+            if(! BEAST_EXPECT(in.size() >= 6))
+                return {};
+            auto const cmf = static_cast<unsigned char>(in[0]);
+            auto const flg = static_cast<unsigned char>(in[1]);
+            BEAST_EXPECT(cmf == 0x78);
+            BEAST_EXPECT((cmf * 256 + flg) % 31 == 0);
+            BEAST_EXPECT((flg & 0x20) == 0);
+            pos = 2;
+        }
+        std::string out;
+        zlib::inflate_stream is;
+        zlib::z_params zs;
+        zs.next_in = &in[pos];
+        zs.avail_in = in.size() - pos;
+        char buf[4096];
+        error_code ec;
+        for(;;)
+        {
+            zs.next_out = buf;
+            zs.avail_out = sizeof(buf);
+            is.write(zs, zlib::Flush::sync, ec);
+            out.append(buf, sizeof(buf) - zs.avail_out);
+            if(ec == zlib::error::end_of_stream)
+                break;
+            if(! BEAST_EXPECTS(! ec, ec.message()))
+                return {};
+        }
+        auto const p = reinterpret_cast<
+            unsigned char const*>(zs.next_in);
+        auto const get32le =
+            [](unsigned char const* p)
+            {
+                return std::uint32_t{p[0]} | (std::uint32_t{p[1]} << 8) |
+                    (std::uint32_t{p[2]} << 16) | (std::uint32_t{p[3]} << 24);
+            };
+        if(coding == content_coding::gzip)
+        {
+            BEAST_EXPECT(zs.avail_in == 8);
+            BEAST_EXPECT(get32le(p) ==
+                zlib::detail::crc32(0, out.data(), out.size()));
+            BEAST_EXPECT(get32le(p + 4) ==
+                static_cast<std::uint32_t>(out.size()));
+        }
+        else
+        {
+            BEAST_EXPECT(zs.avail_in == 4);
+            BEAST_EXPECT(
+                ((std::uint32_t{p[0]} << 24) | (std::uint32_t{p[1]} << 16) |
+                (std::uint32_t{p[2]} << 8) | std::uint32_t{p[3]}) ==
+                zlib::detail::adler32(1, out.data(), out.size()));
+        }
+        return out;
+    }
+
+    // Run the writer to completion
+    template<class Body>
+    std::string
+    encode(message<false, compressed_body<Body>, fields>& res)
+    {
+        std::string out;
+        typename compressed_body<Body>::writer w{res, res.body()};
+        error_code ec;
+        w.init(ec);
+        if(! BEAST_EXPECTS(! ec, ec.message()))
+            return {};
+        for(;;)
+        {
+            auto const result = w.get(ec);
+            if(! BEAST_EXPECTS(! ec, ec.message()))
+                break;
+            if(! result)
+                break;
+            auto const n = asio::buffer_size(result->first);
+            BEAST_EXPECT(n > 0);
+            BEAST_EXPECT(n <= 8192);
+            out.append(static_cast<char const*>(
+                result->first.data()), n);
+            if(! result->second)
+                break;
+        }
+        return out;
+    }
+
+    void
+    testChecksums()
+    {
+        std::string const s = "123456789";
+        BEAST_EXPECT(zlib::detail::crc32(
+            0, s.data(), s.size()) == 0xcbf43926);
+        BEAST_EXPECT(zlib::detail::adler32(
+            1, s.data(), s.size()) == 0x091e01de);
+        BEAST_EXPECT(zlib::detail::crc32(
+            zlib::detail::crc32(0, s.data(), 4), s.data() + 4, 5) ==
+                0xcbf43926);
+        std::string const big(100000, '\xff');
+        BEAST_EXPECT(zlib::detail::adler32(
+            zlib::detail::adler32(1, big.data(), 60000),
+                big.data() + 60000, 40000) ==
+            zlib::detail::adler32(1, big.data(), big.size()));
+    }
+
+    void
+    testCodings()
+    {
+        using B = compressed_body<string_body>;
+        auto const check =
+            [&](std::string const& s, content_coding coding, int level)
+            {
+                response<B> res;
+                res.body().body = s;
+                res.body().coding = coding;
+                res.body().level = level;
+                auto const out = encode(res);
+                if(coding == content_coding::identity)
+                {
+                    BEAST_EXPECT(out == s);
+                    return;
+                }
+                BEAST_EXPECT(decode(out, coding) == s);
+                if(s.size() > 1000 && level != 0)
+                    BEAST_EXPECT(out.size() < s.size() / 2);
+            };
+
+        for(auto coding : {
+            content_coding::gzip,
+            content_coding::deflate,
+            content_coding::identity})
+        {
+            for(auto level : {-1, 0, 1, 9})
+            {
+                check("", coding, level);
+                check("Hello, world!", coding, level);
+                check(make_text(100000), coding, level);
+            }
+        }
+
+        // FLEVEL in the zlib header matches what zlib writes
+        for(auto const& v : {
+            std::make_pair(-1, 2), std::make_pair(0, 0),
+            std::make_pair(1, 0), std::make_pair(2, 1),
+            std::make_pair(5, 1), std::make_pair(6, 2),
+            std::make_pair(7, 3), std::make_pair(9, 3)})
+        {
+            response<B> res;
+            res.body().body = "Hello, world!";
+            res.body().coding = content_coding::deflate;
+            res.body().level = v.first;
+            auto const out = encode(res);
+            if(BEAST_EXPECT(out.size() >= 2))
+                BEAST_EXPECTS(static_cast<unsigned char>(
+                    out[1]) >> 6 == v.second, std::to_string(v.first));
+        }
+    }
+
+    void
+    testBadCoding()
+    {
+        response<compressed_body<string_body>> res;
+        res.body().coding = content_coding::unknown;
+        compressed_body<string_body>::writer w{res, res.body()};
+        error_code ec;
+        w.init(ec);
+        BEAST_EXPECT(ec == error::bad_content_coding);
+    }
+
+    void
+    testBufferBody()
+    {
+        // Data is flushed each time the inner
+        // writer runs out of buffers.
+        using B = compressed_body<buffer_body>;
+        response<B> res;
+        res.body().coding = content_coding::gzip;
+        auto& b = res.body().body;
+        b.data = nullptr;
+        b.more = true;
+        B::writer w{res, res.body()};
+        error_code ec;
+        w.init(ec);
+        BEAST_EXPECTS(! ec, ec.message());
+        std::string out;
+        boost::optional<std::pair<
+            B::writer::const_buffers_type, bool>> result;
+        auto const drain =
+            [&]
+            {
+                for(;;)
+                {
+                    result = w.get(ec);
+                    if(ec == error::need_buffer)
+                        return true;
+                    if(! BEAST_EXPECTS(! ec, ec.message()))
+                        return false;
+                    if(! BEAST_EXPECT(result))
+                        return false;
+                    BEAST_EXPECT(result->second);
+                    out.append(static_cast<char const*>(
+                        result->first.data()),
+                            asio::buffer_size(result->first));
+                }
+            };
+        if(! drain())
+            return;
+        BEAST_EXPECT(out.size() >= 10);
+
+        std::string const s1 = make_text(20000);
+        std::string const s2 = make_text(500);
+        std::string const* const inputs[] = {&s1, &s2};
+        for(auto const ps : inputs)
+        {
+            auto const& s = *ps;
+            b.data = const_cast<char*>(s.data());
+            b.size = s.size();
+            if(! drain())
+                return;
+            // Everything provided so far can be decoded
+            auto const t = out;
+            zlib::inflate_stream is;
+            zlib::z_params zs;
+            zs.next_in = &t[10];
+            zs.avail_in = t.size() - 10;
+            std::string got(s1.size() + s2.size(), 0);
+            zs.next_out = &got[0];
+            zs.avail_out = got.size();
+            ec = {};
+            is.write(zs, zlib::Flush::sync, ec);
+            BEAST_EXPECTS(! ec, ec.message());
+            got.resize(got.size() - zs.avail_out);
+            if(ps == &s1)
+                BEAST_EXPECT(got == s1);
+            else
+                BEAST_EXPECT(got == s1 + s2);
+        }
+        b.data = nullptr;
+        b.more = false;
+        for(;;)
+        {
+            result = w.get(ec);
+            if(! BEAST_EXPECTS(! ec, ec.message()))
+                return;
+            if(! result)
+                break;
+            out.append(static_cast<char const*>(
+                result->first.data()),
+                    asio::buffer_size(result->first));
+            if(! result->second)
+                break;
+        }
+        BEAST_EXPECT(decode(out, content_coding::gzip) == s1 + s2);
+    }
+
+    void
+    testPrepare()
+    {
+        {
+            response<compressed_body<string_body>> res{status::ok, 11};
+            res.set(field::content_length, 5);
+            res.body().coding = content_coding::gzip;
+            prepare_compressed_payload(res);
+            BEAST_EXPECT(res[field::content_encoding] == "gzip");
+            BEAST_EXPECT(res[field::vary] == "Accept-Encoding");
+            BEAST_EXPECT(! res.has_content_length());
+            BEAST_EXPECT(res.chunked());
+        }
+        {
+            response<compressed_body<string_body>> res{status::ok, 11};
+            res.set(field::vary, "Origin");
+            res.set(field::content_encoding, "gzip");
+            res.body().coding = content_coding::identity;
+            prepare_compressed_payload(res);
+            BEAST_EXPECT(res.count(field::content_encoding) == 0);
+            BEAST_EXPECT(res[field::vary] == "Origin, Accept-Encoding");
+            prepare_compressed_payload(res);
+            BEAST_EXPECT(res[field::vary] == "Origin, Accept-Encoding");
+        }
+        {
+            request<compressed_body<string_body>> req{verb::post, "/", 10};
+            req.body().coding = content_coding::deflate;
+            prepare_compressed_payload(req);
+            BEAST_EXPECT(req[field::content_encoding] == "deflate");
+            BEAST_EXPECT(req.count(field::vary) == 0);
+            BEAST_EXPECT(! req.chunked());
+        }
+    }
+
+    struct visitor
+    {
+        std::string& out;
+        std::size_t size;
+
+        template<class ConstBufferSequence>
+        void
+        operator()(error_code&,
+            ConstBufferSequence const& buffers)
+        {
+            size = asio::buffer_size(buffers);
+            out.append(buffers_to_string(buffers));
+        }
+    };
+
+    void
+    testSerializer()
+    {
+        response<compressed_body<string_body>> res{status::ok, 11};
+        res.body().body = make_text(50000);
+        prepare_compressed_payload(res);
+        serializer<false, compressed_body<string_body>> sr{res};
+        sr.limit(1000);
+        std::string out;
+        error_code ec;
+        visitor visit{out, 0};
+        while(! sr.is_done())
+        {
+            sr.next(ec, visit);
+            if(! BEAST_EXPECTS(! ec, ec.message()))
+                return;
+            BEAST_EXPECT(visit.size <= 1000);
+            sr.consume(visit.size);
+        }
+        BEAST_EXPECT(out.find("Content-Encoding: gzip\r\n") != std::string::npos);
+        BEAST_EXPECT(out.find("Transfer-Encoding: chunked\r\n") != std::string::npos);
+        BEAST_EXPECT(out.size() < 50000 / 2);
+    }
+
+    void
+    testPool()
+    {
+        // The compression state is reused across messages
+        using pool = detail::codec_pool<detail::deflate_codec>;
+        detail::deflate_codec* p;
+        {
+            auto c = pool::acquire();
+            p = c.get();
+        }
+        {
+            auto c = pool::acquire();
+            BEAST_EXPECT(c.get() == p);
+        }
+        for(int i = 0; i < 2; ++i)
+        {
+            response<compressed_body<string_body>> res;
+            res.body().body = make_text(10000);
+            BEAST_EXPECT(decode(encode(res),
+                content_coding::gzip) == res.body().body);
+        }
+    }
+
+    void
+    run() override
+    {
+        testChecksums();
+        testCodings();
+        testBadCoding();
+        testBufferBody();
+        testPrepare();
+        testSerializer();
+        testPool();
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(beast,http,compressed_body);
+
+} // http
+} // beast
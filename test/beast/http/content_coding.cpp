@@ -0,0 +1,88 @@
+//
+// Copyright (c) 2016-2017 Vinnie Falco (vinnie dot falco at gmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/boostorg/beast
+//
+
+// Test that header file is self-contained.
+#include <beast/http/content_coding.hpp>
+
+#include <beast/unit_test/suite.hpp>
+
+namespace beast {
+namespace http {
+
+class content_coding_test
+    : public beast::unit_test::suite
+{
+public:
+    void
+    testStrings()
+    {
+        auto const good =
+            [&](content_coding c)
+            {
+                BEAST_EXPECT(string_to_content_coding(to_string(c)) == c);
+            };
+
+        good(content_coding::identity);
+        good(content_coding::deflate);
+        good(content_coding::gzip);
+
+        BEAST_EXPECT(string_to_content_coding("GZip") == content_coding::gzip);
+        BEAST_EXPECT(string_to_content_coding("x-gzip") == content_coding::gzip);
+        BEAST_EXPECT(string_to_content_coding("br") == content_coding::unknown);
+        BEAST_EXPECT(string_to_content_coding("") == content_coding::unknown);
+        BEAST_EXPECT(to_string(content_coding::unknown) == "<unknown>");
+    }
+
+    void
+    testNegotiate()
+    {
+        auto const check =
+            [&](string_view s, content_coding c)
+            {
+                BEAST_EXPECTS(negotiate_content_coding(s) == c, s);
+            };
+
+        check("", content_coding::identity);
+        check("gzip", content_coding::gzip);
+        check("deflate", content_coding::deflate);
+        check("gzip, deflate, br", content_coding::gzip);
+        check("deflate, gzip", content_coding::gzip);
+        check("br", content_coding::identity);
+        check("identity", content_coding::identity);
+        check("*", content_coding::gzip);
+        check("gzip;q=0.5, deflate", content_coding::deflate);
+        check("gzip;q=0.5, deflate;q=0.25", content_coding::gzip);
+        check("gzip;q=0, deflate;q=0", content_coding::identity);
+        check("gzip;q=0, *", content_coding::deflate);
+        check("*;q=0, identity", content_coding::identity);
+        check("*;q=0.1, identity;q=0.5", content_coding::identity);
+        check("gzip;q=1.0, identity;q=1", content_coding::gzip);
+        check("gzip;q=0.001", content_coding::gzip);
+        check("GZIP;Q=0.8", content_coding::gzip);
+        check("x-gzip", content_coding::gzip);
+
+        // malformed quality values are ignored
+        check("gzip;q=2", content_coding::identity);
+        check("gzip;q=1.5", content_coding::identity);
+        check("gzip;q=0.1234", content_coding::identity);
+        check("gzip;q=x, deflate", content_coding::deflate);
+    }
+
+    void
+    run() override
+    {
+        testStrings();
+        testNegotiate();
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(beast,http,content_coding);
+
+} // http
+} // beast
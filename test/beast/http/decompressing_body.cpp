@@ -0,0 +1,404 @@
+//
+// Copyright (c) 2016-2017 Vinnie Falco (vinnie dot falco at gmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/boostorg/beast
+//
+
+// Test that header file is self-contained.
+#include <beast/http/decompressing_body.hpp>
+
+#include <beast/http/buffer_body.hpp>
+#include <beast/http/compressed_body.hpp>
+#include <beast/http/parser.hpp>
+#include <beast/http/string_body.hpp>
+#include <beast/unit_test/suite.hpp>
+#include <random>
+#include <string>
+
+namespace beast {
+namespace http {
+
+class decompressing_body_test
+    : public beast::unit_test::suite
+{
+public:
+    using B = decompressing_body<string_body>;
+
+    static
+    std::string
+    make_text(std::size_t size)
+    {
+        static char const* const words[] = {
+            "{\"id\": ", "42, ", "\"name\": ", "\"fox\", ",
+            "\"tags\": [", "\"quick\", ", "\"brown\"], ",
+            "\"level\": ", "\"info\"}\n"};
+        std::mt19937 g{0};
+        std::string s;
+        s.reserve(size);
+        while(s.size() < size)
+            s += words[g() % (sizeof(words) / sizeof(words[0]))];
+        s.resize(size);
+        return s;
+    }
+
+    // Produce a coded payload using compressed_body
+    static
+    std::string
+    encode(std::string const& s, content_coding coding)
+    {
+        request<compressed_body<string_body>> req;
+        req.body().body = s;
+        req.body().coding = coding;
+        compressed_body<string_body>::writer w{req, req.body()};
+        error_code ec;
+        w.init(ec);
+        std::string out;
+        for(;;)
+        {
+            auto const result = w.get(ec);
+            if(ec || ! result)
+                break;
+            out.append(static_cast<char const*>(
+                result->first.data()), result->first.size());
+            if(! result->second)
+                break;
+        }
+        return out;
+    }
+
+    // Run the reader on the coded payload in pieces of
+    // the given size, returning the decoded payload.
+    static
+    std::string
+    decode(
+        string_view coding,
+        std::string const& in,
+        std::size_t step,
+        error_code& ec,
+        std::uint64_t limit = 8 * 1024 * 1024)
+    {
+        request<B> req;
+        if(! coding.empty())
+            req.set(field::content_encoding, coding);
+        req.body().limit = limit;
+        B::reader r{req, req.body()};
+        r.init(boost::none, ec);
+        if(ec)
+            return {};
+        std::size_t pos = 0;
+        while(pos < in.size())
+        {
+            auto const n = (std::min)(step, in.size() - pos);
+            pos += r.put(asio::const_buffer{
+                in.data() + pos, n}, ec);
+            if(ec)
+                return {};
+        }
+        r.finish(ec);
+        return req.body().body;
+    }
+
+    void
+    testCodings()
+    {
+        auto const check =
+            [&](std::string const& s, content_coding coding)
+            {
+                auto const in = encode(s, coding);
+                for(std::size_t step : {1, 7, 1000, 1000000})
+                {
+                    error_code ec;
+                    auto const out = decode(
+                        coding == content_coding::identity ?
+                            "" : to_string(coding), in, step, ec);
+                    BEAST_EXPECTS(! ec, ec.message());
+                    BEAST_EXPECT(out == s);
+                }
+            };
+
+        for(auto coding : {
+            content_coding::gzip,
+            content_coding::deflate,
+            content_coding::identity})
+        {
+            check("", coding);
+            check("Hello, world!", coding);
+            check(make_text(100000), coding);
+        }
+
+        // codings are matched without regard to case, and
+        // identity entries are ignored
+        error_code ec;
+        auto const s = make_text(5000);
+        BEAST_EXPECT(decode("GZIP", encode(s,
+            content_coding::gzip), 100, ec) == s);
+        BEAST_EXPECTS(! ec, ec.message());
+        BEAST_EXPECT(decode("identity, deflate", encode(s,
+            content_coding::deflate), 100, ec) == s);
+        BEAST_EXPECTS(! ec, ec.message());
+        BEAST_EXPECT(decode("identity", s, 100, ec) == s);
+        BEAST_EXPECTS(! ec, ec.message());
+
+        // an empty payload is allowed
+        BEAST_EXPECT(decode("gzip", "", 1, ec).empty());
+        BEAST_EXPECTS(! ec, ec.message());
+    }
+
+    void
+    testGzipHeader()
+    {
+        auto const s = make_text(3000);
+        auto const in = encode(s, content_coding::gzip);
+
+        // Add FEXTRA, FNAME, FCOMMENT and FHCRC
+        std::string hdr = in.substr(0, 10);
+        hdr[3] = 4 | 8 | 16 | 2;
+        hdr += std::string("\x05\x00" "extra", 7);
+        hdr += std::string("name.json\0", 10);
+        hdr += std::string("comment\0", 8);
+        hdr += std::string("\xab\xcd", 2);
+        auto const coded = hdr + in.substr(10);
+        for(std::size_t step : {1, 3, 11, 100000})
+        {
+            error_code ec;
+            BEAST_EXPECT(decode("gzip", coded, step, ec) == s);
+            BEAST_EXPECTS(! ec, ec.message());
+        }
+
+        // concatenated members
+        auto const t = make_text(200);
+        auto const multi = in + encode(t, content_coding::gzip);
+        for(std::size_t step : {1, 5, 100000})
+        {
+            error_code ec;
+            BEAST_EXPECT(decode("x-gzip", multi, step, ec) == s + t);
+            BEAST_EXPECTS(! ec, ec.message());
+        }
+    }
+
+    void
+    testLimit()
+    {
+        auto const s = make_text(100000);
+        for(auto coding : {
+            content_coding::gzip,
+            content_coding::deflate})
+        {
+            auto const in = encode(s, coding);
+            BEAST_EXPECT(in.size() < 10000);
+            error_code ec;
+            decode(to_string(coding), in, 1000, ec, 10000);
+            BEAST_EXPECTS(ec == error::body_limit, ec.message());
+            decode(to_string(coding), in, 1000, ec, s.size());
+            BEAST_EXPECTS(! ec, ec.message());
+            decode(to_string(coding), in, 1000, ec, s.size() - 1);
+            BEAST_EXPECTS(ec == error::body_limit, ec.message());
+        }
+
+        // identity with a known length
+        {
+            request<B> req;
+            req.body().limit = 100;
+            B::reader r{req, req.body()};
+            error_code ec;
+            r.init(std::uint64_t{101}, ec);
+            BEAST_EXPECTS(ec == error::body_limit, ec.message());
+        }
+
+        // identity with an unknown length
+        {
+            error_code ec;
+            decode("", s, 1000, ec, 5000);
+            BEAST_EXPECTS(ec == error::body_limit, ec.message());
+            decode("", s, 1000, ec, s.size());
+            BEAST_EXPECTS(! ec, ec.message());
+        }
+    }
+
+    void
+    testErrors()
+    {
+        auto const s = make_text(20000);
+        auto const gz = encode(s, content_coding::gzip);
+        auto const zl = encode(s, content_coding::deflate);
+
+        auto const check =
+            [&](string_view coding, std::string const& in,
+                error_code const& expected)
+            {
+                for(std::size_t step : {1, 1000000})
+                {
+                    error_code ec;
+                    decode(coding, in, step, ec);
+                    BEAST_EXPECTS(ec == expected, ec.message());
+                }
+            };
+
+        // unsupported codings
+        check("br", gz, error::bad_content_coding);
+        check("gzip, gzip", gz, error::bad_content_coding);
+        check("deflate, gzip", gz, error::bad_content_coding);
+
+        // checksum and size
+        {
+            auto in = gz;
+            in[in.size() - 6] ^= 1;
+            check("gzip", in, error::bad_encoded_body);
+            in = gz;
+            in[in.size() - 2] ^= 1;
+            check("gzip", in, error::bad_encoded_body);
+            in = zl;
+            in[in.size() - 1] ^= 1;
+            check("deflate", in, error::bad_encoded_body);
+        }
+
+        // framing
+        {
+            auto in = gz;
+            in[0] = 'x';
+            check("gzip", in, error::bad_encoded_body);
+            in = gz;
+            in[3] = '\x80';
+            check("gzip", in, error::bad_encoded_body);
+            in = zl;
+            in[1] ^= 1;
+            check("deflate", in, error::bad_encoded_body);
+            in = zl;
+            in[1] = '\xbb'; // FDICT
+            check("deflate", in, error::bad_encoded_body);
+            check("deflate", zl + "x", error::bad_encoded_body);
+            check("gzip", gz + "x", error::bad_encoded_body);
+            check("gzip", gz.substr(0, gz.size() - 1),
+                error::bad_encoded_body);
+            check("deflate", zl.substr(0, zl.size() / 2),
+                error::bad_encoded_body);
+            check("gzip", gz.substr(0, 5), error::bad_encoded_body);
+        }
+
+        // invalid deflate data is reported by zlib
+        {
+            auto in = gz;
+            in[10] = '\xff';
+            error_code ec;
+            decode("gzip", in, 1000, ec);
+            BEAST_EXPECT(ec);
+            BEAST_EXPECT(ec.category() == make_error_code(
+                zlib::error::need_buffers).category());
+        }
+    }
+
+    void
+    testBufferBody()
+    {
+        using BB = decompressing_body<buffer_body>;
+        auto const s = make_text(100000);
+        for(auto coding : {
+            content_coding::gzip,
+            content_coding::deflate})
+        {
+            auto const in = encode(s, coding);
+            for(std::size_t step : {1, 100, 1000000})
+            {
+                request<BB> req;
+                req.set(field::content_encoding, to_string(coding));
+                BB::reader r{req, req.body()};
+                error_code ec;
+                r.init(boost::none, ec);
+                BEAST_EXPECTS(! ec, ec.message());
+                std::string out;
+                char buf[777];
+                req.body().body.data = buf;
+                req.body().body.size = sizeof(buf);
+                std::size_t pos = 0;
+                while(pos < in.size())
+                {
+                    auto const n = (std::min)(step, in.size() - pos);
+                    pos += r.put(asio::const_buffer{
+                        in.data() + pos, n}, ec);
+                    if(ec == error::need_buffer)
+                    {
+                        // The reader never claims all of the
+                        // input while it holds decoded data.
+                        BEAST_EXPECT(pos < in.size());
+                        out.append(buf, sizeof(buf) -
+                            req.body().body.size);
+                        req.body().body.data = buf;
+                        req.body().body.size = sizeof(buf);
+                        continue;
+                    }
+                    if(! BEAST_EXPECTS(! ec, ec.message()))
+                        break;
+                }
+                r.finish(ec);
+                BEAST_EXPECTS(! ec, ec.message());
+                out.append(buf, sizeof(buf) - req.body().body.size);
+                BEAST_EXPECT(out == s);
+            }
+        }
+    }
+
+    void
+    testParser()
+    {
+        auto const s = make_text(50000);
+        auto const coded = encode(s, content_coding::gzip);
+        std::string const msg =
+            "POST /upload HTTP/1.1\r\n"
+            "Host: localhost\r\n"
+            "Content-Type: application/json\r\n"
+            "Content-Encoding: gzip\r\n"
+            "Content-Length: " + std::to_string(coded.size()) + "\r\n"
+            "\r\n" + coded;
+        request_parser<B> p;
+        p.eager(true);
+        error_code ec;
+        std::size_t pos = 0;
+        while(! p.is_done() && pos < msg.size())
+        {
+            auto const n = (std::min)(
+                std::size_t{512}, msg.size() - pos);
+            pos += p.put(asio::const_buffer{
+                msg.data() + pos, n}, ec);
+            if(ec == error::need_more)
+                continue;
+            if(! BEAST_EXPECTS(! ec, ec.message()))
+                return;
+        }
+        BEAST_EXPECT(p.is_done());
+        BEAST_EXPECT(p.get().body().coding == content_coding::gzip);
+        BEAST_EXPECT(p.get().body().body == s);
+    }
+
+    void
+    testPool()
+    {
+        // Readers return their state to the pool
+        auto const in = encode("Hello", content_coding::gzip);
+        for(int i = 0; i < 10; ++i)
+        {
+            error_code ec;
+            BEAST_EXPECT(decode("gzip", in, 2, ec) == "Hello");
+            BEAST_EXPECTS(! ec, ec.message());
+        }
+    }
+
+    void
+    run() override
+    {
+        testCodings();
+        testGzipHeader();
+        testLimit();
+        testErrors();
+        testBufferBody();
+        testParser();
+        testPool();
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(beast,http,decompressing_body);
+
+} // http
+} // beast
@@ -986,6 +986,95 @@ public:
         BEAST_EXPECT(res[field::transfer_encoding] == "chunked, foo");
     }
 
+    void
+    testMetadata()
+    {
+        // The cached interpretation of Connection,
+        // Transfer-Encoding and Content-Length must
+        // follow every kind of modification.
+
+        request<empty_body> req{verb::get, "/", 11};
+        BEAST_EXPECT(req.keep_alive());
+        BEAST_EXPECT(! req.chunked());
+        BEAST_EXPECT(! req.has_content_length());
+
+        req.insert("CONNECTION", "upgrade, Close");
+        BEAST_EXPECT(! req.keep_alive());
+        req.insert(field::connection, "keep-alive");
+        BEAST_EXPECT(! req.keep_alive());
+        req.erase(req.find(field::connection));
+        BEAST_EXPECT(req.keep_alive());
+        req.version(10);
+        BEAST_EXPECT(req.keep_alive());
+        req.erase("connection");
+        BEAST_EXPECT(! req.keep_alive());
+        req.keep_alive(true);
+        BEAST_EXPECT(req[field::connection] == "keep-alive");
+        req.keep_alive(true);
+        BEAST_EXPECT(req[field::connection] == "keep-alive");
+        req.set(field::connection, "close, keep-alive");
+        BEAST_EXPECT(req.keep_alive());
+        req.keep_alive(true);
+        BEAST_EXPECT(req[field::connection] == "keep-alive");
+        req.version(11);
+        req.keep_alive(false);
+        BEAST_EXPECT(req[field::connection] == "close");
+        req.keep_alive(false);
+        BEAST_EXPECT(req[field::connection] == "close");
+        req.set(field::connection, "upgrade");
+        req.keep_alive(true);
+        BEAST_EXPECT(req[field::connection] == "upgrade");
+
+        req.insert("Transfer-Encoding", "gzip");
+        BEAST_EXPECT(! req.chunked());
+        req.set("transfer-encoding", "gzip, CHUNKED");
+        BEAST_EXPECT(req.chunked());
+        req.insert("Content-Length", "0");
+        BEAST_EXPECT(req.has_content_length());
+
+        {
+            auto req2 = req;
+            BEAST_EXPECT(req2.chunked());
+            BEAST_EXPECT(req2.has_content_length());
+            request<empty_body> req3;
+            swap(req2, req3);
+            BEAST_EXPECT(! req2.chunked());
+            BEAST_EXPECT(! req2.has_content_length());
+            BEAST_EXPECT(req3.chunked());
+            BEAST_EXPECT(req3.has_content_length());
+            req2 = std::move(req3);
+            BEAST_EXPECT(req2.chunked());
+            BEAST_EXPECT(! req3.chunked());
+            BEAST_EXPECT(! req3.has_content_length());
+            req2.clear();
+            BEAST_EXPECT(req2.keep_alive());
+            BEAST_EXPECT(! req2.chunked());
+            BEAST_EXPECT(! req2.has_content_length());
+        }
+
+        req.chunked(false);
+        BEAST_EXPECT(req[field::transfer_encoding] == "gzip");
+        BEAST_EXPECT(! req.has_content_length());
+        req.content_length(5);
+        BEAST_EXPECT(req.has_content_length());
+        BEAST_EXPECT(req[field::transfer_encoding] == "gzip");
+        req.erase(field::content_length);
+        BEAST_EXPECT(! req.has_content_length());
+
+        response<empty_body> res{status::ok, 11};
+        BEAST_EXPECT(res.need_eof());
+        res.content_length(0);
+        BEAST_EXPECT(! res.need_eof());
+        res.insert(field::connection, "close");
+        BEAST_EXPECT(res.need_eof());
+        res.erase(res.find(field::connection));
+        BEAST_EXPECT(! res.need_eof());
+        res.erase(field::content_length);
+        BEAST_EXPECT(res.need_eof());
+        res.chunked(true);
+        BEAST_EXPECT(! res.need_eof());
+    }
+
     void
     run() override
     {
@@ -1000,6 +1089,7 @@ public:
         testKeepAlive();
         testContentLength();
         testChunked();
+        testMetadata();
     }
 };
 
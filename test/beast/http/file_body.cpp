@@ -14,13 +14,26 @@
 #include <beast/core/file_stdio.hpp>
 #include <beast/core/flat_buffer.hpp>
 #include <beast/http/parser.hpp>
+#include <beast/http/read.hpp>
 #include <beast/http/serializer.hpp>
+#include <beast/http/string_body.hpp>
 #include <beast/unit_test/suite.hpp>
+#include <asio/io_context.hpp>
+#include <asio/ip/tcp.hpp>
+#include <asio/write.hpp>
 #include <boost/filesystem.hpp>
+#include <string>
+#include <thread>
+#include <vector>
 
 namespace beast {
 namespace http {
 
+BOOST_STATIC_ASSERT(! detail::has_prefetch<file_stdio>::value);
+#if BEAST_USE_POSIX_FILE
+BOOST_STATIC_ASSERT(detail::has_prefetch<file_posix>::value);
+#endif
+
 class file_body_test : public beast::unit_test::suite
 {
 public:
@@ -96,15 +109,315 @@ public:
         boost::filesystem::remove(temp, ec);
         BEAST_EXPECTS(! ec, ec.message());
     }
+
+    // Returns the sizes of the buffers produced by the writer
+    template<class File>
+    std::vector<std::size_t>
+    read_sizes(char const* path,
+        std::size_t read_size, std::string& out)
+    {
+        error_code ec;
+        std::vector<std::size_t> v;
+        response<basic_file_body<File>> res{status::ok, 11};
+        res.body().open(path, file_mode::scan, ec);
+        BEAST_EXPECTS(! ec, ec.message());
+        BEAST_EXPECT(res.body().read_size() == 1024 * 1024);
+        res.body().read_size(read_size);
+        BEAST_EXPECT(res.body().read_size() == read_size);
+        typename basic_file_body<File>::writer w{res, res.body()};
+        w.init(ec);
+        BEAST_EXPECTS(! ec, ec.message());
+        for(;;)
+        {
+            auto const result = w.get(ec);
+            if(! BEAST_EXPECTS(! ec, ec.message()) || ! result)
+                break;
+            v.push_back(result->first.size());
+            out.append(static_cast<char const*>(
+                result->first.data()), result->first.size());
+            if(! result->second)
+                break;
+        }
+        return v;
+    }
+
+    template<class File>
+    void
+    doTestReadSize()
+    {
+        using v = std::vector<std::size_t>;
+        std::size_t const K = 1024;
+        std::string s;
+        s.resize(1000 * K);
+        for(std::size_t i = 0; i < s.size(); ++i)
+            s[i] = static_cast<char>(i % 251);
+
+        error_code ec;
+        auto const temp = boost::filesystem::unique_path();
+        auto const path = temp.string<std::string>();
+        {
+            File f;
+            f.open(path.c_str(), file_mode::write, ec);
+            BEAST_EXPECTS(! ec, ec.message());
+            f.write(s.data(), s.size(), ec);
+            BEAST_EXPECTS(! ec, ec.message());
+        }
+        {
+            // reads grow up to the limit
+            std::string out;
+            BEAST_EXPECT(read_sizes<File>(path.c_str(), 256 * K, out) ==
+                (v{64 * K, 128 * K, 256 * K, 256 * K, 256 * K, 40 * K}));
+            BEAST_EXPECT(out == s);
+        }
+        {
+            std::string out;
+            BEAST_EXPECT(read_sizes<File>(path.c_str(), 1024 * K, out) ==
+                (v{64 * K, 128 * K, 256 * K, 512 * K, 40 * K}));
+            BEAST_EXPECT(out == s);
+        }
+        {
+            // limits below the initial size
+            std::string out;
+            auto const sizes = read_sizes<File>(path.c_str(), 1000, out);
+            BEAST_EXPECT(sizes.size() == 1024);
+            BEAST_EXPECT(sizes.front() == 1000);
+            BEAST_EXPECT(sizes.back() == 1000);
+            BEAST_EXPECT(out == s);
+        }
+        boost::filesystem::remove(temp, ec);
+        BEAST_EXPECTS(! ec, ec.message());
+    }
+
+#if BEAST_USE_SPLICE
+    static
+    std::string
+    read_file(std::string const& path)
+    {
+        error_code ec;
+        file_posix f;
+        f.open(path.c_str(), file_mode::scan, ec);
+        std::string s;
+        s.resize(static_cast<std::size_t>(f.size(ec)));
+        if(! s.empty())
+            f.read(&s[0], s.size(), ec);
+        return s;
+    }
+
+    // Send `data` from a connected peer of `sock`,
+    // closing the connection afterwards if `close`.
+    static
+    std::thread
+    connect(asio::io_context& ioc, asio::ip::tcp::socket& sock,
+        std::string const& data, bool close)
+    {
+        using asio::ip::tcp;
+        tcp::acceptor a{ioc, tcp::endpoint{
+            asio::ip::make_address_v4("127.0.0.1"), 0}};
+        auto const ep = a.local_endpoint();
+        std::thread t{[ep, &data, close]
+            {
+                asio::io_context ioc;
+                tcp::socket s{ioc};
+                s.connect(ep);
+                error_code ec;
+                asio::write(s, asio::buffer(data), ec);
+                if(! close)
+                {
+                    // wait for the reader to hang up
+                    char c;
+                    s.read_some(asio::buffer(&c, 1), ec);
+                }
+            }};
+        a.accept(sock);
+        return t;
+    }
+
+    void
+    testSplice()
+    {
+        using asio::ip::tcp;
+        auto const path = boost::filesystem::unique_path().string();
+        std::string body;
+        for(std::size_t i = 0; body.size() < 1000000; ++i)
+            body += std::to_string(i) + "\n";
+        auto const header =
+            "POST / HTTP/1.1\r\n"
+            "Content-Length: " + std::to_string(body.size()) + "\r\n"
+            "\r\n";
+        auto const next =
+            "GET /next HTTP/1.1\r\n"
+            "\r\n";
+        auto const data = header + body + next;
+
+        // synchronous, followed by a pipelined request
+        {
+            asio::io_context ioc;
+            tcp::socket sock{ioc};
+            auto t = connect(ioc, sock, data, false);
+            flat_buffer b;
+            request_parser<file_body> p;
+            error_code ec;
+            p.get().body().open(path.c_str(), file_mode::write, ec);
+            BEAST_EXPECTS(! ec, ec.message());
+            auto const n = http::read(sock, b, p, ec);
+            BEAST_EXPECTS(! ec, ec.message());
+            BEAST_EXPECT(p.is_done());
+            BEAST_EXPECT(n == header.size() + body.size());
+            p.get().body().close();
+            BEAST_EXPECT(read_file(path) == body);
+            request<string_body> req;
+            http::read(sock, b, req, ec);
+            BEAST_EXPECTS(! ec, ec.message());
+            BEAST_EXPECT(req.target() == "/next");
+            sock.close();
+            t.join();
+        }
+
+        // message
+        {
+            asio::io_context ioc;
+            tcp::socket sock{ioc};
+            auto t = connect(ioc, sock, data, false);
+            flat_buffer b;
+            request<file_body> req;
+            error_code ec;
+            req.body().open(path.c_str(), file_mode::write, ec);
+            BEAST_EXPECTS(! ec, ec.message());
+            http::read(sock, b, req, ec);
+            BEAST_EXPECTS(! ec, ec.message());
+            req.body().close();
+            BEAST_EXPECT(read_file(path) == body);
+            sock.close();
+            t.join();
+        }
+
+        // asynchronous message, followed by a pipelined request
+        {
+            asio::io_context ioc;
+            tcp::socket sock{ioc};
+            auto t = connect(ioc, sock, data, false);
+            flat_buffer b;
+            request<file_body> req;
+            error_code ec;
+            req.body().open(path.c_str(), file_mode::write, ec);
+            BEAST_EXPECTS(! ec, ec.message());
+            bool invoked = false;
+            http::async_read(sock, b, req,
+                [&](error_code ec, std::size_t n)
+                {
+                    invoked = true;
+                    BEAST_EXPECTS(! ec, ec.message());
+                    BEAST_EXPECT(n == header.size() + body.size());
+                });
+            ioc.run();
+            BEAST_EXPECT(invoked);
+            // spliced, so the next request is still in the socket
+            BEAST_EXPECT(b.size() == 0);
+            req.body().close();
+            BEAST_EXPECT(read_file(path) == body);
+            request<string_body> next_req;
+            http::read(sock, b, next_req, ec);
+            BEAST_EXPECTS(! ec, ec.message());
+            BEAST_EXPECT(next_req.target() == "/next");
+            sock.close();
+            t.join();
+        }
+
+        // asynchronous
+        {
+            asio::io_context ioc;
+            tcp::socket sock{ioc};
+            auto t = connect(ioc, sock, data, false);
+            flat_buffer b;
+            request_parser<file_body> p;
+            error_code ec;
+            p.get().body().open(path.c_str(), file_mode::write, ec);
+            BEAST_EXPECTS(! ec, ec.message());
+            bool invoked = false;
+            http::async_read(sock, b, p,
+                [&](error_code ec, std::size_t n)
+                {
+                    invoked = true;
+                    BEAST_EXPECTS(! ec, ec.message());
+                    BEAST_EXPECT(n == header.size() + body.size());
+                });
+            ioc.run();
+            BEAST_EXPECT(invoked);
+            BEAST_EXPECT(p.is_done());
+            p.get().body().close();
+            BEAST_EXPECT(read_file(path) == body);
+            sock.close();
+            t.join();
+        }
+
+        // body limit
+        {
+            asio::io_context ioc;
+            tcp::socket sock{ioc};
+            auto t = connect(ioc, sock, data, false);
+            flat_buffer b;
+            request_parser<file_body> p;
+            p.body_limit(1000);
+            error_code ec;
+            p.get().body().open(path.c_str(), file_mode::write, ec);
+            BEAST_EXPECTS(! ec, ec.message());
+            http::read(sock, b, p, ec);
+            BEAST_EXPECTS(ec == error::body_limit, ec.message());
+            sock.close();
+            t.join();
+        }
+
+        // connection closed early
+        {
+            auto const partial = header + body.substr(0, body.size() / 2);
+            for(int i = 0; i < 2; ++i)
+            {
+                asio::io_context ioc;
+                tcp::socket sock{ioc};
+                auto t = connect(ioc, sock, partial, true);
+                flat_buffer b;
+                request_parser<file_body> p;
+                error_code ec;
+                p.get().body().open(path.c_str(), file_mode::write, ec);
+                BEAST_EXPECTS(! ec, ec.message());
+                if(i == 0)
+                {
+                    http::read(sock, b, p, ec);
+                }
+                else
+                {
+                    http::async_read(sock, b, p,
+                        [&](error_code ec_, std::size_t)
+                        {
+                            ec = ec_;
+                        });
+                    ioc.run();
+                }
+                BEAST_EXPECTS(ec == error::partial_message, ec.message());
+                t.join();
+            }
+        }
+
+        boost::system::error_code ec;
+        boost::filesystem::remove(path, ec);
+    }
+#endif
+
     void
     run() override
     {
         doTestFileBody<file_stdio>();
+        doTestReadSize<file_stdio>();
     #if BEAST_USE_WIN32_FILE
         doTestFileBody<file_win32>();
+        doTestReadSize<file_win32>();
     #endif
     #if BEAST_USE_POSIX_FILE
         doTestFileBody<file_posix>();
+        doTestReadSize<file_posix>();
+    #endif
+    #if BEAST_USE_SPLICE
+        testSplice();
     #endif
     }
 };
@@ -0,0 +1,364 @@
+//
+// Copyright (c) 2016-2017 Vinnie Falco (vinnie dot falco at gmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/boostorg/beast
+//
+
+// Test that header file is self-contained.
+#include <beast/http/file_cache.hpp>
+
+#if BEAST_USE_POSIX_FILE
+
+#include <beast/http/decompressing_body.hpp>
+#include <beast/http/string_body.hpp>
+#include <beast/unit_test/suite.hpp>
+#include <boost/filesystem.hpp>
+#include <random>
+#include <string>
+
+namespace beast {
+namespace http {
+
+class file_cache_test
+    : public beast::unit_test::suite
+{
+public:
+    struct temp_file
+    {
+        std::string path;
+
+        temp_file()
+            : path(boost::filesystem::unique_path().string())
+        {
+        }
+
+        ~temp_file()
+        {
+            boost::system::error_code ec;
+            boost::filesystem::remove(path, ec);
+            boost::filesystem::remove(path + ".gz", ec);
+        }
+    };
+
+    static
+    void
+    write_file(std::string const& path, string_view s)
+    {
+        error_code ec;
+        file_posix f;
+        f.open(path.c_str(), file_mode::write, ec);
+        f.write(s.data(), s.size(), ec);
+    }
+
+    static
+    std::string
+    make_text(std::size_t size)
+    {
+        std::string s;
+        while(s.size() < size)
+            s += "body { margin: 0; padding: 0; }\n";
+        s.resize(size);
+        return s;
+    }
+
+    static
+    std::string
+    make_random(std::size_t size)
+    {
+        std::mt19937 g{0};
+        std::string s;
+        s.resize(size);
+        for(auto& c : s)
+            c = static_cast<char>(g());
+        return s;
+    }
+
+    std::string
+    read_all(file_cache::representation const& rep)
+    {
+        std::string s;
+        s.resize(static_cast<std::size_t>(rep.size()));
+        error_code ec;
+        std::size_t pos = 0;
+        while(pos < s.size())
+        {
+            // read in odd sized pieces
+            auto const n = rep.read(pos, &s[pos],
+                (std::min<std::size_t>)(1000, s.size() - pos), ec);
+            if(! BEAST_EXPECTS(! ec, ec.message()))
+                break;
+            if(! BEAST_EXPECT(n > 0))
+                break;
+            pos += n;
+        }
+        return s;
+    }
+
+    static
+    std::string
+    gunzip(string_view in)
+    {
+        request<decompressing_body<string_body>> req;
+        req.set(field::content_encoding, "gzip");
+        decompressing_body<string_body>::reader r{req, req.body()};
+        error_code ec;
+        r.init(boost::none, ec);
+        r.put(asio::const_buffer{in.data(), in.size()}, ec);
+        if(! ec)
+            r.finish(ec);
+        if(ec)
+            return {};
+        return req.body().body;
+    }
+
+    void
+    testResident()
+    {
+        temp_file t;
+        auto const s = make_text(10000);
+        write_file(t.path, s);
+
+        file_cache cache;
+        error_code ec;
+        auto const e = cache.get(t.path, ec);
+        if(! BEAST_EXPECTS(! ec, ec.message()))
+            return;
+        BEAST_EXPECT(cache.size() == 1);
+        auto const& id = e->identity();
+        BEAST_EXPECT(id.resident());
+        BEAST_EXPECT(id.size() == s.size());
+        BEAST_EXPECT(id.data() == s);
+        BEAST_EXPECT(read_all(id) == s);
+        BEAST_EXPECT(id.etag().size() > 2);
+        BEAST_EXPECT(id.etag().front() == '"');
+        BEAST_EXPECT(id.etag().back() == '"');
+        BEAST_EXPECT(e->last_modified() != 0);
+
+        // compressed once on load
+        auto const gz = e->gzip();
+        if(! BEAST_EXPECT(gz))
+            return;
+        BEAST_EXPECT(gz->resident());
+        BEAST_EXPECT(gz->size() < s.size() / 10);
+        BEAST_EXPECT(gz->etag() != id.etag());
+        BEAST_EXPECT(gunzip(gz->data()) == s);
+
+        // the same entry is returned
+        BEAST_EXPECT(cache.get(t.path, ec) == e);
+        BEAST_EXPECTS(! ec, ec.message());
+    }
+
+    void
+    testOpen()
+    {
+        temp_file t;
+        auto const s = make_text(50000);
+        write_file(t.path, s);
+
+        file_cache cache;
+        cache.resident_limit(1000);
+        cache.compress_limit(0);
+        BEAST_EXPECT(cache.resident_limit() == 1000);
+        BEAST_EXPECT(cache.compress_limit() == 0);
+        error_code ec;
+        auto const e = cache.get(t.path, ec);
+        if(! BEAST_EXPECTS(! ec, ec.message()))
+            return;
+        auto const& id = e->identity();
+        BEAST_EXPECT(! id.resident());
+        BEAST_EXPECT(id.data().empty());
+        BEAST_EXPECT(id.size() == s.size());
+        BEAST_EXPECT(read_all(id) == s);
+        BEAST_EXPECT(read_all(id) == s);
+        BEAST_EXPECT(! e->gzip());
+
+        // reading past the end
+        char c;
+        BEAST_EXPECT(id.read(s.size(), &c, 1, ec) == 0);
+        BEAST_EXPECTS(! ec, ec.message());
+
+        // the descriptor stays usable after the cache is gone
+        cache.clear();
+        BEAST_EXPECT(cache.size() == 0);
+        BEAST_EXPECT(read_all(id) == s);
+    }
+
+    void
+    testGzip()
+    {
+        file_cache cache;
+        error_code ec;
+
+        // incompressible files have no gzip representation
+        {
+            temp_file t;
+            write_file(t.path, make_random(5000));
+            auto const e = cache.get(t.path, ec);
+            BEAST_EXPECTS(! ec, ec.message());
+            BEAST_EXPECT(e && ! e->gzip());
+        }
+
+        // files larger than the limit are not compressed
+        {
+            temp_file t;
+            write_file(t.path, make_text(5000));
+            cache.compress_limit(4999);
+            auto const e = cache.get(t.path, ec);
+            BEAST_EXPECTS(! ec, ec.message());
+            BEAST_EXPECT(e && ! e->gzip());
+            cache.compress_limit(1024 * 1024);
+        }
+
+        // empty files
+        {
+            temp_file t;
+            write_file(t.path, "");
+            auto const e = cache.get(t.path, ec);
+            BEAST_EXPECTS(! ec, ec.message());
+            BEAST_EXPECT(e && e->identity().size() == 0);
+            BEAST_EXPECT(e && ! e->gzip());
+        }
+
+        // a precompressed sibling is preferred
+        {
+            temp_file t;
+            write_file(t.path, make_text(5000));
+            write_file(t.path + ".gz", "sibling");
+            auto const e = cache.get(t.path, ec);
+            BEAST_EXPECTS(! ec, ec.message());
+            if(BEAST_EXPECT(e && e->gzip()))
+            {
+                BEAST_EXPECT(e->gzip()->data() == "sibling");
+                BEAST_EXPECT(e->gzip()->etag() != e->identity().etag());
+            }
+        }
+
+        // a sibling which is not smaller is ignored
+        {
+            temp_file t;
+            auto const s = make_text(5000);
+            write_file(t.path, s);
+            write_file(t.path + ".gz", make_random(5000));
+            auto const e = cache.get(t.path, ec);
+            BEAST_EXPECTS(! ec, ec.message());
+            if(BEAST_EXPECT(e && e->gzip()))
+                BEAST_EXPECT(gunzip(e->gzip()->data()) == s);
+        }
+
+        // a sibling which cannot be loaded is ignored,
+        // and does not make the entry stale
+        {
+            temp_file t;
+            auto const s = make_text(5000);
+            write_file(t.path, s);
+            boost::filesystem::create_directory(t.path + ".gz");
+            cache.revalidate_interval(std::chrono::seconds(0));
+            auto const e = cache.get(t.path, ec);
+            BEAST_EXPECTS(! ec, ec.message());
+            if(BEAST_EXPECT(e && e->gzip()))
+                BEAST_EXPECT(gunzip(e->gzip()->data()) == s);
+            BEAST_EXPECT(cache.get(t.path, ec) == e);
+            BEAST_EXPECTS(! ec, ec.message());
+        }
+    }
+
+    void
+    testRevalidate()
+    {
+        temp_file t;
+        write_file(t.path, "first");
+
+        file_cache cache;
+        error_code ec;
+        auto const e1 = cache.get(t.path, ec);
+        BEAST_EXPECTS(! ec, ec.message());
+
+        // changes are not seen until the interval elapses
+        write_file(t.path, "second");
+        auto const e2 = cache.get(t.path, ec);
+        BEAST_EXPECT(e2 == e1);
+        BEAST_EXPECT(e2->identity().data() == "first");
+
+        cache.revalidate_interval(std::chrono::seconds(0));
+        BEAST_EXPECT(cache.revalidate_interval() ==
+            file_cache::clock_type::duration::zero());
+        auto const e3 = cache.get(t.path, ec);
+        BEAST_EXPECTS(! ec, ec.message());
+        BEAST_EXPECT(e3 != e1);
+        BEAST_EXPECT(e3->identity().data() == "second");
+        BEAST_EXPECT(e3->identity().etag() != e1->identity().etag());
+
+        // an unchanged file keeps its entry
+        BEAST_EXPECT(cache.get(t.path, ec) == e3);
+
+        // the old entry is still usable
+        BEAST_EXPECT(e1->identity().data() == "first");
+
+        // a sibling which appears, changes or disappears
+        // makes the entry stale even if the file is unchanged
+        write_file(t.path + ".gz", "x");
+        auto const e4 = cache.get(t.path, ec);
+        BEAST_EXPECTS(! ec, ec.message());
+        BEAST_EXPECT(e4 != e3);
+        BEAST_EXPECT(e4->gzip() && e4->gzip()->data() == "x");
+        BEAST_EXPECT(cache.get(t.path, ec) == e4);
+        write_file(t.path + ".gz", "yy");
+        auto const e5 = cache.get(t.path, ec);
+        BEAST_EXPECT(e5 != e4);
+        BEAST_EXPECT(e5->gzip() && e5->gzip()->data() == "yy");
+        boost::filesystem::remove(t.path + ".gz");
+        auto const e6 = cache.get(t.path, ec);
+        BEAST_EXPECT(e6 != e5);
+        BEAST_EXPECT(! e6->gzip());
+        BEAST_EXPECT(cache.get(t.path, ec) == e6);
+
+        // a removed file is removed from the cache
+        boost::filesystem::remove(t.path);
+        BEAST_EXPECT(! cache.get(t.path, ec));
+        BEAST_EXPECT(ec == errc::no_such_file_or_directory);
+        BEAST_EXPECT(cache.size() == 0);
+    }
+
+    void
+    testErrors()
+    {
+        file_cache cache;
+        error_code ec;
+        auto const missing = boost::filesystem::unique_path().string();
+        BEAST_EXPECT(! cache.get(missing, ec));
+        BEAST_EXPECT(ec == errc::no_such_file_or_directory);
+        BEAST_EXPECT(cache.size() == 0);
+
+        auto const dir =
+            boost::filesystem::temp_directory_path().string();
+        BEAST_EXPECT(! cache.get(dir, ec));
+        BEAST_EXPECTS(ec == errc::is_a_directory, ec.message());
+
+        temp_file t;
+        write_file(t.path, "x");
+        BEAST_EXPECT(cache.get(t.path, ec));
+        BEAST_EXPECT(cache.size() == 1);
+        cache.erase(t.path);
+        BEAST_EXPECT(cache.size() == 0);
+    }
+
+    void
+    run() override
+    {
+        testResident();
+        testOpen();
+        testGzip();
+        testRevalidate();
+        testErrors();
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(beast,http,file_cache);
+
+} // http
+} // beast
+
+#endif
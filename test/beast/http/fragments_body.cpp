@@ -0,0 +1,171 @@
+//
+// Copyright (c) 2016-2017 Vinnie Falco (vinnie dot falco at gmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/boostorg/beast
+//
+
+// Test that header file is self-contained.
+#include <beast/http/fragments_body.hpp>
+
+#include <beast/core/buffers_to_string.hpp>
+#include <beast/experimental/test/stream.hpp>
+#include <beast/http/write.hpp>
+#include <beast/unit_test/suite.hpp>
+#include <asio/io_context.hpp>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace beast {
+namespace http {
+
+BOOST_STATIC_ASSERT(is_body<fragments_body>::value);
+BOOST_STATIC_ASSERT(is_body_writer<fragments_body>::value);
+BOOST_STATIC_ASSERT(! is_body_reader<fragments_body>::value);
+
+class fragments_body_test
+    : public beast::unit_test::suite
+{
+public:
+    void
+    testValue()
+    {
+        auto const s = std::make_shared<std::string const>("Hello");
+        auto const v = std::make_shared<
+            std::vector<char> const>(3, '!');
+
+        fragments_body::value_type b;
+        BEAST_EXPECT(b.empty());
+        BEAST_EXPECT(b.size() == 0);
+        b.reserve(4);
+        b.push_back(s);
+        b.push_back(asio::const_buffer{", ", 2});
+        b.push_back(s, asio::const_buffer{s->data() + 1, 3});
+        b.push_back(v);
+        b.push_back(std::shared_ptr<std::string>{});
+        b.push_back(asio::const_buffer{});
+        BEAST_EXPECT(! b.empty());
+        BEAST_EXPECT(b.size() == 13);
+        BEAST_EXPECT(fragments_body::size(b) == 13);
+        BEAST_EXPECT(b.buffers().size() == 4);
+        BEAST_EXPECT(buffers_to_string(b.buffers()) == "Hello, ell!!!");
+
+        // The fragments refer to the original memory
+        BEAST_EXPECT(b.buffers()[0].data() == s->data());
+        BEAST_EXPECT(b.buffers()[3].data() == v->data());
+        BEAST_EXPECT(s.use_count() == 3);
+
+        {
+            auto const b2 = b;
+            BEAST_EXPECT(s.use_count() == 5);
+            BEAST_EXPECT(b2.buffers()[0].data() == s->data());
+        }
+        BEAST_EXPECT(s.use_count() == 3);
+
+        b.clear();
+        BEAST_EXPECT(b.empty());
+        BEAST_EXPECT(b.buffers().empty());
+        BEAST_EXPECT(s.use_count() == 1);
+        BEAST_EXPECT(v.use_count() == 1);
+    }
+
+    void
+    testWriter()
+    {
+        auto const s = std::make_shared<std::string const>("body");
+        response<fragments_body> res;
+        {
+            fragments_body::writer w{res, res.body()};
+            error_code ec;
+            w.init(ec);
+            BEAST_EXPECTS(! ec, ec.message());
+            BEAST_EXPECT(w.get(ec) == boost::none);
+            BEAST_EXPECTS(! ec, ec.message());
+        }
+        res.body().push_back(s);
+        res.body().push_back(asio::const_buffer{"-", 1});
+        res.body().push_back(s);
+        {
+            fragments_body::writer w{res, res.body()};
+            error_code ec;
+            w.init(ec);
+            BEAST_EXPECTS(! ec, ec.message());
+            auto const result = w.get(ec);
+            BEAST_EXPECTS(! ec, ec.message());
+            if(! BEAST_EXPECT(result != boost::none))
+                return;
+            BEAST_EXPECT(! result->second);
+            BEAST_EXPECT(std::distance(
+                result->first.begin(), result->first.end()) == 3);
+            BEAST_EXPECT(buffers_to_string(
+                result->first) == "body-body");
+            BEAST_EXPECT((*result->first.begin()).data() == s->data());
+        }
+    }
+
+    void
+    testWrite()
+    {
+        auto const head = std::make_shared<
+            std::string const>("<html>");
+        auto const tail = std::make_shared<
+            std::string const>("</html>");
+
+        // Many messages share the same fragments, and
+        // are serialized on several threads at once.
+        std::size_t const count = 4;
+        std::vector<std::string> out(count);
+        std::vector<std::thread> threads;
+        for(std::size_t i = 0; i < count; ++i)
+            threads.emplace_back(
+                [&, i]
+                {
+                    auto const text = std::make_shared<
+                        std::string const>(std::to_string(i));
+                    response<fragments_body> res;
+                    res.version(11);
+                    res.result(status::ok);
+                    res.body().push_back(head);
+                    res.body().push_back(text);
+                    res.body().push_back(tail);
+                    res.prepare_payload();
+                    for(int n = 0; n < 100; ++n)
+                    {
+                        asio::io_context ioc;
+                        test::stream ts{ioc}, tr{ioc};
+                        ts.connect(tr);
+                        error_code ec;
+                        write(ts, res, ec);
+                        if(ec)
+                            return;
+                        out[i] = tr.str().to_string();
+                    }
+                });
+        for(auto& t : threads)
+            t.join();
+        BEAST_EXPECT(head.use_count() == 1);
+        for(std::size_t i = 0; i < count; ++i)
+            BEAST_EXPECT(out[i] ==
+                "HTTP/1.1 200 OK\r\n"
+                "Content-Length: 14\r\n"
+                "\r\n"
+                "<html>" + std::to_string(i) + "</html>");
+    }
+
+    void
+    run() override
+    {
+        testValue();
+        testWriter();
+        testWrite();
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(beast,http,fragments_body);
+
+} // http
+} // beast
@@ -0,0 +1,278 @@
+//
+// Copyright (c) 2016-2017 Vinnie Falco (vinnie dot falco at gmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/boostorg/beast
+//
+
+// Test that header file is self-contained.
+#include <beast/http/mmap_body.hpp>
+
+#if BEAST_USE_POSIX_FILE
+
+#include <beast/core/buffers_to_string.hpp>
+#include <beast/http/serializer.hpp>
+#include <beast/unit_test/suite.hpp>
+#include <boost/filesystem.hpp>
+#include <string>
+#include <unistd.h>
+
+namespace beast {
+namespace http {
+
+class mmap_body_test
+    : public beast::unit_test::suite
+{
+public:
+    struct temp_file
+    {
+        std::string path;
+
+        explicit
+        temp_file(string_view s)
+            : path(boost::filesystem::unique_path().string())
+        {
+            write(s);
+        }
+
+        ~temp_file()
+        {
+            boost::system::error_code ec;
+            boost::filesystem::remove(path, ec);
+        }
+
+        void
+        write(string_view s)
+        {
+            error_code ec;
+            file_posix f;
+            f.open(path.c_str(), file_mode::write, ec);
+            f.write(s.data(), s.size(), ec);
+        }
+    };
+
+    static
+    std::string
+    make_text(std::size_t size)
+    {
+        std::string s;
+        s.reserve(size);
+        for(std::size_t i = 0; s.size() < size; ++i)
+            s += std::to_string(i) + "\n";
+        s.resize(size);
+        return s;
+    }
+
+    struct visitor
+    {
+        std::string& out;
+        std::size_t size;
+
+        template<class ConstBufferSequence>
+        void
+        operator()(error_code&,
+            ConstBufferSequence const& buffers)
+        {
+            size = asio::buffer_size(buffers);
+            out.append(buffers_to_string(buffers));
+        }
+    };
+
+    // Returns the body octets produced by the writer
+    std::string
+    drain(response<mmap_body>& res, error_code& ec)
+    {
+        std::string out;
+        mmap_body::writer w{res, res.body()};
+        w.init(ec);
+        if(ec)
+            return {};
+        for(;;)
+        {
+            auto const result = w.get(ec);
+            if(ec || ! result)
+                break;
+            BEAST_EXPECT(result->first.size() <= mmap_body::chunk_size);
+            out.append(static_cast<char const*>(
+                result->first.data()), result->first.size());
+            if(! result->second)
+                break;
+        }
+        return out;
+    }
+
+    void
+    testBody()
+    {
+        auto const s = make_text(3 * mmap_body::chunk_size + 123);
+        temp_file t{s};
+        error_code ec;
+
+        response<mmap_body> res{status::ok, 11};
+        BEAST_EXPECT(! res.body().is_open());
+        BEAST_EXPECT(res.body().size() == 0);
+        res.body().open(t.path.c_str(), ec);
+        if(! BEAST_EXPECTS(! ec, ec.message()))
+            return;
+        BEAST_EXPECT(res.body().is_open());
+        BEAST_EXPECT(res.body().size() == s.size());
+        BEAST_EXPECT(res.body().data() == s);
+        BEAST_EXPECT(drain(res, ec) == s);
+        BEAST_EXPECTS(! ec, ec.message());
+
+        // serialize
+        res.prepare_payload();
+        serializer<false, mmap_body> sr{res};
+        std::string out;
+        visitor visit{out, 0};
+        while(! sr.is_done())
+        {
+            sr.next(ec, visit);
+            if(! BEAST_EXPECTS(! ec, ec.message()))
+                break;
+            sr.consume(visit.size);
+        }
+        BEAST_EXPECT(out.find("Content-Length: " +
+            std::to_string(s.size())) != std::string::npos);
+        BEAST_EXPECT(out.substr(out.size() - s.size()) == s);
+
+        res.body().close();
+        BEAST_EXPECT(! res.body().is_open());
+        BEAST_EXPECT(res.body().data().empty());
+
+        // options
+        mmap_options opts;
+        opts.populate = true;
+        opts.sequential = false;
+        res.body().open(t.path.c_str(), ec, opts);
+        BEAST_EXPECTS(! ec, ec.message());
+        BEAST_EXPECT(res.body().data() == s);
+
+        // empty file
+        temp_file t2{""};
+        res.body().open(t2.path.c_str(), ec);
+        BEAST_EXPECTS(! ec, ec.message());
+        BEAST_EXPECT(res.body().is_open());
+        BEAST_EXPECT(res.body().size() == 0);
+        BEAST_EXPECT(drain(res, ec).empty());
+        BEAST_EXPECTS(! ec, ec.message());
+
+        // errors
+        res.body().open(
+            boost::filesystem::unique_path().string().c_str(), ec);
+        BEAST_EXPECT(ec == errc::no_such_file_or_directory);
+        res.body().open(boost::filesystem::temp_directory_path().
+            string().c_str(), ec);
+        BEAST_EXPECTS(ec == errc::is_a_directory, ec.message());
+    }
+
+    void
+    testRange()
+    {
+        auto const s = make_text(10000);
+        temp_file t{s};
+        error_code ec;
+        auto const m = mmap_body::mapping::create(
+            t.path.c_str(), mmap_options{}, ec);
+        if(! BEAST_EXPECTS(! ec, ec.message()))
+            return;
+        BEAST_EXPECT(m->size() == s.size());
+        BEAST_EXPECT(m->file_size(ec) == s.size());
+
+        // two messages share the mapping
+        response<mmap_body> r1;
+        response<mmap_body> r2;
+        r1.body().reset(m, 0, 100, ec);
+        BEAST_EXPECTS(! ec, ec.message());
+        r2.body().reset(m, 5000, 5000, ec);
+        BEAST_EXPECTS(! ec, ec.message());
+        BEAST_EXPECT(r1.body().get_mapping() == r2.body().get_mapping());
+        BEAST_EXPECT(drain(r1, ec) == s.substr(0, 100));
+        BEAST_EXPECT(drain(r2, ec) == s.substr(5000));
+        BEAST_EXPECT(r2.body().data() == s.substr(5000));
+
+        r1.body().reset(m, s.size(), 0, ec);
+        BEAST_EXPECTS(! ec, ec.message());
+        BEAST_EXPECT(drain(r1, ec).empty());
+        r1.body().reset(m, 5000, 5001, ec);
+        BEAST_EXPECT(ec == errc::invalid_argument);
+        r1.body().reset(m, s.size() + 1, 0, ec);
+        BEAST_EXPECT(ec == errc::invalid_argument);
+    }
+
+    void
+    testTruncate()
+    {
+        auto const s = make_text(2 * mmap_body::chunk_size + 1);
+        temp_file t{s};
+        error_code ec;
+        response<mmap_body> res;
+        res.body().open(t.path.c_str(), ec);
+        BEAST_EXPECTS(! ec, ec.message());
+
+        mmap_body::writer w{res, res.body()};
+        w.init(ec);
+        auto const result = w.get(ec);
+        BEAST_EXPECTS(! ec, ec.message());
+        BEAST_EXPECT(result && result->second);
+
+        // Shrink the file, the next piece is now past the end
+        BEAST_EXPECT(::truncate(t.path.c_str(), 1000) == 0);
+        BEAST_EXPECT(! w.get(ec));
+        BEAST_EXPECTS(ec == errc::io_error, ec.message());
+    }
+
+    void
+    testCache()
+    {
+        auto const s = make_text(5000);
+        temp_file t{s};
+        mmap_cache cache;
+        error_code ec;
+        auto m1 = cache.get(t.path, ec);
+        BEAST_EXPECTS(! ec, ec.message());
+        auto m2 = cache.get(t.path, ec);
+        BEAST_EXPECTS(! ec, ec.message());
+        BEAST_EXPECT(m1 && m1 == m2);
+        BEAST_EXPECT(cache.size() == 1);
+
+        // a changed file is mapped again
+        t.write("changed");
+        auto m3 = cache.get(t.path, ec);
+        BEAST_EXPECTS(! ec, ec.message());
+        BEAST_EXPECT(m3 && m3 != m1);
+        BEAST_EXPECT(m3->data() == "changed");
+        BEAST_EXPECT(m1->size() == s.size());
+
+        // mappings are released with their last user
+        m1.reset();
+        m2.reset();
+        m3.reset();
+        BEAST_EXPECT(cache.size() == 0);
+        auto m4 = cache.get(t.path, ec);
+        BEAST_EXPECT(m4 && m4->data() == "changed");
+        BEAST_EXPECT(cache.size() == 1);
+
+        BEAST_EXPECT(! cache.get(
+            boost::filesystem::unique_path().string(), ec));
+        BEAST_EXPECT(ec == errc::no_such_file_or_directory);
+    }
+
+    void
+    run() override
+    {
+        testBody();
+        testRange();
+        testTruncate();
+        testCache();
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(beast,http,mmap_body);
+
+} // http
+} // beast
+
+#endif
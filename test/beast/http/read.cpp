@@ -17,13 +17,17 @@
 #include <beast/http/fields.hpp>
 #include <beast/http/dynamic_body.hpp>
 #include <beast/http/parser.hpp>
+#include <beast/http/span_body.hpp>
 #include <beast/http/string_body.hpp>
+#include <beast/http/vector_body.hpp>
 #include <beast/experimental/test/stream.hpp>
 #include <beast/test/yield_to.hpp>
 #include <beast/unit_test/suite.hpp>
 #include <asio/io_context.hpp>
 #include <asio/strand.hpp>
 #include <atomic>
+#include <string>
+#include <vector>
 
 namespace beast {
 namespace http {
@@ -521,6 +525,152 @@ public:
         }
     }
 
+    static
+    std::string
+    make_body(std::size_t size)
+    {
+        std::string s;
+        for(std::size_t i = 0; s.size() < size; ++i)
+            s += std::to_string(i) + "\n";
+        s.resize(size);
+        return s;
+    }
+
+    template<class Parser>
+    void
+    readBody(Parser& p, string_view s, std::size_t read_size,
+        bool async, error_code& ec, flat_buffer& b)
+    {
+        asio::io_context ioc;
+        test::stream ts{ioc, s};
+        ts.read_size(read_size);
+        ts.close_remote();
+        if(! async)
+        {
+            read(ts, b, p, ec);
+            return;
+        }
+        bool invoked = false;
+        async_read(ts, b, p,
+            [&](error_code ec_, std::size_t)
+            {
+                invoked = true;
+                ec = ec_;
+            });
+        ioc.run();
+        BEAST_EXPECT(invoked);
+    }
+
+    void
+    testReadBody()
+    {
+        using detail::has_direct_body;
+        BOOST_STATIC_ASSERT(has_direct_body<
+            request_parser<string_body>>::value);
+        BOOST_STATIC_ASSERT(has_direct_body<
+            request_parser<vector_body<char>>>::value);
+        BOOST_STATIC_ASSERT(has_direct_body<
+            request_parser<span_body<char>>>::value);
+        BOOST_STATIC_ASSERT(! has_direct_body<
+            request_parser<dynamic_body>>::value);
+        BOOST_STATIC_ASSERT(! has_direct_body<
+            test_parser<true>>::value);
+
+        auto const body = make_body(100000);
+        auto const header =
+            "POST / HTTP/1.1\r\n"
+            "Content-Length: " + std::to_string(body.size()) + "\r\n"
+            "\r\n";
+        auto const next =
+            "GET /next HTTP/1.1\r\n"
+            "Content-Length: 3\r\n"
+            "\r\n"
+            "xyz";
+        auto const s = header + body + next;
+
+        for(int async = 0; async < 2; ++async)
+        for(std::size_t n : {std::size_t{7}, std::size_t{1000},
+            std::size_t{1024 * 1024}})
+        {
+            // string_body, followed by a pipelined request
+            {
+                flat_buffer b;
+                request_parser<string_body> p;
+                p.get().body() = "prefix:";
+                error_code ec;
+                readBody(p, s, n, async != 0, ec, b);
+                BEAST_EXPECTS(! ec, ec.message());
+                BEAST_EXPECT(p.get().body() == "prefix:" + body);
+            }
+            {
+                flat_buffer b;
+                request_parser<string_body> p;
+                asio::io_context ioc;
+                test::stream ts{ioc, s};
+                ts.read_size(n);
+                error_code ec;
+                read(ts, b, p, ec);
+                BEAST_EXPECTS(! ec, ec.message());
+                BEAST_EXPECT(p.get().body() == body);
+                request<string_body> req;
+                read(ts, b, req, ec);
+                BEAST_EXPECTS(! ec, ec.message());
+                BEAST_EXPECT(req.target() == "/next");
+                BEAST_EXPECT(req.body() == "xyz");
+            }
+
+            // vector_body
+            {
+                flat_buffer b;
+                request_parser<vector_body<char>> p;
+                error_code ec;
+                readBody(p, s, n, async != 0, ec, b);
+                BEAST_EXPECTS(! ec, ec.message());
+                BEAST_EXPECT(std::string(p.get().body().begin(),
+                    p.get().body().end()) == body);
+            }
+
+            // span_body
+            {
+                std::string storage(body.size() + 10, '*');
+                flat_buffer b;
+                request_parser<span_body<char>> p;
+                p.get().body() = span<char>{
+                    &storage[0], storage.size()};
+                error_code ec;
+                readBody(p, s, n, async != 0, ec, b);
+                BEAST_EXPECTS(! ec, ec.message());
+                BEAST_EXPECT(storage.substr(0, body.size()) == body);
+                BEAST_EXPECT(storage.substr(body.size()) == "**********");
+                BEAST_EXPECT(p.get().body().size() == 10);
+            }
+
+            // connection closed early
+            {
+                auto const partial =
+                    header + body.substr(0, body.size() / 2);
+                flat_buffer b;
+                request_parser<string_body> p;
+                error_code ec;
+                readBody(p, partial, n, async != 0, ec, b);
+                BEAST_EXPECTS(ec == error::partial_message,
+                    ec.message());
+                BEAST_EXPECT(p.get().body() ==
+                    body.substr(0, body.size() / 2));
+            }
+
+            // body limit
+            {
+                flat_buffer b;
+                request_parser<string_body> p;
+                p.body_limit(1000);
+                error_code ec;
+                readBody(p, s, n, async != 0, ec, b);
+                BEAST_EXPECTS(ec == error::body_limit, ec.message());
+            }
+        }
+    }
+
     void
     run() override
     {
@@ -544,6 +694,7 @@ public:
         testRegression430();
         testReadGrind();
         testAsioHandlerInvoke();
+        testReadBody();
     }
 };
 
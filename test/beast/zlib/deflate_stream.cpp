@@ -11,8 +11,10 @@
 #include <beast/zlib/deflate_stream.hpp>
 
 #include <beast/core/string.hpp>
+#include <beast/test/test_allocator.hpp>
 #include <beast/unit_test/suite.hpp>
 #include <cstdint>
+#include <cstring>
 #include <random>
 
 #include "zlib-1.2.11/zlib.h"
@@ -68,9 +70,9 @@ public:
         string_view const& in,
         int level,                  // 0=none, 1..9, -1=default
         int windowBits,             // 9..15
-        int memLevel)               // 1..9 (8=default)
+        int memLevel,               // 1..9 (8=default)
+        int strategy = Z_DEFAULT_STRATEGY)
     {
-        int const strategy = Z_DEFAULT_STRATEGY;
         int result;
         z_stream zs;
         memset(&zs, 0, sizeof(zs));
@@ -102,7 +104,7 @@ public:
 
     static
     std::string
-    decompress(string_view const& in)
+    decompress(string_view const& in, string_view const& dict = {})
     {
         int result;
         std::string out;
@@ -111,6 +113,9 @@ public:
         result = inflateInit2(&zs, -15);
         try
         {
+            if(! dict.empty())
+                inflateSetDictionary(&zs, (Bytef const*)dict.data(),
+                    static_cast<uInt>(dict.size()));
             zs.next_in = (Bytef*)in.data();
             zs.avail_in = static_cast<uInt>(in.size());
             for(;;)
@@ -301,6 +306,224 @@ public:
         doMatrix(corpus1(1024), &self::doDeflate1_beast);
     }
 
+    //--------------------------------------------------------------------------
+
+    // Compress a complete message with a full flush
+    std::string
+    deflate_message(deflate_stream& ds, string_view in)
+    {
+        std::string out;
+        out.resize(ds.upper_bound(in.size()) + 6);
+        z_params zs;
+        zs.next_in = in.data();
+        zs.avail_in = in.size();
+        zs.next_out = &out[0];
+        zs.avail_out = out.size();
+        for(;;)
+        {
+            error_code ec;
+            ds.write(zs, Flush::full, ec);
+            if(ec == error::need_buffers)
+                break;
+            if(! BEAST_EXPECTS(! ec, ec.message()))
+                break;
+        }
+        out.resize(zs.total_out);
+        return out;
+    }
+
+    void
+    testMemory()
+    {
+        BEAST_EXPECT(deflate_stream::memory_size(15, 8) == 262144);
+        BEAST_EXPECT(deflate_stream::memory_size(9, 1) == 3072);
+        BEAST_EXPECT(deflate_stream::memory_size(8, 1) ==
+            deflate_stream::memory_size(9, 1));
+        try
+        {
+            deflate_stream::memory_size(16, 8);
+            fail("", __FILE__, __LINE__);
+        }
+        catch(std::invalid_argument const&)
+        {
+            pass();
+        }
+        try
+        {
+            deflate_stream::memory_size(15, 10);
+            fail("", __FILE__, __LINE__);
+        }
+        catch(std::invalid_argument const&)
+        {
+            pass();
+        }
+
+        auto const check = corpus1(1000);
+        std::size_t n = 0;
+        {
+            deflate_stream ds{test::counting_allocator<char>{n}};
+            auto const n0 = n;
+            for(int memLevel = 1; memLevel <= 9; ++memLevel)
+            {
+                ds.reset(6, 12, memLevel, Strategy::normal);
+                BEAST_EXPECT(n == n0 ||
+                    n == n0 + deflate_stream::memory_size(
+                        12, memLevel - 1));
+                auto const out = deflate_message(ds, check);
+                BEAST_EXPECT(n == n0 +
+                    deflate_stream::memory_size(12, memLevel));
+                BEAST_EXPECT(decompress(out) == check);
+            }
+            ds.clear();
+            BEAST_EXPECT(n == n0);
+        }
+        BEAST_EXPECT(n == 0);
+    }
+
+    void
+    testReset()
+    {
+        // Reusing the stream after a reset must produce
+        // exactly the same output as a new stream.
+        auto const check = [&](
+            int level, Strategy strategy,
+            std::string const& s1, std::string const& s2)
+        {
+            deflate_stream ds1;
+            ds1.reset(level, 15, 8, strategy);
+            BEAST_EXPECT(decompress(deflate_message(ds1, s1)) == s1);
+            ds1.reset();
+            auto const out1 = deflate_message(ds1, s2);
+            deflate_stream ds2;
+            ds2.reset(level, 15, 8, strategy);
+            auto const out2 = deflate_message(ds2, s2);
+            BEAST_EXPECT(out1 == out2);
+            BEAST_EXPECT(decompress(out1) == s2);
+        };
+        for(int level = 0; level <= 9; ++level)
+        {
+            for(int strategy = 0; strategy <= 4; ++strategy)
+            {
+                auto const st = toStrategy(strategy);
+                check(level, st, corpus1(300), corpus1(500));
+                check(level, st, corpus1(500), corpus1(300));
+                check(level, st, corpus1(100000), corpus1(700));
+                check(level, st, corpus2(5000), corpus1(5000));
+            }
+        }
+    }
+
+    void
+    testDictionary()
+    {
+        auto const dict = corpus1(3000);
+        auto const msg = dict.substr(1200, 400) + dict.substr(2500, 300);
+
+        // The prepared dictionary must produce the same output
+        // as inserting the bytes, and the zlib reference must be
+        // able to decompress it using the same dictionary.
+        auto const check = [&](
+            int level, int windowBits, int memLevel,
+            Strategy strategy, deflate_dictionary const& dd)
+        {
+            error_code ec;
+            deflate_stream ds1;
+            ds1.reset(level, windowBits, memLevel, strategy);
+            ds1.dictionary(dict.data(), dict.size(), ec);
+            BEAST_EXPECTS(! ec, ec.message());
+            auto const out1 = deflate_message(ds1, msg);
+            deflate_stream ds2;
+            ds2.reset(level, windowBits, memLevel, strategy);
+            ds2.dictionary(dd, ec);
+            BEAST_EXPECTS(! ec, ec.message());
+            auto const out2 = deflate_message(ds2, msg);
+            BEAST_EXPECT(out1 == out2);
+            BEAST_EXPECT(decompress(out1, dict) == msg);
+
+            // reuse after a reset
+            ds2.reset();
+            ds2.dictionary(dd, ec);
+            BEAST_EXPECTS(! ec, ec.message());
+            BEAST_EXPECT(deflate_message(ds2, msg) == out1);
+        };
+        deflate_dictionary const dd{dict.data(), dict.size()};
+        BEAST_EXPECT(dd.size() == dict.size());
+        deflate_dictionary const dd9{dict.data(), dict.size(), 9, 4};
+        BEAST_EXPECT(dd9.size() == 512);
+        BEAST_EXPECT(std::memcmp(dd9.data(),
+            dict.data() + dict.size() - 512, 512) == 0);
+        for(int level = 0; level <= 9; ++level)
+        {
+            for(int strategy = 0; strategy <= 4; ++strategy)
+            {
+                auto const st = toStrategy(strategy);
+                check(level, 15, 9, st, dd);
+                check(level, 9, 4, st, dd9);
+                // mismatched settings
+                check(level, 12, 9, st, dd);
+                check(level, 9, 4, st, dd);
+            }
+        }
+
+        // The dictionary must help
+        {
+            error_code ec;
+            deflate_stream ds;
+            auto const out1 = deflate_message(ds, msg);
+            ds.reset();
+            ds.dictionary(dd, ec);
+            auto const out2 = deflate_message(ds, msg);
+            BEAST_EXPECT(out2.size() * 4 < out1.size());
+        }
+
+        // Too late after input
+        {
+            error_code ec;
+            deflate_stream ds;
+            std::string out(100, 0);
+            z_params zs;
+            zs.next_in = msg.data();
+            zs.avail_in = 100;
+            zs.next_out = &out[0];
+            zs.avail_out = out.size();
+            ds.write(zs, Flush::none, ec);
+            BEAST_EXPECTS(! ec, ec.message());
+            ds.dictionary(dd, ec);
+            BEAST_EXPECTS(ec == error::stream_error, ec.message());
+        }
+    }
+
+    void
+    testIncompressible()
+    {
+        // Random data is skipped over after a while, the search
+        // must resume when the input becomes compressible again.
+        auto const r = corpus2(300000);
+        auto const c = corpus1(300000);
+        auto const mixed = r + c + r.substr(0, 100000) + c;
+        for(int level = 1; level <= 9; ++level)
+        {
+            for(int strategy = 0; strategy <= 1; ++strategy)
+            {
+                auto const st = toStrategy(strategy);
+                deflate_stream ds;
+                ds.reset(level, 15, 8, st);
+                auto const out1 = deflate_message(ds, r);
+                BEAST_EXPECT(decompress(out1) == r);
+                BEAST_EXPECT(out1.size() < r.size() + r.size() / 1000);
+
+                ds.reset();
+                auto const out2 = deflate_message(ds, mixed);
+                BEAST_EXPECT(decompress(out2) == mixed);
+                auto const z = compress(mixed, level, 15, 8, strategy);
+                BEAST_EXPECTS(out2.size() < z.size() + z.size() / 100,
+                    std::to_string(level) + " " +
+                    std::to_string(out2.size()) + " " +
+                    std::to_string(z.size()));
+            }
+        }
+    }
+
     void
     run() override
     {
@@ -309,6 +532,10 @@ public:
             sizeof(deflate_stream) << std::endl;
 
         testDeflate();
+        testMemory();
+        testReset();
+        testDictionary();
+        testIncompressible();
     }
 };
 
@@ -11,6 +11,7 @@
 #include <beast/zlib/inflate_stream.hpp>
 
 #include <beast/core/string.hpp>
+#include <beast/test/test_allocator.hpp>
 #include <beast/unit_test/suite.hpp>
 #include <chrono>
 #include <random>
@@ -69,7 +70,8 @@ public:
         int level,                  // 0=none, 1..9, -1=default
         int windowBits,             // 9..15
         int memLevel,               // 1..9 (8=default)
-        int strategy)               // e.g. Z_DEFAULT_STRATEGY
+        int strategy,               // e.g. Z_DEFAULT_STRATEGY
+        string_view const& dict = {})
     {
         int result;
         z_stream zs;
@@ -83,6 +85,9 @@ public:
             strategy);
         if(result != Z_OK)
             throw std::logic_error{"deflateInit2 failed"};
+        if(! dict.empty())
+            deflateSetDictionary(&zs, (Bytef const*)dict.data(),
+                static_cast<uInt>(dict.size()));
         zs.next_in = (Bytef*)in.data();
         zs.avail_in = static_cast<uInt>(in.size());
         std::string out;
@@ -361,6 +366,144 @@ public:
 #endif
     }
 
+    void
+    testMemory()
+    {
+        BEAST_EXPECT(inflate_stream::memory_size(15) == 32768);
+        BEAST_EXPECT(inflate_stream::memory_size(9) == 512);
+        try
+        {
+            inflate_stream::memory_size(16);
+            fail("", __FILE__, __LINE__);
+        }
+        catch(std::domain_error const&)
+        {
+            pass();
+        }
+
+        auto const check = corpus1(5000);
+        auto const in = compress(check, 6, 15, 8, Z_DEFAULT_STRATEGY);
+        std::size_t n = 0;
+        {
+            inflate_stream is{test::counting_allocator<char>{n}};
+            auto const n0 = n;
+            for(int i = 0; i < 2; ++i)
+            {
+                std::string out;
+                out.resize(check.size());
+                z_params zs;
+                zs.next_in = in.data();
+                zs.avail_in = in.size();
+                zs.next_out = &out[0];
+                zs.avail_out = out.size();
+                error_code ec;
+                is.write(zs, Flush::sync, ec);
+                BEAST_EXPECTS(! ec, ec.message());
+                BEAST_EXPECT(out == check);
+                BEAST_EXPECT(n == n0 + inflate_stream::memory_size(15));
+                is.clear();
+                BEAST_EXPECT(n == n0);
+            }
+        }
+        BEAST_EXPECT(n == 0);
+    }
+
+    void
+    testWriteFinal()
+    {
+        auto const check = corpus1(5000);
+        auto const in = compress(check, 6, 15, 8, Z_DEFAULT_STRATEGY);
+        std::size_t n = 0;
+        inflate_stream is{test::counting_allocator<char>{n}};
+        auto const n0 = n;
+
+        // fits in the output buffer, no window
+        for(int i = 0; i < 3; ++i)
+        {
+            std::string out;
+            out.resize(check.size() + 1);
+            z_params zs;
+            zs.next_in = in.data();
+            zs.avail_in = in.size();
+            zs.next_out = &out[0];
+            zs.avail_out = out.size();
+            error_code ec;
+            is.write_final(zs, Flush::sync, ec);
+            BEAST_EXPECTS(! ec, ec.message());
+            out.resize(zs.total_out);
+            BEAST_EXPECT(out == check);
+            BEAST_EXPECT(n == n0);
+            is.reset();
+        }
+
+        // output buffer too small, window kept
+        {
+            std::string out;
+            out.resize(check.size());
+            z_params zs;
+            zs.next_in = in.data();
+            zs.avail_in = in.size();
+            zs.next_out = &out[0];
+            zs.avail_out = 1000;
+            error_code ec;
+            is.write_final(zs, Flush::sync, ec);
+            BEAST_EXPECTS(! ec, ec.message());
+            BEAST_EXPECT(zs.avail_out == 0);
+            BEAST_EXPECT(n == n0 + inflate_stream::memory_size(15));
+            zs.avail_out = out.size() - zs.total_out;
+            is.write_final(zs, Flush::sync, ec);
+            BEAST_EXPECTS(! ec, ec.message());
+            BEAST_EXPECT(out == check);
+            is.clear();
+            BEAST_EXPECT(n == n0);
+        }
+    }
+
+    void
+    testDictionary()
+    {
+        auto const dict = corpus1(40000);
+        auto const check =
+            dict.substr(30000, 400) + dict.substr(39000, 300);
+        auto const decompress =
+            [&](inflate_stream& is, std::string const& in)
+            {
+                std::string out;
+                out.resize(check.size() + 1);
+                z_params zs;
+                zs.next_in = in.data();
+                zs.avail_in = in.size();
+                zs.next_out = &out[0];
+                zs.avail_out = out.size();
+                error_code ec;
+                is.write(zs, Flush::sync, ec);
+                BEAST_EXPECTS(! ec, ec.message());
+                out.resize(zs.total_out);
+                return out;
+            };
+        for(int window = 9; window <= 15; ++window)
+        {
+            auto const in = compress(check,
+                6, window, 8, Z_DEFAULT_STRATEGY, dict);
+            inflate_stream is;
+            is.reset(window);
+            for(int i = 0; i < 2; ++i)
+            {
+                is.dictionary(dict.data(), dict.size());
+                BEAST_EXPECT(decompress(is, in) == check);
+                is.reset();
+            }
+        }
+
+        // A dictionary which is not needed is harmless
+        {
+            auto const in = compress(check, 6, 15, 8, Z_DEFAULT_STRATEGY);
+            inflate_stream is;
+            is.dictionary(dict.data(), dict.size());
+            BEAST_EXPECT(decompress(is, in) == check);
+        }
+    }
+
     void
     run() override
     {
@@ -368,6 +511,9 @@ public:
             "sizeof(inflate_stream) == " <<
             sizeof(inflate_stream) << std::endl;
         testInflate();
+        testMemory();
+        testWriteFinal();
+        testDictionary();
     }
 };
 
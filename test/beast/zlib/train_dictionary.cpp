@@ -0,0 +1,166 @@
+//
+// Copyright (c) 2016-2017 Vinnie Falco (vinnie dot falco at gmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/boostorg/beast
+//
+
+// Test that header file is self-contained.
+#include <beast/zlib/train_dictionary.hpp>
+
+#include <beast/zlib/deflate_stream.hpp>
+#include <beast/zlib/inflate_stream.hpp>
+#include <beast/unit_test/suite.hpp>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace beast {
+namespace zlib {
+
+class train_dictionary_test : public beast::unit_test::suite
+{
+public:
+    // A small JSON object with a fixed
+    // vocabulary and random values.
+    static
+    std::string
+    message(std::mt19937& g)
+    {
+        static char const* const names[] = {
+            "alice", "bob", "carol", "dave", "erin", "frank" };
+        static char const* const events[] = {
+            "login", "logout", "purchase", "refund", "view" };
+        std::uniform_int_distribution<int> d6{0, 5};
+        std::uniform_int_distribution<int> d5{0, 4};
+        std::uniform_int_distribution<std::uint32_t> dn;
+        std::string s;
+        s += "{\"id\":";
+        s += std::to_string(dn(g));
+        s += ",\"timestamp\":\"2017-";
+        s += std::to_string(10 + d6(g));
+        s += "-";
+        s += std::to_string(10 + d6(g) * 3);
+        s += "T12:";
+        s += std::to_string(10 + d6(g) * 9);
+        s += ":00Z\",\"user\":{\"name\":\"";
+        s += names[d6(g)];
+        s += "\",\"account\":";
+        s += std::to_string(dn(g) % 100000);
+        s += ",\"verified\":";
+        s += d6(g) < 3 ? "true" : "false";
+        s += "},\"event\":{\"type\":\"";
+        s += events[d5(g)];
+        s += "\",\"amount\":";
+        s += std::to_string(dn(g) % 1000);
+        s += ",\"currency\":\"USD\",\"source\":\"mobile-application\"}}";
+        return s;
+    }
+
+    std::string
+    deflate(std::string const& in, deflate_dictionary const* dd)
+    {
+        deflate_stream ds;
+        error_code ec;
+        if(dd)
+            ds.dictionary(*dd, ec);
+        BEAST_EXPECTS(! ec, ec.message());
+        std::string out;
+        out.resize(ds.upper_bound(in.size()) + 6);
+        z_params zs;
+        zs.next_in = in.data();
+        zs.avail_in = in.size();
+        zs.next_out = &out[0];
+        zs.avail_out = out.size();
+        ds.write(zs, Flush::sync, ec);
+        BEAST_EXPECTS(! ec, ec.message());
+        out.resize(zs.total_out);
+        return out;
+    }
+
+    std::string
+    inflate(std::string const& in,
+        std::size_t size, std::string const& dict)
+    {
+        inflate_stream is;
+        is.dictionary(dict.data(), dict.size());
+        std::string out;
+        out.resize(size + 1);
+        z_params zs;
+        zs.next_in = in.data();
+        zs.avail_in = in.size();
+        zs.next_out = &out[0];
+        zs.avail_out = out.size();
+        error_code ec;
+        is.write(zs, Flush::sync, ec);
+        BEAST_EXPECTS(! ec, ec.message());
+        out.resize(zs.total_out);
+        return out;
+    }
+
+    void
+    testTrain()
+    {
+        std::mt19937 g;
+        std::vector<std::string> samples;
+        for(int i = 0; i < 500; ++i)
+            samples.push_back(message(g));
+
+        auto const dict = train_dictionary(
+            samples.begin(), samples.end(), 1024);
+        BEAST_EXPECT(! dict.empty());
+        BEAST_EXPECT(dict.size() <= 1024);
+        deflate_dictionary const dd{dict.data(), dict.size()};
+
+        std::size_t n0 = 0;
+        std::size_t n1 = 0;
+        std::size_t n2 = 0;
+        for(int i = 0; i < 100; ++i)
+        {
+            auto const m = message(g);
+            auto const out1 = deflate(m, nullptr);
+            auto const out2 = deflate(m, &dd);
+            BEAST_EXPECT(inflate(out2, m.size(), dict) == m);
+            n0 += m.size();
+            n1 += out1.size();
+            n2 += out2.size();
+        }
+        log <<
+            "size " << n0 <<
+            ", without dictionary " << n1 <<
+            ", with dictionary " << n2 << std::endl;
+        BEAST_EXPECT(n2 * 2 < n1);
+    }
+
+    void
+    testEdges()
+    {
+        std::vector<string_view> v;
+        BEAST_EXPECT(train_dictionary(v.begin(), v.end(), 100).empty());
+        v.push_back("short");
+        v.push_back("short");
+        BEAST_EXPECT(train_dictionary(v.begin(), v.end(), 100).empty());
+        v.push_back("nothing in common");
+        v.push_back("with the others");
+        BEAST_EXPECT(train_dictionary(v.begin(), v.end(), 100).empty());
+        v.push_back("with the others, again");
+        auto const s = train_dictionary(v.begin(), v.end(), 100);
+        BEAST_EXPECTS(s == "with the others", s);
+        BEAST_EXPECT(train_dictionary(
+            v.begin(), v.end(), 4) == "hers");
+    }
+
+    void
+    run() override
+    {
+        testTrain();
+        testEdges();
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(beast,zlib,train_dictionary);
+
+} // zlib
+} // beast
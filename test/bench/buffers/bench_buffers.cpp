@@ -7,13 +7,18 @@
 // Official repository: https://github.com/boostorg/beast
 //
 
+#include <beast/core/buffers_cat.hpp>
+#include <beast/core/buffers_prefix.hpp>
+#include <beast/core/buffers_suffix.hpp>
 #include <beast/core/flat_buffer.hpp>
 #include <beast/core/multi_buffer.hpp>
+#include <beast/core/detail/buffer_array.hpp>
 #include <beast/core/read_size.hpp>
 #include <beast/core/string.hpp>
 #include <beast/unit_test/suite.hpp>
 #include <asio/streambuf.hpp>
 #include <algorithm>
+#include <array>
 #include <chrono>
 #include <cstdlib>
 #include <iomanip>
@@ -143,6 +148,205 @@ public:
         return throughput(t.elapsed(), total);
     }
 
+    struct pipeline_stats
+    {
+        size_type rate = 0;
+        size_type moves = 0;
+        size_type moved = 0;
+        size_type allocs = 0;
+    };
+
+    // Model reading pipelined requests of `size` octets into a
+    // flat_buffer, where each read returns at most `chunk`
+    // octets and the parser consumes every complete request.
+    // The buffer starts with 16KB of storage, as it would have
+    // after reading a large header. Moves and reallocations are
+    // detected from the position of the readable bytes.
+    pipeline_stats
+    do_pipelined(flat_buffer_policy const& policy,
+        std::size_t repeat, std::size_t count,
+        std::size_t size, std::size_t chunk)
+    {
+        pipeline_stats st;
+        timer t;
+        size_type total = 0;
+        for(auto i = repeat; i--;)
+        {
+            flat_buffer b;
+            b.policy(policy);
+            b.prepare(16384);
+            for(auto j = count; j--;)
+            {
+                auto const capacity = b.capacity();
+                auto const data = b.data().data();
+                auto const mb = b.prepare(read_size(b, 65536));
+                if(b.capacity() != capacity)
+                {
+                    ++st.allocs;
+                }
+                else if(b.size() > 0 && b.data().data() != data)
+                {
+                    ++st.moves;
+                    st.moved += b.size();
+                }
+                auto const n = fill(asio::buffer(
+                    mb, (std::min)(chunk, mb.size())));
+                b.commit(n);
+                total += n;
+                b.consume(b.size() - b.size() % size);
+            }
+        }
+        st.rate = throughput(t.elapsed(), total);
+        return st;
+    }
+
+    void
+    do_pipelined_trials(std::size_t repeat, std::size_t count)
+    {
+        flat_buffer_policy lazy;
+        lazy.compact_ratio = 0.5f;
+        flat_buffer_policy tuned = lazy;
+        tuned.growth_factor = 2;
+        tuned.shrink_after = 64;
+        std::vector<std::pair<char const*, flat_buffer_policy>> policies;
+        policies.emplace_back("default", flat_buffer_policy{});
+        policies.emplace_back("compact_ratio=0.5", lazy);
+        policies.emplace_back("+growth, shrink", tuned);
+        std::vector<std::pair<std::size_t, std::size_t>> params;
+        params.emplace_back(300, 1460);
+        params.emplace_back(300, 4096);
+        params.emplace_back(2000, 1460);
+        params.emplace_back(2000, 8192);
+        for(auto const& param : params)
+        {
+            auto const s = std::string("pipelined size=") +
+                std::to_string(param.first) +
+                ", chunk=" + std::to_string(param.second);
+            log << std::left << std::setw(36) << s <<
+                std::right << std::setw(10) << "MB/s" <<
+                std::right << std::setw(10) << "moves" <<
+                std::right << std::setw(12) << "KB moved" <<
+                std::right << std::setw(10) << "allocs" <<
+                std::endl;
+            for(auto const& policy : policies)
+            {
+                // warm-up
+                do_pipelined(policy.second,
+                    repeat, count, param.first, param.second);
+                auto const st = do_pipelined(policy.second,
+                    repeat, count, param.first, param.second);
+                log << std::left << std::setw(36) << policy.first <<
+                    std::right << std::setw(10) <<
+                        (st.rate + 512 * 1024) / (1024 * 1024) <<
+                    std::right << std::setw(10) << st.moves <<
+                    std::right << std::setw(12) << st.moved / 1024 <<
+                    std::right << std::setw(10) << st.allocs <<
+                    std::endl;
+            }
+            log << std::endl;
+        }
+    }
+
+    // The shape of a chunk written by http::serializer:
+    // header, chunk-size, chunk-ext, crlf, body, crlf.
+    using chunk_type = buffers_suffix<buffers_cat_view<
+        std::array<asio::const_buffer, 8>,
+        asio::const_buffer,
+        asio::const_buffer,
+        asio::const_buffer,
+        std::array<asio::const_buffer, 8>,
+        asio::const_buffer>>;
+
+    struct iov
+    {
+        void const* base;
+        std::size_t len;
+    };
+
+    // Copy a buffer sequence to an array of iov the
+    // way Asio prepares the arguments of a system call.
+    template<class ConstBufferSequence>
+    static
+    std::size_t
+    to_iov(ConstBufferSequence const& buffers,
+        std::array<iov, 64>& v)
+    {
+        std::size_t n = 0;
+        auto it = asio::buffer_sequence_begin(buffers);
+        auto const end = asio::buffer_sequence_end(buffers);
+        for(; it != end && n < v.size(); ++it)
+        {
+            asio::const_buffer const b = *it;
+            v[n].base = b.data();
+            v[n].len = b.size();
+            ++n;
+        }
+        return n;
+    }
+
+    // Returns the number of sequences converted per second
+    template<bool Flatten>
+    size_type
+    do_iov(std::size_t repeat, std::size_t skip)
+    {
+        static char buf[8192];
+        std::array<asio::const_buffer, 8> header;
+        std::array<asio::const_buffer, 8> body;
+        for(std::size_t i = 0; i < 8; ++i)
+        {
+            header[i] = asio::const_buffer{buf + 32 * i, 32};
+            body[i] = asio::const_buffer{buf + 256 + 512 * i, 512};
+        }
+        asio::const_buffer const crlf{"\r\n", 2};
+        chunk_type cb{buffers_cat(header,
+            asio::const_buffer{buf, 4}, asio::const_buffer{},
+            crlf, body, crlf)};
+        cb.consume(skip);
+        std::array<iov, 64> v;
+        std::size_t total = 0;
+        timer t;
+        for(auto i = repeat; i--;)
+        {
+            auto const pcb = buffers_prefix(65536, cb);
+            if(Flatten)
+                total += to_iov(detail::buffer_array<64>{pcb}, v);
+            else
+                total += to_iov(pcb, v);
+            total += v[0].len;
+        }
+        if(total == 0)
+            fail();
+        return throughput(t.elapsed(), repeat);
+    }
+
+    void
+    do_iov_trials(std::size_t repeat)
+    {
+        log << std::left << std::setw(36) << "iovec from serializer chunk" <<
+            std::right << std::setw(14) << "iterate" <<
+            std::right << std::setw(14) << "buffer_array" <<
+            std::endl;
+        std::vector<std::pair<char const*, std::size_t>> params;
+        params.emplace_back("whole", 0);
+        params.emplace_back("after 300 octets", 300);
+        params.emplace_back("after 3000 octets", 3000);
+        for(auto const& param : params)
+        {
+            // warm-up
+            do_iov<false>(repeat, param.second);
+            do_iov<true>(repeat, param.second);
+            log << std::left << std::setw(36) << param.first <<
+                std::right << std::setw(8) <<
+                    1000000000 / do_iov<false>(repeat, param.second) <<
+                        " ns/op" <<
+                std::right << std::setw(8) <<
+                    1000000000 / do_iov<true>(repeat, param.second) <<
+                        " ns/op" <<
+                std::endl;
+        }
+        log << std::endl;
+    }
+
     static
     inline
     void
@@ -229,6 +433,8 @@ public:
             );
             log << std::endl;
         }
+        do_pipelined_trials(repeat, 1000);
+        do_iov_trials(1000000);
         pass();
     }
 };
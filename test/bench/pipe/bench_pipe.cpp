@@ -0,0 +1,341 @@
+//
+// Copyright (c) 2016-2017 Vinnie Falco (vinnie dot falco at gmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/boostorg/beast
+//
+
+#include <beast/core/flat_buffer.hpp>
+#include <beast/experimental/test/pipe_stream.hpp>
+#include <beast/http/read.hpp>
+#include <beast/http/string_body.hpp>
+#include <beast/http/write.hpp>
+#include <beast/websocket/stream.hpp>
+#include <beast/unit_test/suite.hpp>
+#include <asio/buffer.hpp>
+#include <asio/io_context.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <thread>
+
+namespace beast {
+
+/*  Client and server throughput without the network.
+
+    A client and a server are connected with a pair of
+    test::pipe_stream, and run on two threads of the same
+    process. Each HTTP request is answered with a response
+    whose body has the given size, and each WebSocket message
+    is echoed back by the server. The client waits for the
+    answer before sending the next request or message, so the
+    results measure the CPU cost of the parser, serializer
+    and framing on both ends, plus the handoff between the
+    threads.
+
+    The results are printed as comma separated values, one
+    line per protocol, mode and size, following a header line
+    starting with "protocol,".
+*/
+class pipe_test : public beast::unit_test::suite
+{
+public:
+    using clock_type = std::chrono::steady_clock;
+
+    // The approximate number of octets exchanged for each measurement
+    static std::size_t constexpr volume = 64 * 1024 * 1024;
+
+    static
+    std::size_t
+    count(std::size_t size)
+    {
+        return (std::max)(
+            volume / (size + 1024), std::size_t{1000});
+    }
+
+    static
+    double
+    rate(std::size_t n, clock_type::duration elapsed)
+    {
+        return n / std::chrono::duration<double>(elapsed).count();
+    }
+
+    static
+    http::response<http::string_body>
+    make_response(std::size_t size)
+    {
+        http::response<http::string_body> res{http::status::ok, 11};
+        res.set(http::field::server, "test");
+        res.body() = std::string(size, '*');
+        res.prepare_payload();
+        return res;
+    }
+
+    static
+    http::request<http::string_body>
+    make_request()
+    {
+        http::request<http::string_body> req{http::verb::get, "/", 11};
+        req.set(http::field::host, "localhost");
+        req.set(http::field::user_agent, "test");
+        return req;
+    }
+
+    // Returns the number of requests per second
+    double
+    http_sync(std::size_t size)
+    {
+        asio::io_context ioc;
+        test::pipe_stream client{ioc};
+        test::pipe_stream server{ioc};
+        client.connect(server);
+        std::thread t{
+            [&]
+            {
+                auto const res = make_response(size);
+                flat_buffer b;
+                error_code ec;
+                for(;;)
+                {
+                    http::request<http::string_body> req;
+                    http::read(server, b, req, ec);
+                    if(ec)
+                        break;
+                    http::write(server, res, ec);
+                    if(ec)
+                        break;
+                }
+            }};
+        auto const req = make_request();
+        auto const n = count(size);
+        flat_buffer b;
+        error_code ec;
+        auto const when = clock_type::now();
+        for(std::size_t i = 0; i < n && ! ec; ++i)
+        {
+            http::write(client, req, ec);
+            if(ec)
+                break;
+            http::response<http::string_body> res;
+            http::read(client, b, res, ec);
+        }
+        auto const elapsed = clock_type::now() - when;
+        client.close();
+        t.join();
+        if(ec)
+        {
+            fail(ec.message(), __FILE__, __LINE__);
+            return 0;
+        }
+        return rate(n, elapsed);
+    }
+
+    class http_server
+    {
+        test::pipe_stream& s_;
+        flat_buffer b_;
+        http::request<http::string_body> req_;
+        http::response<http::string_body> res_;
+
+    public:
+        http_server(test::pipe_stream& s, std::size_t size)
+            : s_(s)
+            , res_(make_response(size))
+        {
+        }
+
+        void
+        run()
+        {
+            req_ = {};
+            http::async_read(s_, b_, req_,
+                [this](error_code ec, std::size_t)
+                {
+                    if(ec)
+                        return;
+                    http::async_write(s_, res_,
+                        [this](error_code ec, std::size_t)
+                        {
+                            if(! ec)
+                                run();
+                        });
+                });
+        }
+    };
+
+    class http_client
+    {
+        test::pipe_stream& s_;
+        std::size_t n_;
+        flat_buffer b_;
+        http::request<http::string_body> req_;
+        http::response<http::string_body> res_;
+
+    public:
+        error_code ec;
+
+        http_client(test::pipe_stream& s, std::size_t n)
+            : s_(s)
+            , n_(n)
+            , req_(make_request())
+        {
+        }
+
+        void
+        run()
+        {
+            if(n_-- == 0)
+                return s_.close();
+            http::async_write(s_, req_,
+                [this](error_code ec_, std::size_t)
+                {
+                    if(ec_)
+                    {
+                        ec = ec_;
+                        return s_.close();
+                    }
+                    res_ = {};
+                    http::async_read(s_, b_, res_,
+                        [this](error_code ec_, std::size_t)
+                        {
+                            if(ec_)
+                            {
+                                ec = ec_;
+                                return s_.close();
+                            }
+                            run();
+                        });
+                });
+        }
+    };
+
+    // Returns the number of requests per second
+    double
+    http_async(std::size_t size)
+    {
+        asio::io_context ioc1;
+        asio::io_context ioc2;
+        test::pipe_stream client{ioc1};
+        test::pipe_stream server{ioc2};
+        client.connect(server);
+        auto const n = count(size);
+        http_server hs{server, size};
+        http_client hc{client, n};
+        hs.run();
+        std::thread t{[&]{ ioc2.run(); }};
+        auto const when = clock_type::now();
+        hc.run();
+        ioc1.run();
+        auto const elapsed = clock_type::now() - when;
+        t.join();
+        if(hc.ec)
+        {
+            fail(hc.ec.message(), __FILE__, __LINE__);
+            return 0;
+        }
+        return rate(n, elapsed);
+    }
+
+    // Returns the number of messages per second
+    double
+    websocket_sync(std::size_t size)
+    {
+        asio::io_context ioc;
+        test::pipe_stream client{ioc};
+        test::pipe_stream server{ioc};
+        client.connect(server);
+        std::thread t{
+            [&]
+            {
+                websocket::stream<test::pipe_stream&> ws{server};
+                error_code ec;
+                ws.accept(ec);
+                if(ec)
+                    return;
+                flat_buffer b;
+                for(;;)
+                {
+                    ws.read(b, ec);
+                    if(ec)
+                        break;
+                    ws.binary(ws.got_binary());
+                    ws.write(b.data(), ec);
+                    if(ec)
+                        break;
+                    b.consume(b.size());
+                }
+            }};
+        auto const n = count(size);
+        std::string const msg(size, '*');
+        websocket::stream<test::pipe_stream&> ws{client};
+        ws.binary(true);
+        flat_buffer b;
+        error_code ec;
+        ws.handshake("localhost", "/", ec);
+        auto const when = clock_type::now();
+        for(std::size_t i = 0; i < n && ! ec; ++i)
+        {
+            ws.write(asio::buffer(msg), ec);
+            if(ec)
+                break;
+            ws.read(b, ec);
+            b.consume(b.size());
+        }
+        auto const elapsed = clock_type::now() - when;
+        if(! ec)
+            ws.close(websocket::close_code::normal, ec);
+        else
+            client.close();
+        t.join();
+        if(ec)
+        {
+            fail(ec.message(), __FILE__, __LINE__);
+            return 0;
+        }
+        return rate(n, elapsed);
+    }
+
+    void
+    run() override
+    {
+        log <<
+            "protocol,mode,size,per_second" <<
+            std::endl;
+        auto const print =
+            [&](char const* protocol, char const* mode,
+                std::size_t size, double per_second)
+            {
+                log <<
+                    protocol << "," <<
+                    mode << "," <<
+                    size << "," <<
+                    static_cast<std::uint64_t>(per_second) <<
+                    std::endl;
+            };
+        for(std::size_t size : {
+            std::size_t{0},
+            std::size_t{1024},
+            std::size_t{64 * 1024}})
+        {
+            print("http", "sync", size, http_sync(size));
+            print("http", "async", size, http_async(size));
+        }
+        for(std::size_t size : {
+            std::size_t{16},
+            std::size_t{1024},
+            std::size_t{64 * 1024}})
+        {
+            print("websocket", "sync", size, websocket_sync(size));
+        }
+        pass();
+    }
+};
+
+std::size_t constexpr pipe_test::volume;
+
+BEAST_DEFINE_TESTSUITE(beast,benchmarks,pipe);
+
+} // beast
@@ -0,0 +1,185 @@
+//
+// Copyright (c) 2016-2017 Vinnie Falco (vinnie dot falco at gmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/boostorg/beast
+//
+
+#include <beast/core/flat_buffer.hpp>
+#include <beast/experimental/test/stream.hpp>
+#include <beast/http/parser.hpp>
+#include <beast/http/read.hpp>
+#include <beast/http/string_body.hpp>
+#include <beast/unit_test/suite.hpp>
+#include <asio/io_context.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+namespace beast {
+namespace http {
+
+/*  Body size sweep for reading messages with a known length.
+
+    Each message is read from a test::stream which returns at
+    most `read_size` octets per read, once into a string_body,
+    whose reader stores octets in place so the body is read
+    directly into the string, and once into a body with the
+    same storage whose reader only provides put, so the body
+    is read into the flat_buffer and copied from there.
+
+    The results are printed as comma separated values, one
+    line per body size and read size, following a header line
+    starting with "body_size,".
+*/
+class read_test : public beast::unit_test::suite
+{
+public:
+    // The total number of body octets read for each measurement
+    static std::size_t constexpr volume = 64 * 1024 * 1024;
+    static std::size_t constexpr trials = 3;
+
+    // A string body which can only be parsed through put
+    struct copy_body
+    {
+        using value_type = std::string;
+
+        class reader
+        {
+            string_body::reader r_;
+
+        public:
+            template<bool isRequest, class Fields>
+            explicit
+            reader(header<isRequest, Fields>& h, value_type& b)
+                : r_(h, b)
+            {
+            }
+
+            void
+            init(boost::optional<
+                std::uint64_t> const& length, error_code& ec)
+            {
+                r_.init(length, ec);
+            }
+
+            template<class ConstBufferSequence>
+            std::size_t
+            put(ConstBufferSequence const& buffers,
+                error_code& ec)
+            {
+                return r_.put(buffers, ec);
+            }
+
+            void
+            finish(error_code& ec)
+            {
+                r_.finish(ec);
+            }
+        };
+    };
+
+    static
+    std::string
+    make_message(std::size_t size)
+    {
+        std::string s =
+            "POST / HTTP/1.1\r\n"
+            "Content-Length: " + std::to_string(size) + "\r\n"
+            "\r\n";
+        s.reserve(s.size() + size);
+        for(std::size_t i = 0; i < size; ++i)
+            s.push_back(static_cast<char>('a' + i % 26));
+        return s;
+    }
+
+    // Returns the number of megabytes of body read per second
+    template<class Body>
+    double
+    measure(std::string const& msg,
+        std::size_t size, std::size_t read_size)
+    {
+        using clock_type = std::chrono::steady_clock;
+        auto const repeat = (std::max)(
+            volume / (std::max)(size, std::size_t{1}),
+            std::size_t{4});
+        double best = 0;
+        for(std::size_t trial = 0; trial < trials; ++trial)
+        {
+            clock_type::duration elapsed{};
+            for(std::size_t i = 0; i < repeat; ++i)
+            {
+                asio::io_context ioc;
+                test::stream ts{ioc, msg};
+                ts.read_size(read_size);
+                flat_buffer b;
+                request_parser<Body> p;
+                p.body_limit(size);
+                error_code ec;
+                auto const when = clock_type::now();
+                read(ts, b, p, ec);
+                elapsed += clock_type::now() - when;
+                if(ec || p.get().body().size() != size)
+                {
+                    fail(ec ? ec.message() : "wrong body size",
+                        __FILE__, __LINE__);
+                    return 0;
+                }
+            }
+            auto const seconds = std::chrono::duration<
+                double>(elapsed).count();
+            best = (std::max)(best,
+                repeat * size / (1024 * 1024 * seconds));
+        }
+        return best;
+    }
+
+    void
+    run() override
+    {
+        log <<
+            "body_size,read_size,copy_mb_per_s,"
+            "in_place_mb_per_s,speedup" <<
+            std::endl;
+        for(std::size_t size : {
+            std::size_t{1024},
+            std::size_t{16 * 1024},
+            std::size_t{64 * 1024},
+            std::size_t{256 * 1024},
+            std::size_t{1024 * 1024},
+            std::size_t{4 * 1024 * 1024},
+            std::size_t{16 * 1024 * 1024}})
+        {
+            auto const msg = make_message(size);
+            for(std::size_t read_size : {
+                std::size_t{16 * 1024},
+                std::size_t{64 * 1024},
+                std::size_t{1024 * 1024}})
+            {
+                auto const copy =
+                    measure<copy_body>(msg, size, read_size);
+                auto const in_place =
+                    measure<string_body>(msg, size, read_size);
+                log <<
+                    size << "," <<
+                    read_size << "," <<
+                    static_cast<std::uint64_t>(copy) << "," <<
+                    static_cast<std::uint64_t>(in_place) << "," <<
+                    (copy > 0 ? in_place / copy : 0) <<
+                    std::endl;
+            }
+        }
+        pass();
+    }
+};
+
+std::size_t constexpr read_test::volume;
+std::size_t constexpr read_test::trials;
+
+BEAST_DEFINE_TESTSUITE(beast,benchmarks,read);
+
+} // http
+} // beast
@@ -0,0 +1,504 @@
+//
+// Copyright (c) 2016-2017 Vinnie Falco (vinnie dot falco at gmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/boostorg/beast
+//
+
+#include <beast/core/buffered_write_stream.hpp>
+#include <beast/core/flat_buffer.hpp>
+#include <beast/experimental/test/simulated_stream.hpp>
+#include <beast/http/read.hpp>
+#include <beast/http/string_body.hpp>
+#include <beast/http/write.hpp>
+#include <beast/websocket/stream.hpp>
+#include <beast/unit_test/suite.hpp>
+#include <asio/buffer.hpp>
+#include <asio/io_context.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace beast {
+
+/*  Latency and throughput over simulated networks.
+
+    A client and a server are connected with a pair of
+    test::simulated_stream, on a simulated network with the
+    bandwidth, round trip time, jitter and receive window of
+    a typical local, wide area and mobile connection. The
+    client keeps a few HTTP requests or WebSocket messages
+    in flight, and measures the time on the virtual clock
+    until each response or echo is received.
+
+    The HTTP server either writes directly to the simulated
+    stream, or through a buffered_write_stream which coalesces
+    writes and flushes automatically. The WebSocket server
+    either sends each echo as one frame, or fragments it into
+    frames of the size of its write buffer. This allows the
+    effect of the write policy on the tail latency to be
+    compared. The results depend only on the seed, and are the
+    same on every run and on every computer.
+
+    The results are printed as comma separated values, one
+    line per protocol, network, policy and size, following a
+    header line starting with "protocol,". Latencies are in
+    microseconds of virtual time, and "writes" is the number
+    of writes made by the server to the simulated stream.
+*/
+class simulated_test : public beast::unit_test::suite
+{
+public:
+    using duration = test::simulated_network::duration;
+
+    using buffered_stream = buffered_write_stream<
+        test::simulated_stream&, flat_buffer>;
+
+    // The number of requests or messages for each measurement
+    static std::size_t constexpr count = 200;
+
+    // The number of requests or messages in flight
+    static std::size_t constexpr depth = 4;
+
+    struct profile
+    {
+        char const* name;
+        test::network_conditions cond;
+    };
+
+    struct result
+    {
+        std::vector<duration> latency;
+        duration elapsed{0};
+        std::size_t writes = 0;
+        error_code ec;
+    };
+
+    static
+    std::vector<profile>
+    profiles()
+    {
+        using std::chrono::microseconds;
+        using std::chrono::milliseconds;
+        std::vector<profile> v;
+        {
+            profile p;
+            p.name = "lan";
+            p.cond.bandwidth = 125 * 1000 * 1000;
+            p.cond.rtt = microseconds(200);
+            p.cond.jitter = microseconds(20);
+            p.cond.window = 256 * 1024;
+            v.push_back(p);
+        }
+        {
+            profile p;
+            p.name = "wan";
+            p.cond.bandwidth = 1250 * 1000;
+            p.cond.rtt = milliseconds(40);
+            p.cond.jitter = milliseconds(5);
+            p.cond.window = 64 * 1024;
+            v.push_back(p);
+        }
+        {
+            profile p;
+            p.name = "mobile";
+            p.cond.bandwidth = 250 * 1000;
+            p.cond.rtt = milliseconds(120);
+            p.cond.jitter = milliseconds(30);
+            p.cond.window = 32 * 1024;
+            p.cond.partial_writes = true;
+            v.push_back(p);
+        }
+        return v;
+    }
+
+    //--------------------------------------------------------------------------
+
+    template<class Stream>
+    class http_server
+    {
+        Stream s_;
+        flat_buffer b_;
+        http::request<http::string_body> req_;
+        http::response<http::string_body> res_;
+
+    public:
+        http_server(test::simulated_stream& s, std::size_t size)
+            : s_(s)
+            , res_(http::status::ok, 11)
+        {
+            res_.set(http::field::server, "test");
+            res_.body() = std::string(size, '*');
+            res_.prepare_payload();
+        }
+
+        Stream&
+        stream()
+        {
+            return s_;
+        }
+
+        void
+        run()
+        {
+            req_ = {};
+            http::async_read(s_, b_, req_,
+                [this](error_code ec, std::size_t)
+                {
+                    if(ec)
+                        return;
+                    http::async_write(s_, res_,
+                        [this](error_code ec, std::size_t)
+                        {
+                            if(! ec)
+                                run();
+                        });
+                });
+        }
+    };
+
+    class http_client
+    {
+        test::simulated_stream& s_;
+        result& r_;
+        std::size_t sent_ = 0;
+        std::size_t received_ = 0;
+        bool writing_ = false;
+        flat_buffer b_;
+        http::request<http::string_body> req_;
+        http::response<http::string_body> res_;
+        std::deque<duration> times_;
+
+    public:
+        http_client(test::simulated_stream& s, result& r)
+            : s_(s)
+            , r_(r)
+            , req_(http::verb::get, "/", 11)
+        {
+            req_.set(http::field::host, "localhost");
+            req_.set(http::field::user_agent, "test");
+        }
+
+        void
+        run()
+        {
+            do_write();
+            do_read();
+        }
+
+    private:
+        void
+        do_write()
+        {
+            if( writing_ || sent_ == count ||
+                sent_ - received_ >= depth)
+                return;
+            writing_ = true;
+            times_.push_back(s_.network().now());
+            ++sent_;
+            http::async_write(s_, req_,
+                [this](error_code ec, std::size_t)
+                {
+                    writing_ = false;
+                    if(ec)
+                        return on_error(ec);
+                    do_write();
+                });
+        }
+
+        void
+        do_read()
+        {
+            res_ = {};
+            http::async_read(s_, b_, res_,
+                [this](error_code ec, std::size_t)
+                {
+                    if(ec)
+                        return on_error(ec);
+                    r_.latency.push_back(
+                        s_.network().now() - times_.front());
+                    times_.pop_front();
+                    if(++received_ == count)
+                        return s_.close();
+                    do_write();
+                    do_read();
+                });
+        }
+
+        void
+        on_error(error_code ec)
+        {
+            if(! r_.ec)
+                r_.ec = ec;
+            s_.close();
+        }
+    };
+
+    template<class Stream>
+    result
+    http_run(profile const& p, std::size_t size)
+    {
+        asio::io_context ioc;
+        test::simulated_network net{ioc};
+        test::simulated_stream client{net};
+        test::simulated_stream server{net};
+        client.connect(server, p.cond);
+        result r;
+        http_server<Stream> hs{server, size};
+        http_client hc{client, r};
+        configure(hs.stream());
+        hs.run();
+        hc.run();
+        net.run();
+        r.elapsed = net.now();
+        r.writes = server.nwrite();
+        return r;
+    }
+
+    //--------------------------------------------------------------------------
+
+    class ws_server
+    {
+        websocket::stream<test::simulated_stream&> ws_;
+        flat_buffer b_;
+
+    public:
+        ws_server(test::simulated_stream& s, bool fragment)
+            : ws_(s)
+        {
+            ws_.auto_fragment(fragment);
+            ws_.write_buffer_size(4096);
+        }
+
+        void
+        run()
+        {
+            ws_.async_accept(
+                [this](error_code ec)
+                {
+                    if(! ec)
+                        do_read();
+                });
+        }
+
+    private:
+        void
+        do_read()
+        {
+            ws_.async_read(b_,
+                [this](error_code ec, std::size_t)
+                {
+                    if(ec)
+                        return;
+                    ws_.binary(ws_.got_binary());
+                    ws_.async_write(b_.data(),
+                        [this](error_code ec, std::size_t)
+                        {
+                            if(ec)
+                                return;
+                            b_.consume(b_.size());
+                            do_read();
+                        });
+                });
+        }
+    };
+
+    class ws_client
+    {
+        websocket::stream<test::simulated_stream&> ws_;
+        result& r_;
+        std::string msg_;
+        std::size_t sent_ = 0;
+        std::size_t received_ = 0;
+        bool writing_ = false;
+        flat_buffer b_;
+        std::deque<duration> times_;
+
+    public:
+        ws_client(
+            test::simulated_stream& s,
+            result& r,
+            std::size_t size)
+            : ws_(s)
+            , r_(r)
+            , msg_(size, '*')
+        {
+            ws_.binary(true);
+        }
+
+        void
+        run()
+        {
+            ws_.async_handshake("localhost", "/",
+                [this](error_code ec)
+                {
+                    if(ec)
+                        return on_error(ec);
+                    do_write();
+                    do_read();
+                });
+        }
+
+    private:
+        void
+        do_write()
+        {
+            if( writing_ || sent_ == count ||
+                sent_ - received_ >= depth)
+                return;
+            writing_ = true;
+            times_.push_back(ws_.next_layer().network().now());
+            ++sent_;
+            ws_.async_write(asio::buffer(msg_),
+                [this](error_code ec, std::size_t)
+                {
+                    writing_ = false;
+                    if(ec)
+                        return on_error(ec);
+                    do_write();
+                });
+        }
+
+        void
+        do_read()
+        {
+            ws_.async_read(b_,
+                [this](error_code ec, std::size_t)
+                {
+                    if(ec)
+                        return on_error(ec);
+                    b_.consume(b_.size());
+                    r_.latency.push_back(
+                        ws_.next_layer().network().now() -
+                            times_.front());
+                    times_.pop_front();
+                    if(++received_ == count)
+                        return ws_.next_layer().close();
+                    do_write();
+                    do_read();
+                });
+        }
+
+        void
+        on_error(error_code ec)
+        {
+            if(! r_.ec)
+                r_.ec = ec;
+            ws_.next_layer().close();
+        }
+    };
+
+    result
+    ws_run(profile const& p, std::size_t size, bool fragment)
+    {
+        asio::io_context ioc;
+        test::simulated_network net{ioc};
+        test::simulated_stream client{net};
+        test::simulated_stream server{net};
+        client.connect(server, p.cond);
+        result r;
+        ws_server ws{server, fragment};
+        ws_client wc{client, r, size};
+        ws.run();
+        wc.run();
+        net.run();
+        r.elapsed = net.now();
+        r.writes = server.nwrite();
+        return r;
+    }
+
+    //--------------------------------------------------------------------------
+
+    static
+    void
+    configure(test::simulated_stream&)
+    {
+    }
+
+    static
+    void
+    configure(buffered_stream& s)
+    {
+        s.capacity(16 * 1024);
+        s.auto_flush(true);
+    }
+
+    void
+    print(
+        char const* protocol,
+        char const* network,
+        char const* policy,
+        std::size_t size,
+        result r)
+    {
+        if(r.ec)
+            fail(r.ec.message(), __FILE__, __LINE__);
+        if(! BEAST_EXPECT(r.latency.size() == count))
+            return;
+        auto const us =
+            [](duration d)
+            {
+                return std::chrono::duration_cast<
+                    std::chrono::microseconds>(d).count();
+            };
+        auto& v = r.latency;
+        std::sort(v.begin(), v.end());
+        log <<
+            protocol << "," <<
+            network << "," <<
+            policy << "," <<
+            size << "," <<
+            us(v[v.size() / 2]) << "," <<
+            us(v[v.size() * 99 / 100]) << "," <<
+            us(v.back()) << "," <<
+            static_cast<std::uint64_t>(count /
+                std::chrono::duration<double>(r.elapsed).count()) << "," <<
+            r.writes <<
+            std::endl;
+    }
+
+    void
+    run() override
+    {
+        log <<
+            "protocol,network,policy,size,"
+            "p50_us,p99_us,max_us,per_second,writes" <<
+            std::endl;
+        for(auto const& p : profiles())
+        {
+            for(std::size_t size : {
+                std::size_t{1024},
+                std::size_t{64 * 1024}})
+            {
+                print("http", p.name, "direct", size,
+                    http_run<test::simulated_stream&>(p, size));
+                print("http", p.name, "buffered", size,
+                    http_run<buffered_stream>(p, size));
+            }
+            for(std::size_t size : {
+                std::size_t{16},
+                std::size_t{1024},
+                std::size_t{64 * 1024}})
+            {
+                print("websocket", p.name, "whole", size,
+                    ws_run(p, size, false));
+                print("websocket", p.name, "fragmented", size,
+                    ws_run(p, size, true));
+            }
+        }
+        pass();
+    }
+};
+
+std::size_t constexpr simulated_test::count;
+std::size_t constexpr simulated_test::depth;
+
+BEAST_DEFINE_TESTSUITE(beast,benchmarks,simulated);
+
+} // beast
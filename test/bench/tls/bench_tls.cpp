@@ -0,0 +1,213 @@
+//
+// Copyright (c) 2016-2017 Vinnie Falco (vinnie dot falco at gmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/boostorg/beast
+//
+
+#if BEAST_USE_OPENSSL
+
+#include "example/common/server_certificate.hpp"
+
+#include <beast/experimental/core/ssl_stream.hpp>
+#include <beast/unit_test/suite.hpp>
+#include <asio/io_context.hpp>
+#include <asio/ip/tcp.hpp>
+#include <asio/read.hpp>
+#include <asio/ssl/context.hpp>
+#include <asio/write.hpp>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace beast {
+
+/*  Latency and throughput of responses sent over TLS.
+
+    Each response is sent with a single call to `asio::write`
+    on a new loopback connection, once using an ssl_stream with
+    the default flat_stream_policy, which starts with records
+    that fit in one TCP segment, and once with dynamic record
+    sizing turned off, which sends full sized records. The
+    client measures the time from sending a one octet request
+    until it receives the first and the last octet of the
+    response.
+
+    The client then reads a large response using buffers of
+    various sizes, with and without reads through the internal
+    buffer of flat_stream.
+
+    The results are printed as comma separated values, one
+    line per response size and policy, following a header line
+    starting with "body_size,", and one line per read size,
+    following a header line starting with "read_size,". Times
+    are in microseconds, averaged over the trials.
+*/
+class tls_test : public beast::unit_test::suite
+{
+public:
+    using clock_type = std::chrono::steady_clock;
+    using tcp = asio::ip::tcp;
+
+    static std::size_t constexpr trials = 50;
+
+    struct result
+    {
+        clock_type::duration first;
+        clock_type::duration last;
+    };
+
+    result
+    measure(
+        std::string const& body,
+        flat_stream_policy const& policy,
+        flat_stream_policy const& client_policy = {},
+        std::size_t read_size = 64 * 1024)
+    {
+        asio::io_context ioc;
+        asio::ssl::context server_ctx{asio::ssl::context::sslv23};
+        load_server_certificate(server_ctx);
+        asio::ssl::context client_ctx{asio::ssl::context::sslv23_client};
+        tcp::acceptor acceptor{ioc,
+            tcp::endpoint{asio::ip::address_v4::loopback(), 0}};
+        std::vector<char> buf(read_size);
+        result r{};
+        for(std::size_t i = 0; i < trials; ++i)
+        {
+            error_code server_ec;
+            std::thread t{
+                [&]
+                {
+                    ssl_stream<tcp::socket> s{ioc, server_ctx};
+                    s.policy(policy);
+                    acceptor.accept(s.next_layer(), server_ec);
+                    if(server_ec)
+                        return;
+                    s.handshake(asio::ssl::stream_base::server, server_ec);
+                    if(server_ec)
+                        return;
+                    char c;
+                    asio::read(s, asio::buffer(&c, 1), server_ec);
+                    if(server_ec)
+                        return;
+                    asio::write(s, asio::buffer(body), server_ec);
+                }};
+
+            error_code ec;
+            {
+                ssl_stream<tcp::socket> s{ioc, client_ctx};
+                s.policy(client_policy);
+                s.next_layer().connect(acceptor.local_endpoint(), ec);
+                if(! ec)
+                    s.handshake(asio::ssl::stream_base::client, ec);
+                auto const when = clock_type::now();
+                if(! ec)
+                    asio::write(s, asio::buffer("*", 1), ec);
+                std::size_t n = 0;
+                while(! ec && n < body.size())
+                {
+                    auto const bytes_transferred =
+                        s.read_some(asio::buffer(buf), ec);
+                    if(n == 0)
+                        r.first += clock_type::now() - when;
+                    n += bytes_transferred;
+                }
+                r.last += clock_type::now() - when;
+            }
+            t.join();
+            if(ec || server_ec)
+            {
+                fail((ec ? ec : server_ec).message(),
+                    __FILE__, __LINE__);
+                break;
+            }
+        }
+        return r;
+    }
+
+    static
+    std::string
+    make_string(std::size_t size)
+    {
+        std::string s;
+        s.reserve(size);
+        for(std::size_t i = 0; i < size; ++i)
+            s.push_back(static_cast<char>('a' + i % 26));
+        return s;
+    }
+
+    static
+    std::uint64_t
+    average(clock_type::duration d)
+    {
+        return static_cast<std::uint64_t>(
+            std::chrono::duration_cast<
+                std::chrono::microseconds>(d).count() / trials);
+    }
+
+    void
+    run() override
+    {
+        flat_stream_policy fixed;
+        fixed.initial_record_size = 0;
+        log <<
+            "body_size,policy,first_byte_us,last_byte_us" <<
+            std::endl;
+        for(std::size_t size : {
+            std::size_t{1024},
+            std::size_t{16 * 1024},
+            std::size_t{256 * 1024},
+            std::size_t{4 * 1024 * 1024}})
+        {
+            auto const body = make_string(size);
+            auto const dynamic = measure(body, flat_stream_policy{});
+            auto const full = measure(body, fixed);
+            log <<
+                size << ",dynamic," <<
+                average(dynamic.first) << "," <<
+                average(dynamic.last) <<
+                std::endl;
+            log <<
+                size << ",fixed," <<
+                average(full.first) << "," <<
+                average(full.last) <<
+                std::endl;
+        }
+
+        flat_stream_policy direct;
+        direct.read_buffer_size = 0;
+        auto const body = make_string(4 * 1024 * 1024);
+        log <<
+            "read_size,bulk_us,direct_us" <<
+            std::endl;
+        for(std::size_t read_size : {
+            std::size_t{256},
+            std::size_t{1024},
+            std::size_t{4096},
+            std::size_t{16 * 1024}})
+        {
+            auto const bulk = measure(
+                body, flat_stream_policy{}, {}, read_size);
+            auto const unbuffered = measure(
+                body, flat_stream_policy{}, direct, read_size);
+            log <<
+                read_size << "," <<
+                average(bulk.last) << "," <<
+                average(unbuffered.last) <<
+                std::endl;
+        }
+        pass();
+    }
+};
+
+std::size_t constexpr tls_test::trials;
+
+BEAST_DEFINE_TESTSUITE(beast,benchmarks,tls);
+
+} // beast
+
+#endif
@@ -0,0 +1,664 @@
+//
+// Copyright (c) 2016-2017 Vinnie Falco (vinnie dot falco at gmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/boostorg/beast
+//
+
+#include <beast/core/string.hpp>
+#include <beast/zlib/deflate_stream.hpp>
+#include <beast/zlib/inflate_stream.hpp>
+#include <beast/unit_test/suite.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "zlib-1.2.11/zlib.h"
+
+namespace beast {
+namespace zlib {
+
+/*  Benchmark matrix comparing beast::zlib with the reference zlib.
+
+    Each corpus is compressed with every level and strategy in one
+    call, with every level in 16KB streaming writes, and with every
+    level using Flush::sync after each 1KB (as a permessage-deflate
+    websocket does). The output of beast is decompressed by zlib
+    to check it. The output of zlib is then decompressed by both
+    implementations, as one buffer and in 1KB pieces.
+
+    The results are printed as comma separated values, one line
+    per run, following a header line starting with "op,". The
+    last column tells whether both implementations produced
+    exactly the same compressed output.
+*/
+class zlib_test : public beast::unit_test::suite
+{
+public:
+    static std::size_t constexpr size = 256 * 1024;
+    static std::size_t constexpr trials = 3;
+
+    enum class mode
+    {
+        whole,  // one call
+        stream, // 16KB writes
+        sync1k  // Flush::sync each 1KB
+    };
+
+    struct alloc_stats
+    {
+        std::size_t count = 0;
+        std::size_t bytes = 0;
+    };
+
+    template<class T>
+    struct stats_allocator
+    {
+        using value_type = T;
+
+        alloc_stats* s;
+
+        explicit
+        stats_allocator(alloc_stats& s_)
+            : s(&s_)
+        {
+        }
+
+        template<class U>
+        stats_allocator(stats_allocator<U> const& other)
+            : s(other.s)
+        {
+        }
+
+        T*
+        allocate(std::size_t n)
+        {
+            ++s->count;
+            s->bytes += n * sizeof(T);
+            return static_cast<T*>(::operator new(n * sizeof(T)));
+        }
+
+        void
+        deallocate(T* p, std::size_t)
+        {
+            ::operator delete(p);
+        }
+
+        template<class U>
+        friend
+        bool
+        operator==(stats_allocator const& lhs,
+            stats_allocator<U> const& rhs)
+        {
+            return lhs.s == rhs.s;
+        }
+
+        template<class U>
+        friend
+        bool
+        operator!=(stats_allocator const& lhs,
+            stats_allocator<U> const& rhs)
+        {
+            return lhs.s != rhs.s;
+        }
+    };
+
+    static
+    voidpf
+    z_alloc(voidpf opaque, unsigned items, unsigned n)
+    {
+        auto& s = *static_cast<alloc_stats*>(opaque);
+        ++s.count;
+        s.bytes += items * n;
+        return std::malloc(items * n);
+    }
+
+    static
+    void
+    z_free(voidpf, voidpf p)
+    {
+        std::free(p);
+    }
+
+    //--------------------------------------------------------------------------
+    //
+    // Corpus
+    //
+    //--------------------------------------------------------------------------
+
+    // Prose with a skewed word distribution
+    static
+    std::string
+    text(std::size_t n)
+    {
+        static char const* const words[] = {
+            "the", "of", "and", "to", "in", "a", "is", "that", "for",
+            "it", "as", "was", "with", "be", "by", "on", "not", "he",
+            "this", "are", "or", "his", "from", "at", "which", "but",
+            "have", "an", "had", "they", "you", "were", "their", "one",
+            "all", "we", "can", "her", "has", "there", "been", "if",
+            "more", "when", "will", "would", "who", "so", "no", "time",
+            "people", "system", "message", "connection", "server",
+            "request", "response", "buffer", "stream", "compression",
+            "between", "through", "because", "however", "several" };
+        auto const count = sizeof(words) / sizeof(words[0]);
+        std::mt19937 g{1};
+        std::uniform_real_distribution<double> du;
+        std::uniform_int_distribution<int> dn{6, 20};
+        std::string s;
+        s.reserve(n + 200);
+        while(s.size() < n)
+        {
+            auto const len = dn(g);
+            for(int i = 0; i < len; ++i)
+            {
+                auto const u = du(g);
+                std::string w = words[static_cast<std::size_t>(
+                    u * u * u * count)];
+                if(i == 0)
+                    w[0] = static_cast<char>(w[0] - 'a' + 'A');
+                else
+                    s += ' ';
+                s += w;
+            }
+            s += du(g) < 0.2 ? ".\n" : ". ";
+        }
+        s.resize(n);
+        return s;
+    }
+
+    // Newline separated JSON objects
+    static
+    std::string
+    json(std::size_t n)
+    {
+        static char const* const names[] = {
+            "alice", "bob", "carol", "dave", "erin", "frank" };
+        static char const* const events[] = {
+            "login", "logout", "purchase", "refund", "view" };
+        std::mt19937 g{2};
+        std::uniform_int_distribution<int> d6{0, 5};
+        std::uniform_int_distribution<int> d5{0, 4};
+        std::uniform_int_distribution<std::uint32_t> dn;
+        std::string s;
+        s.reserve(n + 300);
+        while(s.size() < n)
+        {
+            s += "{\"id\":";
+            s += std::to_string(dn(g));
+            s += ",\"user\":{\"name\":\"";
+            s += names[d6(g)];
+            s += "\",\"account\":";
+            s += std::to_string(dn(g) % 100000);
+            s += "},\"event\":\"";
+            s += events[d5(g)];
+            s += "\",\"amount\":";
+            s += std::to_string(dn(g) % 10000);
+            s += ",\"tags\":[\"";
+            s += names[d6(g)];
+            s += "\",\"";
+            s += events[d5(g)];
+            s += "\"]}\n";
+        }
+        s.resize(n);
+        return s;
+    }
+
+    // Markup with repeated tags and attributes
+    static
+    std::string
+    html(std::size_t n)
+    {
+        auto const t = text(n);
+        std::mt19937 g{3};
+        std::uniform_int_distribution<std::size_t> dl{20, 120};
+        std::uniform_int_distribution<std::uint32_t> dn{0, 99999};
+        std::string s;
+        s.reserve(n + 300);
+        s += "<!DOCTYPE html>\n<html><head><title>Catalog</title></head>\n<body>\n";
+        std::size_t pos = 0;
+        while(s.size() < n)
+        {
+            auto const len = dl(g);
+            s += "<div class=\"item\"><a href=\"/products/";
+            s += std::to_string(dn(g));
+            s += "\" title=\"View details\">";
+            s.append(t, pos, len);
+            s += "</a><span class=\"price\">$";
+            s += std::to_string(dn(g) % 1000);
+            s += ".99</span></div>\n";
+            pos = (pos + len) % (t.size() - 200);
+        }
+        s.resize(n);
+        return s;
+    }
+
+    // Fixed size little endian records with slowly changing fields
+    static
+    std::string
+    binary(std::size_t n)
+    {
+        std::mt19937 g{4};
+        std::uniform_int_distribution<std::uint32_t> dd{1, 16};
+        std::uniform_int_distribution<std::uint32_t> dt{0, 7};
+        std::normal_distribution<float> dv{100, 15};
+        std::string s;
+        s.reserve(n + 16);
+        std::uint32_t id = 0;
+        auto const put =
+            [&s](std::uint32_t v, int bytes)
+            {
+                for(int i = 0; i < bytes; ++i)
+                    s.push_back(static_cast<char>((v >> (8 * i)) & 0xff));
+            };
+        while(s.size() < n)
+        {
+            id += dd(g);
+            put(id, 4);
+            put(dt(g), 2);
+            put(0x8000, 2);
+            float const f = dv(g);
+            std::uint32_t v;
+            std::memcpy(&v, &f, sizeof(v));
+            put(v, 4);
+            put(0, 4);
+        }
+        s.resize(n);
+        return s;
+    }
+
+    // Incompressible
+    static
+    std::string
+    random(std::size_t n)
+    {
+        std::mt19937 g{5};
+        std::uniform_int_distribution<std::uint32_t> d0{0, 255};
+        std::string s;
+        s.reserve(n);
+        while(n--)
+            s.push_back(static_cast<char>(d0(g)));
+        return s;
+    }
+
+    // Long repeats of a random block with a few changes
+    static
+    std::string
+    repeated(std::size_t n)
+    {
+        auto const block = random(4096);
+        std::mt19937 g{6};
+        std::uniform_int_distribution<std::size_t> dp{0, block.size() - 1};
+        std::uniform_int_distribution<std::uint32_t> d0{0, 255};
+        std::string s;
+        s.reserve(n + block.size());
+        while(s.size() < n)
+        {
+            auto const pos = s.size();
+            s += block;
+            for(int i = 0; i < 40; ++i)
+                s[pos + dp(g)] = static_cast<char>(d0(g));
+        }
+        s.resize(n);
+        return s;
+    }
+
+    //--------------------------------------------------------------------------
+
+    static
+    char const*
+    to_string(mode m)
+    {
+        switch(m)
+        {
+        case mode::whole: return "whole";
+        case mode::stream: return "stream";
+        default:
+        case mode::sync1k: return "sync1k";
+        }
+    }
+
+    static
+    char const*
+    to_string(Strategy strategy)
+    {
+        switch(strategy)
+        {
+        default:
+        case Strategy::normal: return "normal";
+        case Strategy::filtered: return "filtered";
+        case Strategy::huffman: return "huffman";
+        case Strategy::rle: return "rle";
+        case Strategy::fixed: return "fixed";
+        }
+    }
+
+    static
+    int
+    to_zlib(Strategy strategy)
+    {
+        switch(strategy)
+        {
+        default:
+        case Strategy::normal: return Z_DEFAULT_STRATEGY;
+        case Strategy::filtered: return Z_FILTERED;
+        case Strategy::huffman: return Z_HUFFMAN_ONLY;
+        case Strategy::rle: return Z_RLE;
+        case Strategy::fixed: return Z_FIXED;
+        }
+    }
+
+    static
+    std::size_t
+    chunk_size(mode m, std::size_t n)
+    {
+        switch(m)
+        {
+        case mode::whole: return n;
+        case mode::stream: return 16 * 1024;
+        default:
+        case mode::sync1k: return 1024;
+        }
+    }
+
+    // Room for the output of any of the modes
+    static
+    std::size_t
+    out_size(std::size_t n)
+    {
+        return n + n / 8 + 4096;
+    }
+
+    std::string
+    deflate_beast(string_view in,
+        int level, Strategy strategy, mode m, alloc_stats& st)
+    {
+        std::string out;
+        out.resize(out_size(in.size()));
+        deflate_stream ds{stats_allocator<char>{st}};
+        ds.reset(level, 15, 8, strategy);
+        z_params zs;
+        zs.next_out = &out[0];
+        zs.avail_out = out.size();
+        auto const chunk = chunk_size(m, in.size());
+        for(std::size_t pos = 0; pos < in.size(); pos += chunk)
+        {
+            auto const n = (std::min)(chunk, in.size() - pos);
+            auto const last = pos + n == in.size();
+            zs.next_in = in.data() + pos;
+            zs.avail_in = n;
+            auto const flush =
+                m == mode::sync1k ? Flush::sync :
+                last ? Flush::finish : Flush::none;
+            error_code ec;
+            ds.write(zs, flush, ec);
+            if(ec != error::end_of_stream &&
+                ! BEAST_EXPECTS(! ec, ec.message()))
+                break;
+            BEAST_EXPECT(zs.avail_in == 0);
+        }
+        out.resize(zs.total_out);
+        return out;
+    }
+
+    std::string
+    deflate_zlib(string_view in,
+        int level, Strategy strategy, mode m, alloc_stats& st)
+    {
+        std::string out;
+        out.resize(out_size(in.size()));
+        z_stream zs;
+        std::memset(&zs, 0, sizeof(zs));
+        zs.zalloc = &z_alloc;
+        zs.zfree = &z_free;
+        zs.opaque = &st;
+        if(deflateInit2(&zs, level, Z_DEFLATED,
+                -15, 8, to_zlib(strategy)) != Z_OK)
+            throw std::logic_error("deflateInit2 failed");
+        zs.next_out = (Bytef*)&out[0];
+        zs.avail_out = static_cast<uInt>(out.size());
+        auto const chunk = chunk_size(m, in.size());
+        for(std::size_t pos = 0; pos < in.size(); pos += chunk)
+        {
+            auto const n = (std::min)(chunk, in.size() - pos);
+            auto const last = pos + n == in.size();
+            zs.next_in = (Bytef*)in.data() + pos;
+            zs.avail_in = static_cast<uInt>(n);
+            auto const flush =
+                m == mode::sync1k ? Z_SYNC_FLUSH :
+                last ? Z_FINISH : Z_NO_FLUSH;
+            auto const result = deflate(&zs, flush);
+            if(! BEAST_EXPECT(result == Z_OK || result == Z_STREAM_END))
+                break;
+            BEAST_EXPECT(zs.avail_in == 0);
+        }
+        out.resize(zs.total_out);
+        deflateEnd(&zs);
+        return out;
+    }
+
+    std::string
+    inflate_beast(string_view in,
+        std::size_t size, mode m, alloc_stats& st)
+    {
+        std::string out;
+        out.resize(size);
+        inflate_stream is{stats_allocator<char>{st}};
+        z_params zs;
+        zs.next_out = &out[0];
+        zs.avail_out = out.size();
+        auto const chunk = chunk_size(m, in.size());
+        for(std::size_t pos = 0; pos < in.size(); pos += chunk)
+        {
+            auto const n = (std::min)(chunk, in.size() - pos);
+            zs.next_in = in.data() + pos;
+            zs.avail_in = n;
+            error_code ec;
+            is.write(zs, Flush::sync, ec);
+            if(ec != error::end_of_stream &&
+                ! BEAST_EXPECTS(! ec, ec.message()))
+                break;
+        }
+        out.resize(zs.total_out);
+        return out;
+    }
+
+    std::string
+    inflate_zlib(string_view in,
+        std::size_t size, mode m, alloc_stats& st)
+    {
+        std::string out;
+        out.resize(size);
+        z_stream zs;
+        std::memset(&zs, 0, sizeof(zs));
+        zs.zalloc = &z_alloc;
+        zs.zfree = &z_free;
+        zs.opaque = &st;
+        if(inflateInit2(&zs, -15) != Z_OK)
+            throw std::logic_error("inflateInit2 failed");
+        zs.next_out = (Bytef*)&out[0];
+        zs.avail_out = static_cast<uInt>(out.size());
+        auto const chunk = chunk_size(m, in.size());
+        for(std::size_t pos = 0; pos < in.size(); pos += chunk)
+        {
+            auto const n = (std::min)(chunk, in.size() - pos);
+            zs.next_in = (Bytef*)in.data() + pos;
+            zs.avail_in = static_cast<uInt>(n);
+            auto const result = inflate(&zs, Z_SYNC_FLUSH);
+            if(! BEAST_EXPECT(result == Z_OK || result == Z_STREAM_END))
+                break;
+        }
+        out.resize(zs.total_out);
+        inflateEnd(&zs);
+        return out;
+    }
+
+    //--------------------------------------------------------------------------
+
+    // Run f several times, return the output of the
+    // last run, the best speed and the allocations.
+    template<class F>
+    std::string
+    measure(F const& f, double& mbps, alloc_stats& st)
+    {
+        using clock_type = std::chrono::steady_clock;
+        std::string out;
+        mbps = 0;
+        for(std::size_t i = 0; i < trials; ++i)
+        {
+            st = alloc_stats{};
+            auto const t0 = clock_type::now();
+            out = f(st);
+            std::chrono::duration<double> const elapsed =
+                clock_type::now() - t0;
+            mbps = (std::max)(mbps, size / elapsed.count() / 1e6);
+        }
+        return out;
+    }
+
+    void
+    report(
+        char const* op,
+        char const* impl,
+        char const* corpus,
+        mode m,
+        int level,
+        Strategy strategy,
+        std::size_t out,
+        double mbps,
+        alloc_stats const& st,
+        bool same)
+    {
+        log <<
+            op << "," <<
+            impl << "," <<
+            corpus << "," <<
+            to_string(m) << "," <<
+            level << "," <<
+            to_string(strategy) << "," <<
+            size << "," <<
+            out << "," <<
+            std::fixed << std::setprecision(3) <<
+                double(out) / size << "," <<
+            std::setprecision(1) << mbps << "," <<
+            st.count << "," <<
+            st.bytes << "," <<
+            same <<
+            std::endl;
+    }
+
+    void
+    doDeflate(
+        char const* corpus,
+        std::string const& in,
+        int level,
+        Strategy strategy,
+        mode m)
+    {
+        double mbps1;
+        alloc_stats st1;
+        auto const out1 = measure(
+            [&](alloc_stats& st)
+            {
+                return deflate_beast(in, level, strategy, m, st);
+            }, mbps1, st1);
+        double mbps2;
+        alloc_stats st2;
+        auto const out2 = measure(
+            [&](alloc_stats& st)
+            {
+                return deflate_zlib(in, level, strategy, m, st);
+            }, mbps2, st2);
+        // The output differs from zlib 1.2.11 for stored blocks
+        // and when incompressible input is skipped over.
+        auto const same = out1 == out2;
+        report("deflate", "beast", corpus,
+            m, level, strategy, out1.size(), mbps1, st1, same);
+        report("deflate", "zlib", corpus,
+            m, level, strategy, out2.size(), mbps2, st2, same);
+        if(! same)
+        {
+            alloc_stats st;
+            BEAST_EXPECTS(inflate_zlib(out1, in.size(), m, st) == in,
+                std::string{corpus} + " " + to_string(m) + " " +
+                std::to_string(level) + " " + to_string(strategy));
+        }
+    }
+
+    void
+    doInflate(
+        char const* corpus,
+        std::string const& in,
+        int level,
+        mode m)
+    {
+        alloc_stats st;
+        auto const z = deflate_zlib(
+            in, level, Strategy::normal, mode::whole, st);
+        double mbps;
+        auto const out1 = measure(
+            [&](alloc_stats& st)
+            {
+                return inflate_beast(z, in.size(), m, st);
+            }, mbps, st);
+        report("inflate", "beast", corpus,
+            m, level, Strategy::normal, z.size(), mbps, st, true);
+        BEAST_EXPECT(out1 == in);
+        auto const out2 = measure(
+            [&](alloc_stats& st)
+            {
+                return inflate_zlib(z, in.size(), m, st);
+            }, mbps, st);
+        report("inflate", "zlib", corpus,
+            m, level, Strategy::normal, z.size(), mbps, st, true);
+        BEAST_EXPECT(out2 == in);
+    }
+
+    void
+    doCorpus(char const* corpus, std::string const& in)
+    {
+        for(int level = 0; level <= 9; ++level)
+        {
+            for(int strategy = 0; strategy <= 4; ++strategy)
+                doDeflate(corpus, in, level,
+                    static_cast<Strategy>(strategy), mode::whole);
+            doDeflate(corpus, in, level,
+                Strategy::normal, mode::stream);
+            doDeflate(corpus, in, level,
+                Strategy::normal, mode::sync1k);
+        }
+        for(int level = 1; level <= 9; level += 4)
+        {
+            doInflate(corpus, in, level, mode::whole);
+            doInflate(corpus, in, level, mode::sync1k);
+        }
+    }
+
+    void
+    run() override
+    {
+        log <<
+            "op,impl,corpus,mode,level,strategy,"
+            "in_bytes,out_bytes,ratio,mb_per_s,allocs,alloc_bytes,same" <<
+            std::endl;
+        doCorpus("text", text(size));
+        doCorpus("json", json(size));
+        doCorpus("html", html(size));
+        doCorpus("binary", binary(size));
+        doCorpus("random", random(size));
+        doCorpus("repeated", repeated(size));
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(beast,benchmarks,zlib);
+
+} // zlib
+} // beast
@@ -165,7 +165,9 @@ public:
             std::string out2;
             for(std::size_t j = 0; j < repeat; ++j)
                 out2 = doDeflateZLib(c2);
-            BEAST_EXPECT(out1 == out2);
+            // Random data is skipped over without searching
+            // for matches, so the output is not the same.
+            BEAST_EXPECT(out1.size() <= out2.size() + out2.size() / 100);
             auto const t2 =
                 test::throughput(t.elapsed(), size * repeat);
             log << std::right << std::setw(12) << t2 << " B/s";
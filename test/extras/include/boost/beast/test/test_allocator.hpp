@@ -162,6 +162,65 @@ public:
     }
 };
 
+//------------------------------------------------------------------------------
+
+/** An allocator which keeps a running total of the bytes outstanding.
+
+    All copies and rebinds of the allocator update the same counter.
+*/
+template<class T>
+class counting_allocator
+{
+    std::size_t* bytes_;
+
+    template<class U>
+    friend class counting_allocator;
+
+public:
+    using value_type = T;
+
+    explicit
+    counting_allocator(std::size_t& bytes) noexcept
+        : bytes_(&bytes)
+    {
+    }
+
+    template<class U>
+    counting_allocator(counting_allocator<U> const& u) noexcept
+        : bytes_(u.bytes_)
+    {
+    }
+
+    value_type*
+    allocate(std::size_t n)
+    {
+        *bytes_ += n * sizeof(value_type);
+        return static_cast<value_type*>(
+            ::operator new (n*sizeof(value_type)));
+    }
+
+    void
+    deallocate(value_type* p, std::size_t n) noexcept
+    {
+        *bytes_ -= n * sizeof(value_type);
+        ::operator delete(p);
+    }
+
+    template<class U>
+    bool
+    operator==(counting_allocator<U> const& other) const
+    {
+        return bytes_ == other.bytes_;
+    }
+
+    template<class U>
+    bool
+    operator!=(counting_allocator<U> const& other) const
+    {
+        return bytes_ != other.bytes_;
+    }
+};
+
 } // test
 } // beast
 